@@ -0,0 +1,133 @@
+#ifndef _RS9110_BOND_H_
+#define _RS9110_BOND_H_
+
+#include "RS9110_UART.h"
+
+
+/*!
+ *  @brief  RS9110_Bond
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stripes a byte stream across several modules (links), each one with its
+ *      own TCP socket to the same peer. The stream is cut in chunks of up to
+ *      #MAX_CHUNK bytes, each one carrying a header:
+ *      - Sequence number (4 bytes, big endian)
+ *      - Length of the payload (2 bytes, big endian)
+ *
+ *      Every chunk goes to the link expected to finish it first, given the
+ *      throughput observed on each link (from AT+RSI_SND to its OK) and what it
+ *      still has in flight, so faster links carry more chunks. A chunk that
+ *      fails (ERROR or CLOSE) is sent again on another link and the link is
+ *      taken down until #SetLinkUp.
+ *
+ *      On the receiving side the chunks of every link are reassembled from
+ *      the READ frames and delivered in sequence; up to #MAX_REORDER chunks
+ *      arriving early are held until the gap is filled. One more chunk would
+ *      be lost for good, so the stream is broken instead (#IsBroken): nothing
+ *      more is delivered, and both sides have to close the links and start
+ *      a new bond.
+ *
+ *      #ProcessResponse must be called after every #RS9110_UART::ProcessMessage
+ *      of a link and #Poll periodically.
+ */
+class RS9110_Bond
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_LINKS           = RS9110_MAX_BOND_LINKS;
+    static const unsigned short MAX_CHUNK           = RS9110_MAX_BOND_CHUNK;
+    static const unsigned char  MAX_REORDER         = RS9110_MAX_BOND_REORDER;
+    static const unsigned char  HEADER_LEN          = 6;
+
+
+    /* STRUCTURES */
+    struct TLinkStats
+    {
+        bool            isUp;
+        bool            isBusy;                     /*! @note Chunk waiting for its OK/ERROR */
+        unsigned long   numChunks;                  /*! @note Chunks acknowledged */
+        unsigned long   numBytes;                   /*! @note Payload acknowledged */
+        unsigned long   numFailed;                  /*! @note Chunks sent again elsewhere */
+        unsigned long   bytesPerSecond;             /*! @note Throughput observed (0 if unknown) */
+    };
+
+    struct TStats
+    {
+        unsigned long   numDelivered;               /*! @note Chunks received in sequence */
+        unsigned long   numReordered;               /*! @note Chunks held until a gap was filled */
+        unsigned long   numDuplicates;              /*! @note Chunks received twice */
+        unsigned long   numOverflows;               /*! @note Chunks found with no room to hold them */
+        unsigned long   numCorrupt;                 /*! @note Headers with a wrong length */
+        unsigned char   maxHeld;                    /*! @note Most chunks held at once */
+    };
+
+    typedef void (*TDeliver) (void *context, const char *data, unsigned int dataSize);
+
+
+    /* METHODS */
+    RS9110_Bond (TDeliver deliver = NULL, void *context = NULL);
+    ~RS9110_Bond ();
+
+    int             AddLink                 (RS9110_UART &rs, unsigned char socketId);
+    bool            SetLinkUp               (unsigned char link, bool isUp);
+
+    unsigned int    Write                   (const char *data, unsigned int dataSize, unsigned long nowMs);
+    bool            ProcessResponse         (unsigned char link, unsigned long nowMs);
+    void            Poll                    (unsigned long nowMs);
+
+    bool            IsIdle                  ();
+    bool            IsBroken                ();
+    bool            GetLinkStats            (unsigned char link, TLinkStats &stats);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TLink
+    {
+        RS9110_UART    *rs;
+        unsigned char   socketId;
+        bool            isRetry;                    /*! @note Chunk in stage to be sent again */
+        unsigned long   sentMs;
+        unsigned short  stageSize;
+        unsigned short  rxSize;
+        char            stage[HEADER_LEN + MAX_CHUNK];      /*! @note Chunk in flight */
+        char            rx[HEADER_LEN + MAX_CHUNK];         /*! @note Chunk being reassembled */
+        TLinkStats      stats;
+    };
+
+    struct TSlot
+    {
+        bool            isUsed;
+        unsigned long   seq;
+        unsigned short  size;
+        char            data[MAX_CHUNK];
+    };
+
+
+    /* METHODS */
+    int             PickLink                (unsigned int size, unsigned long nowMs, int self = -1);
+    bool            SendStage               (unsigned char link, unsigned long nowMs);
+    bool            Retry                   (unsigned long nowMs);
+    void            Receive                 (TLink &link, const char *data, unsigned int size);
+    void            Deliver                 (unsigned long seq, const char *data, unsigned short size);
+
+
+    /* VARIABLES */
+    TDeliver        _deliver;
+    void           *_context;
+    TLink           _links[MAX_LINKS];
+    unsigned char   _numLinks;
+    unsigned long   _txSeq;                 /*! @note Sequence of the next chunk written */
+    unsigned long   _rxSeq;                 /*! @note Sequence of the next chunk delivered */
+    TSlot           _slots[MAX_REORDER];
+    unsigned char   _numHeld;
+    bool            _isBroken;              /*! @note Early chunk found with no room, stream lost */
+    TStats          _stats;
+};
+
+#endif /* _RS9110_BOND_H_ */
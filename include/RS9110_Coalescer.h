@@ -0,0 +1,100 @@
+#ifndef _RS9110_COALESCER_H_
+#define _RS9110_COALESCER_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+
+/*!
+ *  @brief  RS9110_Coalescer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Merges small writes to a TCP socket into one "AT+RSI_SND" (Nagle-style),
+ *      saving the header, the end of command and the round-trip of every write.
+ *      Coalescing is enabled per socket; writes to any other socket are sent at
+ *      once, as with #RS9110_UART::Send.
+ *
+ *      The pending bytes are sent when the next write would not fit in one
+ *      command after byte stuffing, when the oldest one has waited for the
+ *      delay of the socket (see #Poll) or on #Flush. As every write may send a
+ *      command, the same rules as for #RS9110_UART::Send apply (one command
+ *      waiting for its OK/ERROR at a time), unless the commands go through a
+ *      #RS9110_Scheduler (see #SetScheduler).
+ */
+class RS9110_Coalescer
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_SLOTS           = RS9110_MAX_COALESCE_SOCKETS;
+    static const unsigned int   BUFFER_SIZE         = RS9110_UART::MAX_SEND_DATA_SIZE_TCP;
+    static const unsigned long  DEFAULT_DELAY_MS    = 20;
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long   numWrites;                  /*! @note Writes accepted */
+        unsigned long   numCoalesced;               /*! @note Writes merged into a pending command */
+        unsigned long   numCommands;                /*! @note AT+RSI_SND written */
+        unsigned long   numSizeFlushes;             /*! @note Commands written because the next write did not fit */
+        unsigned long   numDelayFlushes;            /*! @note Commands written by Poll */
+    };
+
+
+    /* METHODS */
+    RS9110_Coalescer (RS9110_UART &rs);
+    ~RS9110_Coalescer ();
+
+    void            SetScheduler            (RS9110_Scheduler *scheduler);
+
+    bool            Enable                  (unsigned char socketId, unsigned long delayMs = DEFAULT_DELAY_MS);
+    bool            Disable                 (unsigned char socketId);
+    bool            IsEnabled               (unsigned char socketId);
+
+    unsigned int    Write                   (unsigned char socketId, const char *data, unsigned int dataSize, unsigned long nowMs);
+    bool            Flush                   (unsigned char socketId);
+    void            Discard                 (unsigned char socketId);
+    void            Poll                    (unsigned long nowMs);
+
+    unsigned int    GetPending              (unsigned char socketId);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TSlot
+    {
+        unsigned long   delayMs;
+        unsigned long   firstMs;                    /*! @note Time of the oldest pending byte */
+        unsigned short  length;                     /*! @note Pending bytes */
+        unsigned short  stuffedLength;              /*! @note Pending bytes after byte stuffing */
+        unsigned short  maxStuffedLength;           /*! @note Room for the payload of one command */
+        unsigned char   socketId;                   /*! @note 0 if free */
+        bool            isFlushing;                 /*! @note Waiting for the scheduler */
+        char            data[BUFFER_SIZE];
+    };
+
+
+    /* METHODS */
+    TSlot *         FindSlot                (unsigned char socketId);
+    bool            FlushSlot               (TSlot *slot);
+    bool            SendSlot                (TSlot *slot);
+    void            PostFlush               ();
+
+    static bool     IssueBulk               (void *context, RS9110_UART &rs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Scheduler   *_scheduler;             /*! @note NULL if commands are written at once */
+    TSlot           _slots[MAX_SLOTS];
+    unsigned char   _nextSlot;              /*! @note First slot looked at by #IssueBulk */
+    bool            _isPosted;              /*! @note #IssueBulk queued on the scheduler */
+    TStats          _stats;
+};
+
+#endif /* _RS9110_COALESCER_H_ */
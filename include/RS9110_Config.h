@@ -0,0 +1,158 @@
+#ifndef _RS9110_CONFIG_H_
+#define _RS9110_CONFIG_H_
+
+/*!
+ *  @file   RS9110_Config.h
+ *
+ *  @brief  Compile-time sizing of the driver
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Every value can be overridden from the compiler command line
+ *      (i.e. -DRS9110_MAX_BUFFER_SIZE=512) or from a board header given by
+ *      RS9110_USER_CONFIG (i.e. -DRS9110_USER_CONFIG=\"board_rs9110.h\").
+ *      tools/footprint.sh reports the code size and RAM per instance of
+ *      several configurations. It is a manual tool, to be run from a shell
+ *      with the toolchain of the target: the IAR and MSVS projects do not
+ *      call it.
+ *
+ *      The buffer holds one command or one response at a time, so it must fit
+ *      the largest response of the enabled subsystems (checked at compile time).
+ *      Send() never builds a command larger than the buffer, so a smaller
+ *      buffer also limits the payload of every AT+RSI_SND.
+ */
+
+#if defined (RS9110_USER_CONFIG)
+#include RS9110_USER_CONFIG
+#endif /* RS9110_USER_CONFIG */
+
+
+/* SIZES */
+#ifndef RS9110_MAX_BUFFER_SIZE
+#define RS9110_MAX_BUFFER_SIZE          1520    /*! @note Command/response buffer (bytes) */
+#endif
+
+#ifndef RS9110_MAX_NUMBER_SOCKETS
+#define RS9110_MAX_NUMBER_SOCKETS       7       /*! @note Sockets with an entry in the driver's table (max 7) */
+#endif
+
+#ifndef RS9110_MAX_NUM_SCAN_RESULTS
+#define RS9110_MAX_NUM_SCAN_RESULTS     10      /*! @note Scan results per Scan/NextScan (max 10) */
+#endif
+
+#ifndef RS9110_MAX_DNSGET_RESP
+#define RS9110_MAX_DNSGET_RESP          10      /*! @note Addresses per GetDNS response (max 10) */
+#endif
+
+#ifndef RS9110_MAX_ERROR_COUNTERS
+#define RS9110_MAX_ERROR_COUNTERS       16      /*! @note Distinct error codes counted */
+#endif
+
+#ifndef RS9110_MAX_TRACE_ENTRIES
+#define RS9110_MAX_TRACE_ENTRIES        256     /*! @note Entries of RS9110_Trace (power of two) */
+#endif
+
+#ifndef RS9110_MAX_DNS_CACHE_ENTRIES
+#define RS9110_MAX_DNS_CACHE_ENTRIES    8       /*! @note Domain names kept by RS9110_DNSCache */
+#endif
+
+#ifndef RS9110_MAX_DNS_NAME_LEN
+#define RS9110_MAX_DNS_NAME_LEN         64      /*! @note Longest name accepted by RS9110_DNSCache */
+#endif
+
+#ifndef RS9110_MAX_SCAN_ENTRIES
+#define RS9110_MAX_SCAN_ENTRIES         32      /*! @note Access points kept by RS9110_ScanTable */
+#endif
+
+#ifndef RS9110_MAX_PIPELINE_SOCKETS
+#define RS9110_MAX_PIPELINE_SOCKETS     4       /*! @note Sockets opened by RS9110_Pipeline */
+#endif
+
+#ifndef RS9110_MAX_SEND_QUEUE
+#define RS9110_MAX_SEND_QUEUE           8       /*! @note Sends queued by RS9110_SendWindow */
+#endif
+
+#ifndef RS9110_MAX_SEND_WINDOW
+#define RS9110_MAX_SEND_WINDOW          4       /*! @note AT+RSI_SND in flight per socket */
+#endif
+
+#ifndef RS9110_MAX_COALESCE_SOCKETS
+#define RS9110_MAX_COALESCE_SOCKETS     2       /*! @note TCP sockets coalesced by RS9110_Coalescer (1460 bytes each) */
+#endif
+
+#ifndef RS9110_MAX_PACKER_DESTINATIONS
+#define RS9110_MAX_PACKER_DESTINATIONS  2       /*! @note UDP destinations of RS9110_Packer (1472 bytes each) */
+#endif
+
+#ifndef RS9110_MAX_SCHEDULER_JOBS
+#define RS9110_MAX_SCHEDULER_JOBS       8       /*! @note Commands queued per class by RS9110_Scheduler */
+#endif
+
+#ifndef RS9110_MAX_FAIR_QUEUE_DEPTH
+#define RS9110_MAX_FAIR_QUEUE_DEPTH     4       /*! @note Sends queued per socket by RS9110_FairQueue */
+#endif
+
+#ifndef RS9110_MAX_SLEEP_BATCH
+#define RS9110_MAX_SLEEP_BATCH          8       /*! @note Sends held by RS9110_SleepBatcher */
+#endif
+
+#ifndef RS9110_MAX_FLEET_MODULES
+#define RS9110_MAX_FLEET_MODULES        256     /*! @note Modules driven by RS9110_Fleet */
+#endif
+
+#ifndef RS9110_MAX_FLEET_REACTORS
+#define RS9110_MAX_FLEET_REACTORS       8       /*! @note Reactors (host threads) of RS9110_Fleet */
+#endif
+
+#ifndef RS9110_MAX_BOND_LINKS
+#define RS9110_MAX_BOND_LINKS           2       /*! @note Modules bonded by RS9110_Bond */
+#endif
+
+#ifndef RS9110_MAX_BOND_CHUNK
+#define RS9110_MAX_BOND_CHUNK           512     /*! @note Payload per chunk of RS9110_Bond (bytes) */
+#endif
+
+#ifndef RS9110_MAX_BOND_REORDER
+#define RS9110_MAX_BOND_REORDER         4       /*! @note Chunks held out of order by RS9110_Bond (at least links - 1) */
+#endif
+
+#ifndef RS9110_MAX_MUX_CLIENTS
+#define RS9110_MAX_MUX_CLIENTS          4       /*! @note Clients sharing the module thru RS9110_Mux */
+#endif
+
+#ifndef RS9110_MAX_MUX_VSOCKETS
+#define RS9110_MAX_MUX_VSOCKETS         7       /*! @note Virtual sockets per client of RS9110_Mux */
+#endif
+
+#ifndef RS9110_MAX_MUX_REQUESTS
+#define RS9110_MAX_MUX_REQUESTS         4       /*! @note Control requests queued per client by RS9110_Mux */
+#endif
+
+#ifndef RS9110_MAX_MUX_RING
+#define RS9110_MAX_MUX_RING             16384   /*! @note Bytes of each ring shared by RS9110_MuxServer */
+#endif
+
+#ifndef RS9110_MAX_SOCKET_DESCRIPTORS
+#define RS9110_MAX_SOCKET_DESCRIPTORS   7       /*! @note Descriptors of RS9110_Sockets */
+#endif
+
+#ifndef RS9110_MAX_SOCKET_RX_BUFFER
+#define RS9110_MAX_SOCKET_RX_BUFFER     2048    /*! @note Receive buffer per descriptor of RS9110_Sockets (bytes) */
+#endif
+
+
+/* OPTIONAL SUBSYSTEMS (1 = built, 0 = left out) */
+#ifndef RS9110_FEATURE_WEP
+#define RS9110_FEATURE_WEP              1       /*! @note SetWEPKeys */
+#endif
+
+#ifndef RS9110_FEATURE_IBSS
+#define RS9110_FEATURE_IBSS             1       /*! @note IBSS network types in SetNetworkType */
+#endif
+
+#ifndef RS9110_FEATURE_DNS
+#define RS9110_FEATURE_DNS              1       /*! @note GetDNS and RS9110_DNSCache */
+#endif
+
+#endif /* _RS9110_CONFIG_H_ */
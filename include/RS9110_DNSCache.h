@@ -0,0 +1,109 @@
+#ifndef _RS9110_DNSCACHE_H_
+#define _RS9110_DNSCACHE_H_
+
+#include "RS9110_UART.h"
+
+#if RS9110_FEATURE_DNS
+
+/*!
+ *  @brief  RS9110_DNSCache
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Resolver cache in front of #RS9110_UART::GetDNS. Answers are kept per
+ *      domain name for a configurable TTL, DNS failures (i.e.
+ *      ERROR_DNS_RESP_TIMEOUT) for a shorter negative TTL. While a name is being resolved, further
+ *      lookups of that name wait for the same "AT+RSI_DNSGET" instead of
+ *      sending another one.
+ *
+ *      The module answers one query at a time and the answer does not carry the
+ *      name, so a single query is in flight; lookups of other names get
+ *      #RESULT_BUSY meanwhile. #ProcessResponse must be called after every
+ *      #RS9110_UART::ProcessMessage.
+ */
+class RS9110_DNSCache
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned int   MAX_ENTRIES             = RS9110_MAX_DNS_CACHE_ENTRIES;
+    static const unsigned int   MAX_NAME_LEN            = RS9110_MAX_DNS_NAME_LEN;
+    static const unsigned long  DEFAULT_TTL_MS          = 300000;
+    static const unsigned long  DEFAULT_NEGATIVE_TTL_MS = 10000;
+    static const unsigned long  QUERY_TIMEOUT_MS        = 15000;    /*! @note In flight without answer */
+
+
+    /* ENUMS */
+    enum EResult
+    {
+        RESULT_HIT = 0,         /*! @note Addresses copied from the cache */
+        RESULT_NEGATIVE,        /*! @note Name failed recently (see #GetLastError) */
+        RESULT_PENDING,         /*! @note Query in flight, ask again after its answer */
+        RESULT_BUSY,            /*! @note Another name is being resolved */
+        RESULT_ERROR,           /*! @note Wrong argument or command not sent */
+        RESULT_MAX
+    };
+
+
+    /* METHODS */
+    RS9110_DNSCache (RS9110_UART &rs, unsigned long ttlMs = DEFAULT_TTL_MS, unsigned long negativeTtlMs = DEFAULT_NEGATIVE_TTL_MS);
+    ~RS9110_DNSCache ();
+
+    void            SetTTL              (unsigned long ttlMs, unsigned long negativeTtlMs);
+
+    EResult         Resolve             (const char *domainName, unsigned long nowMs, RS9110_UART::TDNSGet &result);
+    bool            ProcessResponse     (unsigned long nowMs);
+
+    bool            IsQueryInFlight     ();
+    RS9110_UART::EErrorCode GetLastError (const char *domainName);
+
+    void            Invalidate          (const char *domainName);
+    void            Clear               ();
+
+
+private:
+
+    /* ENUMS */
+    enum EState
+    {
+        STATE_FREE = 0,
+        STATE_PENDING,
+        STATE_VALID,
+        STATE_NEGATIVE
+    };
+
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        char                    name[MAX_NAME_LEN + 1];
+        unsigned long           hash;
+        unsigned char           state;                  /*! @note #EState */
+        unsigned char           errorCode;              /*! @note #RS9110_UART::EErrorCode (negative entries) */
+        unsigned long           timeMs;                 /*! @note Expiry (valid/negative) or sending time (pending) */
+        unsigned long           lastUsedMs;
+        RS9110_UART::TDNSGet    dns;
+    };
+
+
+    /* METHODS */
+    TEntry *        Find                (const char *domainName, unsigned long hash);
+    TEntry *        Allocate            (unsigned long nowMs);
+
+    static unsigned long    Hash        (const char *domainName);
+    static bool             IsSameName  (const char *name1, const char *name2);
+    static bool             IsExpired   (unsigned long timeMs, unsigned long nowMs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    unsigned long   _ttlMs;
+    unsigned long   _negativeTtlMs;
+    TEntry          _entries[MAX_ENTRIES];
+    TEntry         *_inFlight;
+};
+
+#endif /* RS9110_FEATURE_DNS */
+
+#endif /* _RS9110_DNSCACHE_H_ */
@@ -0,0 +1,109 @@
+#ifndef _RS9110_ENERGY_H_
+#define _RS9110_ENERGY_H_
+
+#include "RS9110_Config.h"
+
+#include <stddef.h>
+
+
+/*!
+ *  @brief  RS9110_Energy
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Duty-cycle and energy accounting of the module, fed by #RS9110_UART
+ *      (see #RS9110_UART::SetEnergyMeter). The power mode is taken from every
+ *      "AT+RSI_PWMODE" answered OK; in power modes 1 and 2 the module is taken
+ *      as asleep from its ACK (KeepSleeping) until its next SLEEP or the next
+ *      command written by the host (which wakes it up).
+ *
+ *      The time spent in every state is kept, together with the wake cycles,
+ *      the bytes written per wake and the time from every SLEEP to its ACK.
+ *      The charge and energy are estimated from the current drawn in every
+ *      state (see #SetCurrent) and the supply voltage.
+ *
+ *      The default clock is #RS9110_Trace::MonotonicClock, which always
+ *      returns 0 on the MCU; there the clock must be given to the constructor.
+ */
+class RS9110_Energy
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned short DEFAULT_SUPPLY_MV   = 3300;
+
+
+    /* ENUMS */
+    enum EState
+    {
+        STATE_PM0 = 0,                              /*! @note Power mode 0, always awake */
+        STATE_PM1_AWAKE,
+        STATE_PM1_ASLEEP,
+        STATE_PM2_AWAKE,
+        STATE_PM2_ASLEEP,
+        STATE_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long long  timeUs[STATE_MAX];      /*! @note Indexed by #EState */
+        unsigned long       numWakes;               /*! @note Wake-ups announced by SLEEP */
+        unsigned long       numHostWakes;           /*! @note Wake-ups caused by a command */
+        unsigned long       numAcks;                /*! @note ACKs sent back */
+        unsigned long       totalWakeBytes;         /*! @note Written while awake in power save */
+        unsigned long       maxWakeBytes;           /*! @note Most bytes written in one wake */
+        unsigned long long  totalWakeToAckUs;       /*! @note From SLEEP to its ACK */
+        unsigned long long  maxWakeToAckUs;
+        unsigned long long  chargeUC;               /*! @note Microcoulombs */
+        unsigned long long  energyUJ;               /*! @note Microjoules */
+    };
+
+    typedef unsigned long long (*TClock) ();        /*! @note Microseconds, monotonic */
+
+
+    /* METHODS */
+#if defined (AVR32)
+    RS9110_Energy (TClock clock);                   /*! @note No OS clock on the MCU, a clock must be given */
+#else
+    RS9110_Energy (TClock clock = NULL);
+#endif
+    ~RS9110_Energy ();
+
+    void            SetCurrent              (EState eState, unsigned long microAmps);
+    void            SetSupplyVoltage        (unsigned short milliVolts);
+    void            Reset                   ();
+
+    void            Transmitted             (unsigned char command, unsigned int size, unsigned char powerMode);
+    void            Received                (unsigned char responseType, unsigned char command);
+
+    EState          GetState                ();
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* METHODS */
+    void            Advance                 ();
+    void            SetState                (unsigned char powerMode, bool isAsleep);
+    void            EndWake                 ();
+
+
+    /* VARIABLES */
+    TClock              _clock;
+    unsigned long       _currentUA[STATE_MAX];
+    unsigned short      _supplyMV;
+    unsigned long long  _lastUs;            /*! @note Time accounted up to */
+    unsigned long long  _sleepUs;           /*! @note Time of the SLEEP waiting for its ACK */
+    bool                _isSleepPending;
+    unsigned char       _powerMode;         /*! @note #RS9110_UART::EPowerMode in effect */
+    unsigned char       _requestedMode;     /*! @note Mode of the last AT+RSI_PWMODE written */
+    bool                _isAsleep;
+    unsigned long       _wakeBytes;         /*! @note Written in the current wake */
+    EState              _eState;
+    TStats              _stats;
+};
+
+#endif /* _RS9110_ENERGY_H_ */
@@ -0,0 +1,134 @@
+#ifndef _RS9110_FAIR_QUEUE_H_
+#define _RS9110_FAIR_QUEUE_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+
+/*!
+ *  @brief  RS9110_FairQueue
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Shares the UART among the sockets sending data: sends are queued per
+ *      socket and written one at a time (each one waits for the OK/ERROR of
+ *      the previous one), the sockets being served by deficit round robin on
+ *      the bytes after byte stuffing. Every round a socket with data queued
+ *      earns its weight times #QUANTUM bytes, so over time each one gets its
+ *      weight's share of the line whatever the size of its sends.
+ *
+ *      A socket may also be capped to a rate (token bucket): while its bucket
+ *      holds less than its next command, it is skipped without earning
+ *      anything and #Poll writes it once the bucket refills.
+ *
+ *      The data (and host) of every send belong to the caller until its
+ *      completion is notified. Sends larger than what fits in one command are
+ *      split; a command rejected with ERROR_SEND_DATA_TOO_FAST is sent again.
+ *      With a #RS9110_Scheduler (see #SetScheduler) every command waits for
+ *      its turn in the bulk class.
+ */
+class RS9110_FairQueue
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_DEPTH           = RS9110_MAX_FAIR_QUEUE_DEPTH;
+    static const unsigned char  MAX_SOCKETS         = RS9110_UART::MAX_SOCKET_HANDLE;
+    static const unsigned int   QUANTUM             = RS9110_UART::MAX_SEND_DATA_SIZE_UDP;  /*! @note Bytes per round and unit of weight */
+
+
+    /* STRUCTURES */
+    struct TSocketStats
+    {
+        unsigned char   numQueued;                  /*! @note Sends not completed yet */
+        unsigned char   maxQueued;                  /*! @note Highest numQueued */
+        unsigned long   numCommands;                /*! @note AT+RSI_SND written */
+        unsigned long   numCompleted;               /*! @note Sends fully acknowledged */
+        unsigned long   numFailed;                  /*! @note Sends dropped */
+        unsigned long   stuffedBytes;               /*! @note Acknowledged, after byte stuffing */
+        unsigned long   numWaits;                   /*! @note Sends whose first command was written */
+        unsigned long   totalWaitMs;                /*! @note From Submit to the first command */
+        unsigned long   maxWaitMs;
+    };
+
+    typedef void (*TCompletion) (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                                 bool isSent, RS9110_UART::EErrorCode eErrorCode);
+
+
+    /* METHODS */
+    RS9110_FairQueue (RS9110_UART &rs, TCompletion completion = NULL, void *context = NULL);
+    ~RS9110_FairQueue ();
+
+    void            SetScheduler            (RS9110_Scheduler *scheduler);
+
+    bool            SetWeight               (unsigned char socketId, unsigned char weight);
+    bool            SetRateLimit            (unsigned char socketId, unsigned long bytesPerSecond, unsigned short burstBytes, unsigned long nowMs);
+
+    bool            Submit                  (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort,
+                                             const char *data, unsigned int dataSize, unsigned long nowMs);
+    bool            ProcessResponse         (unsigned long nowMs);
+    void            Poll                    (unsigned long nowMs);
+    void            Abort                   ();
+
+    bool            IsIdle                  ();
+    unsigned char   GetNumQueued            (unsigned char socketId);
+    bool            GetSocketStats          (unsigned char socketId, TSocketStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        const char     *data;
+        const char     *host;
+        unsigned int    size;
+        unsigned int    offset;                     /*! @note Bytes acknowledged */
+        unsigned long   submitMs;
+        unsigned short  hostPort;
+        unsigned char   socketType;                 /*! @note #RS9110_UART::ESocketType */
+        bool            isStarted;                  /*! @note First command written */
+    };
+
+    struct TFlow
+    {
+        TEntry          entries[MAX_DEPTH];         /*! @note FIFO */
+        unsigned char   head;
+        unsigned long   deficit;                    /*! @note Stuffed bytes the socket may still send this round */
+        unsigned char   weight;
+        unsigned long   rate;                       /*! @note Bytes per second (0 if not capped) */
+        long            tokens;                     /*! @note In 1/1000 of a byte */
+        long            maxTokens;
+        unsigned long   refillMs;
+        TSocketStats    stats;
+    };
+
+
+    /* METHODS */
+    void            Dispatch                (unsigned long nowMs);
+    int             NextFlow                (unsigned long nowMs);
+    bool            SendHead                (unsigned char flow, unsigned long nowMs);
+    void            Complete                (unsigned char flow, bool isSent, RS9110_UART::EErrorCode eErrorCode);
+    unsigned int    GetHeadCost             (unsigned char flow);
+    void            Refill                  (TFlow *flow, unsigned long nowMs);
+
+    static bool     IssueBulk               (void *context, RS9110_UART &rs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Scheduler   *_scheduler;             /*! @note NULL if commands are written at once */
+    TCompletion     _completion;
+    void           *_context;
+    TFlow           _flows[MAX_SOCKETS];
+    unsigned char   _current;               /*! @note Flow served by the round robin */
+    bool            _isCredited;            /*! @note The current flow earned its quantum */
+    int             _inFlight;              /*! @note Flow waiting for an OK/ERROR (-1 if none) */
+    unsigned int    _chunk;                 /*! @note Bytes in flight */
+    unsigned int    _cost;                  /*! @note Same bytes after byte stuffing */
+    unsigned long   _nowMs;                 /*! @note Time of the last call, for #IssueBulk */
+    bool            _isPosted;              /*! @note #IssueBulk queued on the scheduler */
+};
+
+#endif /* _RS9110_FAIR_QUEUE_H_ */
@@ -0,0 +1,156 @@
+#ifndef _RS9110_FLEET_H_
+#define _RS9110_FLEET_H_
+
+#include "RS9110_Provision.h"
+
+
+/*!
+ *  @brief  RS9110_Fleet
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drives many modules (one #RS9110_UART each, owned by the application)
+ *      from a few reactors. Every module is pinned to one reactor, and only
+ *      the thread running that reactor calls #ProcessMessage for its frames
+ *      and #Poll for the reactor, so no module is ever touched by two threads
+ *      and nothing is locked. New modules go to the reactor with fewest
+ *      modules; #Rebalance moves modules away from overloaded reactors.
+ *
+ *      Fleet-wide operations (#Start) run in parallel on every module:
+ *      provisioning (the #RS9110_Provision given to #Add), RSSI collection and
+ *      firmware version census. Each reactor starts them on its own modules
+ *      from #Poll and tracks them up to their result (#GetResult).
+ *
+ *      #Add, #Pin, #Start and #Rebalance must be called while no reactor runs.
+ *      #GetResult and #GetCensus may be called from another thread only once
+ *      #IsDone returned true (or the reactor threads are joined).
+ */
+class RS9110_Fleet
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned short MAX_MODULES         = RS9110_MAX_FLEET_MODULES;
+    static const unsigned char  MAX_REACTORS        = RS9110_MAX_FLEET_REACTORS;
+    static const unsigned char  MAX_VERSION_LEN     = sizeof(((RS9110_UART::TFWVersion *) 0)->version);
+
+
+    /* ENUMS */
+    enum EOperation
+    {
+        OP_NONE = 0,
+        OP_PROVISION,                               /*! @note RS9110_Provision of every module */
+        OP_RSSI,                                    /*! @note AT+RSI_RSSI? */
+        OP_VERSION,                                 /*! @note AT+RSI_FWVERSION? */
+        OP_MAX
+    };
+
+    enum EStatus
+    {
+        STATUS_IDLE = 0,
+        STATUS_PENDING,                             /*! @note Waiting for its reactor */
+        STATUS_RUNNING,
+        STATUS_DONE,
+        STATUS_FAILED,
+        STATUS_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TResult
+    {
+        EStatus                     status;
+        RS9110_UART::ECommand       failedCommand;  /*! @note CMD_MAX if not sent or timed out before any */
+        RS9110_UART::EErrorCode     errorCode;      /*! @note ERROR_NONE if not sent or timed out */
+        RS9110_Provision::EResult   provision;      /*! @note OP_PROVISION */
+        unsigned char               rssi;           /*! @note OP_RSSI */
+        char                        version[MAX_VERSION_LEN + 1];   /*! @note OP_VERSION */
+        unsigned long               elapsedMs;
+    };
+
+    struct TCensus
+    {
+        char                        version[MAX_VERSION_LEN + 1];
+        unsigned short              count;
+    };
+
+    struct TReactorStats
+    {
+        unsigned short              numModules;
+        unsigned short              numBusy;        /*! @note Operation pending or running */
+        unsigned long               load;           /*! @note Frames and commands since the last #Rebalance */
+        unsigned long               numDone;
+        unsigned long               numFailed;
+    };
+
+
+    /* METHODS */
+    RS9110_Fleet (unsigned char numReactors = 1);
+    ~RS9110_Fleet ();
+
+    void            SetTimeout              (unsigned long timeoutMs);
+
+    int             Add                     (RS9110_UART &rs, RS9110_Provision *provision = NULL);
+    bool            Pin                     (unsigned short module, unsigned char reactor);
+    unsigned short  Rebalance               ();
+
+    bool            Start                   (EOperation eOperation, unsigned long nowMs);
+    void            Abort                   ();
+
+    bool            ProcessMessage          (unsigned short module, char *message, int size, unsigned long nowMs);
+    unsigned short  Poll                    (unsigned char reactor, unsigned long nowMs);
+
+    bool            IsDone                  ();
+    unsigned short  GetNumModules           ();
+    unsigned char   GetNumReactors          ();
+    unsigned char   GetReactor              (unsigned short module);
+    RS9110_UART *   GetModule               (unsigned short module);
+    bool            GetResult               (unsigned short module, TResult &result);
+    unsigned short  GetCensus               (TCensus *census, unsigned short maxEntries);
+    void            GetReactorStats         (unsigned char reactor, TReactorStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TModule
+    {
+        RS9110_UART        *rs;
+        RS9110_Provision   *provision;
+        unsigned short      next;                   /*! @note Next module of the reactor (MAX_MODULES if last) */
+        unsigned char       reactor;
+        unsigned long       load;
+        unsigned long       startMs;
+        TResult             result;
+    };
+
+    struct TReactor
+    {
+        unsigned short              head;           /*! @note First module (MAX_MODULES if none) */
+        unsigned short              numModules;
+        volatile unsigned short     numBusy;
+        unsigned long               load;
+        unsigned long               numDone;
+        unsigned long               numFailed;
+    };
+
+
+    /* METHODS */
+    void            Link                    (unsigned short module, unsigned char reactor);
+    void            Unlink                  (unsigned short module);
+    void            Issue                   (TModule &module, unsigned long nowMs);
+    void            CheckProvision          (TModule &module, unsigned long nowMs);
+    void            Finish                  (TModule &module, EStatus eStatus, unsigned long nowMs);
+
+
+    /* VARIABLES */
+    TModule         _modules[MAX_MODULES];
+    TReactor        _reactors[MAX_REACTORS];
+    unsigned short  _numModules;
+    unsigned char   _numReactors;
+    EOperation      _eOperation;
+    unsigned long   _timeoutMs;
+};
+
+#endif /* _RS9110_FLEET_H_ */
@@ -0,0 +1,201 @@
+#ifndef _RS9110_MUX_H_
+#define _RS9110_MUX_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Ring.h"
+
+
+/*!
+ *  @brief  RS9110_Mux
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Shares one module among several clients (i.e. processes served by
+ *      #RS9110_MuxServer). Every client gets its own virtual sockets (1 to
+ *      #MAX_VSOCKETS), mapped onto the module handles as they are opened, and
+ *      two rings for the data:
+ *      - TX ring (client to module): one record per send, #TDataHeader
+ *        followed by the payload. Records larger than one AT+RSI_SND are split.
+ *      - RX ring (module to client): one record per READ frame, #TDataHeader
+ *        (with the source of UDP datagrams) followed by the data.
+ *
+ *      Opens and closes go thru #Request and are answered with a #TEvent, so
+ *      the control path never carries data. The module takes one command at a
+ *      time: the clients are served in round robin, one command each, control
+ *      requests before data. The payload is read in place from the TX ring.
+ *
+ *      The rings lie in memory written by the clients: a client whose ring is
+ *      found corrupt (see #RS9110_Ring::IsCorrupt) gets EVT_DETACHED and is
+ *      detached as by #Detach.
+ *
+ *      #ProcessResponse must be called after every #RS9110_UART::ProcessMessage
+ *      and #Poll whenever a client may have written new records.
+ */
+class RS9110_Mux
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_CLIENTS         = RS9110_MAX_MUX_CLIENTS;
+    static const unsigned char  MAX_VSOCKETS        = RS9110_MAX_MUX_VSOCKETS;
+    static const unsigned char  MAX_REQUESTS        = RS9110_MAX_MUX_REQUESTS;
+    static const unsigned char  MAX_ADDRESS_LEN     = 15;       /*! @note "255.255.255.255" */
+
+
+    /* ENUMS */
+    enum ERequest
+    {
+        REQ_OPEN = 0,
+        REQ_CLOSE,
+        REQ_WAKE,                                   /*! @note New records in the TX ring */
+        REQ_MAX
+    };
+
+    enum EEvent
+    {
+        EVT_OPENED = 0,                             /*! @note Answer to REQ_OPEN */
+        EVT_CLOSED,                                 /*! @note Answer to REQ_CLOSE, or closed by the peer */
+        EVT_SEND_FAILED,                            /*! @note TX record dropped */
+        EVT_OVERFLOW,                               /*! @note RX ring full, READ data dropped */
+        EVT_REJECTED,                               /*! @note Request not valid */
+        EVT_DETACHED,                               /*! @note Ring corrupt, client detached */
+        EVT_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TRequest
+    {
+        unsigned char               type;           /*! @note #ERequest */
+        unsigned char               vsock;
+        unsigned char               socketType;     /*! @note TCP, UDP, LTCP or LUDP */
+        unsigned char               reserved;
+        unsigned short              remotePort;     /*! @note TCP and UDP only */
+        unsigned short              localPort;
+        char                        host[MAX_ADDRESS_LEN + 1];      /*! @note TCP and UDP only */
+    };
+
+    struct TEvent
+    {
+        unsigned char               type;           /*! @note #EEvent */
+        unsigned char               vsock;
+        unsigned char               isOk;
+        unsigned char               errorCode;      /*! @note #RS9110_UART::EErrorCode */
+    };
+
+    struct TDataHeader
+    {
+        unsigned char               vsock;
+        unsigned char               reserved;
+        unsigned short              port;           /*! @note Host endian: source (RX, UDP) or destination (TX, LUDP) */
+        unsigned char               address[RS9110_UART::NW_ADDRESS_LEN];
+    };
+
+    struct TClientStats
+    {
+        unsigned long               numCommands;    /*! @note Written on behalf of the client */
+        unsigned long               numSent;        /*! @note TX records fully acknowledged */
+        unsigned long               numSendFailed;  /*! @note TX records dropped */
+        unsigned long               bytesSent;
+        unsigned long               bytesReceived;
+        unsigned long               numOverflows;   /*! @note READ frames dropped */
+    };
+
+    typedef void (*TNotify) (void *context, unsigned char client, const TEvent &event);
+
+
+    /* METHODS */
+    RS9110_Mux (RS9110_UART &rs);
+    ~RS9110_Mux ();
+
+    void            SetNotify               (TNotify notify, void *context);
+
+    int             Attach                  (RS9110_Ring *txRing, RS9110_Ring *rxRing);
+    bool            Detach                  (unsigned char client);
+    bool            IsAttached              (unsigned char client);
+
+    bool            Request                 (unsigned char client, const TRequest &request);
+    bool            ProcessResponse         ();
+    void            Poll                    ();
+
+    bool            IsIdle                  ();
+    unsigned char   GetHandle               (unsigned char client, unsigned char vsock);
+    bool            GetClientStats          (unsigned char client, TClientStats &stats);
+
+
+private:
+
+    /* ENUMS */
+    enum EVSocketState
+    {
+        VSOCK_FREE = 0,
+        VSOCK_OPENING,                              /*! @note Open queued or in flight */
+        VSOCK_OPEN,
+        VSOCK_CLOSING                               /*! @note Close queued or in flight */
+    };
+
+
+    /* STRUCTURES */
+    struct TVSocket
+    {
+        unsigned char               state;          /*! @note #EVSocketState */
+        unsigned char               handle;         /*! @note Module handle (0 if not open) */
+        unsigned char               socketType;
+        unsigned short              remotePort;
+        char                        host[MAX_ADDRESS_LEN + 1];
+    };
+
+    struct TClient
+    {
+        bool                        isUsed;
+        bool                        isDetaching;    /*! @note Closing its sockets before the slot is freed */
+        bool                        isOverflowing;  /*! @note EVT_OVERFLOW sent, RX ring still full */
+        RS9110_Ring                *txRing;
+        RS9110_Ring                *rxRing;
+        TRequest                    requests[MAX_REQUESTS];
+        unsigned char               reqHead;
+        unsigned char               reqCount;
+        TVSocket                    vsockets[MAX_VSOCKETS];
+        unsigned int                offset;         /*! @note Payload of the head TX record acknowledged */
+        TClientStats                stats;
+    };
+
+    struct TOwner
+    {
+        unsigned char               client;
+        unsigned char               vsock;          /*! @note 0 if the handle is not used */
+    };
+
+
+    /* METHODS */
+    void            DetachClient            (unsigned char client);
+    void            Expel                   (unsigned char client);
+    void            Dispatch                ();
+    bool            Issue                   (unsigned char client);
+    bool            IssueRequest            (unsigned char client, const TRequest &request);
+    bool            IssueSend               (unsigned char client);
+    void            Answered                (bool isOk);
+    void            Received                ();
+    void            Closed                  ();
+    void            Release                 (unsigned char client, unsigned char vsock);
+    void            DropRecord              (unsigned char client, unsigned char vsock, RS9110_UART::EErrorCode eErrorCode);
+    void            Notify                  (unsigned char client, EEvent eEvent, unsigned char vsock, bool isOk,
+                                             RS9110_UART::EErrorCode eErrorCode = RS9110_UART::ERROR_NONE);
+    void            CheckDetached           (unsigned char client);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    TNotify         _notify;
+    void           *_context;
+    TClient         _clients[MAX_CLIENTS];
+    TOwner          _owners[RS9110_UART::MAX_SOCKET_HANDLE];     /*! @note Indexed by handle - 1 */
+    RS9110_UART::ECommand   _command;       /*! @note Waiting for its OK/ERROR (CMD_MAX if none) */
+    unsigned char   _client;                /*! @note Client of that command */
+    unsigned char   _vsock;                 /*! @note Virtual socket of that command */
+    unsigned int    _chunk;                 /*! @note Payload of the AT+RSI_SND in flight */
+    unsigned char   _next;                  /*! @note Next client served by the round robin */
+};
+
+#endif /* _RS9110_MUX_H_ */
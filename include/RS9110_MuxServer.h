@@ -0,0 +1,95 @@
+#ifndef _RS9110_MUX_SERVER_H_
+#define _RS9110_MUX_SERVER_H_
+
+#if defined (__linux__) && !defined (WIN32) && !defined (AVR32)
+
+#include "RS9110_Mux.h"
+
+
+/*!
+ *  @brief  RS9110_MuxServer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Serves #RS9110_Mux to local processes (Linux only). Clients connect to a
+ *      Unix domain socket and get a #TWelcome naming a POSIX shared memory
+ *      object holding their two rings: the TX ring first, then the RX ring at
+ *      #GetRxOffset. The socket only carries #RS9110_Mux::TRequest (client to
+ *      server) and #RS9110_Mux::TEvent (server to client) records; the data
+ *      never goes thru it. A client writes REQ_WAKE after adding TX records
+ *      and reads its RX ring on its own schedule.
+ *
+ *      The serial port stays with the owner of the module: its loop calls
+ *      #RS9110_UART::ProcessMessage and #RS9110_Mux::ProcessResponse for every
+ *      frame, and #Poll in between. A client that disconnects is detached and
+ *      its sockets are closed.
+ */
+class RS9110_MuxServer
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned long  RING_SIZE           = RS9110_MAX_MUX_RING;
+    static const unsigned int   MAX_SHM_NAME        = 32;
+    static const unsigned int   MAX_PATH_LEN        = 108;      /*! @note sun_path */
+
+
+    /* STRUCTURES */
+    struct TWelcome
+    {
+        unsigned char               client;         /*! @note Index in #RS9110_Mux */
+        unsigned char               reserved[3];
+        unsigned long               ringSize;       /*! @note Data bytes of each ring */
+        char                        shmName[MAX_SHM_NAME];
+    };
+
+
+    /* METHODS */
+    RS9110_MuxServer (RS9110_Mux &mux);
+    ~RS9110_MuxServer ();
+
+    bool            Listen                  (const char *path);
+    bool            Poll                    (int timeoutMs);
+    void            Close                   ();
+
+    static unsigned long GetRxOffset        ();
+    static unsigned long GetShmSize         ();
+
+
+private:
+
+    /* STRUCTURES */
+    struct TSession
+    {
+        int                         fd;             /*! @note -1 if not used */
+        int                         client;
+        void                       *memory;
+        RS9110_Ring                 txRing;
+        RS9110_Ring                 rxRing;
+        char                        shmName[MAX_SHM_NAME];
+        char                        pending[sizeof(RS9110_Mux::TRequest)];
+        unsigned int                pendingSize;    /*! @note Bytes of a request not complete yet */
+    };
+
+
+    /* METHODS */
+    void            Accept                  ();
+    void            Receive                 (TSession &session);
+    void            Drop                    (TSession &session);
+    void            SendEvent               (TSession &session, const RS9110_Mux::TEvent &event);
+
+    static void     Notify                  (void *context, unsigned char client, const RS9110_Mux::TEvent &event);
+
+
+    /* VARIABLES */
+    RS9110_Mux     &_mux;
+    int             _listenFd;
+    char            _path[MAX_PATH_LEN];
+    unsigned long   _numShm;                /*! @note Shared memory objects created (for their names) */
+    TSession        _sessions[RS9110_Mux::MAX_CLIENTS];
+};
+
+#endif /* __linux__ */
+
+#endif /* _RS9110_MUX_SERVER_H_ */
@@ -0,0 +1,76 @@
+#ifndef _RS9110_PACER_H_
+#define _RS9110_PACER_H_
+
+#include "RS9110_Config.h"
+
+#include <stddef.h>
+
+
+/*!
+ *  @brief  RS9110_Pacer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Paces the commands written by #RS9110_UART to avoid ERROR_CMD_TOO_FAST.
+ *      It learns, per command, the minimum gap since the previous command or
+ *      answer: a rejection doubles the gap that was used, every OK shortens it
+ *      by 1/16 to follow the module when it gets faster again. Commands are
+ *      held back (thru the delay function) only as long as needed.
+ *
+ *      A command rejected for pacing is reported as no answer yet by
+ *      #RS9110_UART::ProcessMessage and written again by #RS9110_UART::Poll
+ *      once its new gap has elapsed (see #GetWait), up to #MAX_RETRIES times. "AT+RSI_SND" is not paced: the data path is
+ *      throttled by #RS9110_SendWindow.
+ */
+class RS9110_Pacer
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_COMMANDS        = 40;           /*! @note >= #RS9110_UART::CMD_MAX */
+    static const unsigned char  MAX_RETRIES         = 3;
+    static const unsigned long  MIN_STEP_US         = 500;          /*! @note Smallest gap after a rejection */
+    static const unsigned long  MAX_GAP_US          = 200000;
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long       numHeld;                /*! @note Commands held back */
+        unsigned long long  totalHeldUs;
+        unsigned long       numRejected;            /*! @note ERROR_CMD_TOO_FAST */
+        unsigned long       numRetried;             /*! @note Written again */
+    };
+
+    typedef unsigned long long (*TClock) ();                    /*! @note Microseconds, monotonic */
+    typedef void               (*TDelay) (unsigned long us);
+
+
+    /* METHODS */
+    RS9110_Pacer (TClock clock, TDelay delay);
+    ~RS9110_Pacer ();
+
+    void            Hold                    (unsigned char command);
+    unsigned long   GetWait                 (unsigned char command);
+    bool            Answered                (unsigned char command, unsigned char responseType, unsigned char errorCode, bool canRetry);
+
+    unsigned long   GetGap                  (unsigned char command);
+    void            SetGap                  (unsigned char command, unsigned long gapUs);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* VARIABLES */
+    TClock              _clock;
+    TDelay              _delay;
+    unsigned long       _gapUs[MAX_COMMANDS];
+    unsigned long long  _lastEventUs;       /*! @note Last command written or answer received */
+    unsigned long       _spacingUs;         /*! @note Gap actually left before the last command */
+    bool                _hasEvent;
+    unsigned char       _retries;
+    TStats              _stats;
+};
+
+#endif /* _RS9110_PACER_H_ */
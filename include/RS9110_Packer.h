@@ -0,0 +1,113 @@
+#ifndef _RS9110_PACKER_H_
+#define _RS9110_PACKER_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+
+/*!
+ *  @brief  RS9110_Packer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Packs application records into UDP datagrams, one datagram being built
+ *      per destination (socket, host and port). The size of the datagram after
+ *      byte stuffing is kept exactly as records are appended, so every
+ *      "AT+RSI_SND" carries as many whole records as fit in
+ *      #RS9110_UART::MAX_SEND_DATA_SIZE_UDP. Records are never split.
+ *
+ *      The datagram is sent when the next record does not fit (and the record
+ *      starts a new one), when it is full or on #Flush. As every append may
+ *      send a command, the same rules as for #RS9110_UART::Send apply (one
+ *      command waiting for its OK/ERROR at a time), unless the commands go
+ *      through a #RS9110_Scheduler (see #SetScheduler).
+ */
+class RS9110_Packer
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_DESTINATIONS    = RS9110_MAX_PACKER_DESTINATIONS;
+    static const unsigned int   BUFFER_SIZE         = RS9110_UART::MAX_SEND_DATA_SIZE_UDP;
+    static const unsigned char  MAX_ADDRESS_LEN     = 15;       /*! @note "255.255.255.255" */
+
+
+    /* ENUMS */
+    enum EResult
+    {
+        RESULT_PACKED = 0,                          /*! @note Record added to the datagram */
+        RESULT_SENT,                                /*! @note Record added, a datagram was sent (or posted) */
+        RESULT_BUSY,                                /*! @note Datagram posted on the scheduler, record not added */
+        RESULT_TOO_LARGE,                           /*! @note Record larger than a datagram */
+        RESULT_NOT_SENT,                            /*! @note Datagram could not be sent, record not added */
+        RESULT_ERROR,                               /*! @note Wrong argument */
+        RESULT_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long   numRecords;                 /*! @note Records packed */
+        unsigned long   numDatagrams;               /*! @note AT+RSI_SND written */
+        unsigned long   payloadBytes;               /*! @note Before byte stuffing */
+        unsigned long   stuffedBytes;               /*! @note After byte stuffing */
+    };
+
+
+    /* METHODS */
+    RS9110_Packer (RS9110_UART &rs);
+    ~RS9110_Packer ();
+
+    void            SetScheduler            (RS9110_Scheduler *scheduler);
+
+    int             Open                    (unsigned char socketId, const char *hostIpAddr, unsigned short hostPort);
+    bool            Close                   (int destination);
+
+    EResult         Append                  (int destination, const char *record, unsigned int recordSize);
+    bool            Flush                   (int destination);
+
+    unsigned int    GetPending              (int destination);
+    unsigned int    GetStuffedSize          (int destination);
+    unsigned int    GetMaxStuffedSize       (int destination);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TDatagram
+    {
+        unsigned short  length;                     /*! @note Bytes of whole records */
+        unsigned short  stuffedLength;              /*! @note Same bytes after byte stuffing */
+        unsigned short  maxStuffedLength;           /*! @note Room for the payload of one command */
+        unsigned short  hostPort;
+        unsigned char   socketId;                   /*! @note 0 if free */
+        bool            isSending;                  /*! @note Waiting for the scheduler */
+        char            host[MAX_ADDRESS_LEN + 1];
+        char            data[BUFFER_SIZE];
+    };
+
+
+    /* METHODS */
+    TDatagram *     GetDatagram             (int destination);
+    bool            SendDatagram            (TDatagram *datagram);
+    bool            WriteDatagram           (TDatagram *datagram);
+    void            PostSend                ();
+
+    static bool     IssueBulk               (void *context, RS9110_UART &rs);
+
+    static bool     Fits                    (const TDatagram *datagram, const char *record, unsigned int recordSize, unsigned int stuffedSize, bool isAlone);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Scheduler   *_scheduler;             /*! @note NULL if commands are written at once */
+    TDatagram       _datagrams[MAX_DESTINATIONS];
+    unsigned char   _nextDatagram;          /*! @note First datagram looked at by #IssueBulk */
+    bool            _isPosted;              /*! @note #IssueBulk queued on the scheduler */
+    TStats          _stats;
+};
+
+#endif /* _RS9110_PACKER_H_ */
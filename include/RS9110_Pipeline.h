@@ -0,0 +1,161 @@
+#ifndef _RS9110_PIPELINE_H_
+#define _RS9110_PIPELINE_H_
+
+#include "RS9110_UART.h"
+
+
+/*!
+ *  @brief  RS9110_Pipeline
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Connection bring-up from a declared target state (band, network type,
+ *      security, SSID, TX rate/power, DHCP or static IP and sockets to open).
+ *      The pipeline derives the commands needed and sends each one from
+ *      #ProcessResponse as soon as the OK of the previous one is parsed, so there
+ *      is no round-trip through the application between steps.
+ *
+ *      A failure stops the pipeline and reports the step, the reason and, for
+ *      ERROR answers, the #RS9110_UART::EErrorCode. If it happens while opening
+ *      the sockets, the ones already opened are closed before the pipeline is
+ *      marked as failed. #ProcessResponse must be
+ *      called after every #RS9110_UART::ProcessMessage and #Poll periodically
+ *      (timeouts only).
+ */
+class RS9110_Pipeline
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned long  DEFAULT_TIMEOUT_MS  = 10000;
+    static const unsigned char  MAX_ADDRESS_LEN     = 15;       /*! @note "255.255.255.255" */
+    static const unsigned char  MAX_SOCKETS         = RS9110_MAX_PIPELINE_SOCKETS;
+
+
+    /* ENUMS */
+    enum EStep
+    {
+        STEP_BAND = 0,
+        STEP_INIT,
+        STEP_SCAN,
+        STEP_NETWORK_TYPE,
+        STEP_FEATURE_SELECT,                        /*! @note Only for #TTarget::isPskExt */
+        STEP_PSK,
+        STEP_WEP_KEYS,
+        STEP_AUTH_MODE,
+        STEP_JOIN,
+        STEP_IP_CONF,
+        STEP_GET_PARAMS,                            /*! @note Only to learn an unknown channel */
+        STEP_OPEN_SOCKETS,
+        STEP_MAX
+    };
+
+    enum EState
+    {
+        STATE_IDLE = 0,
+        STATE_RUNNING,
+        STATE_DONE,
+        STATE_FAILED,
+        STATE_MAX
+    };
+
+    enum EFailure
+    {
+        FAILURE_NONE = 0,
+        FAILURE_ERROR,                              /*! @note ERROR answer (see #GetErrorCode) */
+        FAILURE_TIMEOUT,                            /*! @note No answer in time */
+        FAILURE_NOT_SENT,                           /*! @note Wrong target or persistor error */
+        FAILURE_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TSocketSpec
+    {
+        RS9110_UART::ESocketType    type;                           /*! @note TCP, UDP, LTCP or LUDP */
+        char                        host[MAX_ADDRESS_LEN + 1];      /*! @note TCP and UDP only */
+        unsigned short              remotePort;                     /*! @note TCP and UDP only */
+        unsigned short              localPort;
+    };
+
+    struct TTarget
+    {
+        RS9110_UART::EBand          band;
+        unsigned char               channel;                        /*! @note 0 if unknown */
+        RS9110_UART::ENetworkType   nwType;
+        RS9110_UART::EIBSSType      ibssType;
+        char                        ssid[RS9110_UART::MAX_SSID_LEN + 1];
+        RS9110_UART::ESecurityMode  secMode;
+        char                        psk[RS9110_UART::MAX_PSK_LEN_EXT + 1];
+        bool                        isPskExt;                       /*! @note Sets feature select bit 3 (63 byte PSK mode) */
+        RS9110_UART::EAuthMode      authMode;                       /*! @note WEP only */
+        unsigned char               wepKeyIndex;                    /*! @note WEP only */
+        char                        wepKeys[RS9110_UART::MAX_NUM_WEP_KEYS][RS9110_UART::MAX_PSK_LEN + 1];
+        RS9110_UART::ETxRate        txRate;
+        RS9110_UART::ETxPower       txPower;
+        RS9110_UART::EDHCPMode      dhcpMode;
+        char                        address[MAX_ADDRESS_LEN + 1];   /*! @note DHCP_MANUAL only */
+        char                        subnet[MAX_ADDRESS_LEN + 1];
+        char                        gateway[MAX_ADDRESS_LEN + 1];
+        unsigned char               numSockets;
+        TSocketSpec                 sockets[MAX_SOCKETS];
+    };
+
+
+    /* METHODS */
+    RS9110_Pipeline (RS9110_UART &rs);
+    ~RS9110_Pipeline ();
+
+    void            SetTarget               (const TTarget &target);
+    void            GetTarget               (TTarget &target);
+    const TTarget & GetTarget               ();
+    void            SetChannel              (unsigned char channel);
+    void            SetTimeout              (unsigned long timeoutMs);
+
+    unsigned int    GetRequiredSteps        ();
+    bool            Start                   (unsigned long nowMs, unsigned int steps = 0xFFFFFFFF, bool isFullScan = false);
+    void            Stop                    ();
+
+    EState          Poll                    (unsigned long nowMs);
+    bool            ProcessResponse         (unsigned long nowMs);
+
+    EState          GetState                ();
+    EStep           GetStep                 ();
+    EFailure        GetFailure              ();
+    RS9110_UART::EErrorCode GetErrorCode    ();
+    unsigned char   GetSocketId             (unsigned char index);
+
+    static const char * GetStepName         (EStep eStep);
+
+
+private:
+
+    /* METHODS */
+    void            NextStep                (unsigned long nowMs);
+    bool            SendStep                ();
+    void            Fail                    (EFailure eFailure, RS9110_UART::EErrorCode eErrorCode, unsigned long nowMs);
+    void            CloseNext               (unsigned long nowMs);
+    void            LearnChannel            ();
+
+    static RS9110_UART::ECommand CommandOf  (EStep eStep, RS9110_UART::ESocketType socketType);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    TTarget         _target;
+    EState          _state;
+    unsigned int    _steps;                 /*! @note Bit per #EStep of the current run */
+    unsigned char   _step;                  /*! @note #EStep being run */
+    unsigned char   _socket;                /*! @note Index of the socket being opened */
+    bool            _isFullScan;
+    bool            _isWaiting;             /*! @note Command sent, answer pending */
+    bool            _isClosing;             /*! @note Closing the sockets opened before a failure */
+    EFailure        _failure;
+    RS9110_UART::EErrorCode _errorCode;
+    unsigned char   _socketIds[MAX_SOCKETS];
+    unsigned long   _timeoutMs;
+    unsigned long   _sentMs;
+};
+
+#endif /* _RS9110_PIPELINE_H_ */
@@ -0,0 +1,36 @@
+#ifndef _RS9110_PROBES_H_
+#define _RS9110_PROBES_H_
+
+/*!
+ *  @file   RS9110_Probes.h
+ *
+ *  @brief  Static probes on the hot paths of #RS9110_UART
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Every probe takes a name and two integer arguments and compiles to nothing
+ *      unless one of the following is defined at build time:
+ *      - RS9110_PROBES_USDT: Linux USDT probes (sys/sdt.h) under the "rs9110"
+ *        provider. They are a single nop until perf/bpftrace attaches to them,
+ *        i.e. "bpftrace -e 'usdt:./app:rs9110:send_return { @[arg0] = count(); }'".
+ *      - RS9110_PROBE_SINK(name, arg1, arg2): user supplied sink macro
+ *        (i.e. a GPIO toggle or a cycle counter read on the MCU).
+ *
+ *      Probes:
+ *      - process_message_entry (size, 0)           / process_message_return (responseType, result)
+ *      - command_entry         (command, 0)        / command_return         (command, result)
+ *      - send_entry            (socketId, dataSize)/ send_return            (socketId, sentSize)
+ *      - stuffing_entry        (srcSize, dstSize)  / stuffing_return        (consumed, stuffedSize)
+ */
+
+#if defined (RS9110_PROBES_USDT)
+#include <sys/sdt.h>
+#define RS9110_PROBE(name, arg1, arg2)      DTRACE_PROBE2(rs9110, name, (int) (arg1), (int) (arg2))
+#elif defined (RS9110_PROBE_SINK)
+#define RS9110_PROBE(name, arg1, arg2)      RS9110_PROBE_SINK(name, (arg1), (arg2))
+#else
+#define RS9110_PROBE(name, arg1, arg2)      ((void) 0)
+#endif /* RS9110_PROBES_USDT */
+
+#endif /* _RS9110_PROBES_H_ */
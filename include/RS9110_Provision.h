@@ -0,0 +1,131 @@
+#ifndef _RS9110_PROVISION_H_
+#define _RS9110_PROVISION_H_
+
+#include "RS9110_Pipeline.h"
+
+
+/*!
+ *  @brief  RS9110_Provision
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Boot-time provisioning that only writes the module's flash when the
+ *      stored configuration ("AT+RSI_CFGGET?") differs from the target:
+ *      - Stored, valid and equal: the module joins by itself after
+ *        "AT+RSI_BAND", so only that command is sent (#RESULT_AUTO_JOIN).
+ *      - Different: auto-join is disabled (if the stored configuration is
+ *        valid), the link is brought up and then saved and enabled again
+ *        (#RESULT_PROVISIONED).
+ *      - Auto-join never enabled (ERROR_MULTIPLE_1 to "AT+RSI_CFGGET?"): the
+ *        link is brought up, saved and enabled (#RESULT_PROVISIONED).
+ *
+ *      The bring-up is run by an #RS9110_Pipeline. #ProcessResponse must be
+ *      called after every #RS9110_UART::ProcessMessage and #Poll periodically.
+ */
+class RS9110_Provision
+{
+public:
+
+    /* ENUMS */
+    enum EState
+    {
+        STATE_IDLE = 0,
+        STATE_RUNNING,
+        STATE_DONE,
+        STATE_FAILED,
+        STATE_MAX
+    };
+
+    enum EResult
+    {
+        RESULT_NONE = 0,
+        RESULT_AUTO_JOIN,                           /*! @note Stored configuration used as is */
+        RESULT_PROVISIONED,                         /*! @note Brought up and stored */
+        RESULT_MAX
+    };
+
+    enum EField                                     /*! @note Bits of #GetDiff */
+    {
+        FIELD_VALID         = 0x0001,               /*! @note Missing, short or not valid */
+        FIELD_CHANNEL       = 0x0002,
+        FIELD_NW_TYPE       = 0x0004,
+        FIELD_SEC_MODE      = 0x0008,
+        FIELD_DATA_RATE     = 0x0010,
+        FIELD_POWER_LEVEL   = 0x0020,
+        FIELD_PSK           = 0x0040,
+        FIELD_SSID          = 0x0080,
+        FIELD_DHCP          = 0x0100,
+        FIELD_ADDRESS       = 0x0200,               /*! @note Address, subnet or gateway */
+        FIELD_WEP           = 0x0400                /*! @note Auth mode, index or keys */
+    };
+
+
+    /* CONSTANTS */
+    static const unsigned short CONFIG_VALID            = 0x0001;
+    static const unsigned char  FEATURE_PSK_EXT         = 0x08;     /*! @note Bit 3 of the feature select */
+    static const unsigned char  FEATURE_WEP_CONFIG      = 0x80;     /*! @note Bit 7 of the feature select */
+
+
+    /* METHODS */
+    RS9110_Provision (RS9110_UART &rs);
+    ~RS9110_Provision ();
+
+    void            SetTarget               (const RS9110_Pipeline::TTarget &target);
+    void            SetTimeout              (unsigned long timeoutMs);
+
+    bool            Start                   (unsigned long nowMs);
+    void            Stop                    ();
+
+    EState          Poll                    (unsigned long nowMs);
+    bool            ProcessResponse         (unsigned long nowMs);
+
+    EState          GetState                ();
+    EResult         GetResult               ();
+    unsigned int    GetDiff                 ();
+    RS9110_UART::ECommand   GetFailedCommand ();
+    RS9110_UART::EErrorCode GetErrorCode    ();
+    RS9110_Pipeline &       GetPipeline     ();
+
+    static unsigned int DiffStoredConfig    (const RS9110_Pipeline::TTarget &target, const unsigned char *config, int length);
+
+
+private:
+
+    /* ENUMS */
+    enum EPhase
+    {
+        PHASE_READ = 0,                             /*! @note AT+RSI_CFGGET? */
+        PHASE_DISABLE,                              /*! @note AT+RSI_CFGENABLE=0 */
+        PHASE_BRING_UP,                             /*! @note Pipeline */
+        PHASE_SAVE,                                 /*! @note AT+RSI_CFGSAVE */
+        PHASE_ENABLE,                               /*! @note AT+RSI_CFGENABLE=1 */
+        PHASE_MAX
+    };
+
+
+    /* METHODS */
+    void            StartPhase              (EPhase ePhase, unsigned long nowMs);
+    void            CheckPipeline           (unsigned long nowMs);
+    void            Fail                    (RS9110_UART::ECommand command, RS9110_UART::EErrorCode eErrorCode);
+    void            Decode                  ();
+
+    static RS9110_UART::ECommand CommandOf  (EPhase ePhase);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Pipeline _pipeline;
+    EState          _state;
+    EPhase          _phase;
+    EResult         _result;
+    bool            _isWaiting;             /*! @note Command sent, answer pending */
+    bool            _isEnabled;             /*! @note Auto-join set on the module */
+    unsigned int    _diff;
+    RS9110_UART::ECommand   _failedCommand;
+    RS9110_UART::EErrorCode _errorCode;
+    unsigned long   _timeoutMs;
+    unsigned long   _sentMs;
+};
+
+#endif /* _RS9110_PROVISION_H_ */
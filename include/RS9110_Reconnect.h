@@ -0,0 +1,120 @@
+#ifndef _RS9110_RECONNECT_H_
+#define _RS9110_RECONNECT_H_
+
+#include "RS9110_Pipeline.h"
+
+
+/*!
+ *  @brief  RS9110_Reconnect
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Brings the link up from a profile and, once it has been up, brings it
+ *      back after a loss with as few commands as possible:
+ *      - #LEVEL_FAST:   Scan on the known channel, Join, IPConfiguration.
+ *      - #LEVEL_REJOIN: as above plus network type and security.
+ *      - #LEVEL_FULL:   Band, Init and a scan on all channels first.
+ *
+ *      Every failure (ERROR or no answer in time) falls back to the next level;
+ *      #LEVEL_FULL is retried up to the maximum number of attempts. The steps
+ *      are run by an #RS9110_Pipeline, so the sockets of the profile are opened
+ *      again at every level.
+ *
+ *      The channel of the link is learned from "AT+RSI_NWPARAMS?" after a
+ *      bring-up with an unknown channel (2.4 GHz only, the 5 GHz channels are
+ *      given as #RS9110_UART::EChannel5GHz indexes). #ProcessResponse must be
+ *      called after every #RS9110_UART::ProcessMessage and #Poll periodically.
+ */
+class RS9110_Reconnect
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned long  DEFAULT_TIMEOUT_MS      = 10000;
+    static const unsigned long  DEFAULT_RETRY_DELAY_MS  = 1000;
+    static const unsigned char  DEFAULT_MAX_ATTEMPTS    = 3;
+
+
+    /* ENUMS */
+    enum ELevel
+    {
+        LEVEL_FAST = 0,
+        LEVEL_REJOIN,
+        LEVEL_FULL,
+        LEVEL_MAX
+    };
+
+    enum EState
+    {
+        STATE_IDLE = 0,
+        STATE_CONNECTING,
+        STATE_CONNECTED,
+        STATE_FAILED,
+        STATE_MAX
+    };
+
+
+    /* STRUCTURES */
+    typedef RS9110_Pipeline::TTarget TProfile;
+
+    struct TStats
+    {
+        unsigned long               numReconnects;                  /*! @note Link brought back */
+        unsigned long               numFailures;                    /*! @note All the attempts failed */
+        unsigned long               successes[LEVEL_MAX];           /*! @note Indexed by #ELevel */
+        unsigned long               lastReconnectMs;
+        unsigned long               maxReconnectMs;
+        unsigned long               totalReconnectMs;
+        unsigned char               lastLevel;                      /*! @note #ELevel of the last success */
+    };
+
+
+    /* METHODS */
+    RS9110_Reconnect (RS9110_UART &rs);
+    ~RS9110_Reconnect ();
+
+    void            SetProfile              (const TProfile &profile);
+    void            GetProfile              (TProfile &profile);
+    void            SetTiming               (unsigned long timeoutMs, unsigned long retryDelayMs, unsigned char maxAttempts);
+
+    bool            Connect                 (unsigned long nowMs);
+    bool            LinkLost                (unsigned long nowMs);
+    void            Stop                    ();
+
+    EState          Poll                    (unsigned long nowMs);
+    bool            ProcessResponse         (unsigned long nowMs);
+
+    EState          GetState                ();
+    ELevel          GetLevel                ();
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* METHODS */
+    void            StartAttempt            (ELevel eLevel, unsigned long nowMs);
+    void            CheckAttempt            (unsigned long nowMs);
+    void            Fail                    (unsigned long nowMs);
+    void            Completed               (unsigned long nowMs);
+
+    static unsigned int StepsOf             (ELevel eLevel);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Pipeline _pipeline;
+    TStats          _stats;
+    EState          _state;
+    ELevel          _level;
+    bool            _hasProfile;
+    bool            _hasConnected;
+    bool            _isReconnect;
+    unsigned char   _attempts;              /*! @note Failed #LEVEL_FULL attempts */
+    unsigned long   _retryDelayMs;
+    unsigned char   _maxAttempts;
+    unsigned long   _startMs;
+    unsigned long   _retryAtMs;
+};
+
+#endif /* _RS9110_RECONNECT_H_ */
@@ -0,0 +1,77 @@
+#ifndef _RS9110_RING_H_
+#define _RS9110_RING_H_
+
+#include <stddef.h>
+
+
+/*!
+ *  @brief  RS9110_Ring
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Single-producer single-consumer ring of variable-length records laid
+ *      over a memory region given by the caller (i.e. shared memory mapped by
+ *      two processes). The region starts with the indexes, so both sides
+ *      attach to the same bytes and nothing else is shared.
+ *
+ *      Records never wrap: the producer writes straight into the ring
+ *      (#Reserve, #Commit) and the consumer reads them in place (#Peek,
+ *      #Release), so no data is copied in or out of the ring by it.
+ *
+ *      The other side is not trusted: the size and the own index are kept
+ *      out of the region, and the index and records written by the other
+ *      side are checked before use. Once they are found wrong the ring is
+ *      corrupt (#IsCorrupt) and nothing more is read or written.
+ */
+class RS9110_Ring
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned short MAX_RECORD          = 0xFFFE;
+
+
+    /* METHODS */
+    RS9110_Ring ();
+    ~RS9110_Ring ();
+
+    bool            Attach                  (void *memory, unsigned long footprint, bool isInit);
+    void            Detach                  ();
+    bool            IsAttached              ();
+
+    char *          Reserve                 (unsigned short size);
+    void            Commit                  (unsigned short size);
+    bool            Write                   (const char *data, unsigned short size);
+
+    const char *    Peek                    (unsigned short &size);
+    void            Release                 ();
+
+    bool            IsEmpty                 ();
+    bool            IsCorrupt               ();
+
+    static unsigned long GetFootprint       (unsigned long dataSize);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TControl
+    {
+        volatile unsigned long  head;               /*! @note Next byte written (producer only) */
+        volatile unsigned long  tail;               /*! @note Next byte read (consumer only) */
+        unsigned long           size;               /*! @note Bytes of data */
+    };
+
+
+    /* VARIABLES */
+    TControl       *_control;
+    char           *_data;
+    unsigned long   _size;                  /*! @note Bytes of data (the copy in the region is not used) */
+    unsigned long   _head;                  /*! @note Next byte written (producer) */
+    unsigned long   _tail;                  /*! @note Next byte read (consumer) */
+    unsigned long   _reserved;              /*! @note Offset of the record reserved */
+    bool            _isCorrupt;             /*! @note Wrong index or record found */
+};
+
+#endif /* _RS9110_RING_H_ */
@@ -0,0 +1,109 @@
+#ifndef _RS9110_SCANTABLE_H_
+#define _RS9110_SCANTABLE_H_
+
+#include "RS9110_UART.h"
+
+
+/*!
+ *  @brief  RS9110_ScanTable
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Collects the results of #RS9110_UART::Scan and the following
+ *      #RS9110_UART::NextScan pages, joins them by position with the answers of
+ *      #RS9110_UART::GetMACOfAPs and #RS9110_UART::GetNetworkType and keeps every
+ *      access point seen in a table hashed by SSID and by BSSID.
+ *
+ *      An access point is identified by its BSSID once GetMACOfAPs has been
+ *      answered; until then it is identified by its SSID only. RSSI is the
+ *      absolute value in dBm as given by the module, so the lower the stronger.
+ *      #ProcessResponse must be called after every #RS9110_UART::ProcessMessage.
+ */
+class RS9110_ScanTable
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned int   MAX_ENTRIES     = RS9110_MAX_SCAN_ENTRIES;
+    static const unsigned int   HASH_BUCKETS    = RS9110_MAX_SCAN_ENTRIES;
+
+
+    /* STRUCTURES */
+    struct TAccessPoint
+    {
+        char            ssid[RS9110_UART::MAX_SSID_LEN + 1];
+        unsigned char   bssid[RS9110_UART::MAC_ADDRESS_LEN];
+        bool            hasBssid;
+        unsigned char   secMode;                    /*! @note #RS9110_UART::ESecurityModeResp */
+        unsigned char   nwType;                     /*! @note #RS9110_UART::ENetworkTypeResp (NW_TYPE_RSP_MAX if unknown) */
+        unsigned char   rssi;                       /*! @note -dBm */
+        unsigned long   lastSeenMs;
+    };
+
+
+    /* METHODS */
+    RS9110_ScanTable (RS9110_UART &rs);
+    ~RS9110_ScanTable ();
+
+    bool            ProcessResponse         (unsigned long nowMs);
+
+    unsigned int    GetNumAccessPoints      ();
+    bool            FindBySSID              (const char *ssid, TAccessPoint &accessPoint);
+    bool            FindByBSSID             (const unsigned char *bssid, TAccessPoint &accessPoint);
+    unsigned int    GetStrongest            (TAccessPoint *accessPoints, unsigned int k);
+
+    unsigned int    Expire                  (unsigned long nowMs, unsigned long maxAgeMs);
+    void            Clear                   ();
+
+
+private:
+
+    /* CONSTANTS */
+    static const unsigned short NONE        = 0xFFFF;
+
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        TAccessPoint    ap;
+        bool            isUsed;
+        bool            inBatch;
+        unsigned short  nextSsid;                   /*! @note Next in the free list when not used */
+        unsigned short  nextBssid;
+    };
+
+
+    /* METHODS */
+    void            AddScanResults          (const RS9110_UART::TScan *scan, unsigned int num, unsigned long nowMs);
+    void            JoinBSSIDs              (const RS9110_UART::TBssid *bssid, unsigned int num);
+    void            JoinNetworkTypes        (const RS9110_UART::TNetworkType *nwType, unsigned int num);
+    int             FindInBatch             (unsigned int position, const char *ssid, bool withoutBssid);
+
+    unsigned short  Allocate                ();
+    void            Release                 (unsigned short index);
+    void            LinkSSID                (unsigned short index);
+    void            UnlinkSSID              (unsigned short index);
+    void            LinkBSSID               (unsigned short index);
+    void            UnlinkBSSID             (unsigned short index);
+    unsigned short  LookupBSSID             (const unsigned char *bssid);
+
+    static unsigned long    HashSSID        (const char *ssid);
+    static unsigned long    HashBSSID       (const unsigned char *bssid);
+    static bool             IsStronger      (const TAccessPoint &ap1, const TAccessPoint &ap2);
+    static void             SiftUp          (TAccessPoint *heap, unsigned int pos);
+    static void             SiftDown        (TAccessPoint *heap, unsigned int size, unsigned int pos);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    TEntry          _entries[MAX_ENTRIES];
+    unsigned short  _bucketsSsid[HASH_BUCKETS];
+    unsigned short  _bucketsBssid[HASH_BUCKETS];
+    unsigned int    _numEntries;
+    unsigned short  _free;
+    unsigned short  _batch[MAX_ENTRIES];            /*! @note Entries of the current Scan/NextScan pages, in order */
+    unsigned int    _batchSize;
+};
+
+#endif /* _RS9110_SCANTABLE_H_ */
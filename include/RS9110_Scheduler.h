@@ -0,0 +1,118 @@
+#ifndef _RS9110_SCHEDULER_H_
+#define _RS9110_SCHEDULER_H_
+
+#include "RS9110_UART.h"
+
+
+/*!
+ *  @brief  RS9110_Scheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issues queued commands one at a time, the next one being picked from
+ *      the highest priority class with commands queued: power (i.e. the
+ *      KeepSleeping ACK of a SLEEP), then control, then bulk data. Every
+ *      command waits for the OK/ERROR of the previous one (the ACK of a SLEEP
+ *      is not answered, so it does not).
+ *
+ *      Bulk data is not starved: after a number of commands of the other
+ *      classes issued while bulk data was waiting (see #SetMaxBypass), the
+ *      next command is a bulk one unless an ACK is waiting.
+ *
+ *      A command is queued as a function issuing it thru the driver, i.e. a
+ *      call to #RS9110_UART::GetRSSI or #RS9110_UART::Send, returning false if
+ *      nothing was written; the context given with it must be kept until it is
+ *      issued.
+ *
+ *      The bulk engines (#RS9110_SendWindow, #RS9110_Coalescer,
+ *      #RS9110_Packer, #RS9110_FairQueue, #RS9110_SleepBatcher) given the
+ *      scheduler with their SetScheduler post their commands in the bulk
+ *      class, so queued control and power commands go between them. Their
+ *      ProcessResponse must still be called with this one's.
+ */
+class RS9110_Scheduler
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_JOBS            = RS9110_MAX_SCHEDULER_JOBS;
+    static const unsigned char  DEFAULT_MAX_BYPASS  = 4;
+
+
+    /* ENUMS */
+    enum EClass
+    {
+        CLASS_POWER = 0,                            /*! @note ACK of SLEEP, power mode */
+        CLASS_CONTROL,                              /*! @note Socket and network management, queries */
+        CLASS_BULK,                                 /*! @note AT+RSI_SND */
+        CLASS_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long   numIssued[CLASS_MAX];       /*! @note Indexed by #EClass */
+        unsigned long   numNotSent;                 /*! @note Issued but not written */
+        unsigned long   numPromoted;                /*! @note Bulk commands issued by the starvation guard */
+        unsigned long   numSleepAcks;               /*! @note ACKs queued by #SetAutoSleepAck */
+    };
+
+    typedef bool (*TIssue) (void *context, RS9110_UART &rs);
+
+
+    /* METHODS */
+    RS9110_Scheduler (RS9110_UART &rs);
+    ~RS9110_Scheduler ();
+
+    void            SetMaxBypass            (unsigned char maxBypass);
+    void            SetAutoSleepAck         (bool isEnabled);
+
+    bool            Post                    (EClass eClass, TIssue issue, void *context = NULL);
+    void            Expect                  (unsigned char numAnswers);
+    bool            ProcessResponse         ();
+    void            Abort                   ();
+
+    bool            IsIdle                  ();
+    unsigned char   GetNumQueued            (EClass eClass);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TJob
+    {
+        TIssue          issue;
+        void           *context;
+    };
+
+    struct TQueue
+    {
+        TJob            jobs[MAX_JOBS];
+        unsigned char   head;
+        unsigned char   count;
+    };
+
+
+    /* METHODS */
+    void            Dispatch                ();
+    int             NextClass               ();
+
+    static bool     IssueSleepAck           (void *context, RS9110_UART &rs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    TQueue          _queues[CLASS_MAX];
+    unsigned char   _maxBypass;
+    unsigned char   _numBypassed;           /*! @note Commands issued while bulk data was waiting */
+    unsigned char   _numPending;            /*! @note OK/ERROR still expected */
+    unsigned char   _numExpected;           /*! @note Set by #Expect from the issue function */
+    bool            _isExpected;
+    bool            _isAutoSleepAck;
+    TStats          _stats;
+};
+
+#endif /* _RS9110_SCHEDULER_H_ */
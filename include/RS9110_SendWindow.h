@@ -0,0 +1,143 @@
+#ifndef _RS9110_SEND_WINDOW_H_
+#define _RS9110_SEND_WINDOW_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+
+/*!
+ *  @brief  RS9110_SendWindow
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Keeps up to a window of "AT+RSI_SND" commands in flight per UDP socket
+ *      instead of waiting for the OK of every send. A TCP socket has one send
+ *      in flight at a time, so its stream is never reordered by a rejected
+ *      send; TCP sends are pipelined across sockets only. The module answers
+ *      the commands in the order they were written, so every OK/ERROR to an
+ *      "AT+RSI_SND" belongs to the oldest send in flight. A command of another
+ *      kind would be answered after the sends written before it, so none may
+ *      be written until #IsIdle unless both go through a #RS9110_Scheduler
+ *      (see #SetScheduler): the sends the windows allow are then written
+ *      together in its bulk class, and its next command waits for all their
+ *      answers.
+ *
+ *      Sends rejected with ERROR_SEND_DATA_TOO_FAST are sent again. The window
+ *      of every socket is adapted AIMD-style: it grows by one send per window of
+ *      OKs and is halved on the first rejection; no new send is written to that
+ *      socket until all its sends in flight are answered, then the rejected ones
+ *      go first, in order.
+ *
+ *      The data (and host) of every send belong to the caller until its
+ *      completion is notified. Sends larger than what fits in one command are
+ *      split, one command of each send in flight at a time.
+ */
+class RS9110_SendWindow
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_QUEUE           = RS9110_MAX_SEND_QUEUE;
+    static const unsigned char  MAX_WINDOW          = RS9110_MAX_SEND_WINDOW;
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long   numCommands;                /*! @note AT+RSI_SND written */
+        unsigned long   numAcked;                   /*! @note OK */
+        unsigned long   numThrottled;               /*! @note ERROR_SEND_DATA_TOO_FAST (sent again) */
+        unsigned long   numCompleted;               /*! @note Sends fully acknowledged */
+        unsigned long   numFailed;                  /*! @note Sends dropped */
+    };
+
+    typedef void (*TCompletion) (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                                 bool isSent, RS9110_UART::EErrorCode eErrorCode);
+
+
+    /* METHODS */
+    RS9110_SendWindow (RS9110_UART &rs, TCompletion completion = NULL, void *context = NULL);
+    ~RS9110_SendWindow ();
+
+    void            SetMaxWindow            (unsigned char maxWindow);
+    void            SetScheduler            (RS9110_Scheduler *scheduler);
+
+    bool            Submit                  (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort, const char *data, unsigned int dataSize);
+    bool            ProcessResponse         ();
+    void            Abort                   ();
+
+    bool            IsIdle                  ();
+    unsigned char   GetNumQueued            ();
+    unsigned char   GetWindow               (unsigned char socketId);
+    unsigned char   GetInFlight             (unsigned char socketId);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* CONSTANTS */
+    static const unsigned short WINDOW_ONE  = 16;   /*! @note Windows are kept in 1/16 of a send */
+
+
+    /* ENUMS */
+    enum EEntryState
+    {
+        ENTRY_FREE = 0,
+        ENTRY_QUEUED,
+        ENTRY_IN_FLIGHT,
+        ENTRY_COMPLETING,                           /*! @note Completion being notified */
+        ENTRY_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        const char     *data;
+        const char     *host;
+        unsigned int    size;
+        unsigned int    offset;                     /*! @note Bytes acknowledged */
+        unsigned int    chunk;                      /*! @note Bytes in flight */
+        unsigned long   seq;                        /*! @note Order of submission */
+        unsigned short  hostPort;
+        unsigned char   socketId;
+        unsigned char   socketType;                 /*! @note #RS9110_UART::ESocketType */
+        unsigned char   state;                      /*! @note #EEntryState */
+    };
+
+    struct TWindow
+    {
+        unsigned short  window;                     /*! @note In 1/16 of a send */
+        unsigned char   inFlight;
+        bool            isRecovering;               /*! @note Rejected, draining the sends in flight */
+    };
+
+
+    /* METHODS */
+    void            Pump                    ();
+    int             NextEntry               ();
+    bool            SendEntry               (unsigned char index);
+    void            Complete                (unsigned char index, bool isSent, RS9110_UART::EErrorCode eErrorCode);
+
+    static bool     IssueBulk               (void *context, RS9110_UART &rs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Scheduler   *_scheduler;             /*! @note NULL if sends are written at once */
+    TCompletion     _completion;
+    void           *_context;
+    TEntry          _entries[MAX_QUEUE];
+    TWindow         _windows[RS9110_UART::MAX_SOCKET_HANDLE];
+    unsigned char   _fifo[MAX_QUEUE];       /*! @note Entries in flight, oldest first */
+    unsigned char   _fifoHead;
+    unsigned char   _fifoCount;
+    unsigned char   _numQueued;
+    unsigned char   _maxWindow;
+    unsigned long   _nextSeq;
+    bool            _isPosted;              /*! @note #IssueBulk queued on the scheduler */
+    TStats          _stats;
+};
+
+#endif /* _RS9110_SEND_WINDOW_H_ */
@@ -0,0 +1,129 @@
+#ifndef _RS9110_SLEEP_BATCHER_H_
+#define _RS9110_SLEEP_BATCHER_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+
+/*!
+ *  @brief  RS9110_SleepBatcher
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Batches sends around the sleep cycles of power modes 1 and 2. While
+ *      the module sleeps, sends are held until its next wake window (the
+ *      SLEEP it sends when it wakes up); then they are all written in one
+ *      burst and the module is sent back to sleep with its ACK (KeepSleeping).
+ *      It is taken as asleep only once the ACK is written; an ACK that could
+ *      not be written is tried again by #Poll.
+ *
+ *      Every send has a latency bound: if it would be exceeded before the
+ *      next window, #Poll wakes the module and writes everything held; sends
+ *      with no latency allowed (0) are written at once. Without power save
+ *      (see #SetPowerSave) nothing is held.
+ *
+ *      Commands are written one at a time (each one waits for its OK/ERROR).
+ *      With a #RS9110_Scheduler (see #SetScheduler) the sends wait for their
+ *      turn in the bulk class and the ACK in the power class. The data (and
+ *      host) of every send belong to the caller until its completion is
+ *      notified.
+ */
+class RS9110_SleepBatcher
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_HELD            = RS9110_MAX_SLEEP_BATCH;
+
+
+    /* ENUMS */
+    enum EState
+    {
+        STATE_AWAKE = 0,                            /*! @note No power save, or woken up by the host */
+        STATE_WINDOW,                               /*! @note SLEEP received, writing the batch before the ACK */
+        STATE_ASLEEP,                               /*! @note ACK sent, holding sends */
+        STATE_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TStats
+    {
+        unsigned long   numWindows;                 /*! @note SLEEP received */
+        unsigned long   numAcks;                    /*! @note KeepSleeping written */
+        unsigned long   numWakes;                   /*! @note Module woken up to meet a latency bound */
+        unsigned long   numCompleted;               /*! @note Sends fully acknowledged */
+        unsigned long   numFailed;                  /*! @note Sends dropped */
+        unsigned char   maxBatch;                   /*! @note Most sends written in one window or wake */
+    };
+
+    typedef void (*TCompletion) (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                                 bool isSent, RS9110_UART::EErrorCode eErrorCode);
+
+
+    /* METHODS */
+    RS9110_SleepBatcher (RS9110_UART &rs, TCompletion completion = NULL, void *context = NULL);
+    ~RS9110_SleepBatcher ();
+
+    void            SetScheduler            (RS9110_Scheduler *scheduler);
+
+    void            SetPowerSave            (bool isEnabled);
+
+    bool            Submit                  (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort,
+                                             const char *data, unsigned int dataSize, unsigned long maxLatencyMs, unsigned long nowMs);
+    bool            ProcessResponse         ();
+    void            Poll                    (unsigned long nowMs);
+    void            Abort                   ();
+
+    EState          GetState                ();
+    bool            IsIdle                  ();
+    unsigned char   GetNumHeld              ();
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        const char     *data;
+        const char     *host;
+        unsigned int    size;
+        unsigned int    offset;                     /*! @note Bytes acknowledged */
+        unsigned long   deadlineMs;
+        unsigned short  hostPort;
+        unsigned char   socketId;
+        unsigned char   socketType;                 /*! @note #RS9110_UART::ESocketType */
+    };
+
+
+    /* METHODS */
+    void            Dispatch                ();
+    bool            SendHead                ();
+    bool            SendAck                 ();
+    void            Wake                    ();
+    void            Complete                (bool isSent, RS9110_UART::EErrorCode eErrorCode);
+
+    static bool     IssueSend               (void *context, RS9110_UART &rs);
+    static bool     IssueAck                (void *context, RS9110_UART &rs);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    RS9110_Scheduler   *_scheduler;             /*! @note NULL if commands are written at once */
+    TCompletion     _completion;
+    void           *_context;
+    TEntry          _entries[MAX_HELD];     /*! @note FIFO */
+    unsigned char   _head;
+    unsigned char   _count;
+    unsigned char   _batch;                 /*! @note Sends written in the current window or wake */
+    unsigned int    _chunk;                 /*! @note Bytes in flight */
+    bool            _isPowerSave;
+    bool            _isBusy;                /*! @note Waiting for an OK/ERROR */
+    bool            _isPosted;              /*! @note #IssueSend or #IssueAck queued on the scheduler */
+    EState          _eState;
+    TStats          _stats;
+};
+
+#endif /* _RS9110_SLEEP_BATCHER_H_ */
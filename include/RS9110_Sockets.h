@@ -0,0 +1,184 @@
+#ifndef _RS9110_SOCKETS_H_
+#define _RS9110_SOCKETS_H_
+
+#include "RS9110_UART.h"
+#include "RS9110_Ring.h"
+
+
+/*!
+ *  @brief  RS9110_Sockets
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      BSD-style sockets over the module: #Socket, #Bind, #Connect, #Listen,
+ *      #Send, #SendTo, #Recv, #RecvFrom, #Close and #Poll, all non-blocking.
+ *      Every descriptor maps onto one module handle once it is opened, and
+ *      keeps its own receive buffer filled from the READ frames, so the
+ *      application reads at its own pace.
+ *
+ *      Calls return the number of bytes (or 0) on success and a negative
+ *      #EResult otherwise. #Connect and #Listen return RESULT_IN_PROGRESS:
+ *      the open is written as soon as the module is free and #Poll reports
+ *      POLL_OUT once it is done (or POLL_ERR). Data is written straight from
+ *      the caller to AT+RSI_SND when the module is free (RESULT_WOULD_BLOCK
+ *      otherwise); an ERROR to it is reported by the next call on the
+ *      descriptor, like SO_ERROR. A STREAM descriptor whose receive buffer
+ *      overflows has lost part of its stream: it is reset, and its calls
+ *      return RESULT_RESET from then on.
+ *
+ *      The module has no accept: a listening TCP descriptor carries the
+ *      connection of its peer itself. DGRAM descriptors are opened by
+ *      #Connect (fixed peer) or #Listen (any peer, thru #SendTo).
+ *
+ *      #ProcessResponse must be called after every
+ *      #RS9110_UART::ProcessMessage, and the module must not be given other
+ *      commands meanwhile.
+ */
+class RS9110_Sockets
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned char  MAX_DESCRIPTORS     = RS9110_MAX_SOCKET_DESCRIPTORS;
+    static const unsigned int   RX_BUFFER_SIZE      = RS9110_MAX_SOCKET_RX_BUFFER;
+    static const unsigned char  MAX_ADDRESS_LEN     = 15;       /*! @note "255.255.255.255" */
+    static const unsigned short MIN_EPHEMERAL_PORT  = 40000;    /*! @note Local ports given by #Connect without #Bind */
+    static const unsigned short MAX_EPHEMERAL_PORT  = 49151;
+
+
+    /* ENUMS */
+    enum EType
+    {
+        TYPE_STREAM = 0,                            /*! @note TCP */
+        TYPE_DGRAM,                                 /*! @note UDP */
+        TYPE_MAX
+    };
+
+    enum EResult
+    {
+        RESULT_OK               = 0,
+        RESULT_WOULD_BLOCK      = -1,               /*! @note No data, or the module is busy */
+        RESULT_IN_PROGRESS      = -2,               /*! @note Open not answered yet */
+        RESULT_BAD_DESCRIPTOR   = -3,
+        RESULT_INVALID          = -4,               /*! @note Wrong argument or state */
+        RESULT_NOT_CONNECTED    = -5,
+        RESULT_RESET            = -6,               /*! @note Closed by the module or the peer */
+        RESULT_NO_DESCRIPTORS   = -7,
+        RESULT_MODULE_ERROR     = -8                /*! @note ERROR answer (see #GetErrorCode) */
+    };
+
+    enum EPollEvent
+    {
+        POLL_IN     = 0x01,                         /*! @note Data or end of stream to read */
+        POLL_OUT    = 0x02,                         /*! @note Open and the module free */
+        POLL_ERR    = 0x04,                         /*! @note Error pending */
+        POLL_HUP    = 0x08                          /*! @note Closed by the module or the peer */
+    };
+
+
+    /* STRUCTURES */
+    struct TPollFd
+    {
+        int                         fd;
+        unsigned char               events;         /*! @note #EPollEvent mask (POLL_ERR and POLL_HUP always reported) */
+        unsigned char               revents;
+    };
+
+    struct TStats
+    {
+        unsigned long               numCommands;
+        unsigned long               bytesSent;      /*! @note Acknowledged by the module */
+        unsigned long               bytesReceived;  /*! @note Stored in the receive buffers */
+        unsigned long               bytesDropped;   /*! @note Receive buffer full */
+        unsigned long               numSendErrors;
+    };
+
+
+    /* METHODS */
+    RS9110_Sockets (RS9110_UART &rs);
+    ~RS9110_Sockets ();
+
+    int             Socket                  (EType eType);
+    int             Bind                    (int fd, unsigned short localPort);
+    int             Connect                 (int fd, const char *host, unsigned short port);
+    int             Listen                  (int fd);
+    int             Send                    (int fd, const char *data, unsigned int size);
+    int             SendTo                  (int fd, const char *data, unsigned int size, const char *host, unsigned short port);
+    int             Recv                    (int fd, char *buffer, unsigned int size);
+    int             RecvFrom                (int fd, char *buffer, unsigned int size, char *host, unsigned short *port);
+    int             Close                   (int fd);
+    int             Poll                    (TPollFd *fds, unsigned int numFds);
+
+    bool            ProcessResponse         ();
+
+    unsigned char   GetHandle               (int fd);
+    RS9110_UART::EErrorCode GetErrorCode    (int fd);
+    void            GetStats                (TStats &stats);
+
+
+private:
+
+    /* ENUMS */
+    enum EState
+    {
+        STATE_FREE = 0,
+        STATE_CREATED,                              /*! @note Not opened yet */
+        STATE_OPENING,                              /*! @note Open queued or in flight */
+        STATE_OPEN,
+        STATE_CLOSED,                               /*! @note Closed by the module, or the open failed */
+        STATE_CLOSING                               /*! @note #Close called, waiting for the module */
+    };
+
+
+    /* STRUCTURES */
+    struct TDatagramHeader
+    {
+        unsigned char               address[RS9110_UART::NW_ADDRESS_LEN];
+        unsigned short              port;           /*! @note Host endian */
+    };
+
+    struct TDescriptor
+    {
+        unsigned char               state;          /*! @note #EState */
+        unsigned char               type;           /*! @note #EType */
+        bool                        isListening;
+        bool                        isQueued;       /*! @note Open or close waiting for the module */
+        unsigned char               handle;         /*! @note Module handle (0 if not open) */
+        unsigned short              localPort;
+        unsigned short              remotePort;
+        char                        host[MAX_ADDRESS_LEN + 1];
+        int                         error;          /*! @note #EResult pending (RESULT_OK if none) */
+        bool                        isReset;        /*! @note STREAM data dropped, nothing more read */
+        RS9110_UART::EErrorCode     errorCode;
+        RS9110_Ring                 rxRing;
+        unsigned short              rxOffset;       /*! @note Bytes of the head record already read (STREAM) */
+        unsigned long               rxMemory[(RX_BUFFER_SIZE + (4 * sizeof(unsigned long))) / sizeof(unsigned long)];
+    };
+
+
+    /* METHODS */
+    TDescriptor *   Lookup                  (int fd);
+    int             TakeError               (TDescriptor &descriptor);
+    int             Write                   (TDescriptor &descriptor, const char *data, unsigned int size, const char *host, unsigned short port);
+    void            Dispatch                ();
+    bool            Issue                   (unsigned char fd);
+    void            Answered                (bool isOk);
+    void            Received                ();
+    void            Closed                  ();
+    void            Release                 (TDescriptor &descriptor, EState eState);
+
+
+    /* VARIABLES */
+    RS9110_UART    &_rs;
+    TDescriptor     _descriptors[MAX_DESCRIPTORS];
+    signed char     _owners[RS9110_UART::MAX_SOCKET_HANDLE];    /*! @note Descriptor per handle - 1 (-1 if none) */
+    RS9110_UART::ECommand   _command;       /*! @note Waiting for its OK/ERROR (CMD_MAX if none) */
+    unsigned char   _fd;                    /*! @note Descriptor of that command */
+    unsigned int    _chunk;                 /*! @note Payload of the AT+RSI_SND in flight */
+    unsigned char   _next;                  /*! @note Next descriptor served by the round robin */
+    unsigned short  _nextPort;              /*! @note Next ephemeral local port */
+    TStats          _stats;
+};
+
+#endif /* _RS9110_SOCKETS_H_ */
@@ -0,0 +1,71 @@
+#ifndef _RS9110_TRACE_H_
+#define _RS9110_TRACE_H_
+
+#include "IPersistor.h"
+#include "RS9110_Config.h"
+
+#include <stddef.h>
+
+
+class RS9110_Trace
+{
+public:
+
+    /* CONSTANTS */
+    static const unsigned int   MAX_TRACE_ENTRIES   = RS9110_MAX_TRACE_ENTRIES;     /*! @note Must be a power of two */
+
+
+    /* ENUMS */
+    enum EEvent
+    {
+        EVENT_TX = 0,
+        EVENT_RX,
+        EVENT_RX_REJECTED,
+        EVENT_MAX
+    };
+
+
+    /* STRUCTURES */
+    struct TEntry
+    {
+        unsigned long long  timestamp;              /*! @note Microseconds, monotonic */
+        unsigned char       event;                  /*! @note #EEvent */
+        unsigned char       type;                   /*! @note #RS9110_UART::ECommand (TX) or #RS9110_UART::EResponseType (RX) */
+        unsigned char       socketId;               /*! @note 0 if not related to a socket */
+        unsigned char       errorCode;              /*! @note #RS9110_UART::EErrorCode */
+        unsigned short      length;
+    };
+
+    typedef unsigned long long (*TClock) ();
+
+
+    /* METHODS */
+    RS9110_Trace (TClock clock = NULL);
+    ~RS9110_Trace ();
+
+    void            Record                  (EEvent eEvent, unsigned char type, unsigned char socketId, unsigned short length, unsigned char errorCode = 0);
+    void            Clear                   ();
+
+    unsigned int    GetNumEntries           ();
+    bool            GetEntry                (unsigned int index, TEntry &entry);
+
+    bool            ExportChromeTrace       (IPersistor *persistor);
+
+    static unsigned long long MonotonicClock ();
+
+
+private:
+
+    /* METHODS */
+    bool WriteCommand           (IPersistor *persistor, const TEntry &command, const TEntry *response, unsigned long long base);
+    bool WriteInstant           (IPersistor *persistor, const TEntry &entry, unsigned long long base);
+    bool WriteString            (IPersistor *persistor, const char *str);
+
+
+    /* VARIABLES */
+    TClock                  _clock;
+    TEntry                  _entries[MAX_TRACE_ENTRIES];
+    volatile unsigned long  _head;
+};
+
+#endif /* _RS9110_TRACE_H_ */
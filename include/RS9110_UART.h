@@ -2,6 +2,7 @@
 #define _RS9110_UART_H_
 
 #include "IPersistor.h"
+#include "RS9110_Config.h"
 
 #if defined (WIN32)
 #include <stddef.h>
@@ -10,7 +11,12 @@
 #endif /* WIN32 */
 
 
-class RS9110_UART
+class RS9110_Trace;
+class RS9110_Pacer;
+class RS9110_Energy;
+
+
+class RS9110_UART_Base
 {
 public:
 
@@ -22,18 +28,19 @@ public:
     static const unsigned short MAX_SEND_DATA_SIZE_TCP  = 1460;
 	static const unsigned char	MIN_SOCKET_HANDLE		= 1;
 	static const unsigned char	MAX_SOCKET_HANDLE		= 7;
-	static const unsigned char	MAX_NUMBER_SOCKETS	    = 7;
+	static const unsigned char	MAX_NUMBER_SOCKETS	    = RS9110_MAX_NUMBER_SOCKETS;
 	static const unsigned short	MIN_TCP_SOCKET_PORT		= 1024;
 	static const unsigned short MAX_TCP_SOCKET_PORT		= 49151;
-	static const unsigned int	MAX_BUFFER_SIZE			= 1520;
-    static const unsigned char  MAX_NUM_SCAN_RESULTS    = 10;
+	static const unsigned int	MAX_BUFFER_SIZE			= RS9110_MAX_BUFFER_SIZE;
+    static const unsigned char  MAX_NUM_SCAN_RESULTS    = RS9110_MAX_NUM_SCAN_RESULTS;
     static const unsigned char  MAC_ADDRESS_LEN         = 6;
     static const unsigned char  NW_ADDRESS_LEN          = 4;
     static const unsigned int   MAX_SLEEP_TIME_MS		= 10000;
     static const unsigned int   MAX_NUM_WEP_KEYS		= 3;
     static const unsigned int   MAX_LEN_WEP_KEYS		= 32;
     static const unsigned int   MAX_LEN_DOMAIN_NAME		= 134;
-    static const unsigned int   MAX_DNSGET_RESP		    = 10;
+    static const unsigned int   MAX_DNSGET_RESP		    = RS9110_MAX_DNSGET_RESP;
+    static const unsigned char  MAX_ERROR_COUNTERS      = RS9110_MAX_ERROR_COUNTERS;
 
 
     /* ENUMS */
@@ -321,6 +328,14 @@ public:
 		PW_MODE_MAX
 	};
 
+    enum ERefresh
+    {
+        REFRESH_SENT = 0,                           /*! @note Cache invalidated, command sent */
+        REFRESH_CACHED,                             /*! @note Cache still valid, nothing sent */
+        REFRESH_NOT_SENT,                           /*! @note Cache invalidated, persistor error */
+        REFRESH_MAX
+    };
+
 
     /* STRUCTURES */
 #pragma pack(push, 1)
@@ -563,15 +578,52 @@ public:
     };
 #pragma pack(pop)
 
+    struct TErrorCounter
+    {
+        unsigned char   code;                       /*! @note #EErrorCode */
+        unsigned long   count;
+    };
 
-    /* METHODS */
-    RS9110_UART (IPersistor *persistor);
-    ~RS9110_UART ();
+    struct TCounters
+    {
+        unsigned long   frames[RESP_TYPE_MAX];      /*! @note Indexed by #EResponseType */
+        unsigned long   rejectedFrames;             /*! @note #ProcessMessage returned false */
+        unsigned long   bytesWritten;
+        unsigned long   bytesRead;
+        unsigned long   payloadBytes;               /*! @note Before byte stuffing */
+        unsigned long   stuffedBytes;               /*! @note After byte stuffing */
+        TErrorCounter   errors[MAX_ERROR_COUNTERS]; /*! @note In order of first occurrence */
+        unsigned long   otherErrors;                /*! @note Codes not fitting in errors[] */
+    };
+
+    struct TSocketInfo
+    {
+        unsigned char   id;                         /*! @note 0 if the handle is not open */
+        unsigned char   type;                       /*! @note #ESocketType */
+        unsigned short  localPort;                  /*! @note Host endian */
+        unsigned short  remotePort;                 /*! @note Host endian (0 if unknown) */
+        unsigned char   remoteAddress[NW_ADDRESS_LEN];
+    };
 
-    void            SetPersistor            (IPersistor *persistor);
-    IPersistor *    GetPersistor            ();
 
-    bool            ProcessMessage          (char *message, int size);
+    /* METHODS */
+    RS9110_UART_Base ();
+    ~RS9110_UART_Base ();
+
+    void            SetTrace                (RS9110_Trace *trace);
+    RS9110_Trace *  GetTrace                ();
+    void            SetPacer                (RS9110_Pacer *pacer);
+    RS9110_Pacer *  GetPacer                ();
+    void            SetEnergyMeter          (RS9110_Energy *energy);
+    RS9110_Energy * GetEnergyMeter          ();
+
+    static const char * GetCommandName      (ECommand command);
+    static const char * GetResponseName     (EResponseType responseType);
+    static bool         ParseAddress        (const char *string, unsigned char *address);
+    static unsigned int GetMaxSendSize      (unsigned char socketId, ESocketType socketType, const char *hostIpAddr = NULL, unsigned short hostPort = 0);
+    static unsigned int GetStuffedSize      (const char *source, unsigned int srcSize);
+    static unsigned int FitByteStuffing     (unsigned int &dstSize, const char *source, unsigned int srcSize);
+    static int          Format              (char *destination, unsigned int size, const char *format, ...);
 
     ECommand        GetLastCommand          ();
     void *          GetResponse             (int &responseLength);
@@ -580,6 +632,103 @@ public:
     EResponseType   GetResponseType         ();
     EErrorCode      GetErrorCode            ();
 
+    void            GetCounters             (TCounters &counters);
+    unsigned long   GetErrorCount           (EErrorCode eErrorCode);
+    void            ResetCounters           ();
+
+    bool            GetSocketInfo           (unsigned char socketId, TSocketInfo &socketInfo);
+    bool            IsSocketOpen            (unsigned char socketId);
+    unsigned char   GetOpenSockets          ();
+    unsigned char   GetNumOpenSockets       ();
+    void            ResetSocketTable        ();
+
+    bool            IsNetworkParametersCached   ();
+    const void *    GetCachedNetworkParameters  (int &length);
+    void            InvalidateNetworkParameters ();
+
+    bool            IsRetryPending          ();
+
+
+protected:
+
+    /* METHODS */
+    bool ParseMessage           (char *message, int size);
+    void SetLastCommand         (ECommand command, bool isTransmitted = false);
+    void ProcessResponseType    (const char *message);
+    bool IsValidSocketId        (unsigned char socketId);
+    bool IsValidLocalTcpPort    (unsigned short port);
+    void Transmitted            (ECommand command, unsigned int size, unsigned char socketId);
+    void Pace                   (ECommand command);
+    bool IsRetryDue             ();
+    void AbandonRetry           ();
+    void CountError             (EErrorCode eErrorCode);
+    void ExpectSocket           (ESocketType socketType, const char *hostIpAddr, unsigned short remotePort, unsigned short localPort);
+    void ExpectClose            (unsigned char socketId);
+    void UpdateSocketTable      (const char *message, int size);
+    void CloseSocketEntry       (unsigned char socketId);
+    TSocketInfo * FindSocketEntry   (unsigned char socketId);
+    void UpdateNetworkParameters ();
+
+    static bool         IsValidString       (const char *string, int maxLen = -1);
+    static unsigned int SendByteStuffing    (char *destination, unsigned int &dstSize, const char *source, unsigned int srcSize);
+
+
+    /* CONSTANTS */
+    static const char * const COMMAND[];
+    static const char * const NETWORK_TYPE_STR[];
+    static const char * const CMD_END;
+    static const unsigned char CMD_END_LEN;
+    static const unsigned int  MAX_NW_PARAMS_LEN = sizeof(TNetworkParamsExt) + ((MAX_SOCKET_HANDLE - MAX_NUMBER_SOCKETS) * sizeof(TSocketDetails)) + NW_ADDRESS_LEN;   /*! @note Every handle open and the DNS server */
+
+
+    /* VARIABLES */
+    RS9110_Trace   *_trace;
+    RS9110_Pacer   *_pacer;
+    RS9110_Energy  *_energy;
+    char            _buffer[MAX_BUFFER_SIZE];
+    int             _responseLength;
+    ECommand        _lastCommand;
+    EResponseType   _responseType;
+    EErrorCode      _errorCode;
+    TCounters       _counters;
+    TSocketInfo     _sockets[MAX_NUMBER_SOCKETS];   /*! @note Free if id is 0 */
+    TSocketInfo     _pendingSocket;                 /*! @note Open/close waiting for its OK */
+    unsigned char   _openSockets;                   /*! @note Bit (handle - 1) set if open */
+    unsigned char   _numOpenSockets;
+    char            _nwParams[MAX_NW_PARAMS_LEN];           /*! @note Last AT+RSI_NWPARAMS? answer */
+    int             _nwParamsLength;                        /*! @note 0 if invalidated */
+    unsigned int    _commandLength;                 /*! @note Last command still in _buffer (0 if overwritten) */
+    unsigned char   _commandSocketId;
+    bool            _isRetryPending;                /*! @note Rejected for pacing, to be written again */
+};
+
+
+/*!
+ *  @brief  RS9110_UART_T
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Command encoder. The persistor is a compile-time policy: any class with a
+ *      "bool Write (unsigned char *data, unsigned int size)" method, so the call
+ *      can be inlined together with the encoding. #RS9110_UART uses #IPersistor
+ *      (virtual Write) and keeps the persistor swappable at runtime.
+ */
+template <class TPersistor>
+class RS9110_UART_T : public RS9110_UART_Base
+{
+public:
+
+    /* METHODS */
+    RS9110_UART_T (TPersistor *persistor);
+    ~RS9110_UART_T ();
+
+    void            SetPersistor            (TPersistor *persistor);
+    TPersistor *    GetPersistor            ();
+
+    bool            ProcessMessage          (char *message, int size);
+    bool            Poll                    ();
+
     bool            Band                    (EBand eBand);
     bool            Init                    ();
     bool            GetNumScanResults       ();
@@ -591,7 +740,9 @@ public:
     bool            GetNetworkType          ();
     bool            SetNetworkType          (ENetworkType eNWType, EIBSSType eIBSSType = IBSS_TYPE_MAX, unsigned char channel = 0);
     bool            PSK                     (const char *psk);
+#if RS9110_FEATURE_WEP
     bool            SetWEPKeys              (unsigned char keyIndex, char *key2, char *key3, char *key4);
+#endif /* RS9110_FEATURE_WEP */
     bool            AuthMode                (EAuthMode eAuthMode);
     bool            Join                    (const char *ssid, ETxRate eTxRate, ETxPower eTxPower);
 	bool            Disassociate            ();
@@ -610,10 +761,13 @@ public:
     bool            GetSocketStatus         (unsigned char socketId);
 	bool            CloseSocket             (unsigned char socketId);
     unsigned int    Send                    (unsigned char socketId, ESocketType socketType, const char *hostIpAddr, unsigned short hostPort, const char *data, unsigned int dataSize);
+#if RS9110_FEATURE_DNS
     bool            GetDNS                  (const char *domainName);
+#endif /* RS9110_FEATURE_DNS */
 
 	bool            GetFirmwareVersion      ();
     bool            GetNetworkParameters    ();
+    ERefresh        RefreshNetworkParameters ();
     bool            Reset                   ();
     bool            GetMACAddress           ();
     bool            GetRSSI                 ();
@@ -626,22 +780,20 @@ public:
 private:
 
     /* METHODS */
-    void SetLastCommand         (ECommand command, bool isTransmitted = false);
-    void ProcessResponseType    (const char *message);
-    bool IsValidSocketId        (unsigned char socketId);
-    bool IsValidLocalTcpPort    (unsigned short port);
     bool GenericCommand         (ECommand command);
     bool GenericCommandInt      (ECommand command, int value);
     bool GenericCommandStr      (ECommand command, const char *str);
+    bool WriteBuffer            (ECommand command, unsigned int size, unsigned char socketId = 0);
 
 
     /* VARIABLES */
-    IPersistor     *_persistor;
-    char            _buffer[MAX_BUFFER_SIZE];
-    int             _responseLength;
-    ECommand        _lastCommand;
-    EResponseType   _responseType;
-    EErrorCode      _errorCode;
+    TPersistor     *_persistor;
 };
 
+
+typedef RS9110_UART_T<IPersistor> RS9110_UART;
+
+
+#include "RS9110_UART_Impl.h"
+
 #endif /* _RS9110_UART_H_ */
@@ -0,0 +1,1379 @@
+#ifndef _RS9110_UART_IMPL_H_
+#define _RS9110_UART_IMPL_H_
+
+#include "RS9110_Probes.h"
+
+#include <string.h>
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  persistor   - Pointer to the persistor
+ *
+ */
+template <class TPersistor>
+RS9110_UART_T<TPersistor>::RS9110_UART_T (TPersistor *persistor)
+  : _persistor(persistor)
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+template <class TPersistor>
+RS9110_UART_T<TPersistor>::~RS9110_UART_T ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetPersistor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Set which persistor must be used (only Write method).
+ *
+ *  @param[in]  persistor   - Pointer to the persistor
+ *
+ */
+template <class TPersistor>
+void RS9110_UART_T<TPersistor>::SetPersistor (TPersistor *persistor)
+{
+    if(persistor != NULL)
+    {
+        _persistor = persistor;
+    }
+}
+
+
+/*!
+ *  @brief  GetPersistor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Get which persistor is used.
+ *
+ *  @return Pointer to the persistor
+ *
+ */
+template <class TPersistor>
+TPersistor * RS9110_UART_T<TPersistor>::GetPersistor ()
+{
+    return _persistor;
+}
+
+
+/*!
+ *  @brief  ProcessMessage
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Processes an incoming message (see #RS9110_UART_Base::ParseMessage).
+ *      With a pacer set, a command rejected with ERROR_CMD_TOO_FAST is reported
+ *      as no answer yet (RESP_TYPE_MAX) and written again by #Poll, so the
+ *      parsing never waits for the pacer.
+ *
+ *  @param[in]  message - Incoming message
+ *  @param[in]  size    - Length of the message
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Malformed message
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::ProcessMessage (char *message, int size)
+{
+    return ParseMessage(message, size);
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes again the command rejected for pacing once the pacer allows it,
+ *      without waiting. To be called periodically while #IsRetryPending.
+ *
+ *      If it cannot be written (i.e. the persistor fails or an incoming message
+ *      has overwritten it), the rejection is reported as its answer: the
+ *      response type is RESP_TYPE_ERROR and the error code ERROR_CMD_TOO_FAST,
+ *      to be processed as if returned by #ProcessMessage.
+ *
+ *  @return bool
+ *  @retval true    - OK (written again, not due yet or nothing pending)
+ *  @retval false   - Not written again, rejection reported
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Poll ()
+{
+    ECommand command = _lastCommand;
+
+
+    if(IsRetryDue() == false)
+    {
+        return true;
+    }
+
+    _isRetryPending = false;
+
+    if((_commandLength > 0) && (WriteBuffer(command, _commandLength, _commandSocketId) == true))
+    {
+        SetLastCommand(command, true);
+        return true;
+    }
+
+    AbandonRetry();
+
+    return false;
+}
+
+
+/*!
+ *  @brief  Band
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the band in which the module has to be configured.
+ *
+ *  @param[in]  eBand     - Type of band
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Band (EBand eBand)
+{
+    if(eBand >= BAND_MAX)
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    return GenericCommandInt(CMD_BAND, eBand);
+}
+
+
+/*!
+ *  @brief  Init
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command programs the RS9110-N-11-2X module's Baseband and RF components.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Init ()
+{
+    return GenericCommand(CMD_INIT);
+}
+
+
+/*!
+ *  @brief  GetNumScanResults
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is to get the number of networks already scanned by the "Scan"
+ *      or "Next Scan" command.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetNumScanResults ()
+{
+    return GenericCommand(CMD_GET_SCAN_RESULTS);
+}
+
+
+/*!
+ *  @brief  SetNumScanResults
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the number of scan results the module returns for
+ *      the Scan and NextScan commands.
+ *
+ *  @param[in]  value   - Number of scan results (Min = 1, Max = #MAX_NUM_SCAN_RESULTS)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SetNumScanResults (unsigned char value)
+{
+    if((value <= 0) || (value > MAX_NUM_SCAN_RESULTS))
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    return GenericCommandInt(CMD_SET_SCAN_RESULTS, value);
+}
+
+
+/*!
+ *  @brief  PassiveScan
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command enables the module to scan for networks without sending a probe
+ *      request from the module.
+ *
+ *  @param[in]  channels    - Channels passive scan is to be done
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::PassiveScan (unsigned int channels)
+{
+    return GenericCommandInt(CMD_PASSIVE_SCAN, (unsigned int) channels);
+}
+
+
+/*!
+ *  @brief  Scan
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command scans in all the channels or the channel specified in the command #RS9110_UART::SetNumScanResults.
+ *
+ *  @param[in]  channels    - Channel Number
+ *  @param[in]  ssid        - SSID (Max length is #MAX_SSID_LEN)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Scan (unsigned char channel, const char *ssid)
+{
+    bool bRtn;
+
+
+    if(IsValidString(ssid) == false)
+    {
+        Format(_buffer, sizeof(_buffer), "%s%d%s", COMMAND[CMD_SCAN], channel, CMD_END);
+    }
+    else
+    {
+        if(strlen(ssid) > MAX_SSID_LEN)
+        {
+            SetLastCommand(CMD_MAX);
+            return false;
+        }
+
+        Format(_buffer, sizeof(_buffer), "%s%d,%s%s", COMMAND[CMD_SCAN], channel, ssid, CMD_END);
+    }
+
+    bRtn = WriteBuffer(CMD_SCAN, strlen(_buffer));
+
+    SetLastCommand(CMD_SCAN, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  NextScan
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command returns the number of results (set by the command RS9110_UART::SetNumScanResults)
+ *      obtained by #RS9110_UART::Scan.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::NextScan ()
+{
+    return GenericCommand(CMD_NEXT_SCAN);
+}
+
+
+/*!
+ *  @brief  GetMACOfAPs
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command returns the MAC addresses of the Access Points returned by the "Scan" command.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetMACOfAPs ()
+{
+    return GenericCommand(CMD_GET_MAC_APS);
+}
+
+
+/*!
+ *  @brief  GetNetworkType
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command returns the network type of the scanned AP.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetNetworkType ()
+{
+    return GenericCommand(CMD_GET_NETWORK_TYPE);
+}
+
+
+/*!
+ *  @brief  SetNetworkType
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the type of network the module wishes to join.
+ *
+ *  @param[in]  eNWType     - Type of the network to be created/joined
+ *  @param[in]  eIBSSType   - Type of IBSS network (optional if #NW_TYPE_INFRASTRUCTURE is chosen)
+ *  @param[in]  channel     - Channel in which the IBSS network has to be created (optional if #NW_TYPE_INFRASTRUCTURE is chosen)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SetNetworkType (ENetworkType eNWType, EIBSSType eIBSSType, unsigned char channel)
+{
+    bool bRtn;
+
+
+    switch(eNWType)
+    {
+        case NW_TYPE_INFRASTRUCTURE:
+            Format(_buffer, sizeof(_buffer), "%s%s%s", COMMAND[CMD_SET_NETWORK_TYPE], NETWORK_TYPE_STR[eNWType], CMD_END);
+        break;
+
+#if RS9110_FEATURE_IBSS
+        case NW_TYPE_IBSS:
+        case NW_TYPE_IBSS_SEC:
+            Format(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_SET_NETWORK_TYPE], NETWORK_TYPE_STR[eNWType], eIBSSType, channel, CMD_END);
+        break;
+#endif /* RS9110_FEATURE_IBSS */
+
+        default:
+            SetLastCommand(CMD_MAX);
+            return false;
+        break;
+    }
+
+    bRtn = WriteBuffer(CMD_SET_NETWORK_TYPE, strlen(_buffer));
+
+    SetLastCommand(CMD_SET_NETWORK_TYPE, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  PSK
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the PSK (Pre Shared Key) that is used for creating
+ *      secured access.
+ *
+ *  @param[in]  psk - Preshared key (Max length is #MAX_PSK_LEN)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::PSK (const char *psk)
+{
+    if(IsValidString(psk, MAX_PSK_LEN_EXT) == false)
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    return GenericCommandStr(CMD_PSK, psk);
+}
+
+
+#if RS9110_FEATURE_WEP
+/*!
+ *  @brief  SetWEPKeys
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is issued to supply WEP keys to the module, if the AP is in WEP mode.
+ *
+ *  @param[in]  keyIndex    - Key index to be used to select the key.
+ *  @param[in]  key2        - 2nd key of AP
+ *  @param[in]  key3        - 3rd key of AP
+ *  @param[in]  key4        - 4th key of AP
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SetWEPKeys (unsigned char keyIndex, char *key2, char *key3, char *key4)
+{
+    bool bRtn;
+
+
+    if((keyIndex > 3) ||
+       (IsValidString(key2, MAX_PSK_LEN) == false) ||
+       (IsValidString(key3, MAX_PSK_LEN) == false) ||
+       (IsValidString(key4, MAX_PSK_LEN) == false))
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    Format(_buffer, sizeof(_buffer), "%s%d,%s,%s,%s%s", COMMAND[CMD_WEP_KEYS], keyIndex, key2, key3, key4, CMD_END);
+
+    bRtn = WriteBuffer(CMD_WEP_KEYS, strlen(_buffer));
+
+    SetLastCommand(CMD_WEP_KEYS, bRtn);
+
+    return bRtn;
+}
+#endif /* RS9110_FEATURE_WEP */
+
+
+/*!
+ *  @brief  AuthMode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the mode of security during the WLAN connection setup.
+ *
+ *  @param[in]  eAuthMode   - Authentication mode
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::AuthMode (EAuthMode eAuthMode)
+{
+    return GenericCommandInt(CMD_AUTH_MODE, eAuthMode);
+}
+
+
+/*!
+ *  @brief  Join
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to join a network.
+ *
+ *  @param[in]  ssid        - SSID
+ *  @param[in]  eTxRate     - Transmit Power level
+ *  @param[in]  eTxPower    - Rate at which the data has to be transmitted
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Join (const char *ssid, ETxRate eTxRate, ETxPower eTxPower)
+{
+    bool bRtn;
+
+
+    if(IsValidString(ssid, MAX_SSID_LEN) == false)
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    Format(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_JOIN], ssid, eTxRate, eTxPower, CMD_END);
+
+    bRtn = WriteBuffer(CMD_JOIN, strlen(_buffer));
+
+    SetLastCommand(CMD_JOIN, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  Disassociate
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is issued to request the module to disassociate (disconnect)
+ *      from an Access Point.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Disassociate ()
+{
+    return GenericCommand(CMD_DISASSOCIATE);
+}
+
+
+/*!
+ *  @brief  PowerMode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the power mode.
+ *
+ *  @param[in]  powerMode   - Power mode
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::PowerMode (EPowerMode powerMode)
+{
+	return GenericCommandInt(CMD_POWER_MODE, powerMode);
+}
+
+
+/*!
+ *  @brief  KeepSleeping
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This is not actually a command. This is an ACK to the module which must be sent as a response to the
+ *      #RESP_TYPE_SLEEP response type. Sending this message back to the module makes it go to sleep again.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::KeepSleeping ()
+{
+	return GenericCommand(CMD_KEEP_SLEEPING);
+}
+
+
+/*!
+ *  @brief  SetSleepTimer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the sleep timer which is used in Power Mode 1 when
+ *      the module has not established the Wi-Fi connection.
+ *
+ *  @param[in]  milliseconds    - Time the module goes to sleep
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SetSleepTimer (unsigned int milliseconds)
+{
+	if((milliseconds == 0) || (milliseconds > MAX_SLEEP_TIME_MS))
+	{
+		//_lastCommand = CMD_MAX;
+        //_responseType = RESP_TYPE_MAX;
+        SetLastCommand(CMD_MAX);
+		return false;
+	}
+
+	return GenericCommandInt(CMD_SLEEP_TIMER, milliseconds);
+}
+
+
+/*!
+ *  @brief  SetFeatureSelect
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to enable some configurable features.
+ *
+ *  @param[in]  value   - Configurable features
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SetFeatureSelect (TFeatureSelect value)
+{
+    return GenericCommandInt(CMD_FEATURE_SELECT, (unsigned int) value.value);
+}
+
+
+/*!
+ *  @brief  IPConfiguration
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command configures the IP address, subnet mask and default gateway of the TCP/IP stack.
+ *
+ *  @param[in]  eDHCPMode   - IP address in manual or DHCP mode
+ *  @param[in]  ipAddr      - IP address in dotted decimal format
+ *  @param[in]  subNetwork  - Subnet mask in dotted decimal format
+ *  @param[in]  gateway     - Gateway in the dotted decimal format
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::IPConfiguration (EDHCPMode eDHCPMode, const char *ipAddr, const char *subNetwork, const char *gateway)
+{
+	bool bRtn = false;
+
+
+	switch(eDHCPMode)
+	{
+		case DHCP_MANUAL:
+			if((IsValidString(ipAddr)		== false) ||
+			   (IsValidString(subNetwork)	== false) ||
+			   (IsValidString(gateway)		== false))
+			{
+                SetLastCommand(CMD_MAX);
+			}
+			else
+			{
+				Format(_buffer, sizeof(_buffer), "%s%d,%s,%s,%s%s", COMMAND[CMD_IP_CONF], eDHCPMode, ipAddr, subNetwork, gateway, CMD_END);
+
+				bRtn = WriteBuffer(CMD_IP_CONF, strlen(_buffer));
+
+                SetLastCommand(CMD_IP_CONF, bRtn);
+			}
+		break;
+
+		case DHCP_DHCP:
+			Format(_buffer, sizeof(_buffer), "%s%d,0,0%s", COMMAND[CMD_IP_CONF], eDHCPMode, CMD_END);
+
+			bRtn = WriteBuffer(CMD_IP_CONF, strlen(_buffer));
+
+            SetLastCommand(CMD_IP_CONF, bRtn);
+		break;
+
+		default:
+            SetLastCommand(CMD_MAX);
+		break;
+	}
+
+	return bRtn;
+}
+
+
+/*!
+ *  @brief  OpenTcpSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command opens a client TCP socket and attempts to connect it to the
+ *      specified "port" on a server defined by "host".
+ *
+ *  @param[in]  hostIpAddr  - Destination IP Address of the target server
+ *  @param[in]  targetPort  - The target port
+ *  @param[in]  localPort   - Local Port on the RS9110-N-11-2X module (allowed range #MIN_TCP_SOCKET_PORT to #MAX_TCP_SOCKET_PORT)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::OpenTcpSocket (const char *hostIpAddr, unsigned short targetPort, unsigned short localPort)
+{
+	bool bRtn;
+
+
+	if((IsValidString(hostIpAddr) == false) || (IsValidLocalTcpPort(localPort) == false))
+	{
+        SetLastCommand(CMD_MAX);
+		return false;
+	}
+
+	Format(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_OPEN_TCP_SOCKET], hostIpAddr, targetPort, localPort, CMD_END);
+
+    ExpectSocket(SOCKET_TCP, hostIpAddr, targetPort, localPort);
+
+	bRtn = WriteBuffer(CMD_OPEN_TCP_SOCKET, strlen(_buffer));
+
+    SetLastCommand(CMD_OPEN_TCP_SOCKET, bRtn);
+
+	return bRtn;
+}
+
+
+/*!
+ *  @brief  OpenListeningUdpSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command opens a User Datagram Protocol (UDP) socket and binds to a specified port.
+ *
+ *  @param[in]  localPort   - Local port on the module
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::OpenListeningUdpSocket (unsigned short localPort)
+{
+    ExpectSocket(SOCKET_LUDP, NULL, 0, localPort);
+
+    return GenericCommandInt(CMD_OPEN_LUDP_SOCKET, localPort);
+}
+
+
+/*!
+ *  @brief  OpenUdpSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command opens a User Datagram Protocol (UDP) socket and links to the
+ *      remote system's specific host and port address.
+ *
+ *  @param[in]  hostIpAddr   - IP Address of the Target server
+ *  @param[in]  targetPort   - Target port (0 to 65535)
+ *  @param[in]  localPort    - Local port on the module
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::OpenUdpSocket (const char *hostIpAddr, unsigned short targetPort, unsigned short localPort)
+{
+	bool bRtn;
+
+
+	if(IsValidString(hostIpAddr) == false)
+	{
+        SetLastCommand(CMD_MAX);
+		return false;
+	}
+
+	Format(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_OPEN_UDP_SOCKET], hostIpAddr, targetPort, localPort, CMD_END);
+
+    ExpectSocket(SOCKET_UDP, hostIpAddr, targetPort, localPort);
+
+	bRtn = WriteBuffer(CMD_OPEN_UDP_SOCKET, strlen(_buffer));
+
+    SetLastCommand(CMD_OPEN_UDP_SOCKET, bRtn);
+
+	return bRtn;
+}
+
+
+/*!
+ *  @brief  OpenListeningTcpSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This commands opens a TCP listening socket on the local IP address and
+ *      the specified "port".
+ *
+ *  @param[in]  localPort    - Local port on the module
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::OpenListeningTcpSocket (unsigned short localPort)
+{
+    ExpectSocket(SOCKET_LTCP, NULL, 0, localPort);
+
+    return GenericCommandInt(CMD_OPEN_LTCP_SOCKET, localPort);
+}
+
+
+/*!
+ *  @brief  GetSocketStatus
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command retrieves handles of active socket connections established
+ *      through the listening socket.
+ *
+ *  @param[in]  socketId    - TCP listening socket handle for an already open listening socket in the module
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetSocketStatus (unsigned char socketId)
+{
+	if(IsValidSocketId(socketId) == false)
+	{
+        SetLastCommand(CMD_MAX);
+		return false;
+	}
+
+    return GenericCommandInt(CMD_GET_SOCKET_STATUS, socketId);
+}
+
+
+/*!
+ *  @brief  CloseSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command closes a TCP/UDP socket in the module.
+ *
+ *  @param[in]  socketId    - Socket handle of an already open socket
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::CloseSocket (unsigned char socketId)
+{
+	if(IsValidSocketId(socketId) == false)
+	{
+        SetLastCommand(CMD_MAX);
+		return false;
+	}
+
+    ExpectClose(socketId);
+
+    return GenericCommandInt(CMD_CLOSE_SOCKET, socketId);
+}
+
+
+/*!
+ *  @brief  CloseSocket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command sends a byte stream to the socket specified by the socket handle.
+ *
+ *  @param[in]  socketId    - Socket handle of an already open socket
+ *  @param[in]  socketType  - Socket type
+ *  @param[in]  hostIpAddr  - Destination IP Address
+ *  @param[in]  hostPort    - Destination Port
+ *  @param[in]  data        - Byte stream
+ *  @param[in]  dataSize    - Length of the byte stream
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+unsigned int RS9110_UART_T<TPersistor>::Send (unsigned char socketId, ESocketType socketType, const char *hostIpAddr, unsigned short hostPort, const char *data, unsigned int dataSize)
+{
+	bool         bRtn;
+    unsigned int sendLen;
+    unsigned int maxDataLen;
+
+
+    RS9110_PROBE(send_entry, socketId, dataSize);
+
+    if(IsValidSocketId(socketId) == false)
+    {
+        SetLastCommand(CMD_MAX);
+        return 0;
+    }
+
+    /* Command and Parameters */
+    switch(socketType)
+    {
+        case SOCKET_TCP:
+            Format(_buffer, sizeof(_buffer), "%s%d,0,0,0,", COMMAND[CMD_SEND_DATA], socketId);
+            maxDataLen = MAX_SEND_DATA_SIZE_TCP;
+        break;
+
+        case SOCKET_UDP:
+            Format(_buffer, sizeof(_buffer), "%s%d,0,%s,%d,", COMMAND[CMD_SEND_DATA], socketId, hostIpAddr, hostPort);
+            maxDataLen = MAX_SEND_DATA_SIZE_UDP;
+        break;
+
+        default:
+            SetLastCommand(CMD_MAX);
+            return 0;
+        break;
+    }
+
+    /* Fill data after byte stuffing */
+    unsigned int hdr = strlen(_buffer);
+
+    if(maxDataLen > (sizeof(_buffer) - hdr - CMD_END_LEN))
+    {
+        maxDataLen = sizeof(_buffer) - hdr - CMD_END_LEN;
+    }
+
+    unsigned int destSize = maxDataLen;
+    sendLen = SendByteStuffing(&_buffer[hdr], destSize, data, dataSize);
+
+    _counters.payloadBytes += sendLen;
+    _counters.stuffedBytes += destSize;
+
+    /* End of Command */
+    Format(&_buffer[hdr + destSize], (sizeof(_buffer) - hdr - destSize), "%s", CMD_END);
+
+	bRtn = WriteBuffer(CMD_SEND_DATA, hdr + destSize + strlen(CMD_END), socketId);
+
+    SetLastCommand(CMD_SEND_DATA, bRtn);
+
+    RS9110_PROBE(send_return, socketId, sendLen);
+
+    return sendLen;
+}
+
+
+#if RS9110_FEATURE_DNS
+/*!
+ *  @brief  GetDNS
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to send the domain name of a website to the module
+ *      to resolve the IP address.
+ *
+ *  @param[in]  domainName  - Domain name of the target website
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetDNS (const char *domainName)
+{
+    if(IsValidString(domainName) == false)
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    return GenericCommandStr(CMD_GET_DNS, domainName);
+}
+#endif /* RS9110_FEATURE_DNS */
+
+
+/*!
+ *  @brief  GetFirmwareVersion
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to retrieve the firmware version in the module.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetFirmwareVersion ()
+{
+    return GenericCommand(CMD_FW_VERSION);
+}
+
+
+/*!
+ *  @brief  GetNetworkParameters
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to retrieve the WLAN connection and IP parameters.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetNetworkParameters ()
+{
+    return GenericCommand(CMD_GET_NETWORK_PARAMS);
+}
+
+
+/*!
+ *  @brief  RefreshNetworkParameters
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends #GetNetworkParameters only if the cached parameters were invalidated
+ *      (see #RS9110_UART_Base::GetCachedNetworkParameters). Nothing is sent while
+ *      the cache is still valid.
+ *
+ *  @return ERefresh
+ *  @retval REFRESH_SENT        - Command sent, wait for its answer
+ *  @retval REFRESH_CACHED      - Cache still valid, nothing sent
+ *  @retval REFRESH_NOT_SENT    - Command not sent
+ */
+template <class TPersistor>
+RS9110_UART_Base::ERefresh RS9110_UART_T<TPersistor>::RefreshNetworkParameters ()
+{
+    if(IsNetworkParametersCached() == true)
+    {
+        return REFRESH_CACHED;
+    }
+
+    return ((GenericCommand(CMD_GET_NETWORK_PARAMS) == true) ? REFRESH_SENT : REFRESH_NOT_SENT);
+}
+
+
+/*!
+ *  @brief  Reset
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command acts as a software reset to the module.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Reset ()
+{
+    return GenericCommand(CMD_RESET);
+}
+
+
+/*!
+ *  @brief  GetMACAddress
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to retrieve the MAC address of the module.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetMACAddress ()
+{
+    return GenericCommand(CMD_GET_MAC);
+}
+
+
+/*!
+ *  @brief  GetRSSI
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to get the signal strength of the Access Point or
+ *      network that the module is connected to.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetRSSI ()
+{
+    return GenericCommand(CMD_GET_RSSI);
+}
+
+
+/*!
+ *  @brief  SaveConfiguration
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to save the parameters of an access point to internal memory.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::SaveConfiguration ()
+{
+    return GenericCommand(CMD_SAVE_CONFIG);
+}
+
+
+/*!
+ *  @brief  Configuration
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to enable or disable the feature of automatic joining
+ *      to a pre-configured Access Point on power up.
+ *
+ *  @pram[in]   eConfig - Enable/Disable the auto-join
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::Configuration (EConfiguration eConfig)
+{
+    if(eConfig >= CONFIG_MAX)
+    {
+        SetLastCommand(CMD_MAX);
+        return false;
+    }
+
+    return GenericCommandInt(CMD_ENABLE_CONFIG, eConfig);
+}
+
+
+/*!
+ *  @brief  GetConfiguration
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      This command is used to get the configuration values that have been
+ *      stored in the module's memory.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument or command not sent
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GetConfiguration ()
+{
+    return GenericCommand(CMD_GET_CONFIG);
+}
+
+
+/*!
+ *  @brief  IsValidSocketId
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether the socket is within the valid values
+ *      (Min = #MIN_SOCKET_HANDLE, Max = #MAX_SOCKET_HANDLE).
+ *
+ *  @param[in]  socketId - Socket handle
+ *
+ *  @return bool
+ */
+inline bool RS9110_UART_Base::IsValidSocketId (unsigned char socketId)
+{
+    return ((socketId >= MIN_SOCKET_HANDLE) && (socketId <= MAX_SOCKET_HANDLE));
+}
+
+
+/*!
+ *  @brief  IsValidLocalTcpPort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether the TCP port is within the valid values
+ *      (Min = #MIN_TCP_SOCKET_PORT, Max = #MAX_TCP_SOCKET_PORT).
+ *
+ *  @param[in]  port - TCP port
+ *
+ *  @return bool
+ */
+inline bool RS9110_UART_Base::IsValidLocalTcpPort (unsigned short port)
+{
+    return ((port >= MIN_TCP_SOCKET_PORT) && (port <= MAX_TCP_SOCKET_PORT));
+}
+
+
+/*!
+ *  @brief  GenericCommand
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Generic command sender. No arguments are nedded.
+ *      i.e. "AT+RSI_RESET\r\n"
+ *
+ *  @param[in]  command - Command type
+ *
+ *  @return bool
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GenericCommand (ECommand command)
+{
+    bool bRtn;
+
+
+    RS9110_PROBE(command_entry, command, 0);
+
+    Format(_buffer, sizeof(_buffer), "%s%s", COMMAND[command], CMD_END);
+
+    bRtn = WriteBuffer(command, strlen(_buffer));
+
+    SetLastCommand(command, bRtn);
+
+    RS9110_PROBE(command_return, command, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  GenericCommandInt
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Generic command sender. Integer value is needed as argument.
+ *      i.e. "AT+RSI_CTCP=1\r\n"
+ *
+ *  @param[in]  command - Command type
+ *  @param[in]  value   - Integer value
+ *
+ *  @return bool
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GenericCommandInt (ECommand command, int value)
+{
+    bool bRtn;
+
+
+    RS9110_PROBE(command_entry, command, 0);
+
+    Format(_buffer, sizeof(_buffer), "%s%d%s", COMMAND[command], value, CMD_END);
+
+    bRtn = WriteBuffer(command, strlen(_buffer), (((command == CMD_CLOSE_SOCKET) || (command == CMD_GET_SOCKET_STATUS)) ? (unsigned char) value : 0));
+
+    SetLastCommand(command, bRtn);
+
+    RS9110_PROBE(command_return, command, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  GenericCommandStr
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Generic command sender. Byte array (zero-ended) is needed as argument.
+ *      i.e. "AT+RSI_CTCP=1\r\n"
+ *
+ *  @param[in]  command - Command type
+ *  @param[in]  str     - String argument
+ *
+ *  @return bool
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::GenericCommandStr (ECommand command, const char *str)
+{
+    bool bRtn;
+
+
+    RS9110_PROBE(command_entry, command, 0);
+
+    Format(_buffer, sizeof(_buffer), "%s%s%s", COMMAND[command], str, CMD_END);
+
+    bRtn = WriteBuffer(command, strlen(_buffer));
+
+    SetLastCommand(command, bRtn);
+
+    RS9110_PROBE(command_return, command, bRtn);
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  WriteBuffer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the command stored in the internal buffer thru the persistor.
+ *
+ *  @param[in]  command     - Command type
+ *  @param[in]  size        - Length of the command (in bytes)
+ *  @param[in]  socketId    - Socket handle the command refers to (0 if none)
+ *
+ *  @return bool
+ */
+template <class TPersistor>
+bool RS9110_UART_T<TPersistor>::WriteBuffer (ECommand command, unsigned int size, unsigned char socketId)
+{
+    bool bRtn;
+
+
+    Pace(command);
+
+    bRtn = _persistor->Write((unsigned char *) _buffer, size);
+
+    if(bRtn == true)
+    {
+        Transmitted(command, size, socketId);
+    }
+
+    return bRtn;
+}
+
+#endif /* _RS9110_UART_IMPL_H_ */
@@ -0,0 +1,31 @@
+#ifndef _RS9110_BARRIER_H_
+#define _RS9110_BARRIER_H_
+
+/*!
+ *  @brief  RS9110_MEMORY_BARRIER
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Private to the library. Full memory barrier for the lock-free single
+ *      producer structures (#RS9110_Ring, #RS9110_Trace, #RS9110_Fleet): the
+ *      producer issues it after filling an entry and before publishing its
+ *      index, a reader after reading the index and again before checking it
+ *      was not overwritten. The UC3 core has a single in-order hart, so there
+ *      it only keeps the compiler from moving the accesses across it.
+ */
+#if defined (WIN32)
+#include <windows.h>
+#define RS9110_MEMORY_BARRIER()     MemoryBarrier()
+#elif defined (AVR32) && defined (__GNUC__)
+#define RS9110_MEMORY_BARRIER()     __asm__ __volatile__("" ::: "memory")
+#elif defined (__GNUC__)
+#define RS9110_MEMORY_BARRIER()     __sync_synchronize()
+#elif defined (__IAR_SYSTEMS_ICC__)
+#include <intrinsics.h>
+#define RS9110_MEMORY_BARRIER()     __memory_barrier()
+#else
+#error "RS9110_MEMORY_BARRIER is not defined for this compiler"
+#endif /* WIN32 */
+
+#endif /* _RS9110_BARRIER_H_ */
@@ -0,0 +1,784 @@
+#include "RS9110_Bond.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckBondLinks         [((RS9110_MAX_BOND_LINKS > 0) && (RS9110_MAX_BOND_LINKS <= 255)) ? 1 : -1];
+typedef char CheckBondChunk         [((RS9110_MAX_BOND_CHUNK > 0) && (RS9110_MAX_BOND_CHUNK <= 65535)) ? 1 : -1];
+typedef char CheckBondReorder       [((RS9110_MAX_BOND_REORDER > 0) && (RS9110_MAX_BOND_REORDER <= 255)) ? 1 : -1];
+
+/* One chunk in flight per link: the others may all arrive before the oldest */
+typedef char CheckBondWindow        [(RS9110_MAX_BOND_REORDER >= (RS9110_MAX_BOND_LINKS - 1)) ? 1 : -1];
+
+static const unsigned long  SEQ_MASK    = 0xFFFFFFFFUL;
+
+
+/*!
+ *  @brief  GetHeader
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Decodes the header of a chunk.
+ *
+ *  @param[in]  header  - First #RS9110_Bond::HEADER_LEN bytes of the chunk
+ *  @param[out] seq     - Sequence number
+ *
+ *  @return Length of the payload
+ */
+static unsigned short GetHeader (const char *header, unsigned long &seq)
+{
+    const unsigned char *tmp = (const unsigned char *) header;
+
+
+    seq = (((unsigned long) tmp[0]) << 24) | (((unsigned long) tmp[1]) << 16) |
+          (((unsigned long) tmp[2]) << 8)  | ((unsigned long) tmp[3]);
+
+    return (unsigned short) ((tmp[4] << 8) | tmp[5]);
+}
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  deliver - Called with every chunk received, in sequence (may be NULL)
+ *  @param[in]  context - Given back to deliver
+ *
+ */
+RS9110_Bond::RS9110_Bond (TDeliver deliver, void *context)
+  : _deliver(deliver),
+    _context(context),
+    _numLinks(0),
+    _txSeq(0),
+    _rxSeq(0),
+    _numHeld(0),
+    _isBroken(false)
+{
+    memset(_links, 0, sizeof(_links));
+    memset(_slots, 0, sizeof(_slots));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Bond::~RS9110_Bond ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  AddLink
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds a module and its TCP socket (already open) to the bond.
+ *
+ *  @param[in]  rs          - Driver of the module
+ *  @param[in]  socketId    - TCP socket to the peer
+ *
+ *  @return int
+ *  @retval >=0 - Index of the link
+ *  @retval -1  - Bond full, wrong socket or a chunk does not fit in one command
+ */
+int RS9110_Bond::AddLink (RS9110_UART &rs, unsigned char socketId)
+{
+    TLink *link;
+
+
+    if((_numLinks >= MAX_LINKS) || (socketId == 0) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return -1;
+    }
+
+    /* A chunk must fit whole even if every byte is stuffed */
+    if((2 * (HEADER_LEN + MAX_CHUNK)) > RS9110_UART::GetMaxSendSize(socketId, RS9110_UART::SOCKET_TCP))
+    {
+        return -1;
+    }
+
+    link = &_links[_numLinks];
+    memset(link, 0, sizeof(*link));
+    link->rs            = &rs;
+    link->socketId      = socketId;
+    link->stats.isUp    = true;
+
+    return _numLinks++;
+}
+
+
+/*!
+ *  @brief  SetLinkUp
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a link up (i.e. once its socket is open again) or down. The
+ *      throughput observed is kept.
+ *
+ *  @param[in]  link    - Index of the link
+ *  @param[in]  isUp    - Up
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong link
+ */
+bool RS9110_Bond::SetLinkUp (unsigned char link, bool isUp)
+{
+    if(link >= _numLinks)
+    {
+        return false;
+    }
+
+    _links[link].stats.isUp = isUp;
+    _links[link].rxSize     = 0;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Write
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Cuts the data in chunks and sends each one on the link expected to
+ *      finish it first. Stops when that link is still busy: the rest must be
+ *      written again once some chunk is acknowledged.
+ *
+ *  @param[in]  data        - Data to send
+ *  @param[in]  dataSize    - Size of the data (in bytes)
+ *  @param[in]  nowMs       - Current time (ms)
+ *
+ *  @return Bytes accepted
+ */
+unsigned int RS9110_Bond::Write (const char *data, unsigned int dataSize, unsigned long nowMs)
+{
+    unsigned int accepted = 0;
+
+
+    if((data == NULL) || (Retry(nowMs) == false))
+    {
+        return 0;
+    }
+
+    while(accepted < dataSize)
+    {
+        unsigned int    size    = dataSize - accepted;
+        int             link;
+        unsigned char  *header;
+
+
+        if(size > MAX_CHUNK)
+        {
+            size = MAX_CHUNK;
+        }
+
+        link = PickLink(HEADER_LEN + size, nowMs);
+
+        if((link < 0) || (_links[link].stats.isBusy == true))
+        {
+            break;
+        }
+
+        header = (unsigned char *) _links[link].stage;
+        header[0] = (unsigned char) (_txSeq >> 24);
+        header[1] = (unsigned char) (_txSeq >> 16);
+        header[2] = (unsigned char) (_txSeq >> 8);
+        header[3] = (unsigned char) _txSeq;
+        header[4] = (unsigned char) (size >> 8);
+        header[5] = (unsigned char) size;
+        memcpy(&_links[link].stage[HEADER_LEN], &data[accepted], size);
+
+        _links[link].stageSize = (unsigned short) (HEADER_LEN + size);
+        _txSeq = (_txSeq + 1) & SEQ_MASK;
+        accepted += size;
+
+        if(SendStage((unsigned char) link, nowMs) == false)
+        {
+            /* Owned by the bond now: sent again on another link */
+            Retry(nowMs);
+            break;
+        }
+    }
+
+    return accepted;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Handles the message just parsed by the driver of a link: the OK/ERROR
+ *      of a chunk, the READ frames of its socket and its CLOSE.
+ *
+ *  @param[in]  link    - Index of the link
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Message handled by the bond
+ *  @retval false   - Not related to the bond
+ */
+bool RS9110_Bond::ProcessResponse (unsigned char link, unsigned long nowMs)
+{
+    TLink *pLink;
+
+
+    if(link >= _numLinks)
+    {
+        return false;
+    }
+
+    pLink = &_links[link];
+
+    switch(pLink->rs->GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if((pLink->stats.isBusy == false) || (pLink->rs->GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+            {
+                return false;
+            }
+
+            pLink->stats.isBusy = false;
+
+            if(pLink->rs->GetResponseType() == RS9110_UART::RESP_TYPE_OK)
+            {
+                unsigned long elapsedMs = nowMs - pLink->sentMs;
+                unsigned long sample;
+
+
+                if(elapsedMs == 0)
+                {
+                    elapsedMs = 1;
+                }
+
+                sample = (pLink->stageSize * 1000UL) / elapsedMs;
+
+                pLink->stats.bytesPerSecond = ((pLink->stats.bytesPerSecond == 0) ?
+                                               sample : (((3 * pLink->stats.bytesPerSecond) + sample) / 4));
+                pLink->stats.numChunks++;
+                pLink->stats.numBytes += pLink->stageSize - HEADER_LEN;
+            }
+            else
+            {
+                /* Paced by the module: the link itself may take it again */
+                if(pLink->rs->GetErrorCode() != RS9110_UART::ERROR_SEND_DATA_TOO_FAST)
+                {
+                    pLink->stats.isUp = false;
+                }
+
+                pLink->isRetry = true;
+                pLink->stats.numFailed++;
+            }
+
+            Retry(nowMs);
+        break;
+
+        case RS9110_UART::RESP_TYPE_READ:
+        {
+            RS9110_UART::TReadTCP readTCP;
+
+
+            pLink->rs->Read(readTCP);
+
+            if(readTCP.socketId != pLink->socketId)
+            {
+                return false;
+            }
+
+            Receive(*pLink, readTCP.data, readTCP.size);
+        }
+        break;
+
+        case RS9110_UART::RESP_TYPE_CLOSE:
+            if(pLink->rs->IsSocketOpen(pLink->socketId) == true)
+            {
+                return false;
+            }
+
+            pLink->stats.isUp   = false;
+            pLink->rxSize       = 0;
+
+            /* Its OK will never come */
+            if(pLink->stats.isBusy == true)
+            {
+                pLink->stats.isBusy = false;
+                pLink->isRetry      = true;
+                pLink->stats.numFailed++;
+            }
+
+            Retry(nowMs);
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends again the chunks of failed links, once some link is free.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Bond::Poll (unsigned long nowMs)
+{
+    Retry(nowMs);
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether every chunk written has been acknowledged.
+ *
+ *  @return bool
+ */
+bool RS9110_Bond::IsIdle ()
+{
+    for(unsigned char i = 0; i < _numLinks; i++)
+    {
+        if((_links[i].stats.isBusy == true) || (_links[i].isRetry == true))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  IsBroken
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether a chunk of the received stream was lost (no room to
+ *      hold it). Nothing is delivered any more.
+ *
+ *  @return bool
+ */
+bool RS9110_Bond::IsBroken ()
+{
+    return _isBroken;
+}
+
+
+/*!
+ *  @brief  GetLinkStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the counters of a link.
+ *
+ *  @param[in]  link    - Index of the link
+ *  @param[out] stats   - Copy of the counters
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong link
+ */
+bool RS9110_Bond::GetLinkStats (unsigned char link, TLinkStats &stats)
+{
+    if(link >= _numLinks)
+    {
+        return false;
+    }
+
+    memcpy(&stats, &_links[link].stats, sizeof(stats));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the counters of the receiving side.
+ *
+ *  @param[out] stats   - Copy of the counters
+ */
+void RS9110_Bond::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  PickLink
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Picks the link expected to finish a chunk first: what it has in flight
+ *      plus the chunk, at the throughput observed. Free links with no
+ *      throughput known yet are tried first.
+ *
+ *  @param[in]  size    - Size of the chunk (with its header)
+ *  @param[in]  nowMs   - Current time (ms)
+ *  @param[in]  self    - Link holding the chunk to send again (-1 if none)
+ *
+ *  @return Index of the link (-1 if none up), which may still be busy
+ */
+int RS9110_Bond::PickLink (unsigned int size, unsigned long nowMs, int self)
+{
+    int             best        = -1;
+    unsigned long   bestUs      = 0;
+
+
+    for(unsigned char i = 0; i < _numLinks; i++)
+    {
+        const TLink    &link    = _links[i];
+        unsigned long   rate    = link.stats.bytesPerSecond;
+        unsigned long   finishUs;
+
+
+        if((link.stats.isUp == false) || ((link.isRetry == true) && (i != self)))
+        {
+            continue;
+        }
+
+        if(rate == 0)
+        {
+            /* Not measured yet: try it when free, never wait for it */
+            finishUs = ((link.stats.isBusy == true) ? 0xFFFFFFFFUL : 0);
+        }
+        else
+        {
+            finishUs = (size * 1000000UL) / rate;
+
+            if(link.stats.isBusy == true)
+            {
+                unsigned long expectedUs    = (link.stageSize * 1000000UL) / rate;
+                unsigned long elapsedUs     = (nowMs - link.sentMs) * 1000UL;
+
+
+                if(expectedUs > elapsedUs)
+                {
+                    finishUs += expectedUs - elapsedUs;
+                }
+            }
+        }
+
+        /* Free links win the ties */
+        if((best < 0) || (finishUs < bestUs) ||
+           ((finishUs == bestUs) && (_links[best].stats.isBusy == true) && (link.stats.isBusy == false)))
+        {
+            best    = i;
+            bestUs  = finishUs;
+        }
+    }
+
+    return best;
+}
+
+
+/*!
+ *  @brief  SendStage
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the chunk staged in a link. On failure the link is taken down
+ *      and the chunk left to #Retry.
+ *
+ *  @param[in]  link    - Index of the link
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ */
+bool RS9110_Bond::SendStage (unsigned char link, unsigned long nowMs)
+{
+    TLink &entry = _links[link];
+
+
+    if(entry.rs->Send(entry.socketId, RS9110_UART::SOCKET_TCP, NULL, 0, entry.stage, entry.stageSize) == entry.stageSize)
+    {
+        entry.stats.isBusy  = true;
+        entry.isRetry       = false;
+        entry.sentMs        = nowMs;
+
+        return true;
+    }
+
+    entry.stats.isUp    = false;
+    entry.isRetry       = true;
+    entry.stats.numFailed++;
+
+    return false;
+}
+
+
+/*!
+ *  @brief  Retry
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves the chunks of failed links to free links and sends them again.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Nothing left to send again
+ *  @retval false   - Some chunk still waits for a link
+ */
+bool RS9110_Bond::Retry (unsigned long nowMs)
+{
+    bool isDone = true;
+
+
+    for(unsigned char i = 0; i < _numLinks; i++)
+    {
+        int target;
+
+
+        if(_links[i].isRetry == false)
+        {
+            continue;
+        }
+
+        target = PickLink(_links[i].stageSize, nowMs, i);
+
+        if((target < 0) || (_links[target].stats.isBusy == true))
+        {
+            isDone = false;
+            continue;
+        }
+
+        if(target != i)
+        {
+            memcpy(_links[target].stage, _links[i].stage, _links[i].stageSize);
+            _links[target].stageSize = _links[i].stageSize;
+            _links[i].isRetry = false;
+        }
+
+        if(SendStage((unsigned char) target, nowMs) == false)
+        {
+            isDone = false;
+        }
+    }
+
+    return isDone;
+}
+
+
+/*!
+ *  @brief  Receive
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reassembles the chunks carried by the READ frames of a link. Whole
+ *      chunks within a frame are delivered straight from the driver's buffer.
+ *
+ *  @param[in]  link    - Link
+ *  @param[in]  data    - Data of the READ frame
+ *  @param[in]  size    - Size of the data (in bytes)
+ */
+void RS9110_Bond::Receive (TLink &link, const char *data, unsigned int size)
+{
+    unsigned long   seq;
+    unsigned short  length;
+
+
+    while(size > 0)
+    {
+        if((link.rxSize == 0) && (size >= HEADER_LEN))
+        {
+            length = GetHeader(data, seq);
+
+            if(length > MAX_CHUNK)
+            {
+                _stats.numCorrupt++;
+                return;
+            }
+
+            if(size >= (unsigned int) (HEADER_LEN + length))
+            {
+                Deliver(seq, &data[HEADER_LEN], length);
+
+                data += HEADER_LEN + length;
+                size -= HEADER_LEN + length;
+                continue;
+            }
+        }
+
+        /* Split across frames: gather the header, then the payload */
+        {
+            unsigned int need = ((link.rxSize < HEADER_LEN) ?
+                                 (HEADER_LEN - link.rxSize) :
+                                 (HEADER_LEN + GetHeader(link.rx, seq) - link.rxSize));
+
+
+            if(need > size)
+            {
+                need = size;
+            }
+
+            memcpy(&link.rx[link.rxSize], data, need);
+            link.rxSize += (unsigned short) need;
+            data        += need;
+            size        -= need;
+        }
+
+        if(link.rxSize >= HEADER_LEN)
+        {
+            length = GetHeader(link.rx, seq);
+
+            if(length > MAX_CHUNK)
+            {
+                _stats.numCorrupt++;
+                link.rxSize = 0;
+                return;
+            }
+
+            if(link.rxSize == (HEADER_LEN + length))
+            {
+                Deliver(seq, &link.rx[HEADER_LEN], length);
+                link.rxSize = 0;
+            }
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Deliver
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Delivers a chunk if it is the next one in sequence (and then the held
+ *      ones following it), or holds it until the gap is filled. An early chunk
+ *      with no room to hold it breaks the stream.
+ *
+ *  @param[in]  seq     - Sequence number
+ *  @param[in]  data    - Payload
+ *  @param[in]  size    - Size of the payload (in bytes)
+ */
+void RS9110_Bond::Deliver (unsigned long seq, const char *data, unsigned short size)
+{
+    unsigned long   ahead   = (seq - _rxSeq) & SEQ_MASK;
+    int             slot    = -1;
+
+
+    if(_isBroken == true)
+    {
+        return;
+    }
+
+    /* Sequence numbers wrap at 32 bits: the upper half is behind */
+    if(ahead > (SEQ_MASK >> 1))
+    {
+        _stats.numDuplicates++;
+        return;
+    }
+
+    if(ahead > 0)
+    {
+        for(unsigned char i = 0; i < MAX_REORDER; i++)
+        {
+            if(_slots[i].isUsed == false)
+            {
+                slot = ((slot < 0) ? i : slot);
+            }
+            else if(_slots[i].seq == seq)
+            {
+                _stats.numDuplicates++;
+                return;
+            }
+        }
+
+        if(slot < 0)
+        {
+            /* Dropping it would stall the stream for ever */
+            _stats.numOverflows++;
+            _isBroken = true;
+            return;
+        }
+
+        _slots[slot].isUsed = true;
+        _slots[slot].seq    = seq;
+        _slots[slot].size   = size;
+        memcpy(_slots[slot].data, data, size);
+
+        _numHeld++;
+        _stats.numReordered++;
+
+        if(_numHeld > _stats.maxHeld)
+        {
+            _stats.maxHeld = _numHeld;
+        }
+
+        return;
+    }
+
+    if(_deliver != NULL)
+    {
+        _deliver(_context, data, size);
+    }
+
+    _rxSeq = (_rxSeq + 1) & SEQ_MASK;
+    _stats.numDelivered++;
+
+    /* Then the held ones, while in sequence */
+    for(unsigned char i = 0; (i < MAX_REORDER) && (_numHeld > 0); )
+    {
+        if((_slots[i].isUsed == true) && (_slots[i].seq == _rxSeq))
+        {
+            if(_deliver != NULL)
+            {
+                _deliver(_context, _slots[i].data, _slots[i].size);
+            }
+
+            _slots[i].isUsed = false;
+            _numHeld--;
+            _rxSeq = (_rxSeq + 1) & SEQ_MASK;
+            _stats.numDelivered++;
+
+            i = 0;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,546 @@
+#include "RS9110_Coalescer.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckCoalesceSockets   [((RS9110_MAX_COALESCE_SOCKETS > 0) && (RS9110_MAX_COALESCE_SOCKETS <= 7)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver used to send
+ *
+ */
+RS9110_Coalescer::RS9110_Coalescer (RS9110_UART &rs)
+  : _rs(rs),
+    _scheduler(NULL),
+    _nextSlot(0),
+    _isPosted(false)
+{
+    memset(_slots, 0, sizeof(_slots));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Coalescer::~RS9110_Coalescer ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetScheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the commands thru the bulk class of a scheduler: a flush only
+ *      marks the pending bytes, which are sent when the scheduler gives the
+ *      line (and may grow meanwhile). Only coalesced sockets are written then.
+ *      NULL (the default) sends at once.
+ *
+ *  @param[in]  scheduler   - Scheduler of the driver (NULL if none)
+ */
+void RS9110_Coalescer::SetScheduler (RS9110_Scheduler *scheduler)
+{
+    _scheduler = scheduler;
+    _isPosted  = false;
+
+    PostFlush();
+}
+
+
+/*!
+ *  @brief  Enable
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts coalescing the writes to a TCP socket, or changes its delay if it
+ *      is already coalesced.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *  @param[in]  delayMs     - Longest time a write is held (0 sends on the next #Poll)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong socket or no free slot
+ */
+bool RS9110_Coalescer::Enable (unsigned char socketId, unsigned long delayMs)
+{
+    TSlot *slot = FindSlot(socketId);
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return false;
+    }
+
+    if(slot == NULL)
+    {
+        slot = FindSlot(0);
+
+        if(slot == NULL)
+        {
+            return false;
+        }
+
+        slot->socketId          = socketId;
+        slot->length            = 0;
+        slot->stuffedLength     = 0;
+        slot->isFlushing        = false;
+        slot->maxStuffedLength  = (unsigned short) RS9110_UART::GetMaxSendSize(socketId, RS9110_UART::SOCKET_TCP);
+    }
+
+    slot->delayMs = delayMs;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Disable
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stops coalescing the writes to a socket (i.e. for latency-sensitive
+ *      traffic). The pending bytes are sent first.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Not coalesced or pending bytes not sent (with a
+ *                    scheduler, call again once they are)
+ */
+bool RS9110_Coalescer::Disable (unsigned char socketId)
+{
+    TSlot *slot = FindSlot(socketId);
+
+
+    /* With a scheduler the flush is only posted */
+    if((slot == NULL) || (FlushSlot(slot) == false) || (slot->length > 0))
+    {
+        return false;
+    }
+
+    slot->socketId = 0;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  IsEnabled
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether the writes to a socket are coalesced.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return bool
+ */
+bool RS9110_Coalescer::IsEnabled (unsigned char socketId)
+{
+    return ((socketId != 0) && (FindSlot(socketId) != NULL));
+}
+
+
+/*!
+ *  @brief  Write
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Appends a byte stream to the pending bytes of a coalesced socket. When
+ *      the pending bytes reach the size of one command they are sent, carrying
+ *      as much of the stream as fits; the rest must be written again, as with
+ *      #RS9110_UART::Send. Writes to other sockets are sent at once (and
+ *      refused with a scheduler).
+ *
+ *  @param[in]  socketId    - Socket handle of an already open TCP socket
+ *  @param[in]  data        - Byte stream
+ *  @param[in]  dataSize    - Length of the byte stream
+ *  @param[in]  nowMs       - Current time (ms)
+ *
+ *  @return unsigned int (bytes accepted)
+ */
+unsigned int RS9110_Coalescer::Write (unsigned char socketId, const char *data, unsigned int dataSize, unsigned long nowMs)
+{
+    TSlot          *slot    = FindSlot(socketId);
+    unsigned int    take    = 0;
+    unsigned int    stuffed = 0;
+
+
+    if((socketId == 0) || (data == NULL) || (dataSize == 0))
+    {
+        return 0;
+    }
+
+    if((slot == NULL) && (_scheduler != NULL))
+    {
+        return 0;
+    }
+
+    if(slot == NULL)
+    {
+        take = _rs.Send(socketId, RS9110_UART::SOCKET_TCP, NULL, 0, data, dataSize);
+
+        if(_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA)
+        {
+            return 0;
+        }
+
+        _stats.numWrites++;
+        _stats.numCommands++;
+
+        return take;
+    }
+
+    /* Largest prefix Send() takes whole after the pending bytes */
+    stuffed = slot->maxStuffedLength - slot->stuffedLength;
+    take    = RS9110_UART::FitByteStuffing(stuffed, data, dataSize);
+
+    if(take > 0)
+    {
+        if(slot->length == 0)
+        {
+            slot->firstMs = nowMs;
+        }
+        else
+        {
+            _stats.numCoalesced++;
+        }
+
+        memcpy(&slot->data[slot->length], data, take);
+        slot->length        = (unsigned short) (slot->length + take);
+        slot->stuffedLength = (unsigned short) (slot->stuffedLength + stuffed);
+        _stats.numWrites++;
+    }
+
+    /* Full: not even one more byte fits */
+    if((slot->isFlushing == false) && ((take < dataSize) || ((slot->stuffedLength + 1) >= slot->maxStuffedLength)))
+    {
+        if(FlushSlot(slot) == true)
+        {
+            _stats.numSizeFlushes++;
+        }
+    }
+
+    return take;
+}
+
+
+/*!
+ *  @brief  Flush
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending bytes of a coalesced socket now.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return bool
+ *  @retval true    - OK (or nothing pending)
+ *  @retval false   - Not coalesced or command not sent
+ */
+bool RS9110_Coalescer::Flush (unsigned char socketId)
+{
+    TSlot *slot = FindSlot(socketId);
+
+
+    if((socketId == 0) || (slot == NULL))
+    {
+        return false;
+    }
+
+    return FlushSlot(slot);
+}
+
+
+/*!
+ *  @brief  Discard
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops the pending bytes of a socket without sending them (i.e. when the
+ *      socket is closed). Coalescing stays enabled.
+ *
+ *  @param[in]  socketId    - Socket handle
+ */
+void RS9110_Coalescer::Discard (unsigned char socketId)
+{
+    TSlot *slot = FindSlot(socketId);
+
+
+    if((socketId != 0) && (slot != NULL))
+    {
+        slot->length        = 0;
+        slot->stuffedLength = 0;
+        slot->isFlushing    = false;
+    }
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending bytes that have waited for the delay of their socket.
+ *      At most one command is sent per call, so it can be called periodically
+ *      whenever the driver is not waiting for an OK/ERROR.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Coalescer::Poll (unsigned long nowMs)
+{
+    for(unsigned char i = 0; i < MAX_SLOTS; i++)
+    {
+        TSlot *slot = &_slots[i];
+
+        if((slot->socketId != 0) && (slot->length > 0) && (slot->isFlushing == false) && ((nowMs - slot->firstMs) >= slot->delayMs))
+        {
+            if(FlushSlot(slot) == true)
+            {
+                _stats.numDelayFlushes++;
+            }
+
+            return;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  GetPending
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of bytes of a socket not sent yet.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return unsigned int (0 if not coalesced)
+ */
+unsigned int RS9110_Coalescer::GetPending (unsigned char socketId)
+{
+    TSlot *slot = FindSlot(socketId);
+
+
+    return (((socketId != 0) && (slot != NULL)) ? slot->length : 0);
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Coalescer::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  FindSlot
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Looks for the slot of a socket (0 looks for a free one).
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return TSlot * (NULL if not found)
+ */
+RS9110_Coalescer::TSlot * RS9110_Coalescer::FindSlot (unsigned char socketId)
+{
+    for(unsigned char i = 0; i < MAX_SLOTS; i++)
+    {
+        if(_slots[i].socketId == socketId)
+        {
+            return &_slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+ *  @brief  FlushSlot
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending bytes of a slot in one command, or marks them for
+ *      #IssueBulk with a scheduler.
+ *
+ *  @param[in]  slot    - Slot in use
+ *
+ *  @return bool
+ *  @retval true    - OK, flush posted (or nothing pending)
+ *  @retval false   - Command not sent
+ */
+bool RS9110_Coalescer::FlushSlot (TSlot *slot)
+{
+    if(slot->length == 0)
+    {
+        return true;
+    }
+
+    if(_scheduler != NULL)
+    {
+        slot->isFlushing = true;
+        PostFlush();
+
+        return true;
+    }
+
+    return SendSlot(slot);
+}
+
+
+/*!
+ *  @brief  SendSlot
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending bytes of a slot in one command. They are kept if the
+ *      command could not be written.
+ *
+ *  @param[in]  slot    - Slot with bytes pending
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Command not sent
+ */
+bool RS9110_Coalescer::SendSlot (TSlot *slot)
+{
+    _rs.Send(slot->socketId, RS9110_UART::SOCKET_TCP, NULL, 0, slot->data, slot->length);
+
+    if(_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA)
+    {
+        return false;
+    }
+
+    _stats.numCommands++;
+
+    slot->length        = 0;
+    slot->stuffedLength = 0;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  PostFlush
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Posts #IssueBulk on the scheduler if a slot is waiting for it.
+ */
+void RS9110_Coalescer::PostFlush ()
+{
+    if((_scheduler == NULL) || (_isPosted == true))
+    {
+        return;
+    }
+
+    for(unsigned char i = 0; i < MAX_SLOTS; i++)
+    {
+        if(_slots[i].isFlushing == true)
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueBulk, this) == false)
+            {
+                _isPosted = false;
+            }
+
+            return;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  IssueBulk
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #PostFlush: sends the pending bytes of the
+ *      next slot waiting, round robin, and posts again if others wait. Bytes
+ *      not sent stay pending for the next flush.
+ *
+ *  @param[in]  context - Coalescer
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_Coalescer::IssueBulk (void *context, RS9110_UART &rs)
+{
+    RS9110_Coalescer   *coalescer   = (RS9110_Coalescer *) context;
+    TSlot              *slot;
+    bool                bRtn        = false;
+
+
+    (void) rs;
+
+    coalescer->_isPosted = false;
+
+    for(unsigned char i = 0; (i < MAX_SLOTS) && (bRtn == false); i++)
+    {
+        slot                    = &coalescer->_slots[coalescer->_nextSlot];
+        coalescer->_nextSlot    = (unsigned char) ((coalescer->_nextSlot + 1) % MAX_SLOTS);
+
+        if(slot->isFlushing == true)
+        {
+            slot->isFlushing = false;
+
+            if((slot->socketId != 0) && (slot->length > 0))
+            {
+                bRtn = coalescer->SendSlot(slot);
+            }
+        }
+    }
+
+    coalescer->PostFlush();
+
+    return bRtn;
+}
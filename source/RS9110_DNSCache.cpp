@@ -0,0 +1,544 @@
+#include "RS9110_DNSCache.h"
+
+#include <string.h>
+
+#if RS9110_FEATURE_DNS
+
+
+/*!
+ *  @brief  IsDnsError
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether an error code tells the name could not be resolved
+ *      (worth caching), rather than the module not being able to try.
+ *
+ *  @param[in]  eErrorCode  - Error code of the module
+ *
+ *  @return bool
+ */
+static bool IsDnsError (RS9110_UART::EErrorCode eErrorCode)
+{
+    switch(eErrorCode)
+    {
+        case RS9110_UART::ERROR_REPLY_WITHOUT_IP:
+        case RS9110_UART::ERROR_DNS_CLASS:
+        case RS9110_UART::ERROR_REPLY_WITH_ERROR:
+        case RS9110_UART::ERROR_REPLY_TRUNCATED:
+        case RS9110_UART::ERROR_REPLY_ID:
+        case RS9110_UART::ERROR_REPLY_TOO_SHORT:
+        case RS9110_UART::ERROR_DNS_RESP_TIMEOUT:
+            return true;
+        break;
+
+        default:
+            return false;
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs              - Driver used to resolve the names
+ *  @param[in]  ttlMs           - Lifetime of a resolved name (ms)
+ *  @param[in]  negativeTtlMs   - Lifetime of a failed name (ms)
+ *
+ */
+RS9110_DNSCache::RS9110_DNSCache (RS9110_UART &rs, unsigned long ttlMs, unsigned long negativeTtlMs)
+  : _rs(rs),
+    _ttlMs(ttlMs),
+    _negativeTtlMs(negativeTtlMs),
+    _inFlight(NULL)
+{
+    Clear();
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_DNSCache::~RS9110_DNSCache ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetTTL
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the lifetime of the names resolved from now on.
+ *
+ *  @param[in]  ttlMs           - Lifetime of a resolved name (ms)
+ *  @param[in]  negativeTtlMs   - Lifetime of a failed name (ms)
+ */
+void RS9110_DNSCache::SetTTL (unsigned long ttlMs, unsigned long negativeTtlMs)
+{
+    _ttlMs          = ttlMs;
+    _negativeTtlMs  = negativeTtlMs;
+}
+
+
+/*!
+ *  @brief  Resolve
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Looks the name up in the cache and sends "AT+RSI_DNSGET" only if it is
+ *      unknown or expired and no query is in flight. When #RESULT_PENDING is
+ *      returned, the caller asks again once #ProcessResponse has consumed the
+ *      answer.
+ *
+ *  @param[in]  domainName  - Domain name (up to #MAX_NAME_LEN characters)
+ *  @param[in]  nowMs       - Current time (ms)
+ *  @param[out] result      - Addresses (only with #RESULT_HIT)
+ *
+ *  @return EResult
+ */
+RS9110_DNSCache::EResult RS9110_DNSCache::Resolve (const char *domainName, unsigned long nowMs, RS9110_UART::TDNSGet &result)
+{
+    TEntry         *entry;
+    unsigned long   hash;
+
+
+    if((domainName == NULL) || (strlen(domainName) == 0) || (strlen(domainName) > MAX_NAME_LEN))
+    {
+        return RESULT_ERROR;
+    }
+
+    hash  = Hash(domainName);
+    entry = Find(domainName, hash);
+
+    if(entry != NULL)
+    {
+        entry->lastUsedMs = nowMs;
+
+        switch(entry->state)
+        {
+            case STATE_VALID:
+                if(IsExpired(entry->timeMs, nowMs) == false)
+                {
+                    memcpy(&result, &entry->dns, sizeof(result));
+                    return RESULT_HIT;
+                }
+            break;
+
+            case STATE_NEGATIVE:
+                if(IsExpired(entry->timeMs, nowMs) == false)
+                {
+                    return RESULT_NEGATIVE;
+                }
+            break;
+
+            case STATE_PENDING:
+                if(IsExpired(entry->timeMs + QUERY_TIMEOUT_MS, nowMs) == false)
+                {
+                    return RESULT_PENDING;
+                }
+
+                /* The answer never came */
+                _inFlight = NULL;
+            break;
+
+            default:
+                /* Nothing to do */
+            break;
+        }
+    }
+
+    if(_inFlight != NULL)
+    {
+        if(IsExpired(_inFlight->timeMs + QUERY_TIMEOUT_MS, nowMs) == false)
+        {
+            return RESULT_BUSY;
+        }
+
+        _inFlight->state = STATE_FREE;
+        _inFlight = NULL;
+    }
+
+    if(entry == NULL)
+    {
+        entry = Allocate(nowMs);
+
+        strcpy(entry->name, domainName);
+        entry->hash         = hash;
+        entry->lastUsedMs   = nowMs;
+    }
+
+    if(_rs.GetDNS(domainName) == false)
+    {
+        entry->state = STATE_FREE;
+        return RESULT_ERROR;
+    }
+
+    entry->state    = STATE_PENDING;
+    entry->timeMs   = nowMs;
+    _inFlight       = entry;
+
+    return RESULT_PENDING;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stores the answer to the query in flight. Must be called after every
+ *      #RS9110_UART::ProcessMessage; other messages are ignored. Only DNS
+ *      failures are cached; on other errors (i.e. ERROR_ASSOC_NOT_DONE) the
+ *      entry is freed, so the next lookup sends a new query.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not an answer to the query in flight
+ */
+bool RS9110_DNSCache::ProcessResponse (unsigned long nowMs)
+{
+    const void *response;
+    int         length;
+
+
+    if((_inFlight == NULL) || (_rs.GetLastCommand() != RS9110_UART::CMD_GET_DNS))
+    {
+        return false;
+    }
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+            response = _rs.GetResponse(length);
+            memset(&_inFlight->dns, 0, sizeof(_inFlight->dns));
+
+            if((response != NULL) && (length > 0))
+            {
+                memcpy(&_inFlight->dns, response, ((length < (int) sizeof(_inFlight->dns)) ? length : sizeof(_inFlight->dns)));
+            }
+
+            if(_inFlight->dns.numIPs > RS9110_UART::MAX_DNSGET_RESP)
+            {
+                _inFlight->dns.numIPs = RS9110_UART::MAX_DNSGET_RESP;
+            }
+
+            if(_inFlight->dns.numIPs > 0)
+            {
+                _inFlight->state     = STATE_VALID;
+                _inFlight->errorCode = RS9110_UART::ERROR_NONE;
+                _inFlight->timeMs    = nowMs + _ttlMs;
+            }
+            else
+            {
+                _inFlight->state     = STATE_NEGATIVE;
+                _inFlight->errorCode = RS9110_UART::ERROR_NONE;
+                _inFlight->timeMs    = nowMs + _negativeTtlMs;
+            }
+        break;
+
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if(IsDnsError(_rs.GetErrorCode()) == false)
+            {
+                _inFlight->state = STATE_FREE;
+                break;
+            }
+
+            _inFlight->state     = STATE_NEGATIVE;
+            _inFlight->errorCode = (unsigned char) _rs.GetErrorCode();
+            _inFlight->timeMs    = nowMs + _negativeTtlMs;
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    _inFlight = NULL;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  IsQueryInFlight
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether an "AT+RSI_DNSGET" is waiting for its answer.
+ *
+ *  @return bool
+ */
+bool RS9110_DNSCache::IsQueryInFlight ()
+{
+    return (_inFlight != NULL);
+}
+
+
+/*!
+ *  @brief  GetLastError
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns why a name is negatively cached (#RS9110_UART::ERROR_NONE if the
+ *      module answered with no address or the name is not negatively cached).
+ *
+ *  @param[in]  domainName  - Domain name
+ *
+ *  @return RS9110_UART::EErrorCode
+ */
+RS9110_UART::EErrorCode RS9110_DNSCache::GetLastError (const char *domainName)
+{
+    TEntry *entry;
+
+
+    if(domainName == NULL)
+    {
+        return RS9110_UART::ERROR_NONE;
+    }
+
+    entry = Find(domainName, Hash(domainName));
+
+    if((entry == NULL) || (entry->state != STATE_NEGATIVE))
+    {
+        return RS9110_UART::ERROR_NONE;
+    }
+
+    return (RS9110_UART::EErrorCode) entry->errorCode;
+}
+
+
+/*!
+ *  @brief  Invalidate
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops a name from the cache (i.e. the addresses stopped answering). A
+ *      query in flight for that name is not affected.
+ *
+ *  @param[in]  domainName  - Domain name
+ */
+void RS9110_DNSCache::Invalidate (const char *domainName)
+{
+    TEntry *entry;
+
+
+    if(domainName == NULL)
+    {
+        return;
+    }
+
+    entry = Find(domainName, Hash(domainName));
+
+    if((entry != NULL) && (entry != _inFlight))
+    {
+        entry->state = STATE_FREE;
+    }
+}
+
+
+/*!
+ *  @brief  Clear
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops every name and forgets the query in flight.
+ */
+void RS9110_DNSCache::Clear ()
+{
+    memset(_entries, 0, sizeof(_entries));
+
+    _inFlight = NULL;
+}
+
+
+/*!
+ *  @brief  Find
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Looks for the entry of a name (compared case-insensitively).
+ *
+ *  @param[in]  domainName  - Domain name
+ *  @param[in]  hash        - Hash of the domain name
+ *
+ *  @return Pointer to the entry (NULL if not found)
+ */
+RS9110_DNSCache::TEntry * RS9110_DNSCache::Find (const char *domainName, unsigned long hash)
+{
+    for(unsigned int i = 0; i < MAX_ENTRIES; i++)
+    {
+        if((_entries[i].state != STATE_FREE) &&
+           (_entries[i].hash == hash) &&
+           (IsSameName(_entries[i].name, domainName) == true))
+        {
+            return &_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+ *  @brief  Allocate
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns a free entry or, if all are used, the least recently used one
+ *      (expired entries first). The query in flight is never evicted.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return Pointer to the entry
+ */
+RS9110_DNSCache::TEntry * RS9110_DNSCache::Allocate (unsigned long nowMs)
+{
+    TEntry *victim = NULL;
+
+
+    for(unsigned int i = 0; i < MAX_ENTRIES; i++)
+    {
+        TEntry *entry = &_entries[i];
+
+        if(entry->state == STATE_FREE)
+        {
+            return entry;
+        }
+
+        if(entry == _inFlight)
+        {
+            continue;
+        }
+
+        if((entry->state != STATE_PENDING) && (IsExpired(entry->timeMs, nowMs) == true))
+        {
+            return entry;
+        }
+
+        if((victim == NULL) || ((long) (entry->lastUsedMs - victim->lastUsedMs) < 0))
+        {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+
+/*!
+ *  @brief  Hash
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      FNV-1a hash of the lower case name.
+ *
+ *  @param[in]  domainName  - Domain name
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_DNSCache::Hash (const char *domainName)
+{
+    unsigned long hash = 2166136261UL;
+
+
+    while(*domainName != '\0')
+    {
+        char c = *domainName++;
+
+        if((c >= 'A') && (c <= 'Z'))
+        {
+            c += ('a' - 'A');
+        }
+
+        hash = ((hash ^ (unsigned char) c) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return hash;
+}
+
+
+/*!
+ *  @brief  IsSameName
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Compares two domain names ignoring the case.
+ *
+ *  @param[in]  name1   - Domain name
+ *  @param[in]  name2   - Domain name
+ *
+ *  @return bool
+ */
+bool RS9110_DNSCache::IsSameName (const char *name1, const char *name2)
+{
+    char c1;
+    char c2;
+
+
+    do
+    {
+        c1 = *name1++;
+        c2 = *name2++;
+
+        if((c1 >= 'A') && (c1 <= 'Z'))
+        {
+            c1 += ('a' - 'A');
+        }
+
+        if((c2 >= 'A') && (c2 <= 'Z'))
+        {
+            c2 += ('a' - 'A');
+        }
+    }
+    while((c1 == c2) && (c1 != '\0'));
+
+    return (c1 == c2);
+}
+
+
+/*!
+ *  @brief  IsExpired
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether a deadline has passed (wrap-around safe).
+ *
+ *  @param[in]  timeMs  - Deadline (ms)
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ */
+bool RS9110_DNSCache::IsExpired (unsigned long timeMs, unsigned long nowMs)
+{
+    return ((long) (nowMs - timeMs) >= 0);
+}
+
+#endif /* RS9110_FEATURE_DNS */
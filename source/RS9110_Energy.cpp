@@ -0,0 +1,331 @@
+#include "RS9110_Energy.h"
+
+#include "RS9110_UART.h"
+#include "RS9110_Trace.h"
+
+#include <string.h>
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor. The module is taken as awake in power mode 0 and every
+ *    state draws nothing until #SetCurrent is called.
+ *
+ *  @param[in]  clock   - Time source in microseconds (NULL uses #RS9110_Trace::MonotonicClock,
+ *                        not available on the MCU)
+ *
+ */
+RS9110_Energy::RS9110_Energy (TClock clock)
+  : _clock((clock != NULL) ? clock : RS9110_Trace::MonotonicClock),
+    _supplyMV(DEFAULT_SUPPLY_MV),
+    _sleepUs(0),
+    _isSleepPending(false),
+    _powerMode(RS9110_UART::PW_MODE_0),
+    _requestedMode(RS9110_UART::PW_MODE_0),
+    _isAsleep(false),
+    _wakeBytes(0),
+    _eState(STATE_PM0)
+{
+    memset(_currentUA, 0, sizeof(_currentUA));
+    memset(&_stats, 0, sizeof(_stats));
+
+    _lastUs = _clock();
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Energy::~RS9110_Energy ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetCurrent
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the current drawn by the module in a state (i.e. from its
+ *      datasheet or measured on the board).
+ *
+ *  @param[in]  eState      - State
+ *  @param[in]  microAmps   - Average current (uA)
+ */
+void RS9110_Energy::SetCurrent (EState eState, unsigned long microAmps)
+{
+    if(eState < STATE_MAX)
+    {
+        _currentUA[eState] = microAmps;
+    }
+}
+
+
+/*!
+ *  @brief  SetSupplyVoltage
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the supply voltage used to turn the charge into energy.
+ *
+ *  @param[in]  milliVolts  - Supply voltage (mV)
+ */
+void RS9110_Energy::SetSupplyVoltage (unsigned short milliVolts)
+{
+    _supplyMV = milliVolts;
+}
+
+
+/*!
+ *  @brief  Reset
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Clears the statistics. The current state is kept.
+ */
+void RS9110_Energy::Reset ()
+{
+    memset(&_stats, 0, sizeof(_stats));
+
+    _lastUs         = _clock();
+    _wakeBytes      = 0;
+    _isSleepPending = false;
+}
+
+
+/*!
+ *  @brief  Transmitted
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Accounts a command written to the module. An ACK sends it to sleep in
+ *      power modes 1 and 2; any other command wakes it up.
+ *
+ *  @param[in]  command     - #RS9110_UART::ECommand
+ *  @param[in]  size        - Length of the command (in bytes)
+ *  @param[in]  powerMode   - Mode requested (AT+RSI_PWMODE only)
+ */
+void RS9110_Energy::Transmitted (unsigned char command, unsigned int size, unsigned char powerMode)
+{
+    Advance();
+
+    if(command == RS9110_UART::CMD_POWER_MODE)
+    {
+        _requestedMode = powerMode;
+    }
+
+    if(command == RS9110_UART::CMD_KEEP_SLEEPING)
+    {
+        if((_powerMode != RS9110_UART::PW_MODE_0) && (_isAsleep == false))
+        {
+            if(_isSleepPending == true)
+            {
+                unsigned long long wakeToAckUs = _lastUs - _sleepUs;
+
+                _stats.totalWakeToAckUs += wakeToAckUs;
+
+                if(wakeToAckUs > _stats.maxWakeToAckUs)
+                {
+                    _stats.maxWakeToAckUs = wakeToAckUs;
+                }
+
+                _isSleepPending = false;
+            }
+
+            _stats.numAcks++;
+            EndWake();
+            SetState(_powerMode, true);
+        }
+
+        return;
+    }
+
+    if(_isAsleep == true)
+    {
+        _stats.numHostWakes++;
+        SetState(_powerMode, false);
+    }
+
+    if(_powerMode != RS9110_UART::PW_MODE_0)
+    {
+        _wakeBytes += size;
+    }
+}
+
+
+/*!
+ *  @brief  Received
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Accounts a message from the module: a SLEEP wakes it up (or announces
+ *      it wants to sleep), the OK of AT+RSI_PWMODE changes the power mode.
+ *
+ *  @param[in]  responseType    - #RS9110_UART::EResponseType
+ *  @param[in]  command         - Last #RS9110_UART::ECommand written
+ */
+void RS9110_Energy::Received (unsigned char responseType, unsigned char command)
+{
+    Advance();
+
+    if(responseType == RS9110_UART::RESP_TYPE_SLEEP)
+    {
+        if(_isAsleep == true)
+        {
+            _stats.numWakes++;
+            SetState(_powerMode, false);
+        }
+
+        _sleepUs        = _lastUs;
+        _isSleepPending = true;
+    }
+    else if((responseType == RS9110_UART::RESP_TYPE_OK) && (command == RS9110_UART::CMD_POWER_MODE))
+    {
+        if((_powerMode != RS9110_UART::PW_MODE_0) && (_requestedMode == RS9110_UART::PW_MODE_0))
+        {
+            EndWake();
+        }
+
+        _isSleepPending = false;
+        SetState(_requestedMode, false);
+    }
+}
+
+
+/*!
+ *  @brief  GetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the state the module is taken to be in.
+ *
+ *  @return EState
+ */
+RS9110_Energy::EState RS9110_Energy::GetState ()
+{
+    return _eState;
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics, accounting the current state up to
+ *      now, and estimates the charge and energy drawn.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Energy::GetStats (TStats &stats)
+{
+    unsigned long long chargePC = 0;
+
+
+    Advance();
+
+    /* uA x us = pC */
+    for(unsigned char i = 0; i < STATE_MAX; i++)
+    {
+        chargePC += _stats.timeUs[i] * _currentUA[i];
+    }
+
+    _stats.chargeUC = chargePC / 1000000;
+    _stats.energyUJ = (chargePC / 1000) * _supplyMV / 1000000;
+
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  Advance
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Accounts the time elapsed since the last event to the current state.
+ */
+void RS9110_Energy::Advance ()
+{
+    unsigned long long nowUs = _clock();
+
+
+    _stats.timeUs[_eState] += nowUs - _lastUs;
+    _lastUs = nowUs;
+}
+
+
+/*!
+ *  @brief  SetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves to the state of a power mode, awake or asleep.
+ *
+ *  @param[in]  powerMode   - #RS9110_UART::EPowerMode
+ *  @param[in]  isAsleep    - Asleep (power modes 1 and 2 only)
+ */
+void RS9110_Energy::SetState (unsigned char powerMode, bool isAsleep)
+{
+    _powerMode = powerMode;
+
+    switch(powerMode)
+    {
+        case RS9110_UART::PW_MODE_1:
+            _isAsleep   = isAsleep;
+            _eState     = ((isAsleep == true) ? STATE_PM1_ASLEEP : STATE_PM1_AWAKE);
+        break;
+
+        case RS9110_UART::PW_MODE_2:
+            _isAsleep   = isAsleep;
+            _eState     = ((isAsleep == true) ? STATE_PM2_ASLEEP : STATE_PM2_AWAKE);
+        break;
+
+        default:
+            _powerMode  = RS9110_UART::PW_MODE_0;
+            _isAsleep   = false;
+            _eState     = STATE_PM0;
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  EndWake
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Closes the bytes written in the current wake.
+ */
+void RS9110_Energy::EndWake ()
+{
+    _stats.totalWakeBytes += _wakeBytes;
+
+    if(_wakeBytes > _stats.maxWakeBytes)
+    {
+        _stats.maxWakeBytes = _wakeBytes;
+    }
+
+    _wakeBytes = 0;
+}
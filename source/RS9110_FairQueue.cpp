@@ -0,0 +1,704 @@
+#include "RS9110_FairQueue.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckFairQueueDepth    [((RS9110_MAX_FAIR_QUEUE_DEPTH > 0) && (RS9110_MAX_FAIR_QUEUE_DEPTH <= 255)) ? 1 : -1];
+
+static const long   MILLI           = 1000;     /*! @note Tokens are kept in 1/1000 of a byte */
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor. Every socket starts with weight 1 and no rate cap.
+ *
+ *  @param[in]  rs          - Driver used to send
+ *  @param[in]  completion  - Called when a send is acknowledged or dropped (may be NULL)
+ *  @param[in]  context     - Given back to the completion
+ *
+ */
+RS9110_FairQueue::RS9110_FairQueue (RS9110_UART &rs, TCompletion completion, void *context)
+  : _rs(rs),
+    _scheduler(NULL),
+    _completion(completion),
+    _context(context),
+    _current(0),
+    _isCredited(false),
+    _inFlight(-1),
+    _chunk(0),
+    _cost(0),
+    _nowMs(0),
+    _isPosted(false)
+{
+    memset(_flows, 0, sizeof(_flows));
+
+    for(unsigned char i = 0; i < MAX_SOCKETS; i++)
+    {
+        _flows[i].weight = 1;
+    }
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_FairQueue::~RS9110_FairQueue ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetScheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the commands thru the bulk class of a scheduler: the command of
+ *      the flow picked by the round robin is written when the scheduler gives
+ *      the line. NULL (the default) writes it at once. To be set while
+ *      #IsIdle.
+ *
+ *  @param[in]  scheduler   - Scheduler of the driver (NULL if none)
+ */
+void RS9110_FairQueue::SetScheduler (RS9110_Scheduler *scheduler)
+{
+    _scheduler = scheduler;
+    _isPosted  = false;
+
+    Dispatch(_nowMs);
+}
+
+
+/*!
+ *  @brief  SetWeight
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the share of the line of a socket relative to the others.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *  @param[in]  weight      - #QUANTUM bytes earned per round (1 to 255)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument
+ */
+bool RS9110_FairQueue::SetWeight (unsigned char socketId, unsigned char weight)
+{
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE) || (weight == 0))
+    {
+        return false;
+    }
+
+    _flows[socketId - RS9110_UART::MIN_SOCKET_HANDLE].weight = weight;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  SetRateLimit
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Caps the bytes (after byte stuffing) a socket writes per second. The
+ *      bucket starts full; a command larger than the burst is only written
+ *      when the bucket is full.
+ *
+ *  @param[in]  socketId        - Socket handle
+ *  @param[in]  bytesPerSecond  - Rate (0 removes the cap)
+ *  @param[in]  burstBytes      - Size of the bucket
+ *  @param[in]  nowMs           - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong argument
+ */
+bool RS9110_FairQueue::SetRateLimit (unsigned char socketId, unsigned long bytesPerSecond, unsigned short burstBytes, unsigned long nowMs)
+{
+    TFlow *flow;
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return false;
+    }
+
+    flow            = &_flows[socketId - RS9110_UART::MIN_SOCKET_HANDLE];
+    flow->rate      = bytesPerSecond;
+    flow->maxTokens = burstBytes * MILLI;
+    flow->tokens    = flow->maxTokens;
+    flow->refillMs  = nowMs;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Submit
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Queues a send on its socket and writes the next command if the line is
+ *      free.
+ *
+ *  @param[in]  socketId    - Socket handle of an already open socket
+ *  @param[in]  socketType  - SOCKET_TCP or SOCKET_UDP
+ *  @param[in]  hostIpAddr  - Destination IP Address (UDP only, kept until completion)
+ *  @param[in]  hostPort    - Destination Port (UDP only)
+ *  @param[in]  data        - Byte stream (kept until completion)
+ *  @param[in]  dataSize    - Length of the byte stream
+ *  @param[in]  nowMs       - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Queued
+ *  @retval false   - Wrong argument or queue of the socket full
+ */
+bool RS9110_FairQueue::Submit (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort,
+                               const char *data, unsigned int dataSize, unsigned long nowMs)
+{
+    TFlow  *flow;
+    TEntry *entry;
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       ((socketType != RS9110_UART::SOCKET_TCP) && (socketType != RS9110_UART::SOCKET_UDP)) ||
+       (data == NULL) || (dataSize == 0))
+    {
+        return false;
+    }
+
+    flow = &_flows[socketId - RS9110_UART::MIN_SOCKET_HANDLE];
+
+    if(flow->stats.numQueued >= MAX_DEPTH)
+    {
+        return false;
+    }
+
+    entry               = &flow->entries[(flow->head + flow->stats.numQueued) % MAX_DEPTH];
+    entry->data         = data;
+    entry->host         = hostIpAddr;
+    entry->size         = dataSize;
+    entry->offset       = 0;
+    entry->submitMs     = nowMs;
+    entry->hostPort     = hostPort;
+    entry->socketType   = (unsigned char) socketType;
+    entry->isStarted    = false;
+
+    flow->stats.numQueued++;
+
+    if(flow->stats.numQueued > flow->stats.maxQueued)
+    {
+        flow->stats.maxQueued = flow->stats.numQueued;
+    }
+
+    Dispatch(nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Matches an OK/ERROR with the command in flight and writes the next one.
+ *      Must be called after every #RS9110_UART::ProcessMessage.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not related to the sends
+ */
+bool RS9110_FairQueue::ProcessResponse (unsigned long nowMs)
+{
+    TFlow *flow;
+
+
+    if((_inFlight < 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+    {
+        return false;
+    }
+
+    flow = &_flows[_inFlight];
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+            flow->entries[flow->head].offset += _chunk;
+            flow->stats.stuffedBytes         += _cost;
+
+            if(flow->entries[flow->head].offset >= flow->entries[flow->head].size)
+            {
+                Complete((unsigned char) _inFlight, true, RS9110_UART::ERROR_NONE);
+            }
+        break;
+
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if(_rs.GetErrorCode() == RS9110_UART::ERROR_SEND_DATA_TOO_FAST)
+            {
+                /* Sent again: give back what it was charged */
+                flow->deficit += _cost;
+
+                if(flow->rate != 0)
+                {
+                    flow->tokens += (long) _cost * MILLI;
+                }
+            }
+            else
+            {
+                Complete((unsigned char) _inFlight, false, _rs.GetErrorCode());
+            }
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    _inFlight = -1;
+
+    Dispatch(nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command if the line is free, i.e. once the bucket of a
+ *      capped socket has refilled. To be called periodically.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_FairQueue::Poll (unsigned long nowMs)
+{
+    Dispatch(nowMs);
+}
+
+
+/*!
+ *  @brief  Abort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops all the sends (i.e. after a reset or a link loss), notifying every
+ *      one of them as not sent. Weights and rate caps are kept. The scheduler,
+ *      if any, must be aborted too.
+ */
+void RS9110_FairQueue::Abort ()
+{
+    _inFlight = -1;
+    _isPosted = false;
+
+    for(unsigned char i = 0; i < MAX_SOCKETS; i++)
+    {
+        while(_flows[i].stats.numQueued > 0)
+        {
+            Complete(i, false, RS9110_UART::ERROR_NONE);
+        }
+
+        _flows[i].deficit = 0;
+    }
+
+    _isCredited = false;
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether no command is in flight, so another command may be issued.
+ *
+ *  @return bool
+ */
+bool RS9110_FairQueue::IsIdle ()
+{
+    return (_inFlight < 0);
+}
+
+
+/*!
+ *  @brief  GetNumQueued
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of sends of a socket not completed yet.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return unsigned char (0 if wrong socket)
+ */
+unsigned char RS9110_FairQueue::GetNumQueued (unsigned char socketId)
+{
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return 0;
+    }
+
+    return _flows[socketId - RS9110_UART::MIN_SOCKET_HANDLE].stats.numQueued;
+}
+
+
+/*!
+ *  @brief  GetSocketStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics of a socket.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *  @param[out] stats       - Copy of the statistics
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong socket
+ */
+bool RS9110_FairQueue::GetSocketStats (unsigned char socketId, TSocketStats &stats)
+{
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return false;
+    }
+
+    memcpy(&stats, &_flows[socketId - RS9110_UART::MIN_SOCKET_HANDLE].stats, sizeof(stats));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Dispatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the command of the flow picked by the round robin, if the line
+ *      is free. Sends that cannot be written are dropped. With a scheduler
+ *      the command is only posted, #IssueBulk writes it.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_FairQueue::Dispatch (unsigned long nowMs)
+{
+    int flow;
+
+
+    _nowMs = nowMs;
+
+    if(_scheduler != NULL)
+    {
+        if((_inFlight < 0) && (_isPosted == false) && (NextFlow(nowMs) >= 0))
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueBulk, this) == false)
+            {
+                _isPosted = false;
+            }
+        }
+
+        return;
+    }
+
+    while((_inFlight < 0) && ((flow = NextFlow(nowMs)) >= 0))
+    {
+        SendHead((unsigned char) flow, nowMs);
+    }
+}
+
+
+/*!
+ *  @brief  NextFlow
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Deficit round robin: the current flow keeps the line while its deficit
+ *      covers its next command, then the next flow with data earns its quantum.
+ *      Flows without data lose their deficit; flows whose bucket cannot pay
+ *      the next command are skipped without earning anything.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return int (flow, -1 if none can send)
+ */
+int RS9110_FairQueue::NextFlow (unsigned long nowMs)
+{
+    TFlow          *flow;
+    unsigned int    cost;
+
+
+    /* The quantum covers any command, so one turn visits every flow */
+    for(unsigned char i = 0; i <= MAX_SOCKETS; i++)
+    {
+        flow = &_flows[_current];
+
+        if(flow->stats.numQueued == 0)
+        {
+            flow->deficit = 0;
+        }
+        else
+        {
+            cost = GetHeadCost(_current);
+            Refill(flow, nowMs);
+
+            if((flow->rate == 0) || (flow->tokens >= ((long) cost * MILLI)) || (flow->tokens >= flow->maxTokens))
+            {
+                if(_isCredited == false)
+                {
+                    flow->deficit  += (unsigned long) flow->weight * QUANTUM;
+                    _isCredited     = true;
+                }
+
+                if(cost <= flow->deficit)
+                {
+                    return _current;
+                }
+            }
+        }
+
+        _current    = (unsigned char) ((_current + 1) % MAX_SOCKETS);
+        _isCredited = false;
+    }
+
+    return -1;
+}
+
+
+/*!
+ *  @brief  SendHead
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command of the oldest send of a flow and charges it to
+ *      the deficit and the bucket. A send that cannot be written is dropped.
+ *
+ *  @param[in]  flow    - Flow (socket handle - 1)
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Command in flight
+ *  @retval false   - Send dropped
+ */
+bool RS9110_FairQueue::SendHead (unsigned char flow, unsigned long nowMs)
+{
+    TFlow          *pFlow  = &_flows[flow];
+    TEntry         *entry  = &pFlow->entries[pFlow->head];
+    unsigned int    cost   = GetHeadCost(flow);
+    unsigned int    sent;
+
+
+    sent = _rs.Send((unsigned char) (flow + RS9110_UART::MIN_SOCKET_HANDLE), (RS9110_UART::ESocketType) entry->socketType,
+                    entry->host, entry->hostPort, &entry->data[entry->offset], (entry->size - entry->offset));
+
+    if((sent == 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+    {
+        Complete(flow, false, RS9110_UART::ERROR_NONE);
+        return false;
+    }
+
+    pFlow->deficit -= cost;
+
+    if(pFlow->rate != 0)
+    {
+        pFlow->tokens -= (long) cost * MILLI;
+    }
+
+    if(entry->isStarted == false)
+    {
+        unsigned long waitMs = nowMs - entry->submitMs;
+
+        entry->isStarted            = true;
+        pFlow->stats.numWaits++;
+        pFlow->stats.totalWaitMs   += waitMs;
+
+        if(waitMs > pFlow->stats.maxWaitMs)
+        {
+            pFlow->stats.maxWaitMs = waitMs;
+        }
+    }
+
+    pFlow->stats.numCommands++;
+
+    _inFlight   = flow;
+    _chunk      = sent;
+    _cost       = cost;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Complete
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees the oldest send of a flow and notifies its completion.
+ *
+ *  @param[in]  flow        - Flow (socket handle - 1)
+ *  @param[in]  isSent      - Fully acknowledged
+ *  @param[in]  eErrorCode  - Error code of the ERROR that dropped it (if any)
+ */
+void RS9110_FairQueue::Complete (unsigned char flow, bool isSent, RS9110_UART::EErrorCode eErrorCode)
+{
+    TFlow  *pFlow = &_flows[flow];
+    TEntry  entry;
+
+
+    memcpy(&entry, &pFlow->entries[pFlow->head], sizeof(entry));
+    pFlow->head = (unsigned char) ((pFlow->head + 1) % MAX_DEPTH);
+    pFlow->stats.numQueued--;
+
+    if(isSent == true)
+    {
+        pFlow->stats.numCompleted++;
+    }
+    else
+    {
+        pFlow->stats.numFailed++;
+    }
+
+    if(_completion != NULL)
+    {
+        _completion(_context, (unsigned char) (flow + RS9110_UART::MIN_SOCKET_HANDLE), entry.data, entry.size, isSent, eErrorCode);
+    }
+}
+
+
+/*!
+ *  @brief  GetHeadCost
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Works out the length after byte stuffing of the next command of the
+ *      oldest send of a flow.
+ *
+ *  @param[in]  flow    - Flow with data queued
+ *
+ *  @return unsigned int
+ */
+unsigned int RS9110_FairQueue::GetHeadCost (unsigned char flow)
+{
+    TEntry         *entry   = &_flows[flow].entries[_flows[flow].head];
+    unsigned int    cost;
+
+
+    cost = RS9110_UART::GetMaxSendSize((unsigned char) (flow + RS9110_UART::MIN_SOCKET_HANDLE), (RS9110_UART::ESocketType) entry->socketType,
+                                       entry->host, entry->hostPort);
+    RS9110_UART::FitByteStuffing(cost, &entry->data[entry->offset], (entry->size - entry->offset));
+
+    return cost;
+}
+
+
+/*!
+ *  @brief  Refill
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds the tokens earned since the last refill to the bucket of a flow.
+ *
+ *  @param[in]  flow    - Flow
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_FairQueue::Refill (TFlow *flow, unsigned long nowMs)
+{
+    unsigned long elapsedMs = nowMs - flow->refillMs;
+    unsigned long missing;
+
+
+    if(flow->rate == 0)
+    {
+        return;
+    }
+
+    flow->refillMs = nowMs;
+
+    if(flow->tokens >= flow->maxTokens)
+    {
+        return;
+    }
+
+    missing = (unsigned long) (flow->maxTokens - flow->tokens);
+
+    /* 1 ms earns "rate" thousandths of a byte */
+    if(elapsedMs >= ((missing / flow->rate) + 1))
+    {
+        flow->tokens = flow->maxTokens;
+    }
+    else
+    {
+        flow->tokens += (long) (elapsedMs * flow->rate);
+    }
+}
+
+
+/*!
+ *  @brief  IssueBulk
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #Dispatch: writes the command of the flow
+ *      picked by the round robin at the time of the last call.
+ *
+ *  @param[in]  context - Fair queue
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_FairQueue::IssueBulk (void *context, RS9110_UART &rs)
+{
+    RS9110_FairQueue   *queue = (RS9110_FairQueue *) context;
+    int                 flow;
+
+
+    (void) rs;
+
+    queue->_isPosted = false;
+
+    while((queue->_inFlight < 0) && ((flow = queue->NextFlow(queue->_nowMs)) >= 0))
+    {
+        if(queue->SendHead((unsigned char) flow, queue->_nowMs) == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,876 @@
+#include "RS9110_Fleet.h"
+
+#include "RS9110_Barrier.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckFleetModules      [((RS9110_MAX_FLEET_MODULES > 0) && (RS9110_MAX_FLEET_MODULES < 65535)) ? 1 : -1];
+typedef char CheckFleetReactors     [((RS9110_MAX_FLEET_REACTORS > 0) && (RS9110_MAX_FLEET_REACTORS <= 255)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  numReactors - Reactors the modules are spread over (1 to #MAX_REACTORS)
+ *
+ */
+RS9110_Fleet::RS9110_Fleet (unsigned char numReactors)
+  : _numModules(0),
+    _numReactors(numReactors),
+    _eOperation(OP_NONE),
+    _timeoutMs(RS9110_Pipeline::DEFAULT_TIMEOUT_MS)
+{
+    if(_numReactors == 0)
+    {
+        _numReactors = 1;
+    }
+    else if(_numReactors > MAX_REACTORS)
+    {
+        _numReactors = MAX_REACTORS;
+    }
+
+    memset(_modules, 0, sizeof(_modules));
+    memset(_reactors, 0, sizeof(_reactors));
+
+    for(unsigned char i = 0; i < MAX_REACTORS; i++)
+    {
+        _reactors[i].head = MAX_MODULES;
+    }
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Fleet::~RS9110_Fleet ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetTimeout
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets how long the answer to AT+RSI_RSSI? and AT+RSI_FWVERSION? is
+ *      waited for (provisioning uses the timeout of every #RS9110_Provision).
+ *
+ *  @param[in]  timeoutMs   - Time to wait for an answer (ms)
+ */
+void RS9110_Fleet::SetTimeout (unsigned long timeoutMs)
+{
+    _timeoutMs = timeoutMs;
+}
+
+
+/*!
+ *  @brief  Add
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds a module, pinned to the reactor with fewest modules.
+ *
+ *  @param[in]  rs          - Driver of the module
+ *  @param[in]  provision   - Provisioning of the module (NULL if OP_PROVISION is not used)
+ *
+ *  @return int
+ *  @retval >=0 - Index of the module
+ *  @retval -1  - Fleet full
+ */
+int RS9110_Fleet::Add (RS9110_UART &rs, RS9110_Provision *provision)
+{
+    unsigned short  index   = _numModules;
+    unsigned char   reactor = 0;
+    TModule        *module;
+
+
+    if(_numModules >= MAX_MODULES)
+    {
+        return -1;
+    }
+
+    for(unsigned char i = 1; i < _numReactors; i++)
+    {
+        if(_reactors[i].numModules < _reactors[reactor].numModules)
+        {
+            reactor = i;
+        }
+    }
+
+    module = &_modules[index];
+    memset(module, 0, sizeof(*module));
+    module->rs                      = &rs;
+    module->provision               = provision;
+    module->result.status           = STATUS_IDLE;
+    module->result.failedCommand    = RS9110_UART::CMD_MAX;
+    module->result.errorCode        = RS9110_UART::ERROR_NONE;
+    module->result.provision        = RS9110_Provision::RESULT_NONE;
+
+    _numModules++;
+    Link(index, reactor);
+
+    return index;
+}
+
+
+/*!
+ *  @brief  Pin
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves a module to a reactor.
+ *
+ *  @param[in]  module  - Index of the module
+ *  @param[in]  reactor - Index of the reactor
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong module or reactor
+ */
+bool RS9110_Fleet::Pin (unsigned short module, unsigned char reactor)
+{
+    if((module >= _numModules) || (reactor >= _numReactors))
+    {
+        return false;
+    }
+
+    if(_modules[module].reactor != reactor)
+    {
+        _reactors[_modules[module].reactor].load -= _modules[module].load;
+        _reactors[reactor].load                  += _modules[module].load;
+
+        Unlink(module);
+        Link(module, reactor);
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Rebalance
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Evens out the load (frames processed and commands written) of the
+ *      reactors since the last call: the busiest module that narrows the gap
+ *      is moved from the busiest reactor to the least busy one, until no move
+ *      helps. The load is cleared afterwards.
+ *
+ *  @return Number of modules moved
+ */
+unsigned short RS9110_Fleet::Rebalance ()
+{
+    unsigned short numMoved = 0;
+
+
+    while((_numReactors > 1) && (numMoved < _numModules))
+    {
+        unsigned char   busiest = 0;
+        unsigned char   idlest  = 0;
+        unsigned short  best    = MAX_MODULES;
+        unsigned long   gap;
+
+
+        for(unsigned char i = 1; i < _numReactors; i++)
+        {
+            if(_reactors[i].load > _reactors[busiest].load)
+            {
+                busiest = i;
+            }
+
+            if(_reactors[i].load < _reactors[idlest].load)
+            {
+                idlest = i;
+            }
+        }
+
+        gap = _reactors[busiest].load - _reactors[idlest].load;
+
+        /* Moving a load below the gap always narrows it */
+        for(unsigned short i = _reactors[busiest].head; i != MAX_MODULES; i = _modules[i].next)
+        {
+            if((_modules[i].load > 0) && (_modules[i].load < gap) &&
+               ((best == MAX_MODULES) || (_modules[i].load > _modules[best].load)))
+            {
+                best = i;
+            }
+        }
+
+        if(best == MAX_MODULES)
+        {
+            break;
+        }
+
+        Pin(best, idlest);
+        numMoved++;
+    }
+
+    for(unsigned short i = 0; i < _numModules; i++)
+    {
+        _modules[i].load = 0;
+    }
+
+    for(unsigned char i = 0; i < _numReactors; i++)
+    {
+        _reactors[i].load = 0;
+    }
+
+    return numMoved;
+}
+
+
+/*!
+ *  @brief  Start
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts an operation on every module. Each reactor issues it on its
+ *      own modules from its next #Poll.
+ *
+ *  @param[in]  eOperation  - Operation
+ *  @param[in]  nowMs       - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong operation or previous one not done
+ */
+bool RS9110_Fleet::Start (EOperation eOperation, unsigned long nowMs)
+{
+    if((eOperation == OP_NONE) || (eOperation >= OP_MAX) || (IsDone() == false))
+    {
+        return false;
+    }
+
+    _eOperation = eOperation;
+
+    for(unsigned short i = 0; i < _numModules; i++)
+    {
+        TResult &result = _modules[i].result;
+
+
+        memset(&result, 0, sizeof(result));
+        result.status           = STATUS_PENDING;
+        result.failedCommand    = RS9110_UART::CMD_MAX;
+        result.errorCode        = RS9110_UART::ERROR_NONE;
+        result.provision        = RS9110_Provision::RESULT_NONE;
+
+        _modules[i].startMs     = nowMs;
+    }
+
+    for(unsigned char i = 0; i < _numReactors; i++)
+    {
+        _reactors[i].numBusy = _reactors[i].numModules;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Abort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stops the current operation. Modules not done are left idle.
+ */
+void RS9110_Fleet::Abort ()
+{
+    for(unsigned short i = 0; i < _numModules; i++)
+    {
+        TModule &module = _modules[i];
+
+
+        if((module.result.status == STATUS_RUNNING) && (_eOperation == OP_PROVISION))
+        {
+            module.provision->Stop();
+        }
+
+        if((module.result.status == STATUS_PENDING) || (module.result.status == STATUS_RUNNING))
+        {
+            module.result.status = STATUS_IDLE;
+        }
+    }
+
+    for(unsigned char i = 0; i < _numReactors; i++)
+    {
+        _reactors[i].numBusy = 0;
+    }
+
+    _eOperation = OP_NONE;
+}
+
+
+/*!
+ *  @brief  ProcessMessage
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Hands a frame of a module to its driver and to the operation running
+ *      on it. Must be called from the reactor the module is pinned to.
+ *
+ *  @param[in]  module  - Index of the module
+ *  @param[in]  message - Pointer to the beginning of the incoming message
+ *  @param[in]  size    - Size of the incoming message (in bytes)
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong module or frame rejected by the driver
+ */
+bool RS9110_Fleet::ProcessMessage (unsigned short module, char *message, int size, unsigned long nowMs)
+{
+    TModule                *pModule;
+    RS9110_UART::ECommand   command;
+    bool                    bRtn;
+
+
+    if(module >= _numModules)
+    {
+        return false;
+    }
+
+    pModule = &_modules[module];
+    bRtn    = pModule->rs->ProcessMessage(message, size);
+
+    pModule->load++;
+    _reactors[pModule->reactor].load++;
+
+    if((bRtn == false) || (pModule->result.status != STATUS_RUNNING))
+    {
+        return bRtn;
+    }
+
+    if(_eOperation == OP_PROVISION)
+    {
+        pModule->provision->ProcessResponse(nowMs);
+        CheckProvision(*pModule, nowMs);
+
+        return bRtn;
+    }
+
+    command = ((_eOperation == OP_RSSI) ? RS9110_UART::CMD_GET_RSSI : RS9110_UART::CMD_FW_VERSION);
+
+    if(pModule->rs->GetLastCommand() != command)
+    {
+        return bRtn;
+    }
+
+    switch(pModule->rs->GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+        {
+            int             length;
+            const char     *data = (const char *) pModule->rs->GetResponse(length);
+
+
+            if(_eOperation == OP_RSSI)
+            {
+                pModule->result.rssi = ((length > 0) ? (unsigned char) data[0] : 0);
+            }
+            else if(length > 0)
+            {
+                if(length > MAX_VERSION_LEN)
+                {
+                    length = MAX_VERSION_LEN;
+                }
+
+                memcpy(pModule->result.version, data, length);
+                pModule->result.version[length] = '\0';
+            }
+
+            Finish(*pModule, STATUS_DONE, nowMs);
+        }
+        break;
+
+        case RS9110_UART::RESP_TYPE_ERROR:
+            pModule->result.failedCommand   = command;
+            pModule->result.errorCode       = pModule->rs->GetErrorCode();
+            Finish(*pModule, STATUS_FAILED, nowMs);
+        break;
+
+        default:
+            /* Unsolicited */
+        break;
+    }
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Runs a reactor: issues the pending operation on its modules, writes
+ *      again their commands rejected for pacing and checks the timeouts of the
+ *      running ones. Must be called periodically by the thread running the
+ *      reactor.
+ *
+ *  @param[in]  reactor - Index of the reactor
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return Modules of the reactor still pending or running
+ */
+unsigned short RS9110_Fleet::Poll (unsigned char reactor, unsigned long nowMs)
+{
+    if(reactor >= _numReactors)
+    {
+        return 0;
+    }
+
+    for(unsigned short i = _reactors[reactor].head; i != MAX_MODULES; i = _modules[i].next)
+    {
+        TModule &module = _modules[i];
+
+
+        switch(module.result.status)
+        {
+            case STATUS_PENDING:
+                Issue(module, nowMs);
+            break;
+
+            case STATUS_RUNNING:
+                /* A paced retry that cannot be written ends in a timeout */
+                module.rs->Poll();
+
+                if(_eOperation == OP_PROVISION)
+                {
+                    module.provision->Poll(nowMs);
+                    CheckProvision(module, nowMs);
+                }
+                else if((nowMs - module.startMs) >= _timeoutMs)
+                {
+                    module.result.failedCommand = ((_eOperation == OP_RSSI) ? RS9110_UART::CMD_GET_RSSI : RS9110_UART::CMD_FW_VERSION);
+                    Finish(module, STATUS_FAILED, nowMs);
+                }
+            break;
+
+            default:
+                /* Nothing to do */
+            break;
+        }
+    }
+
+    return _reactors[reactor].numBusy;
+}
+
+
+/*!
+ *  @brief  IsDone
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether the operation is over on every module. Once it is, the
+ *      results written by the reactors are seen by the calling thread.
+ *
+ *  @return bool
+ */
+bool RS9110_Fleet::IsDone ()
+{
+    for(unsigned char i = 0; i < _numReactors; i++)
+    {
+        if(_reactors[i].numBusy > 0)
+        {
+            return false;
+        }
+    }
+
+    /* The results are read after the counters */
+    RS9110_MEMORY_BARRIER();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetNumModules
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of modules added.
+ *
+ *  @return unsigned short
+ */
+unsigned short RS9110_Fleet::GetNumModules ()
+{
+    return _numModules;
+}
+
+
+/*!
+ *  @brief  GetNumReactors
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of reactors.
+ *
+ *  @return unsigned char
+ */
+unsigned char RS9110_Fleet::GetNumReactors ()
+{
+    return _numReactors;
+}
+
+
+/*!
+ *  @brief  GetReactor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the reactor a module is pinned to.
+ *
+ *  @param[in]  module  - Index of the module
+ *
+ *  @return Index of the reactor (#MAX_REACTORS if wrong module)
+ */
+unsigned char RS9110_Fleet::GetReactor (unsigned short module)
+{
+    return ((module < _numModules) ? _modules[module].reactor : MAX_REACTORS);
+}
+
+
+/*!
+ *  @brief  GetModule
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the driver of a module.
+ *
+ *  @param[in]  module  - Index of the module
+ *
+ *  @return RS9110_UART (NULL if wrong module)
+ */
+RS9110_UART * RS9110_Fleet::GetModule (unsigned short module)
+{
+    return ((module < _numModules) ? _modules[module].rs : NULL);
+}
+
+
+/*!
+ *  @brief  GetResult
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies the result of the last operation on a module.
+ *
+ *  @param[in]  module  - Index of the module
+ *  @param[out] result  - Copy of the result
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong module
+ */
+bool RS9110_Fleet::GetResult (unsigned short module, TResult &result)
+{
+    if(module >= _numModules)
+    {
+        return false;
+    }
+
+    memcpy(&result, &_modules[module].result, sizeof(result));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetCensus
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Counts the modules per firmware version after an OP_VERSION. Versions
+ *      not fitting in the table are left out.
+ *
+ *  @param[out] census      - Table of versions
+ *  @param[in]  maxEntries  - Size of the table
+ *
+ *  @return Number of versions found
+ */
+unsigned short RS9110_Fleet::GetCensus (TCensus *census, unsigned short maxEntries)
+{
+    unsigned short numEntries = 0;
+
+
+    if((census == NULL) || (_eOperation != OP_VERSION))
+    {
+        return 0;
+    }
+
+    for(unsigned short i = 0; i < _numModules; i++)
+    {
+        const TResult  &result  = _modules[i].result;
+        unsigned short  entry   = 0;
+
+
+        if(result.status != STATUS_DONE)
+        {
+            continue;
+        }
+
+        while((entry < numEntries) && (strcmp(census[entry].version, result.version) != 0))
+        {
+            entry++;
+        }
+
+        if(entry == numEntries)
+        {
+            if(numEntries >= maxEntries)
+            {
+                continue;
+            }
+
+            memcpy(census[entry].version, result.version, sizeof(census[entry].version));
+            census[entry].count = 0;
+            numEntries++;
+        }
+
+        census[entry].count++;
+    }
+
+    return numEntries;
+}
+
+
+/*!
+ *  @brief  GetReactorStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the counters of a reactor.
+ *
+ *  @param[in]  reactor - Index of the reactor
+ *  @param[out] stats   - Copy of the counters (zeroed if wrong reactor)
+ */
+void RS9110_Fleet::GetReactorStats (unsigned char reactor, TReactorStats &stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    if(reactor < _numReactors)
+    {
+        stats.numModules    = _reactors[reactor].numModules;
+        stats.numBusy       = _reactors[reactor].numBusy;
+        stats.load          = _reactors[reactor].load;
+        stats.numDone       = _reactors[reactor].numDone;
+        stats.numFailed     = _reactors[reactor].numFailed;
+    }
+}
+
+
+/*!
+ *  @brief  Link
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Pins a module to a reactor.
+ *
+ *  @param[in]  module  - Index of the module
+ *  @param[in]  reactor - Index of the reactor
+ */
+void RS9110_Fleet::Link (unsigned short module, unsigned char reactor)
+{
+    TModule &entry = _modules[module];
+
+
+    entry.reactor   = reactor;
+    entry.next      = _reactors[reactor].head;
+
+    _reactors[reactor].head = module;
+    _reactors[reactor].numModules++;
+
+    if((entry.result.status == STATUS_PENDING) || (entry.result.status == STATUS_RUNNING))
+    {
+        _reactors[reactor].numBusy++;
+    }
+}
+
+
+/*!
+ *  @brief  Unlink
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Removes a module from its reactor.
+ *
+ *  @param[in]  module  - Index of the module
+ */
+void RS9110_Fleet::Unlink (unsigned short module)
+{
+    TModule        &entry   = _modules[module];
+    TReactor       &reactor = _reactors[entry.reactor];
+    unsigned short *link    = &reactor.head;
+
+
+    while(*link != module)
+    {
+        link = &_modules[*link].next;
+    }
+
+    *link = entry.next;
+    reactor.numModules--;
+
+    if((entry.result.status == STATUS_PENDING) || (entry.result.status == STATUS_RUNNING))
+    {
+        reactor.numBusy--;
+    }
+}
+
+
+/*!
+ *  @brief  Issue
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts the operation on a module.
+ *
+ *  @param[in]  module  - Module
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Fleet::Issue (TModule &module, unsigned long nowMs)
+{
+    bool bRtn = false;
+
+
+    module.result.status    = STATUS_RUNNING;
+    module.startMs          = nowMs;
+    module.load++;
+    _reactors[module.reactor].load++;
+
+    switch(_eOperation)
+    {
+        case OP_PROVISION:
+            if((module.provision != NULL) && (module.provision->Start(nowMs) == true))
+            {
+                CheckProvision(module, nowMs);
+                return;
+            }
+        break;
+
+        case OP_RSSI:
+            module.result.failedCommand = RS9110_UART::CMD_GET_RSSI;
+            bRtn = module.rs->GetRSSI();
+        break;
+
+        case OP_VERSION:
+            module.result.failedCommand = RS9110_UART::CMD_FW_VERSION;
+            bRtn = module.rs->GetFirmwareVersion();
+        break;
+
+        default:
+            /* Nothing to do */
+        break;
+    }
+
+    if(bRtn == true)
+    {
+        module.result.failedCommand = RS9110_UART::CMD_MAX;
+    }
+    else
+    {
+        Finish(module, STATUS_FAILED, nowMs);
+    }
+}
+
+
+/*!
+ *  @brief  CheckProvision
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Picks up the outcome of the provisioning of a module, if over.
+ *
+ *  @param[in]  module  - Module
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Fleet::CheckProvision (TModule &module, unsigned long nowMs)
+{
+    switch(module.provision->GetState())
+    {
+        case RS9110_Provision::STATE_DONE:
+            module.result.provision = module.provision->GetResult();
+            Finish(module, STATUS_DONE, nowMs);
+        break;
+
+        case RS9110_Provision::STATE_FAILED:
+            module.result.failedCommand = module.provision->GetFailedCommand();
+            module.result.errorCode     = module.provision->GetErrorCode();
+            Finish(module, STATUS_FAILED, nowMs);
+        break;
+
+        default:
+            /* Still running */
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Finish
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Ends the operation on a module.
+ *
+ *  @param[in]  module  - Module
+ *  @param[in]  eStatus - STATUS_DONE or STATUS_FAILED
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Fleet::Finish (TModule &module, EStatus eStatus, unsigned long nowMs)
+{
+    TReactor &reactor = _reactors[module.reactor];
+
+
+    module.result.status    = eStatus;
+    module.result.elapsedMs = nowMs - module.startMs;
+
+    if(eStatus == STATUS_DONE)
+    {
+        reactor.numDone++;
+    }
+    else
+    {
+        reactor.numFailed++;
+    }
+
+    /* The result is complete before #IsDone sees the module done */
+    RS9110_MEMORY_BARRIER();
+
+    reactor.numBusy--;
+}
@@ -0,0 +1,1047 @@
+#include "RS9110_Mux.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckMuxClients        [((RS9110_MAX_MUX_CLIENTS > 0) && (RS9110_MAX_MUX_CLIENTS <= 255)) ? 1 : -1];
+typedef char CheckMuxVSockets       [((RS9110_MAX_MUX_VSOCKETS > 0) && (RS9110_MAX_MUX_VSOCKETS <= 255)) ? 1 : -1];
+typedef char CheckMuxRequests       [((RS9110_MAX_MUX_REQUESTS > 0) && (RS9110_MAX_MUX_REQUESTS <= 255)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver of the shared module
+ *
+ */
+RS9110_Mux::RS9110_Mux (RS9110_UART &rs)
+  : _rs(rs),
+    _notify(NULL),
+    _context(NULL),
+    _command(RS9110_UART::CMD_MAX),
+    _client(0),
+    _vsock(0),
+    _chunk(0),
+    _next(0)
+{
+    memset(_clients, 0, sizeof(_clients));
+    memset(_owners, 0, sizeof(_owners));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Mux::~RS9110_Mux ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetNotify
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets where the events for the clients are sent.
+ *
+ *  @param[in]  notify  - Called with every event (may be NULL)
+ *  @param[in]  context - Given back to notify
+ */
+void RS9110_Mux::SetNotify (TNotify notify, void *context)
+{
+    _notify     = notify;
+    _context    = context;
+}
+
+
+/*!
+ *  @brief  Attach
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds a client with its rings (already attached to their memory).
+ *
+ *  @param[in]  txRing  - Records from the client (the mux consumes them)
+ *  @param[in]  rxRing  - Records to the client (the mux produces them)
+ *
+ *  @return int
+ *  @retval >=0 - Index of the client
+ *  @retval -1  - No free client or missing ring
+ */
+int RS9110_Mux::Attach (RS9110_Ring *txRing, RS9110_Ring *rxRing)
+{
+    if((txRing == NULL) || (rxRing == NULL))
+    {
+        return -1;
+    }
+
+    for(unsigned char i = 0; i < MAX_CLIENTS; i++)
+    {
+        if(_clients[i].isUsed == false)
+        {
+            memset(&_clients[i], 0, sizeof(_clients[i]));
+            _clients[i].isUsed  = true;
+            _clients[i].txRing  = txRing;
+            _clients[i].rxRing  = rxRing;
+
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/*!
+ *  @brief  Detach
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Removes a client: its rings are not touched any more, its queued
+ *      requests are dropped and its sockets closed. The slot is freed once
+ *      they are all closed. No event is sent to it any more.
+ *
+ *  @param[in]  client  - Index of the client
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong client
+ */
+bool RS9110_Mux::Detach (unsigned char client)
+{
+    if(IsAttached(client) == false)
+    {
+        return false;
+    }
+
+    DetachClient(client);
+    Dispatch();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  IsAttached
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether a client is attached (and not being detached).
+ *
+ *  @param[in]  client  - Index of the client
+ *
+ *  @return bool
+ */
+bool RS9110_Mux::IsAttached (unsigned char client)
+{
+    return ((client < MAX_CLIENTS) && (_clients[client].isUsed == true) && (_clients[client].isDetaching == false));
+}
+
+
+/*!
+ *  @brief  Request
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Queues an open or a close of a virtual socket, answered later with
+ *      EVT_OPENED or EVT_CLOSED. REQ_WAKE only looks for new TX records.
+ *
+ *  @param[in]  client  - Index of the client
+ *  @param[in]  request - Request
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong client or request, or queue full
+ */
+bool RS9110_Mux::Request (unsigned char client, const TRequest &request)
+{
+    TClient    *pClient;
+    TVSocket   *vs;
+
+
+    if(IsAttached(client) == false)
+    {
+        return false;
+    }
+
+    if(request.type == REQ_WAKE)
+    {
+        Dispatch();
+        return true;
+    }
+
+    pClient = &_clients[client];
+
+    if((request.type >= REQ_MAX) || (request.vsock == 0) || (request.vsock > MAX_VSOCKETS) ||
+       (pClient->reqCount >= MAX_REQUESTS))
+    {
+        return false;
+    }
+
+    vs = &pClient->vsockets[request.vsock - 1];
+
+    if(request.type == REQ_OPEN)
+    {
+        if((vs->state != VSOCK_FREE) ||
+           ((request.socketType != RS9110_UART::SOCKET_TCP) && (request.socketType != RS9110_UART::SOCKET_UDP) &&
+            (request.socketType != RS9110_UART::SOCKET_LTCP) && (request.socketType != RS9110_UART::SOCKET_LUDP)) ||
+           (memchr(request.host, '\0', sizeof(request.host)) == NULL))
+        {
+            return false;
+        }
+
+        vs->state       = VSOCK_OPENING;
+        vs->handle      = 0;
+        vs->socketType  = request.socketType;
+        vs->remotePort  = request.remotePort;
+        memcpy(vs->host, request.host, sizeof(vs->host));
+    }
+    else
+    {
+        if(vs->state != VSOCK_OPEN)
+        {
+            return false;
+        }
+
+        vs->state = VSOCK_CLOSING;
+    }
+
+    memcpy(&pClient->requests[(pClient->reqHead + pClient->reqCount) % MAX_REQUESTS], &request, sizeof(request));
+    pClient->reqCount++;
+
+    Dispatch();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Handles the message just parsed by the driver: the OK/ERROR of the
+ *      command in flight, READ frames (to the RX ring of the owner) and
+ *      CLOSE. Then writes the next command.
+ *
+ *  @return bool
+ *  @retval true    - Message handled by the mux
+ *  @retval false   - Not related to the mux
+ */
+bool RS9110_Mux::ProcessResponse ()
+{
+    bool bRtn = true;
+
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if((_command == RS9110_UART::CMD_MAX) || (_rs.GetLastCommand() != _command))
+            {
+                return false;
+            }
+
+            Answered(_rs.GetResponseType() == RS9110_UART::RESP_TYPE_OK);
+        break;
+
+        case RS9110_UART::RESP_TYPE_READ:
+            Received();
+        break;
+
+        case RS9110_UART::RESP_TYPE_CLOSE:
+            Closed();
+        break;
+
+        default:
+            bRtn = false;
+        break;
+    }
+
+    Dispatch();
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command if the module is free.
+ */
+void RS9110_Mux::Poll ()
+{
+    Dispatch();
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether no command is waiting for its answer.
+ *
+ *  @return bool
+ */
+bool RS9110_Mux::IsIdle ()
+{
+    return (_command == RS9110_UART::CMD_MAX);
+}
+
+
+/*!
+ *  @brief  GetHandle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the module handle a virtual socket is mapped onto.
+ *
+ *  @param[in]  client  - Index of the client
+ *  @param[in]  vsock   - Virtual socket
+ *
+ *  @return Handle (0 if not open)
+ */
+unsigned char RS9110_Mux::GetHandle (unsigned char client, unsigned char vsock)
+{
+    if((client >= MAX_CLIENTS) || (_clients[client].isUsed == false) || (vsock == 0) || (vsock > MAX_VSOCKETS))
+    {
+        return 0;
+    }
+
+    return _clients[client].vsockets[vsock - 1].handle;
+}
+
+
+/*!
+ *  @brief  GetClientStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the counters of a client.
+ *
+ *  @param[in]  client  - Index of the client
+ *  @param[out] stats   - Copy of the counters
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong client
+ */
+bool RS9110_Mux::GetClientStats (unsigned char client, TClientStats &stats)
+{
+    if((client >= MAX_CLIENTS) || (_clients[client].isUsed == false))
+    {
+        return false;
+    }
+
+    memcpy(&stats, &_clients[client].stats, sizeof(stats));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  DetachClient
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Forgets the rings and queued requests of a client and leaves its
+ *      sockets to be closed by #Issue.
+ *
+ *  @param[in]  client  - Index of the client
+ */
+void RS9110_Mux::DetachClient (unsigned char client)
+{
+    TClient *pClient = &_clients[client];
+
+
+    pClient->isDetaching    = true;
+    pClient->txRing         = NULL;
+    pClient->rxRing         = NULL;
+    pClient->reqCount       = 0;
+    pClient->offset         = 0;
+
+    for(unsigned char i = 0; i < MAX_VSOCKETS; i++)
+    {
+        TVSocket &vs = pClient->vsockets[i];
+
+
+        /* Only the open in flight is still to come */
+        if((vs.state == VSOCK_OPENING) &&
+           ((_command == RS9110_UART::CMD_MAX) || (_client != client) || (_vsock != (i + 1))))
+        {
+            vs.state = VSOCK_FREE;
+        }
+        else if(vs.state == VSOCK_CLOSING)
+        {
+            vs.state = VSOCK_OPEN;
+        }
+    }
+
+    CheckDetached(client);
+}
+
+
+/*!
+ *  @brief  Expel
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Detaches a client whose ring is corrupt, telling it first with
+ *      EVT_DETACHED. Nothing more is read from or written to its memory.
+ *
+ *  @param[in]  client  - Index of the client
+ */
+void RS9110_Mux::Expel (unsigned char client)
+{
+    Notify(client, EVT_DETACHED, 0, false);
+    DetachClient(client);
+}
+
+
+/*!
+ *  @brief  Dispatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command, if the module is free, serving the clients
+ *      in round robin.
+ */
+void RS9110_Mux::Dispatch ()
+{
+    for(unsigned char i = 0; (i < MAX_CLIENTS) && (_command == RS9110_UART::CMD_MAX); i++)
+    {
+        unsigned char client = (unsigned char) ((_next + i) % MAX_CLIENTS);
+
+
+        if(Issue(client) == true)
+        {
+            _next = (unsigned char) ((client + 1) % MAX_CLIENTS);
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Issue
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command of a client: the close of its sockets when it
+ *      is being detached, else its next request, else its next TX record.
+ *
+ *  @param[in]  client  - Index of the client
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Nothing to write
+ */
+bool RS9110_Mux::Issue (unsigned char client)
+{
+    TClient *pClient = &_clients[client];
+
+
+    if(pClient->isUsed == false)
+    {
+        return false;
+    }
+
+    if(pClient->isDetaching == true)
+    {
+        for(unsigned char i = 0; i < MAX_VSOCKETS; i++)
+        {
+            TVSocket &vs = pClient->vsockets[i];
+
+
+            if(vs.state != VSOCK_OPEN)
+            {
+                continue;
+            }
+
+            if(_rs.CloseSocket(vs.handle) == true)
+            {
+                vs.state    = VSOCK_CLOSING;
+                _command    = RS9110_UART::CMD_CLOSE_SOCKET;
+                _client     = client;
+                _vsock      = (unsigned char) (i + 1);
+                pClient->stats.numCommands++;
+
+                return true;
+            }
+
+            Release(client, (unsigned char) (i + 1));
+        }
+
+        CheckDetached(client);
+
+        return false;
+    }
+
+    while(pClient->reqCount > 0)
+    {
+        TRequest request;
+
+
+        memcpy(&request, &pClient->requests[pClient->reqHead], sizeof(request));
+        pClient->reqHead = (unsigned char) ((pClient->reqHead + 1) % MAX_REQUESTS);
+        pClient->reqCount--;
+
+        if(IssueRequest(client, request) == true)
+        {
+            return true;
+        }
+    }
+
+    return IssueSend(client);
+}
+
+
+/*!
+ *  @brief  IssueRequest
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the command of an open or close request. A command that cannot
+ *      be written is answered at once.
+ *
+ *  @param[in]  client  - Index of the client
+ *  @param[in]  request - Request
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Failed (already answered)
+ */
+bool RS9110_Mux::IssueRequest (unsigned char client, const TRequest &request)
+{
+    TVSocket               &vs      = _clients[client].vsockets[request.vsock - 1];
+    RS9110_UART::ECommand   command = RS9110_UART::CMD_MAX;
+    bool                    bRtn    = false;
+
+
+    if(request.type == REQ_OPEN)
+    {
+        switch(request.socketType)
+        {
+            case RS9110_UART::SOCKET_TCP:
+                command = RS9110_UART::CMD_OPEN_TCP_SOCKET;
+                bRtn    = _rs.OpenTcpSocket(request.host, request.remotePort, request.localPort);
+            break;
+
+            case RS9110_UART::SOCKET_UDP:
+                command = RS9110_UART::CMD_OPEN_UDP_SOCKET;
+                bRtn    = _rs.OpenUdpSocket(request.host, request.remotePort, request.localPort);
+            break;
+
+            case RS9110_UART::SOCKET_LTCP:
+                command = RS9110_UART::CMD_OPEN_LTCP_SOCKET;
+                bRtn    = _rs.OpenListeningTcpSocket(request.localPort);
+            break;
+
+            default:
+                command = RS9110_UART::CMD_OPEN_LUDP_SOCKET;
+                bRtn    = _rs.OpenListeningUdpSocket(request.localPort);
+            break;
+        }
+
+        if(bRtn == false)
+        {
+            vs.state = VSOCK_FREE;
+            Notify(client, EVT_OPENED, request.vsock, false);
+        }
+    }
+    else
+    {
+        command = RS9110_UART::CMD_CLOSE_SOCKET;
+        bRtn    = _rs.CloseSocket(vs.handle);
+
+        if(bRtn == false)
+        {
+            vs.state = VSOCK_OPEN;
+            Notify(client, EVT_CLOSED, request.vsock, false);
+        }
+    }
+
+    if(bRtn == true)
+    {
+        _command    = command;
+        _client     = client;
+        _vsock      = request.vsock;
+        _clients[client].stats.numCommands++;
+    }
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  IssueSend
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next part of the oldest TX record of a client, straight
+ *      from the ring. Records for sockets not open are dropped. A corrupt
+ *      ring, or a record shrunk below the part already sent, expels the
+ *      client.
+ *
+ *  @param[in]  client  - Index of the client
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Nothing to write
+ */
+bool RS9110_Mux::IssueSend (unsigned char client)
+{
+    TClient        *pClient = &_clients[client];
+    const char     *record;
+    unsigned short  size;
+
+
+    while((record = pClient->txRing->Peek(size)) != NULL)
+    {
+        TDataHeader                 header;
+        TVSocket                   *vs;
+        RS9110_UART::ESocketType    socketType  = RS9110_UART::SOCKET_TCP;
+        const char                 *host        = NULL;
+        unsigned short              port        = 0;
+        char                        address[MAX_ADDRESS_LEN + 1];
+        unsigned int                sent;
+
+
+        if(size < sizeof(header))
+        {
+            DropRecord(client, 0, RS9110_UART::ERROR_NONE);
+            continue;
+        }
+
+        memcpy(&header, record, sizeof(header));
+
+        if((header.vsock == 0) || (header.vsock > MAX_VSOCKETS) ||
+           (pClient->vsockets[header.vsock - 1].state != VSOCK_OPEN))
+        {
+            DropRecord(client, header.vsock, RS9110_UART::ERROR_NONE);
+            continue;
+        }
+
+        vs = &pClient->vsockets[header.vsock - 1];
+
+        if((pClient->offset > 0) && ((sizeof(header) + pClient->offset) >= size))
+        {
+            break;
+        }
+
+        if(size == sizeof(header))
+        {
+            pClient->txRing->Release();
+            pClient->stats.numSent++;
+            continue;
+        }
+
+        switch(vs->socketType)
+        {
+            case RS9110_UART::SOCKET_UDP:
+                socketType  = RS9110_UART::SOCKET_UDP;
+                host        = vs->host;
+                port        = vs->remotePort;
+            break;
+
+            case RS9110_UART::SOCKET_LUDP:
+                RS9110_UART::Format(address, sizeof(address), "%u.%u.%u.%u",
+                                    header.address[0], header.address[1], header.address[2], header.address[3]);
+                socketType  = RS9110_UART::SOCKET_UDP;
+                host        = address;
+                port        = header.port;
+            break;
+
+            default:
+                /* TCP and LTCP */
+            break;
+        }
+
+        sent = _rs.Send(vs->handle, socketType, host, port, &record[sizeof(header) + pClient->offset],
+                        size - sizeof(header) - pClient->offset);
+
+        if(sent == 0)
+        {
+            DropRecord(client, header.vsock, RS9110_UART::ERROR_NONE);
+            continue;
+        }
+
+        _command    = RS9110_UART::CMD_SEND_DATA;
+        _client     = client;
+        _vsock      = header.vsock;
+        _chunk      = sent;
+        pClient->stats.numCommands++;
+
+        return true;
+    }
+
+    if((record != NULL) || (pClient->txRing->IsCorrupt() == true))
+    {
+        Expel(client);
+
+        return Issue(client);
+    }
+
+    return false;
+}
+
+
+/*!
+ *  @brief  Answered
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Handles the OK/ERROR of the command in flight.
+ *
+ *  @param[in]  isOk    - OK received
+ */
+void RS9110_Mux::Answered (bool isOk)
+{
+    TClient                *pClient     = &_clients[_client];
+    TVSocket               &vs          = pClient->vsockets[_vsock - 1];
+    RS9110_UART::ECommand   command     = _command;
+    RS9110_UART::EErrorCode eErrorCode  = (isOk ? RS9110_UART::ERROR_NONE : _rs.GetErrorCode());
+
+
+    _command = RS9110_UART::CMD_MAX;
+
+    switch(command)
+    {
+        case RS9110_UART::CMD_SEND_DATA:
+            if(pClient->txRing == NULL)
+            {
+                /* Detached meanwhile */
+                break;
+            }
+
+            if(isOk == true)
+            {
+                unsigned short size;
+
+
+                pClient->offset             += _chunk;
+                pClient->stats.bytesSent    += _chunk;
+
+                if((pClient->txRing->Peek(size) != NULL) && ((sizeof(TDataHeader) + pClient->offset) >= size))
+                {
+                    pClient->txRing->Release();
+                    pClient->offset = 0;
+                    pClient->stats.numSent++;
+                }
+            }
+            else if(eErrorCode != RS9110_UART::ERROR_SEND_DATA_TOO_FAST)
+            {
+                DropRecord(_client, _vsock, eErrorCode);
+            }
+        break;
+
+        case RS9110_UART::CMD_CLOSE_SOCKET:
+            if((isOk == true) || (pClient->isDetaching == true))
+            {
+                Release(_client, _vsock);
+                Notify(_client, EVT_CLOSED, _vsock, isOk, eErrorCode);
+                CheckDetached(_client);
+            }
+            else
+            {
+                vs.state = VSOCK_OPEN;
+                Notify(_client, EVT_CLOSED, _vsock, false, eErrorCode);
+            }
+        break;
+
+        default:
+        {
+            /* Opens: the handle comes in the OK */
+            int             length;
+            unsigned char  *response    = (unsigned char *) _rs.GetResponse(length);
+            unsigned char   handle      = (((isOk == true) && (length > 0)) ? response[0] : 0);
+
+
+            if((handle == 0) || (handle > RS9110_UART::MAX_SOCKET_HANDLE))
+            {
+                vs.state = VSOCK_FREE;
+                Notify(_client, EVT_OPENED, _vsock, false, eErrorCode);
+                CheckDetached(_client);
+                break;
+            }
+
+            vs.state                        = VSOCK_OPEN;
+            vs.handle                       = handle;
+            _owners[handle - 1].client      = _client;
+            _owners[handle - 1].vsock       = _vsock;
+
+            Notify(_client, EVT_OPENED, _vsock, true);
+        }
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Received
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies a READ frame to the RX ring of the owner of its socket.
+ */
+void RS9110_Mux::Received ()
+{
+    RS9110_UART::TReadTCP   readTCP;
+    RS9110_UART::TReadUDP   readUDP;
+    TDataHeader             header;
+    TClient                *pClient;
+    const char             *data;
+    unsigned short          size;
+    char                   *record;
+
+
+    _rs.Read(readTCP);
+
+    if((readTCP.socketId == 0) || (readTCP.socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       (_owners[readTCP.socketId - 1].vsock == 0))
+    {
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.vsock    = _owners[readTCP.socketId - 1].vsock;
+    pClient         = &_clients[_owners[readTCP.socketId - 1].client];
+    data            = readTCP.data;
+    size            = readTCP.size;
+
+    switch(pClient->vsockets[header.vsock - 1].socketType)
+    {
+        case RS9110_UART::SOCKET_UDP:
+        case RS9110_UART::SOCKET_LUDP:
+            _rs.Read(readUDP);
+            memcpy(header.address, readUDP.address, sizeof(header.address));
+            header.port = (unsigned short) ((((unsigned char *) &readUDP.srcPort)[0] << 8) |
+                                            ((unsigned char *) &readUDP.srcPort)[1]);
+            data        = readUDP.data;
+            size        = readUDP.size;
+        break;
+
+        default:
+            /* TCP and LTCP */
+        break;
+    }
+
+    if(pClient->rxRing == NULL)
+    {
+        return;
+    }
+
+    record = pClient->rxRing->Reserve((unsigned short) (sizeof(header) + size));
+
+    if((record == NULL) && (pClient->rxRing->IsCorrupt() == true))
+    {
+        Expel(_owners[readTCP.socketId - 1].client);
+        return;
+    }
+
+    if(record == NULL)
+    {
+        pClient->stats.numOverflows++;
+
+        if(pClient->isOverflowing == false)
+        {
+            pClient->isOverflowing = true;
+            Notify(_owners[readTCP.socketId - 1].client, EVT_OVERFLOW, header.vsock, false);
+        }
+
+        return;
+    }
+
+    memcpy(record, &header, sizeof(header));
+    memcpy(&record[sizeof(header)], data, size);
+    pClient->rxRing->Commit((unsigned short) (sizeof(header) + size));
+
+    pClient->isOverflowing          = false;
+    pClient->stats.bytesReceived   += size;
+}
+
+
+/*!
+ *  @brief  Closed
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Releases the virtual sockets whose handle was closed by the module.
+ */
+void RS9110_Mux::Closed ()
+{
+    for(unsigned char i = 0; i < RS9110_UART::MAX_SOCKET_HANDLE; i++)
+    {
+        unsigned char client    = _owners[i].client;
+        unsigned char vsock     = _owners[i].vsock;
+
+
+        if((vsock == 0) || (_rs.IsSocketOpen((unsigned char) (i + 1)) == true))
+        {
+            continue;
+        }
+
+        /* A close in flight is answered by its own OK/ERROR */
+        if((_command == RS9110_UART::CMD_CLOSE_SOCKET) && (_client == client) && (_vsock == vsock))
+        {
+            continue;
+        }
+
+        Release(client, vsock);
+        Notify(client, EVT_CLOSED, vsock, true);
+        CheckDetached(client);
+    }
+}
+
+
+/*!
+ *  @brief  Release
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees a virtual socket and its module handle.
+ *
+ *  @param[in]  client  - Index of the client
+ *  @param[in]  vsock   - Virtual socket
+ */
+void RS9110_Mux::Release (unsigned char client, unsigned char vsock)
+{
+    TVSocket &vs = _clients[client].vsockets[vsock - 1];
+
+
+    if((vs.handle > 0) && (vs.handle <= RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        _owners[vs.handle - 1].vsock = 0;
+    }
+
+    vs.state    = VSOCK_FREE;
+    vs.handle   = 0;
+}
+
+
+/*!
+ *  @brief  DropRecord
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops the oldest TX record of a client.
+ *
+ *  @param[in]  client      - Index of the client
+ *  @param[in]  vsock       - Virtual socket of the record
+ *  @param[in]  eErrorCode  - Reason (ERROR_NONE if not sent)
+ */
+void RS9110_Mux::DropRecord (unsigned char client, unsigned char vsock, RS9110_UART::EErrorCode eErrorCode)
+{
+    TClient *pClient = &_clients[client];
+
+
+    pClient->txRing->Release();
+    pClient->offset = 0;
+    pClient->stats.numSendFailed++;
+
+    Notify(client, EVT_SEND_FAILED, vsock, false, eErrorCode);
+}
+
+
+/*!
+ *  @brief  Notify
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends an event to a client, unless it is being detached.
+ *
+ *  @param[in]  client      - Index of the client
+ *  @param[in]  eEvent      - Event
+ *  @param[in]  vsock       - Virtual socket
+ *  @param[in]  isOk        - Success
+ *  @param[in]  eErrorCode  - Error code of the module
+ */
+void RS9110_Mux::Notify (unsigned char client, EEvent eEvent, unsigned char vsock, bool isOk, RS9110_UART::EErrorCode eErrorCode)
+{
+    TEvent event;
+
+
+    if((_notify == NULL) || (_clients[client].isDetaching == true))
+    {
+        return;
+    }
+
+    event.type      = (unsigned char) eEvent;
+    event.vsock     = vsock;
+    event.isOk      = (unsigned char) isOk;
+    event.errorCode = (unsigned char) eErrorCode;
+
+    _notify(_context, client, event);
+}
+
+
+/*!
+ *  @brief  CheckDetached
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees the slot of a client being detached once all its sockets are
+ *      closed and no command of it is in flight.
+ *
+ *  @param[in]  client  - Index of the client
+ */
+void RS9110_Mux::CheckDetached (unsigned char client)
+{
+    TClient *pClient = &_clients[client];
+
+
+    if((pClient->isUsed == false) || (pClient->isDetaching == false) ||
+       ((_command != RS9110_UART::CMD_MAX) && (_client == client)))
+    {
+        return;
+    }
+
+    for(unsigned char i = 0; i < MAX_VSOCKETS; i++)
+    {
+        if(pClient->vsockets[i].state != VSOCK_FREE)
+        {
+            return;
+        }
+    }
+
+    pClient->isUsed = false;
+}
@@ -0,0 +1,484 @@
+#include "RS9110_MuxServer.h"
+
+#if defined (__linux__) && !defined (WIN32) && !defined (AVR32)
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckMuxRing           [((RS9110_MAX_MUX_RING >= 1024) && (RS9110_MAX_MUX_RING <= 0x40000000)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor. The events of the mux are sent to the clients from now on.
+ *
+ *  @param[in]  mux - Mux served
+ *
+ */
+RS9110_MuxServer::RS9110_MuxServer (RS9110_Mux &mux)
+  : _mux(mux),
+    _listenFd(-1),
+    _numShm(0)
+{
+    _path[0] = '\0';
+
+    for(unsigned char i = 0; i < RS9110_Mux::MAX_CLIENTS; i++)
+    {
+        _sessions[i].fd     = -1;
+        _sessions[i].memory = NULL;
+    }
+
+    _mux.SetNotify(Notify, this);
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_MuxServer::~RS9110_MuxServer ()
+{
+    Close();
+    _mux.SetNotify(NULL, NULL);
+}
+
+
+/*!
+ *  @brief  Listen
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Creates the Unix domain socket the clients connect to (a stale one
+ *      left by a previous run is removed).
+ *
+ *  @param[in]  path    - Path of the socket
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Already listening or socket error
+ */
+bool RS9110_MuxServer::Listen (const char *path)
+{
+    struct sockaddr_un address;
+
+
+    if((_listenFd >= 0) || (path == NULL) || (strlen(path) >= sizeof(address.sun_path)))
+    {
+        return false;
+    }
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if(_listenFd < 0)
+    {
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+
+    if((bind(_listenFd, (struct sockaddr *) &address, sizeof(address)) != 0) ||
+       (listen(_listenFd, RS9110_Mux::MAX_CLIENTS) != 0))
+    {
+        close(_listenFd);
+        _listenFd = -1;
+
+        return false;
+    }
+
+    strcpy(_path, path);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Waits for new clients, requests or disconnections, handles them and
+ *      lets the mux write its next command.
+ *
+ *  @param[in]  timeoutMs   - Longest wait (0 does not wait, -1 waits forever)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Not listening or poll error
+ */
+bool RS9110_MuxServer::Poll (int timeoutMs)
+{
+    struct pollfd   fds[RS9110_Mux::MAX_CLIENTS + 1];
+    TSession       *sessions[RS9110_Mux::MAX_CLIENTS + 1];
+    nfds_t          numFds = 0;
+    int             rc;
+
+
+    if(_listenFd < 0)
+    {
+        return false;
+    }
+
+    fds[numFds].fd          = _listenFd;
+    fds[numFds].events      = POLLIN;
+    sessions[numFds]        = NULL;
+    numFds++;
+
+    for(unsigned char i = 0; i < RS9110_Mux::MAX_CLIENTS; i++)
+    {
+        if(_sessions[i].fd >= 0)
+        {
+            fds[numFds].fd      = _sessions[i].fd;
+            fds[numFds].events  = POLLIN;
+            sessions[numFds]    = &_sessions[i];
+            numFds++;
+        }
+    }
+
+    rc = poll(fds, numFds, timeoutMs);
+
+    if((rc < 0) && (errno != EINTR))
+    {
+        return false;
+    }
+
+    for(nfds_t i = 1; (rc > 0) && (i < numFds); i++)
+    {
+        if(fds[i].revents != 0)
+        {
+            Receive(*sessions[i]);
+        }
+    }
+
+    if((rc > 0) && (fds[0].revents != 0))
+    {
+        Accept();
+    }
+
+    _mux.Poll();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Close
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops every client and removes the socket.
+ */
+void RS9110_MuxServer::Close ()
+{
+    for(unsigned char i = 0; i < RS9110_Mux::MAX_CLIENTS; i++)
+    {
+        if(_sessions[i].fd >= 0)
+        {
+            Drop(_sessions[i]);
+        }
+    }
+
+    if(_listenFd >= 0)
+    {
+        close(_listenFd);
+        unlink(_path);
+        _listenFd   = -1;
+        _path[0]    = '\0';
+    }
+}
+
+
+/*!
+ *  @brief  GetRxOffset
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns where the RX ring starts in the shared memory object.
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_MuxServer::GetRxOffset ()
+{
+    return ((RS9110_Ring::GetFootprint(RING_SIZE) + 63) & ~63UL);
+}
+
+
+/*!
+ *  @brief  GetShmSize
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the size of the shared memory object of a client.
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_MuxServer::GetShmSize ()
+{
+    return (GetRxOffset() + RS9110_Ring::GetFootprint(RING_SIZE));
+}
+
+
+/*!
+ *  @brief  Accept
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Accepts a client: creates its shared memory, attaches its rings to the
+ *      mux and sends it the #TWelcome. Clients over #RS9110_Mux::MAX_CLIENTS
+ *      are closed at once.
+ */
+void RS9110_MuxServer::Accept ()
+{
+    TSession   *session = NULL;
+    TWelcome    welcome;
+    int         fd;
+    int         shmFd;
+
+
+    fd = accept4(_listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if(fd < 0)
+    {
+        return;
+    }
+
+    for(unsigned char i = 0; (i < RS9110_Mux::MAX_CLIENTS) && (session == NULL); i++)
+    {
+        if(_sessions[i].fd < 0)
+        {
+            session = &_sessions[i];
+        }
+    }
+
+    if(session == NULL)
+    {
+        close(fd);
+        return;
+    }
+
+    snprintf(session->shmName, sizeof(session->shmName), "/rs9110-%ld-%lu", (long) getpid(), _numShm++);
+    shmFd = shm_open(session->shmName, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if(shmFd < 0)
+    {
+        close(fd);
+        return;
+    }
+
+    if(ftruncate(shmFd, GetShmSize()) == 0)
+    {
+        session->memory = mmap(NULL, GetShmSize(), PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    }
+
+    close(shmFd);
+
+    if((session->memory == NULL) || (session->memory == MAP_FAILED))
+    {
+        session->memory = NULL;
+        shm_unlink(session->shmName);
+        close(fd);
+        return;
+    }
+
+    session->txRing.Attach(session->memory, RS9110_Ring::GetFootprint(RING_SIZE), true);
+    session->rxRing.Attach((char *) session->memory + GetRxOffset(), RS9110_Ring::GetFootprint(RING_SIZE), true);
+    session->client         = _mux.Attach(&session->txRing, &session->rxRing);
+    session->fd             = fd;
+    session->pendingSize    = 0;
+
+    if(session->client < 0)
+    {
+        Drop(*session);
+        return;
+    }
+
+    memset(&welcome, 0, sizeof(welcome));
+    welcome.client      = (unsigned char) session->client;
+    welcome.ringSize    = RING_SIZE;
+    memcpy(welcome.shmName, session->shmName, sizeof(welcome.shmName));
+
+    if(send(fd, &welcome, sizeof(welcome), MSG_NOSIGNAL) != (ssize_t) sizeof(welcome))
+    {
+        Drop(*session);
+    }
+}
+
+
+/*!
+ *  @brief  Receive
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reads the requests of a client and hands them to the mux. Rejected
+ *      requests are answered with EVT_REJECTED.
+ *
+ *  @param[in]  session - Client
+ */
+void RS9110_MuxServer::Receive (TSession &session)
+{
+    for(;;)
+    {
+        ssize_t rc = recv(session.fd, &session.pending[session.pendingSize],
+                          sizeof(session.pending) - session.pendingSize, 0);
+
+
+        if(rc == 0)
+        {
+            Drop(session);
+            return;
+        }
+
+        if(rc < 0)
+        {
+            if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            {
+                Drop(session);
+            }
+
+            return;
+        }
+
+        session.pendingSize += (unsigned int) rc;
+
+        if(session.pendingSize == sizeof(session.pending))
+        {
+            RS9110_Mux::TRequest request;
+
+
+            memcpy(&request, session.pending, sizeof(request));
+            session.pendingSize = 0;
+
+            if(_mux.Request((unsigned char) session.client, request) == false)
+            {
+                RS9110_Mux::TEvent event;
+
+
+                event.type      = RS9110_Mux::EVT_REJECTED;
+                event.vsock     = request.vsock;
+                event.isOk      = 0;
+                event.errorCode = 0;
+
+                SendEvent(session, event);
+            }
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Drop
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Forgets a client: detaches it from the mux (which closes its sockets)
+ *      and releases its shared memory.
+ *
+ *  @param[in]  session - Client
+ */
+void RS9110_MuxServer::Drop (TSession &session)
+{
+    if(session.client >= 0)
+    {
+        _mux.Detach((unsigned char) session.client);
+        session.client = -1;
+    }
+
+    session.txRing.Detach();
+    session.rxRing.Detach();
+
+    if(session.memory != NULL)
+    {
+        munmap(session.memory, GetShmSize());
+        shm_unlink(session.shmName);
+        session.memory = NULL;
+    }
+
+    close(session.fd);
+    session.fd = -1;
+}
+
+
+/*!
+ *  @brief  SendEvent
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes an event to a client. It is lost if the client does not read
+ *      its socket (the disconnection is found by #Receive).
+ *
+ *  @param[in]  session - Client
+ *  @param[in]  event   - Event
+ */
+void RS9110_MuxServer::SendEvent (TSession &session, const RS9110_Mux::TEvent &event)
+{
+    (void) send(session.fd, &event, sizeof(event), MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+
+/*!
+ *  @brief  Notify
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the events of the mux to the socket of their client. A client
+ *      expelled by the mux (EVT_DETACHED) is dropped right after it.
+ *
+ *  @param[in]  context - Server
+ *  @param[in]  client  - Index of the client
+ *  @param[in]  event   - Event
+ */
+void RS9110_MuxServer::Notify (void *context, unsigned char client, const RS9110_Mux::TEvent &event)
+{
+    RS9110_MuxServer *server = (RS9110_MuxServer *) context;
+
+
+    for(unsigned char i = 0; i < RS9110_Mux::MAX_CLIENTS; i++)
+    {
+        if((server->_sessions[i].fd >= 0) && (server->_sessions[i].client == client))
+        {
+            server->SendEvent(server->_sessions[i], event);
+
+            if(event.type == RS9110_Mux::EVT_DETACHED)
+            {
+                /* Already detached from the mux */
+                server->_sessions[i].client = -1;
+                server->Drop(server->_sessions[i]);
+            }
+
+            return;
+        }
+    }
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,239 @@
+#include "RS9110_Pacer.h"
+
+#include "RS9110_UART.h"
+
+#include <string.h>
+
+
+/* Compile-time check of the command table */
+typedef char CheckPacerCommands     [(RS9110_Pacer::MAX_COMMANDS >= RS9110_UART_Base::CMD_MAX) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor. All the gaps start at 0.
+ *
+ *  @param[in]  clock   - Time source in microseconds
+ *  @param[in]  delay   - Busy-wait or sleep for the given microseconds
+ *
+ */
+RS9110_Pacer::RS9110_Pacer (TClock clock, TDelay delay)
+  : _clock(clock),
+    _delay(delay),
+    _lastEventUs(0),
+    _spacingUs(0),
+    _hasEvent(false),
+    _retries(0)
+{
+    memset(_gapUs, 0, sizeof(_gapUs));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Pacer::~RS9110_Pacer ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Hold
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Waits until the learned gap of the command has elapsed since the last
+ *      command or answer. Called right before a command is written.
+ *
+ *  @param[in]  command - #RS9110_UART::ECommand about to be written
+ */
+void RS9110_Pacer::Hold (unsigned char command)
+{
+    unsigned long long  now;
+    unsigned long       wait;
+
+
+    if((command >= RS9110_UART_Base::CMD_MAX) || (command == RS9110_UART_Base::CMD_SEND_DATA))
+    {
+        return;
+    }
+
+    wait = GetWait(command);
+
+    if(wait > 0)
+    {
+        _delay(wait);
+
+        _stats.numHeld++;
+        _stats.totalHeldUs += wait;
+    }
+
+    now = _clock();
+
+    _spacingUs      = ((_hasEvent == true) ? (unsigned long) (now - _lastEventUs) : 0);
+    _lastEventUs    = now;
+    _hasEvent       = true;
+}
+
+
+/*!
+ *  @brief  GetWait
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns how long a command would be held back if written now, without
+ *      waiting.
+ *
+ *  @param[in]  command - #RS9110_UART::ECommand
+ *
+ *  @return Time left of the gap in microseconds (0 if it may be written now)
+ */
+unsigned long RS9110_Pacer::GetWait (unsigned char command)
+{
+    unsigned long elapsed;
+
+
+    if((command >= RS9110_UART_Base::CMD_MAX) || (command == RS9110_UART_Base::CMD_SEND_DATA) || (_hasEvent == false))
+    {
+        return 0;
+    }
+
+    elapsed = (unsigned long) (_clock() - _lastEventUs);
+
+    return ((elapsed < _gapUs[command]) ? (_gapUs[command] - elapsed) : 0);
+}
+
+
+/*!
+ *  @brief  Answered
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Learns from the answer to a command and decides whether it has to be
+ *      written again.
+ *
+ *  @param[in]  command         - #RS9110_UART::ECommand answered
+ *  @param[in]  responseType    - #RS9110_UART::EResponseType
+ *  @param[in]  errorCode       - #RS9110_UART::EErrorCode (ERROR only)
+ *  @param[in]  canRetry        - The command is still in the driver's buffer
+ *
+ *  @return bool
+ *  @retval true    - Rejected for pacing, write it again
+ *  @retval false   - Nothing to do
+ */
+bool RS9110_Pacer::Answered (unsigned char command, unsigned char responseType, unsigned char errorCode, bool canRetry)
+{
+    unsigned long gap;
+
+
+    if(((responseType != RS9110_UART_Base::RESP_TYPE_OK) && (responseType != RS9110_UART_Base::RESP_TYPE_ERROR)) ||
+       (command >= RS9110_UART_Base::CMD_MAX) || (command == RS9110_UART_Base::CMD_SEND_DATA))
+    {
+        return false;
+    }
+
+    _lastEventUs    = _clock();
+    _hasEvent       = true;
+
+    if((responseType == RS9110_UART_Base::RESP_TYPE_OK) || (errorCode != RS9110_UART_Base::ERROR_CMD_TOO_FAST))
+    {
+        /* Probe for a shorter gap */
+        _gapUs[command] -= (_gapUs[command] >> 4);
+        _retries         = 0;
+
+        return false;
+    }
+
+    _stats.numRejected++;
+
+    /* The gap actually left was too short */
+    gap = ((_spacingUs > _gapUs[command]) ? _spacingUs : _gapUs[command]) * 2;
+
+    if(gap < MIN_STEP_US)
+    {
+        gap = MIN_STEP_US;
+    }
+
+    _gapUs[command] = ((gap < MAX_GAP_US) ? gap : MAX_GAP_US);
+
+    if((canRetry == false) || (_retries >= MAX_RETRIES))
+    {
+        _retries = 0;
+        return false;
+    }
+
+    _retries++;
+    _stats.numRetried++;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetGap
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the learned gap of a command.
+ *
+ *  @param[in]  command - #RS9110_UART::ECommand
+ *
+ *  @return Gap in microseconds
+ */
+unsigned long RS9110_Pacer::GetGap (unsigned char command)
+{
+    return ((command < MAX_COMMANDS) ? _gapUs[command] : 0);
+}
+
+
+/*!
+ *  @brief  SetGap
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Seeds the gap of a command (i.e. with values learned in a previous run).
+ *
+ *  @param[in]  command - #RS9110_UART::ECommand
+ *  @param[in]  gapUs   - Gap in microseconds
+ */
+void RS9110_Pacer::SetGap (unsigned char command, unsigned long gapUs)
+{
+    if(command < MAX_COMMANDS)
+    {
+        _gapUs[command] = ((gapUs < MAX_GAP_US) ? gapUs : MAX_GAP_US);
+    }
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the pacing statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Pacer::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
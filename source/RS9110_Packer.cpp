@@ -0,0 +1,546 @@
+#include "RS9110_Packer.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckPackerDestinations    [(RS9110_MAX_PACKER_DESTINATIONS > 0) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver used to send
+ *
+ */
+RS9110_Packer::RS9110_Packer (RS9110_UART &rs)
+  : _rs(rs),
+    _scheduler(NULL),
+    _nextDatagram(0),
+    _isPosted(false)
+{
+    memset(_datagrams, 0, sizeof(_datagrams));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Packer::~RS9110_Packer ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetScheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the commands thru the bulk class of a scheduler: a datagram to
+ *      send is only marked, and sent when the scheduler gives the line. It
+ *      may take more records meanwhile; a record that does not fit is then
+ *      refused (RESULT_BUSY). NULL (the default) sends at once.
+ *
+ *  @param[in]  scheduler   - Scheduler of the driver (NULL if none)
+ */
+void RS9110_Packer::SetScheduler (RS9110_Scheduler *scheduler)
+{
+    _scheduler = scheduler;
+    _isPosted  = false;
+
+    PostSend();
+}
+
+
+/*!
+ *  @brief  Open
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts packing the records sent to a destination thru an already open
+ *      UDP socket.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *  @param[in]  hostIpAddr  - Destination IP Address
+ *  @param[in]  hostPort    - Destination Port
+ *
+ *  @return int (destination, -1 if wrong argument or no free destination)
+ */
+int RS9110_Packer::Open (unsigned char socketId, const char *hostIpAddr, unsigned short hostPort)
+{
+    unsigned char address[RS9110_UART::NW_ADDRESS_LEN];
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       (RS9110_UART::ParseAddress(hostIpAddr, address) == false) || (strlen(hostIpAddr) > MAX_ADDRESS_LEN))
+    {
+        return -1;
+    }
+
+    for(int i = 0; i < MAX_DESTINATIONS; i++)
+    {
+        TDatagram *datagram = &_datagrams[i];
+
+        if(datagram->socketId == 0)
+        {
+            strcpy(datagram->host, hostIpAddr);
+            datagram->hostPort          = hostPort;
+            datagram->socketId          = socketId;
+            datagram->length            = 0;
+            datagram->stuffedLength     = 0;
+            datagram->isSending         = false;
+            datagram->maxStuffedLength  = (unsigned short) RS9110_UART::GetMaxSendSize(socketId, RS9110_UART::SOCKET_UDP, hostIpAddr, hostPort);
+
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/*!
+ *  @brief  Close
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees a destination, dropping the records not sent yet.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong destination
+ */
+bool RS9110_Packer::Close (int destination)
+{
+    TDatagram *datagram = GetDatagram(destination);
+
+
+    if(datagram == NULL)
+    {
+        return false;
+    }
+
+    datagram->socketId  = 0;
+    datagram->isSending = false;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Append
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds a record to the datagram of a destination. If the record does not
+ *      fit after byte stuffing, the datagram is sent first and the record
+ *      starts the next one; a datagram left full is sent at once. With a
+ *      scheduler, a record that does not fit waits for the datagram to be
+ *      sent (RESULT_BUSY).
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *  @param[in]  record      - Record (copied)
+ *  @param[in]  recordSize  - Length of the record
+ *
+ *  @return EResult
+ */
+RS9110_Packer::EResult RS9110_Packer::Append (int destination, const char *record, unsigned int recordSize)
+{
+    TDatagram      *datagram    = GetDatagram(destination);
+    EResult         eResult     = RESULT_PACKED;
+    unsigned int    stuffedSize;
+
+
+    if((datagram == NULL) || (record == NULL) || (recordSize == 0))
+    {
+        return RESULT_ERROR;
+    }
+
+    stuffedSize = RS9110_UART::GetStuffedSize(record, recordSize);
+
+    if(Fits(datagram, record, recordSize, stuffedSize, true) == false)
+    {
+        return RESULT_TOO_LARGE;
+    }
+
+    if(Fits(datagram, record, recordSize, stuffedSize, false) == false)
+    {
+        if(SendDatagram(datagram) == false)
+        {
+            return RESULT_NOT_SENT;
+        }
+
+        /* Only posted */
+        if(datagram->length > 0)
+        {
+            return RESULT_BUSY;
+        }
+
+        eResult = RESULT_SENT;
+    }
+
+    memcpy(&datagram->data[datagram->length], record, recordSize);
+    datagram->length        = (unsigned short) (datagram->length + recordSize);
+    datagram->stuffedLength = (unsigned short) (datagram->stuffedLength + stuffedSize);
+    _stats.numRecords++;
+
+    /* Full: not even a 1 byte record fits */
+    if((eResult == RESULT_PACKED) && (datagram->isSending == false) && ((datagram->stuffedLength + 1) >= datagram->maxStuffedLength))
+    {
+        if(SendDatagram(datagram) == true)
+        {
+            eResult = RESULT_SENT;
+        }
+    }
+
+    return eResult;
+}
+
+
+/*!
+ *  @brief  Flush
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the datagram of a destination now.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return bool
+ *  @retval true    - OK (or nothing pending)
+ *  @retval false   - Wrong destination or command not sent
+ */
+bool RS9110_Packer::Flush (int destination)
+{
+    TDatagram *datagram = GetDatagram(destination);
+
+
+    if(datagram == NULL)
+    {
+        return false;
+    }
+
+    return SendDatagram(datagram);
+}
+
+
+/*!
+ *  @brief  GetPending
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of bytes packed and not sent yet.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return unsigned int (0 if wrong destination)
+ */
+unsigned int RS9110_Packer::GetPending (int destination)
+{
+    TDatagram *datagram = GetDatagram(destination);
+
+
+    return ((datagram != NULL) ? datagram->length : 0);
+}
+
+
+/*!
+ *  @brief  GetStuffedSize
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the size of the pending datagram after byte stuffing.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return unsigned int (0 if wrong destination)
+ */
+unsigned int RS9110_Packer::GetStuffedSize (int destination)
+{
+    TDatagram *datagram = GetDatagram(destination);
+
+
+    return ((datagram != NULL) ? datagram->stuffedLength : 0);
+}
+
+
+/*!
+ *  @brief  GetMaxStuffedSize
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the room for a datagram of a destination after byte stuffing.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return unsigned int (0 if wrong destination)
+ */
+unsigned int RS9110_Packer::GetMaxStuffedSize (int destination)
+{
+    TDatagram *datagram = GetDatagram(destination);
+
+
+    return ((datagram != NULL) ? datagram->maxStuffedLength : 0);
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Packer::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  GetDatagram
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the datagram of an open destination.
+ *
+ *  @param[in]  destination - Value returned by #Open
+ *
+ *  @return TDatagram * (NULL if wrong destination)
+ */
+RS9110_Packer::TDatagram * RS9110_Packer::GetDatagram (int destination)
+{
+    if((destination < 0) || (destination >= MAX_DESTINATIONS) || (_datagrams[destination].socketId == 0))
+    {
+        return NULL;
+    }
+
+    return &_datagrams[destination];
+}
+
+
+/*!
+ *  @brief  SendDatagram
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending records of a destination in one command, or marks
+ *      them for #IssueBulk with a scheduler.
+ *
+ *  @param[in]  datagram    - Datagram in use
+ *
+ *  @return bool
+ *  @retval true    - OK, send posted (or nothing pending)
+ *  @retval false   - Command not sent
+ */
+bool RS9110_Packer::SendDatagram (TDatagram *datagram)
+{
+    if(datagram->length == 0)
+    {
+        return true;
+    }
+
+    if(_scheduler != NULL)
+    {
+        datagram->isSending = true;
+        PostSend();
+
+        return true;
+    }
+
+    return WriteDatagram(datagram);
+}
+
+
+/*!
+ *  @brief  WriteDatagram
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the pending records of a destination in one command. They are
+ *      kept if the command could not be written.
+ *
+ *  @param[in]  datagram    - Datagram with records pending
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Command not sent
+ */
+bool RS9110_Packer::WriteDatagram (TDatagram *datagram)
+{
+    _rs.Send(datagram->socketId, RS9110_UART::SOCKET_UDP, datagram->host, datagram->hostPort, datagram->data, datagram->length);
+
+    if(_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA)
+    {
+        return false;
+    }
+
+    _stats.numDatagrams++;
+    _stats.payloadBytes += datagram->length;
+    _stats.stuffedBytes += datagram->stuffedLength;
+
+    datagram->length        = 0;
+    datagram->stuffedLength = 0;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  PostSend
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Posts #IssueBulk on the scheduler if a datagram is waiting for it.
+ */
+void RS9110_Packer::PostSend ()
+{
+    if((_scheduler == NULL) || (_isPosted == true))
+    {
+        return;
+    }
+
+    for(unsigned char i = 0; i < MAX_DESTINATIONS; i++)
+    {
+        if(_datagrams[i].isSending == true)
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueBulk, this) == false)
+            {
+                _isPosted = false;
+            }
+            return;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  IssueBulk
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #PostSend: sends the next datagram waiting,
+ *      round robin, and posts again if others wait. Records not sent stay
+ *      pending for the next flush.
+ *
+ *  @param[in]  context - Packer
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_Packer::IssueBulk (void *context, RS9110_UART &rs)
+{
+    RS9110_Packer  *packer  = (RS9110_Packer *) context;
+    TDatagram      *datagram;
+    bool            bRtn    = false;
+
+
+    (void) rs;
+
+    packer->_isPosted = false;
+
+    for(unsigned char i = 0; (i < MAX_DESTINATIONS) && (bRtn == false); i++)
+    {
+        datagram                = &packer->_datagrams[packer->_nextDatagram];
+        packer->_nextDatagram   = (unsigned char) ((packer->_nextDatagram + 1) % MAX_DESTINATIONS);
+
+        if(datagram->isSending == true)
+        {
+            datagram->isSending = false;
+
+            if((datagram->socketId != 0) && (datagram->length > 0))
+            {
+                bRtn = packer->WriteDatagram(datagram);
+            }
+        }
+    }
+
+    packer->PostSend();
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  Fits
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether Send() would take the datagram and the record whole.
+ *      Send() stops stuffing when less than 2 bytes are left, so the stuffed
+ *      size may only reach the room if it ends with a 2 byte sequence
+ *      (0xDB or 0x0D 0x0A).
+ *
+ *  @param[in]  datagram    - Datagram in use
+ *  @param[in]  record      - Record to append
+ *  @param[in]  recordSize  - Length of the record
+ *  @param[in]  stuffedSize - Length of the record after byte stuffing
+ *  @param[in]  isAlone     - Check the record as the first one of a datagram
+ *
+ *  @return bool
+ */
+bool RS9110_Packer::Fits (const TDatagram *datagram, const char *record, unsigned int recordSize, unsigned int stuffedSize, bool isAlone)
+{
+    unsigned int    length  = ((isAlone == true) ? 0 : datagram->length);
+    unsigned int    total   = ((isAlone == true) ? 0 : datagram->stuffedLength) + stuffedSize;
+    char            last    = record[recordSize - 1];
+    char            prev;
+
+
+    if((length + recordSize) > BUFFER_SIZE)
+    {
+        return false;
+    }
+
+    if(total != datagram->maxStuffedLength)
+    {
+        return (total < datagram->maxStuffedLength);
+    }
+
+    if(recordSize >= 2)
+    {
+        prev = record[recordSize - 2];
+    }
+    else
+    {
+        prev = ((length > 0) ? datagram->data[length - 1] : 0);
+    }
+
+    return ((last == (char) 0xDB) || ((prev == (char) 0x0D) && (last == (char) 0x0A)));
+}
@@ -0,0 +1,774 @@
+#include "RS9110_Pipeline.h"
+
+#include <string.h>
+#include <stddef.h>
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver used to bring the link up
+ *
+ */
+RS9110_Pipeline::RS9110_Pipeline (RS9110_UART &rs)
+  : _rs(rs),
+    _state(STATE_IDLE),
+    _steps(0),
+    _step(STEP_MAX),
+    _socket(0),
+    _isFullScan(false),
+    _isWaiting(false),
+    _isClosing(false),
+    _failure(FAILURE_NONE),
+    _errorCode(RS9110_UART::ERROR_NONE),
+    _timeoutMs(DEFAULT_TIMEOUT_MS),
+    _sentMs(0)
+{
+    memset(&_target, 0, sizeof(_target));
+    memset(_socketIds, 0, sizeof(_socketIds));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Pipeline::~RS9110_Pipeline ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetTarget
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Declares the state the link has to be brought to. It is copied, so the
+ *      given structure may be reused.
+ *
+ *  @param[in]  target  - Desired state of the link
+ */
+void RS9110_Pipeline::SetTarget (const TTarget &target)
+{
+    memcpy(&_target, &target, sizeof(_target));
+
+    _target.ssid[RS9110_UART::MAX_SSID_LEN]     = '\0';
+    _target.psk[RS9110_UART::MAX_PSK_LEN_EXT]   = '\0';
+
+    if(_target.numSockets > MAX_SOCKETS)
+    {
+        _target.numSockets = MAX_SOCKETS;
+    }
+}
+
+
+/*!
+ *  @brief  GetTarget
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the declared state of the link, including the learned channel.
+ *
+ *  @param[out] target  - Desired state of the link
+ */
+void RS9110_Pipeline::GetTarget (TTarget &target)
+{
+    memcpy(&target, &_target, sizeof(target));
+}
+
+
+/*!
+ *  @brief  GetTarget
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Gives read access to the declared state of the link without copying it.
+ *
+ *  @return Desired state of the link
+ */
+const RS9110_Pipeline::TTarget & RS9110_Pipeline::GetTarget ()
+{
+    return _target;
+}
+
+
+/*!
+ *  @brief  SetChannel
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the channel of the target when it has been learned elsewhere
+ *      (i.e. from the stored configuration).
+ *
+ *  @param[in]  channel - Channel (0 if unknown)
+ */
+void RS9110_Pipeline::SetChannel (unsigned char channel)
+{
+    _target.channel = channel;
+}
+
+
+/*!
+ *  @brief  SetTimeout
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets how long the answer to every command is waited for.
+ *
+ *  @param[in]  timeoutMs   - Time to wait for an answer (ms)
+ */
+void RS9110_Pipeline::SetTimeout (unsigned long timeoutMs)
+{
+    _timeoutMs = timeoutMs;
+}
+
+
+/*!
+ *  @brief  GetRequiredSteps
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the steps needed to reach the target from a module just reset.
+ *
+ *  @return Bit per #EStep
+ */
+unsigned int RS9110_Pipeline::GetRequiredSteps ()
+{
+    unsigned int steps = (1 << STEP_BAND) | (1 << STEP_INIT) | (1 << STEP_SCAN) |
+                         (1 << STEP_NETWORK_TYPE) | (1 << STEP_JOIN) | (1 << STEP_IP_CONF);
+
+
+    switch(_target.secMode)
+    {
+        case RS9110_UART::SEC_MODE_WPA:
+        case RS9110_UART::SEC_MODE_WPA2:
+            steps |= (1 << STEP_PSK);
+
+            if(_target.isPskExt == true)
+            {
+                steps |= (1 << STEP_FEATURE_SELECT);
+            }
+        break;
+
+#if RS9110_FEATURE_WEP
+        case RS9110_UART::SEC_MODE_WEP:
+            steps |= (1 << STEP_WEP_KEYS) | (1 << STEP_AUTH_MODE);
+        break;
+#endif /* RS9110_FEATURE_WEP */
+
+        default:
+            /* Nothing to do */
+        break;
+    }
+
+    if((_target.channel == 0) && (_target.band == RS9110_UART::BAND_2_4_GHZ))
+    {
+        steps |= (1 << STEP_GET_PARAMS);
+    }
+
+    if(_target.numSockets > 0)
+    {
+        steps |= (1 << STEP_OPEN_SOCKETS);
+    }
+
+    return steps;
+}
+
+
+/*!
+ *  @brief  Start
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts the pipeline by sending its first command. Only the steps both
+ *      required by the target (see #GetRequiredSteps) and given are run, so a
+ *      caller knowing the state of the module may skip some of them.
+ *
+ *  @param[in]  nowMs       - Current time (ms)
+ *  @param[in]  steps       - Bit per #EStep allowed to run
+ *  @param[in]  isFullScan  - Scan all the channels even if the channel is known
+ *
+ *  @return bool
+ *  @retval true    - OK (see #GetState)
+ *  @retval false   - No SSID or already running
+ */
+bool RS9110_Pipeline::Start (unsigned long nowMs, unsigned int steps, bool isFullScan)
+{
+    if((strlen(_target.ssid) == 0) || (_state == STATE_RUNNING))
+    {
+        return false;
+    }
+
+    _state      = STATE_RUNNING;
+    _steps      = GetRequiredSteps() & steps;
+    _step       = STEP_MAX;
+    _socket     = 0;
+    _isFullScan = isFullScan;
+    _isWaiting  = false;
+    _isClosing  = false;
+    _failure    = FAILURE_NONE;
+    _errorCode  = RS9110_UART::ERROR_NONE;
+
+    memset(_socketIds, 0, sizeof(_socketIds));
+
+    NextStep(nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Stop
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Abandons the pipeline. An answer still pending is ignored and sockets
+ *      still to be closed after a failure are left open.
+ */
+void RS9110_Pipeline::Stop ()
+{
+    _state      = STATE_IDLE;
+    _isWaiting  = false;
+    _isClosing  = false;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Detects commands not answered in time.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return EState
+ */
+RS9110_Pipeline::EState RS9110_Pipeline::Poll (unsigned long nowMs)
+{
+    if((_state == STATE_RUNNING) && (_isWaiting == true) && ((nowMs - _sentMs) >= _timeoutMs))
+    {
+        Fail(FAILURE_TIMEOUT, RS9110_UART::ERROR_NONE, nowMs);
+    }
+
+    return _state;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the command of the next step on the OK of the current one and stops
+ *      on its ERROR. Must be called after every #RS9110_UART::ProcessMessage.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not related to the pipeline
+ */
+bool RS9110_Pipeline::ProcessResponse (unsigned long nowMs)
+{
+    const unsigned char     *response;
+    int                      length;
+    RS9110_UART::ESocketType socketType = RS9110_UART::SOCKET_MAX;
+
+
+    if((_step == STEP_OPEN_SOCKETS) && (_socket < _target.numSockets))
+    {
+        socketType = _target.sockets[_socket].type;
+    }
+
+    if((_state != STATE_RUNNING) || (_isWaiting == false))
+    {
+        return false;
+    }
+
+    if(_isClosing == true)
+    {
+        if(_rs.GetLastCommand() != RS9110_UART::CMD_CLOSE_SOCKET)
+        {
+            return false;
+        }
+
+        switch(_rs.GetResponseType())
+        {
+            case RS9110_UART::RESP_TYPE_OK:
+                _socketIds[_socket] = 0;
+            break;
+
+            case RS9110_UART::RESP_TYPE_ERROR:
+                /* Left open: its handle is still reported */
+            break;
+
+            default:
+                return false;
+            break;
+        }
+
+        _isWaiting = false;
+        CloseNext(nowMs);
+
+        return true;
+    }
+
+    if(_rs.GetLastCommand() != CommandOf((EStep) _step, socketType))
+    {
+        return false;
+    }
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+            _isWaiting = false;
+
+            if(_step == STEP_GET_PARAMS)
+            {
+                LearnChannel();
+            }
+            else if(_step == STEP_OPEN_SOCKETS)
+            {
+                response = (const unsigned char *) _rs.GetResponse(length);
+
+                if((response == NULL) || (length < (int) sizeof(RS9110_UART::TSocket)))
+                {
+                    Fail(FAILURE_ERROR, RS9110_UART::ERROR_NONE, nowMs);
+                    return true;
+                }
+
+                _socketIds[_socket++] = response[0];
+
+                /* Same step again for the next socket */
+                if(_socket < _target.numSockets)
+                {
+                    _step--;
+                }
+            }
+
+            NextStep(nowMs);
+        break;
+
+        case RS9110_UART::RESP_TYPE_ERROR:
+            Fail(FAILURE_ERROR, _rs.GetErrorCode(), nowMs);
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the state of the pipeline.
+ *
+ *  @return EState
+ */
+RS9110_Pipeline::EState RS9110_Pipeline::GetState ()
+{
+    return _state;
+}
+
+
+/*!
+ *  @brief  GetStep
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the step being run or, once failed, the step that failed.
+ *      #STEP_MAX if no step has been run yet or the pipeline is done.
+ *
+ *  @return EStep
+ */
+RS9110_Pipeline::EStep RS9110_Pipeline::GetStep ()
+{
+    return (EStep) _step;
+}
+
+
+/*!
+ *  @brief  GetFailure
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns why the pipeline failed.
+ *
+ *  @return EFailure
+ */
+RS9110_Pipeline::EFailure RS9110_Pipeline::GetFailure ()
+{
+    return _failure;
+}
+
+
+/*!
+ *  @brief  GetErrorCode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the error code of the ERROR that stopped the pipeline
+ *      (ERROR_NONE for any other failure).
+ *
+ *  @return RS9110_UART::EErrorCode
+ */
+RS9110_UART::EErrorCode RS9110_Pipeline::GetErrorCode ()
+{
+    return _errorCode;
+}
+
+
+/*!
+ *  @brief  GetSocketId
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the handle of a socket opened by the pipeline. After a failure
+ *      only the sockets that could not be closed keep their handle.
+ *
+ *  @param[in]  index   - Position of the socket in #TTarget::sockets
+ *
+ *  @return Socket handle (0 if not opened)
+ */
+unsigned char RS9110_Pipeline::GetSocketId (unsigned char index)
+{
+    return ((index < MAX_SOCKETS) ? _socketIds[index] : 0);
+}
+
+
+/*!
+ *  @brief  GetStepName
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the name of a step (for logs).
+ *
+ *  @param[in]  eStep   - Step
+ *
+ *  @return Zero-ended string
+ */
+const char * RS9110_Pipeline::GetStepName (EStep eStep)
+{
+    static const char *NAMES[STEP_MAX] =
+    {
+        "BAND",
+        "INIT",
+        "SCAN",
+        "NETWORK_TYPE",
+        "FEATURE_SELECT",
+        "PSK",
+        "WEP_KEYS",
+        "AUTH_MODE",
+        "JOIN",
+        "IP_CONF",
+        "GET_PARAMS",
+        "OPEN_SOCKETS"
+    };
+
+
+    return ((eStep < STEP_MAX) ? NAMES[eStep] : "NONE");
+}
+
+
+/*!
+ *  @brief  NextStep
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the command of the next step or, if there are no more, marks the
+ *      pipeline as done.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Pipeline::NextStep (unsigned long nowMs)
+{
+    unsigned char step = ((_step == STEP_MAX) ? 0 : (_step + 1));
+
+
+    while((step < STEP_MAX) && ((_steps & (1 << step)) == 0))
+    {
+        step++;
+    }
+
+    _step = step;
+
+    if(step >= STEP_MAX)
+    {
+        _state = STATE_DONE;
+        return;
+    }
+
+    if(SendStep() == true)
+    {
+        _isWaiting  = true;
+        _sentMs     = nowMs;
+    }
+    else
+    {
+        Fail(FAILURE_NOT_SENT, RS9110_UART::ERROR_NONE, nowMs);
+    }
+}
+
+
+/*!
+ *  @brief  SendStep
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the command of the current step.
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Wrong target or command not sent
+ */
+bool RS9110_Pipeline::SendStep ()
+{
+    const TSocketSpec              *socket = &_target.sockets[_socket];
+    RS9110_UART::TFeatureSelect     feature;
+
+
+    switch(_step)
+    {
+        case STEP_BAND:
+            return _rs.Band(_target.band);
+
+        case STEP_INIT:
+            return _rs.Init();
+
+        case STEP_SCAN:
+            return _rs.Scan(((_isFullScan == true) ? 0 : _target.channel), _target.ssid);
+
+        case STEP_NETWORK_TYPE:
+            return _rs.SetNetworkType(_target.nwType, _target.ibssType, _target.channel);
+
+        case STEP_FEATURE_SELECT:
+            feature.value       = 0;
+            feature.pskLength   = 1;
+            return _rs.SetFeatureSelect(feature);
+
+        case STEP_PSK:
+            return _rs.PSK(_target.psk);
+
+#if RS9110_FEATURE_WEP
+        case STEP_WEP_KEYS:
+            return _rs.SetWEPKeys(_target.wepKeyIndex, _target.wepKeys[0], _target.wepKeys[1], _target.wepKeys[2]);
+#endif /* RS9110_FEATURE_WEP */
+
+        case STEP_AUTH_MODE:
+            return _rs.AuthMode(_target.authMode);
+
+        case STEP_JOIN:
+            return _rs.Join(_target.ssid, _target.txRate, _target.txPower);
+
+        case STEP_IP_CONF:
+            return _rs.IPConfiguration(_target.dhcpMode, _target.address, _target.subnet, _target.gateway);
+
+        case STEP_GET_PARAMS:
+            return _rs.GetNetworkParameters();
+
+        case STEP_OPEN_SOCKETS:
+            switch(socket->type)
+            {
+                case RS9110_UART::SOCKET_TCP:
+                    return _rs.OpenTcpSocket(socket->host, socket->remotePort, socket->localPort);
+
+                case RS9110_UART::SOCKET_UDP:
+                    return _rs.OpenUdpSocket(socket->host, socket->remotePort, socket->localPort);
+
+                case RS9110_UART::SOCKET_LTCP:
+                    return _rs.OpenListeningTcpSocket(socket->localPort);
+
+                case RS9110_UART::SOCKET_LUDP:
+                    return _rs.OpenListeningUdpSocket(socket->localPort);
+
+                default:
+                    return false;
+            }
+
+        default:
+            return false;
+    }
+}
+
+
+/*!
+ *  @brief  Fail
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stops the pipeline at the current step. A failure while opening the
+ *      sockets first closes the ones already opened (see #CloseNext).
+ *
+ *  @param[in]  eFailure    - Reason
+ *  @param[in]  eErrorCode  - Error code of the ERROR answer (if any)
+ *  @param[in]  nowMs       - Current time (ms)
+ */
+void RS9110_Pipeline::Fail (EFailure eFailure, RS9110_UART::EErrorCode eErrorCode, unsigned long nowMs)
+{
+    _isWaiting = false;
+
+    if(_isClosing == true)
+    {
+        /* The close timed out: the failure of the open is the one reported */
+        CloseNext(nowMs);
+        return;
+    }
+
+    _failure    = eFailure;
+    _errorCode  = eErrorCode;
+
+    if(_step == STEP_OPEN_SOCKETS)
+    {
+        _isClosing = true;
+        CloseNext(nowMs);
+        return;
+    }
+
+    _state = STATE_FAILED;
+}
+
+
+/*!
+ *  @brief  CloseNext
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the close of the last socket opened by the pipeline, from the
+ *      last one to the first, or marks the pipeline as failed once there are
+ *      no more. A close that cannot be sent is skipped.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Pipeline::CloseNext (unsigned long nowMs)
+{
+    while(_socket > 0)
+    {
+        _socket--;
+
+        if(_rs.CloseSocket(_socketIds[_socket]) == true)
+        {
+            _isWaiting  = true;
+            _sentMs     = nowMs;
+            return;
+        }
+    }
+
+    _isClosing  = false;
+    _state      = STATE_FAILED;
+}
+
+
+/*!
+ *  @brief  LearnChannel
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes the channel of the link from the answer to "AT+RSI_NWPARAMS?".
+ */
+void RS9110_Pipeline::LearnChannel ()
+{
+    const unsigned char *response;
+    unsigned int         offset;
+    int                  length;
+
+
+    offset   = ((_target.isPskExt == true) ? offsetof(RS9110_UART::TNetworkParamsExt, channel) : offsetof(RS9110_UART::TNetworkParams, channel));
+    response = (const unsigned char *) _rs.GetResponse(length);
+
+    if((response != NULL) && (length > (int) offset) && (response[offset] != 0))
+    {
+        _target.channel = response[offset];
+    }
+}
+
+
+/*!
+ *  @brief  CommandOf
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the command sent by a step.
+ *
+ *  @param[in]  eStep       - Step
+ *  @param[in]  socketType  - Type of the socket being opened (#STEP_OPEN_SOCKETS only)
+ *
+ *  @return RS9110_UART::ECommand
+ */
+RS9110_UART::ECommand RS9110_Pipeline::CommandOf (EStep eStep, RS9110_UART::ESocketType socketType)
+{
+    static const RS9110_UART::ECommand COMMANDS[STEP_OPEN_SOCKETS] =
+    {
+        RS9110_UART::CMD_BAND,
+        RS9110_UART::CMD_INIT,
+        RS9110_UART::CMD_SCAN,
+        RS9110_UART::CMD_SET_NETWORK_TYPE,
+        RS9110_UART::CMD_FEATURE_SELECT,
+        RS9110_UART::CMD_PSK,
+        RS9110_UART::CMD_WEP_KEYS,
+        RS9110_UART::CMD_AUTH_MODE,
+        RS9110_UART::CMD_JOIN,
+        RS9110_UART::CMD_IP_CONF,
+        RS9110_UART::CMD_GET_NETWORK_PARAMS
+    };
+
+
+    if(eStep < STEP_OPEN_SOCKETS)
+    {
+        return COMMANDS[eStep];
+    }
+
+    if(eStep == STEP_OPEN_SOCKETS)
+    {
+        switch(socketType)
+        {
+            case RS9110_UART::SOCKET_TCP:   return RS9110_UART::CMD_OPEN_TCP_SOCKET;
+            case RS9110_UART::SOCKET_UDP:   return RS9110_UART::CMD_OPEN_UDP_SOCKET;
+            case RS9110_UART::SOCKET_LTCP:  return RS9110_UART::CMD_OPEN_LTCP_SOCKET;
+            case RS9110_UART::SOCKET_LUDP:  return RS9110_UART::CMD_OPEN_LUDP_SOCKET;
+            default:                        break;
+        }
+    }
+
+    return RS9110_UART::CMD_MAX;
+}
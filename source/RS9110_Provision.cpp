@@ -0,0 +1,677 @@
+#include "RS9110_Provision.h"
+
+#include <string.h>
+
+
+static const unsigned char  STORED_NW_TYPE_ADHOC    = 0x00;
+static const unsigned char  STORED_NW_TYPE_INFRA    = 0x01;
+static const unsigned char  STORED_DHCP_ENABLE      = 0x01;
+
+
+/*!
+ *  @brief  IsSameString
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Compares a zero-ended string with a field of the stored configuration
+ *      padded with 0x00 (not zero-ended when full).
+ *
+ *  @param[in]  string  - Zero-ended string
+ *  @param[in]  padded  - Stored field
+ *  @param[in]  size    - Size of the stored field
+ *
+ *  @return bool
+ */
+static bool IsSameString (const char *string, const char *padded, unsigned int size)
+{
+    return ((strlen(string) <= size) && (strncmp(string, padded, size) == 0));
+}
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver of the module to provision
+ *
+ */
+RS9110_Provision::RS9110_Provision (RS9110_UART &rs)
+  : _rs(rs),
+    _pipeline(rs),
+    _state(STATE_IDLE),
+    _phase(PHASE_MAX),
+    _result(RESULT_NONE),
+    _isWaiting(false),
+    _isEnabled(false),
+    _diff(0),
+    _failedCommand(RS9110_UART::CMD_MAX),
+    _errorCode(RS9110_UART::ERROR_NONE),
+    _timeoutMs(RS9110_Pipeline::DEFAULT_TIMEOUT_MS),
+    _sentMs(0)
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Provision::~RS9110_Provision ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetTarget
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the configuration the module must end up with.
+ *
+ *  @param[in]  target  - Desired state of the link
+ */
+void RS9110_Provision::SetTarget (const RS9110_Pipeline::TTarget &target)
+{
+    _pipeline.SetTarget(target);
+}
+
+
+/*!
+ *  @brief  SetTimeout
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets how long the answer to every command is waited for.
+ *
+ *  @param[in]  timeoutMs   - Time to wait for an answer (ms)
+ */
+void RS9110_Provision::SetTimeout (unsigned long timeoutMs)
+{
+    _timeoutMs = timeoutMs;
+    _pipeline.SetTimeout(timeoutMs);
+}
+
+
+/*!
+ *  @brief  Start
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts the provisioning by reading the stored configuration. Must be
+ *      run right after the module boots (before "AT+RSI_BAND").
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK (see #GetState)
+ *  @retval false   - Already running
+ */
+bool RS9110_Provision::Start (unsigned long nowMs)
+{
+    if(_state == STATE_RUNNING)
+    {
+        return false;
+    }
+
+    _state          = STATE_RUNNING;
+    _result         = RESULT_NONE;
+    _isEnabled      = false;
+    _diff           = 0;
+    _failedCommand  = RS9110_UART::CMD_MAX;
+    _errorCode      = RS9110_UART::ERROR_NONE;
+
+    StartPhase(PHASE_READ, nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Stop
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Abandons the provisioning. An answer still pending is ignored.
+ */
+void RS9110_Provision::Stop ()
+{
+    _state      = STATE_IDLE;
+    _isWaiting  = false;
+    _pipeline.Stop();
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Detects commands not answered in time.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return EState
+ */
+RS9110_Provision::EState RS9110_Provision::Poll (unsigned long nowMs)
+{
+    if(_state == STATE_RUNNING)
+    {
+        if(_phase == PHASE_BRING_UP)
+        {
+            _pipeline.Poll(nowMs);
+            CheckPipeline(nowMs);
+        }
+        else if((_isWaiting == true) && ((nowMs - _sentMs) >= _timeoutMs))
+        {
+            Fail(CommandOf(_phase), RS9110_UART::ERROR_NONE);
+        }
+    }
+
+    return _state;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves to the next phase on the OK of the current one. Must be called
+ *      after every #RS9110_UART::ProcessMessage.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not related to the provisioning
+ */
+bool RS9110_Provision::ProcessResponse (unsigned long nowMs)
+{
+    if(_state != STATE_RUNNING)
+    {
+        return false;
+    }
+
+    if(_phase == PHASE_BRING_UP)
+    {
+        if(_pipeline.ProcessResponse(nowMs) == false)
+        {
+            return false;
+        }
+
+        CheckPipeline(nowMs);
+        return true;
+    }
+
+    if((_isWaiting == false) || (_rs.GetLastCommand() != CommandOf(_phase)))
+    {
+        return false;
+    }
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+            _isWaiting = false;
+
+            switch(_phase)
+            {
+                case PHASE_READ:
+                    _isEnabled = true;
+                    Decode();
+
+                    if(_diff == 0)
+                    {
+                        _result = RESULT_AUTO_JOIN;
+                        StartPhase(PHASE_BRING_UP, nowMs);
+                    }
+                    else
+                    {
+                        /* A valid configuration would be joined after "AT+RSI_BAND" */
+                        _result = RESULT_PROVISIONED;
+                        StartPhase((((_diff & FIELD_VALID) == 0) ? PHASE_DISABLE : PHASE_BRING_UP), nowMs);
+                    }
+                break;
+
+                case PHASE_DISABLE:
+                    _isEnabled = false;
+                    StartPhase(PHASE_BRING_UP, nowMs);
+                break;
+
+                case PHASE_SAVE:
+                    StartPhase(((_isEnabled == true) ? PHASE_MAX : PHASE_ENABLE), nowMs);
+                break;
+
+                default:    /* PHASE_ENABLE */
+                    _isEnabled = true;
+                    StartPhase(PHASE_MAX, nowMs);
+                break;
+            }
+        break;
+
+        case RS9110_UART::RESP_TYPE_ERROR:
+            _isWaiting = false;
+
+            if((_phase == PHASE_READ) && (_rs.GetErrorCode() == RS9110_UART::ERROR_MULTIPLE_1))
+            {
+                /* Auto-join has never been enabled, so there is nothing stored */
+                _diff   = FIELD_VALID;
+                _result = RESULT_PROVISIONED;
+                StartPhase(PHASE_BRING_UP, nowMs);
+            }
+            else
+            {
+                Fail(CommandOf(_phase), _rs.GetErrorCode());
+            }
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the state of the provisioning.
+ *
+ *  @return EState
+ */
+RS9110_Provision::EState RS9110_Provision::GetState ()
+{
+    return _state;
+}
+
+
+/*!
+ *  @brief  GetResult
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns whether the stored configuration was used as is or rewritten
+ *      (#RESULT_NONE until it has been read).
+ *
+ *  @return EResult
+ */
+RS9110_Provision::EResult RS9110_Provision::GetResult ()
+{
+    return _result;
+}
+
+
+/*!
+ *  @brief  GetDiff
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the fields of the stored configuration that did not match the
+ *      target.
+ *
+ *  @return Bit per #EField
+ */
+unsigned int RS9110_Provision::GetDiff ()
+{
+    return _diff;
+}
+
+
+/*!
+ *  @brief  GetFailedCommand
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the command that stopped the provisioning (CMD_MAX if none or
+ *      not sent). See #GetPipeline for failures during the bring-up.
+ *
+ *  @return RS9110_UART::ECommand
+ */
+RS9110_UART::ECommand RS9110_Provision::GetFailedCommand ()
+{
+    return _failedCommand;
+}
+
+
+/*!
+ *  @brief  GetErrorCode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the error code of the ERROR that stopped the provisioning
+ *      (ERROR_NONE for any other failure).
+ *
+ *  @return RS9110_UART::EErrorCode
+ */
+RS9110_UART::EErrorCode RS9110_Provision::GetErrorCode ()
+{
+    return _errorCode;
+}
+
+
+/*!
+ *  @brief  GetPipeline
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Gives access to the pipeline running the bring-up (i.e. to get the
+ *      learned channel or the handles of the sockets opened).
+ *
+ *  @return RS9110_Pipeline
+ */
+RS9110_Pipeline & RS9110_Provision::GetPipeline ()
+{
+    return _pipeline;
+}
+
+
+/*!
+ *  @brief  DiffStoredConfig
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Compares the answer to "AT+RSI_CFGGET?" with a target, field by field.
+ *      Only the fields the target relies on are compared: the channel if it is
+ *      known, the PSK for WPA/WPA2, the WEP configuration for WEP (present only
+ *      if bit 7 of the feature select is set) and the addresses for DHCP_MANUAL.
+ *      The PSK is compared over 32 bytes unless bit 3 of the feature select
+ *      (63 byte mode) is set.
+ *
+ *  @param[in]  target  - Desired state of the link
+ *  @param[in]  config  - #RS9110_UART::TStoredConfig (plus #RS9110_UART::TStoredConfigWEP)
+ *  @param[in]  length  - Length of the answer (in bytes)
+ *
+ *  @return Bit per #EField (0 if equal)
+ */
+unsigned int RS9110_Provision::DiffStoredConfig (const RS9110_Pipeline::TTarget &target, const unsigned char *config, int length)
+{
+    const RS9110_UART::TStoredConfig    *stored = (const RS9110_UART::TStoredConfig *) config;
+    const RS9110_UART::TStoredConfigWEP *wep    = (const RS9110_UART::TStoredConfigWEP *) (config + sizeof(RS9110_UART::TStoredConfig));
+    unsigned char                        address[RS9110_UART::NW_ADDRESS_LEN];
+    unsigned short                       isValid;
+    unsigned char                        features;
+    unsigned int                         diff   = 0;
+
+
+    if((config == NULL) || (length < (int) sizeof(RS9110_UART::TStoredConfig)))
+    {
+        return FIELD_VALID;
+    }
+
+    /* Multi-byte fields are small endian */
+    isValid  = (unsigned short) (config[0] | (config[1] << 8));
+    features = stored->featureSelect[0];
+
+    if(isValid != CONFIG_VALID)
+    {
+        return FIELD_VALID;
+    }
+
+    if((target.channel != 0) && (target.channel != stored->channel))
+    {
+        diff |= FIELD_CHANNEL;
+    }
+
+    if(stored->nwType != ((target.nwType == RS9110_UART::NW_TYPE_INFRASTRUCTURE) ? STORED_NW_TYPE_INFRA : STORED_NW_TYPE_ADHOC))
+    {
+        diff |= FIELD_NW_TYPE;
+    }
+
+    if(stored->secMode != target.secMode)
+    {
+        diff |= FIELD_SEC_MODE;
+    }
+
+    if(stored->dataRate != target.txRate)
+    {
+        diff |= FIELD_DATA_RATE;
+    }
+
+    if(stored->powerLevel != target.txPower)
+    {
+        diff |= FIELD_POWER_LEVEL;
+    }
+
+    if(IsSameString(target.ssid, stored->ssid, RS9110_UART::MAX_SSID_LEN) == false)
+    {
+        diff |= FIELD_SSID;
+    }
+
+    switch(target.secMode)
+    {
+        case RS9110_UART::SEC_MODE_WPA:
+        case RS9110_UART::SEC_MODE_WPA2:
+            if(IsSameString(target.psk, stored->psk, (((features & FEATURE_PSK_EXT) != 0) ? RS9110_UART::MAX_PSK_LEN_EXT : RS9110_UART::MAX_PSK_LEN)) == false)
+            {
+                diff |= FIELD_PSK;
+            }
+        break;
+
+        case RS9110_UART::SEC_MODE_WEP:
+            if(((features & FEATURE_WEP_CONFIG) == 0) ||
+               (length < (int) (sizeof(RS9110_UART::TStoredConfig) + sizeof(RS9110_UART::TStoredConfigWEP))) ||
+               (wep->authMode != target.authMode) || (wep->index != target.wepKeyIndex))
+            {
+                diff |= FIELD_WEP;
+                break;
+            }
+
+            for(unsigned int i = 0; i < RS9110_UART::MAX_NUM_WEP_KEYS; i++)
+            {
+                if(IsSameString(target.wepKeys[i], (const char *) wep->keys[i], RS9110_UART::MAX_LEN_WEP_KEYS) == false)
+                {
+                    diff |= FIELD_WEP;
+                }
+            }
+        break;
+
+        default:
+            /* Nothing to do */
+        break;
+    }
+
+    if(stored->dhcp != ((target.dhcpMode == RS9110_UART::DHCP_DHCP) ? STORED_DHCP_ENABLE : 0))
+    {
+        diff |= FIELD_DHCP;
+    }
+    else if(target.dhcpMode == RS9110_UART::DHCP_MANUAL)
+    {
+        if((RS9110_UART::ParseAddress(target.address, address) == false) || (memcmp(address, stored->address, sizeof(address)) != 0) ||
+           (RS9110_UART::ParseAddress(target.subnet,  address) == false) || (memcmp(address, stored->subnet,  sizeof(address)) != 0) ||
+           (RS9110_UART::ParseAddress(target.gateway, address) == false) || (memcmp(address, stored->gateway, sizeof(address)) != 0))
+        {
+            diff |= FIELD_ADDRESS;
+        }
+    }
+
+    return diff;
+}
+
+
+/*!
+ *  @brief  StartPhase
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the command of a phase or starts the pipeline. #PHASE_MAX marks
+ *      the provisioning as done.
+ *
+ *  @param[in]  ePhase  - Phase to run
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Provision::StartPhase (EPhase ePhase, unsigned long nowMs)
+{
+    bool bRtn;
+
+
+    _phase      = ePhase;
+    _isWaiting  = false;
+
+    switch(ePhase)
+    {
+        case PHASE_READ:
+            bRtn = _rs.GetConfiguration();
+        break;
+
+        case PHASE_DISABLE:
+            bRtn = _rs.Configuration(RS9110_UART::CONFIG_DISABLE);
+        break;
+
+        case PHASE_BRING_UP:
+            /* The module joins by itself after "AT+RSI_BAND" when auto-join is set */
+            _pipeline.Start(nowMs, ((_result == RESULT_AUTO_JOIN) ? (1 << RS9110_Pipeline::STEP_BAND) : 0xFFFFFFFF));
+            CheckPipeline(nowMs);
+        return;
+
+        case PHASE_SAVE:
+            bRtn = _rs.SaveConfiguration();
+        break;
+
+        case PHASE_ENABLE:
+            bRtn = _rs.Configuration(RS9110_UART::CONFIG_ENABLE);
+        break;
+
+        default:
+            _state = STATE_DONE;
+        return;
+    }
+
+    if(bRtn == true)
+    {
+        _isWaiting  = true;
+        _sentMs     = nowMs;
+    }
+    else
+    {
+        Fail(RS9110_UART::CMD_MAX, RS9110_UART::ERROR_NONE);
+    }
+}
+
+
+/*!
+ *  @brief  CheckPipeline
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Follows the outcome of the bring-up once the pipeline stops running.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Provision::CheckPipeline (unsigned long nowMs)
+{
+    switch(_pipeline.GetState())
+    {
+        case RS9110_Pipeline::STATE_DONE:
+            StartPhase(((_result == RESULT_AUTO_JOIN) ? PHASE_MAX : PHASE_SAVE), nowMs);
+        break;
+
+        case RS9110_Pipeline::STATE_FAILED:
+            Fail(_rs.GetLastCommand(), _pipeline.GetErrorCode());
+        break;
+
+        default:
+            /* Nothing to do */
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Fail
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stops the provisioning.
+ *
+ *  @param[in]  command     - Command that failed
+ *  @param[in]  eErrorCode  - Error code of the ERROR answer (if any)
+ */
+void RS9110_Provision::Fail (RS9110_UART::ECommand command, RS9110_UART::EErrorCode eErrorCode)
+{
+    _state          = STATE_FAILED;
+    _isWaiting      = false;
+    _failedCommand  = command;
+    _errorCode      = eErrorCode;
+}
+
+
+/*!
+ *  @brief  Decode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Diffs the answer to "AT+RSI_CFGGET?" against the target. When they match,
+ *      an unknown channel is taken from the stored configuration.
+ */
+void RS9110_Provision::Decode ()
+{
+    const unsigned char *response;
+    int                  length;
+
+
+    response = (const unsigned char *) _rs.GetResponse(length);
+    _diff    = DiffStoredConfig(_pipeline.GetTarget(), response, length);
+
+    if((_diff == 0) && (_pipeline.GetTarget().channel == 0))
+    {
+        _pipeline.SetChannel(((const RS9110_UART::TStoredConfig *) response)->channel);
+    }
+}
+
+
+/*!
+ *  @brief  CommandOf
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the command sent by a phase (CMD_MAX for the bring-up).
+ *
+ *  @param[in]  ePhase  - Phase
+ *
+ *  @return RS9110_UART::ECommand
+ */
+RS9110_UART::ECommand RS9110_Provision::CommandOf (EPhase ePhase)
+{
+    switch(ePhase)
+    {
+        case PHASE_READ:    return RS9110_UART::CMD_GET_CONFIG;
+        case PHASE_DISABLE: return RS9110_UART::CMD_ENABLE_CONFIG;
+        case PHASE_SAVE:    return RS9110_UART::CMD_SAVE_CONFIG;
+        case PHASE_ENABLE:  return RS9110_UART::CMD_ENABLE_CONFIG;
+        default:            return RS9110_UART::CMD_MAX;
+    }
+}
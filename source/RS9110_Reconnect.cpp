@@ -0,0 +1,458 @@
+#include "RS9110_Reconnect.h"
+
+#include <string.h>
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver used to bring the link up
+ *
+ */
+RS9110_Reconnect::RS9110_Reconnect (RS9110_UART &rs)
+  : _rs(rs),
+    _pipeline(rs),
+    _state(STATE_IDLE),
+    _level(LEVEL_FULL),
+    _hasProfile(false),
+    _hasConnected(false),
+    _isReconnect(false),
+    _attempts(0),
+    _retryDelayMs(DEFAULT_RETRY_DELAY_MS),
+    _maxAttempts(DEFAULT_MAX_ATTEMPTS),
+    _startMs(0),
+    _retryAtMs(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    _pipeline.SetTimeout(DEFAULT_TIMEOUT_MS);
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Reconnect::~RS9110_Reconnect ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetProfile
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the configuration of the link. A new profile forgets that the link
+ *      has ever been up, so the next (re)connection is a full bring-up.
+ *
+ *  @param[in]  profile - Configuration of the link
+ */
+void RS9110_Reconnect::SetProfile (const TProfile &profile)
+{
+    _pipeline.SetTarget(profile);
+
+    _hasProfile     = (profile.ssid[0] != '\0');
+    _hasConnected   = false;
+}
+
+
+/*!
+ *  @brief  GetProfile
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the configuration of the link, including the learned channel.
+ *
+ *  @param[out] profile - Configuration of the link
+ */
+void RS9110_Reconnect::GetProfile (TProfile &profile)
+{
+    _pipeline.GetTarget(profile);
+}
+
+
+/*!
+ *  @brief  SetTiming
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets how long an answer is waited for, the delay between full bring-up
+ *      attempts and how many of them are made before giving up.
+ *
+ *  @param[in]  timeoutMs       - Time to wait for an answer (ms)
+ *  @param[in]  retryDelayMs    - Delay between #LEVEL_FULL attempts (ms)
+ *  @param[in]  maxAttempts     - #LEVEL_FULL attempts (at least 1)
+ */
+void RS9110_Reconnect::SetTiming (unsigned long timeoutMs, unsigned long retryDelayMs, unsigned char maxAttempts)
+{
+    _pipeline.SetTimeout(timeoutMs);
+
+    _retryDelayMs   = retryDelayMs;
+    _maxAttempts    = ((maxAttempts > 0) ? maxAttempts : 1);
+}
+
+
+/*!
+ *  @brief  Connect
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts a full bring-up.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - No profile or already connecting
+ */
+bool RS9110_Reconnect::Connect (unsigned long nowMs)
+{
+    if((_hasProfile == false) || (_state == STATE_CONNECTING))
+    {
+        return false;
+    }
+
+    _isReconnect    = false;
+    _attempts       = 0;
+    _startMs        = nowMs;
+
+    StartAttempt(LEVEL_FULL, nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  LinkLost
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts bringing the link back, with #LEVEL_FAST if it has been up with
+ *      the current profile. ERROR_DEAUTH_FROM_AP calls it automatically.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - No profile or already connecting
+ */
+bool RS9110_Reconnect::LinkLost (unsigned long nowMs)
+{
+    if((_hasProfile == false) || (_state == STATE_CONNECTING))
+    {
+        return false;
+    }
+
+    _isReconnect    = true;
+    _attempts       = 0;
+    _startMs        = nowMs;
+
+    StartAttempt(((_hasConnected == true) ? LEVEL_FAST : LEVEL_FULL), nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Stop
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Abandons the (re)connection in progress. An answer still pending is ignored.
+ */
+void RS9110_Reconnect::Stop ()
+{
+    _state = STATE_IDLE;
+    _pipeline.Stop();
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Detects commands not answered in time and starts the pending retries.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return EState
+ */
+RS9110_Reconnect::EState RS9110_Reconnect::Poll (unsigned long nowMs)
+{
+    if(_state == STATE_CONNECTING)
+    {
+        if(_pipeline.GetState() == RS9110_Pipeline::STATE_RUNNING)
+        {
+            _pipeline.Poll(nowMs);
+            CheckAttempt(nowMs);
+        }
+        else if((long) (nowMs - _retryAtMs) >= 0)
+        {
+            StartAttempt(LEVEL_FULL, nowMs);
+        }
+    }
+
+    return _state;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Runs the next step on the OK of the current one and falls back on its
+ *      ERROR. While connected, ERROR_DEAUTH_FROM_AP starts a reconnection. Must
+ *      be called after every #RS9110_UART::ProcessMessage.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not related to the (re)connection
+ */
+bool RS9110_Reconnect::ProcessResponse (unsigned long nowMs)
+{
+    RS9110_UART::EResponseType responseType = _rs.GetResponseType();
+
+
+    if((_state == STATE_CONNECTED) &&
+       (responseType == RS9110_UART::RESP_TYPE_ERROR) &&
+       (_rs.GetErrorCode() == RS9110_UART::ERROR_DEAUTH_FROM_AP))
+    {
+        return LinkLost(nowMs);
+    }
+
+    if((_state != STATE_CONNECTING) || (_pipeline.ProcessResponse(nowMs) == false))
+    {
+        return false;
+    }
+
+    CheckAttempt(nowMs);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the state of the link.
+ *
+ *  @return EState
+ */
+RS9110_Reconnect::EState RS9110_Reconnect::GetState ()
+{
+    return _state;
+}
+
+
+/*!
+ *  @brief  GetLevel
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the level of the attempt in progress (or of the last one).
+ *
+ *  @return ELevel
+ */
+RS9110_Reconnect::ELevel RS9110_Reconnect::GetLevel ()
+{
+    return _level;
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the reconnection statistics. Times go from
+ *      #LinkLost to the OK of the last step.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Reconnect::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  StartAttempt
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Starts an attempt at the given level by sending its first command.
+ *
+ *  @param[in]  eLevel  - Level of the attempt
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Reconnect::StartAttempt (ELevel eLevel, unsigned long nowMs)
+{
+    _state = STATE_CONNECTING;
+    _level = eLevel;
+
+    _pipeline.Start(nowMs, StepsOf(eLevel), (eLevel == LEVEL_FULL));
+
+    CheckAttempt(nowMs);
+}
+
+
+/*!
+ *  @brief  CheckAttempt
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Follows the outcome of the pipeline once it stops running.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Reconnect::CheckAttempt (unsigned long nowMs)
+{
+    switch(_pipeline.GetState())
+    {
+        case RS9110_Pipeline::STATE_DONE:
+            Completed(nowMs);
+        break;
+
+        case RS9110_Pipeline::STATE_FAILED:
+            Fail(nowMs);
+        break;
+
+        default:
+            /* Nothing to do */
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Fail
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Falls back to the next level or, at #LEVEL_FULL, schedules another
+ *      attempt until the maximum is reached.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Reconnect::Fail (unsigned long nowMs)
+{
+    if(_level < LEVEL_FULL)
+    {
+        StartAttempt((ELevel) (_level + 1), nowMs);
+        return;
+    }
+
+    _attempts++;
+
+    if(_attempts >= _maxAttempts)
+    {
+        _state = STATE_FAILED;
+        _stats.numFailures++;
+    }
+    else
+    {
+        _retryAtMs = nowMs + _retryDelayMs;
+    }
+}
+
+
+/*!
+ *  @brief  Completed
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Marks the link as connected and, for reconnections, updates the statistics.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_Reconnect::Completed (unsigned long nowMs)
+{
+    unsigned long elapsed = nowMs - _startMs;
+
+
+    _state          = STATE_CONNECTED;
+    _hasConnected   = true;
+
+    if(_isReconnect == true)
+    {
+        _stats.numReconnects++;
+        _stats.successes[_level]++;
+        _stats.lastReconnectMs   = elapsed;
+        _stats.totalReconnectMs += elapsed;
+        _stats.lastLevel         = (unsigned char) _level;
+
+        if(elapsed > _stats.maxReconnectMs)
+        {
+            _stats.maxReconnectMs = elapsed;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  StepsOf
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the steps of an attempt at the given level. The pipeline leaves
+ *      out the ones the profile does not need.
+ *
+ *  @param[in]  eLevel  - Level of the attempt
+ *
+ *  @return Bit per #EStep
+ */
+unsigned int RS9110_Reconnect::StepsOf (ELevel eLevel)
+{
+    unsigned int steps = (1 << RS9110_Pipeline::STEP_SCAN) | (1 << RS9110_Pipeline::STEP_JOIN) |
+                         (1 << RS9110_Pipeline::STEP_IP_CONF) | (1 << RS9110_Pipeline::STEP_GET_PARAMS) |
+                         (1 << RS9110_Pipeline::STEP_OPEN_SOCKETS);
+
+
+    if(eLevel >= LEVEL_REJOIN)
+    {
+        steps |= (1 << RS9110_Pipeline::STEP_NETWORK_TYPE) | (1 << RS9110_Pipeline::STEP_FEATURE_SELECT) |
+                 (1 << RS9110_Pipeline::STEP_PSK) | (1 << RS9110_Pipeline::STEP_WEP_KEYS) |
+                 (1 << RS9110_Pipeline::STEP_AUTH_MODE);
+    }
+
+    if(eLevel >= LEVEL_FULL)
+    {
+        steps |= (1 << RS9110_Pipeline::STEP_BAND) | (1 << RS9110_Pipeline::STEP_INIT);
+    }
+
+    return steps;
+}
@@ -0,0 +1,462 @@
+#include "RS9110_Ring.h"
+
+#include "RS9110_Barrier.h"
+
+#include <string.h>
+
+
+static const unsigned short LEN_SIZE    = sizeof(unsigned short);
+static const unsigned short LEN_WRAP    = 0xFFFF;     /* Rest of the ring skipped */
+
+
+/*!
+ *  @brief  GetLength
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reads the (unaligned) length prefix of a record.
+ *
+ *  @param[in]  position    - Start of the record
+ *
+ *  @return unsigned short
+ */
+static unsigned short GetLength (const char *position)
+{
+    unsigned short length;
+
+
+    memcpy(&length, position, LEN_SIZE);
+
+    return length;
+}
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ */
+RS9110_Ring::RS9110_Ring ()
+  : _control(NULL),
+    _data(NULL),
+    _size(0),
+    _head(0),
+    _tail(0),
+    _reserved(0),
+    _isCorrupt(false)
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Ring::~RS9110_Ring ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Attach
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Lays the ring over a memory region. Only the side creating the region
+ *      initializes it.
+ *
+ *  @param[in]  memory      - Region (aligned to unsigned long)
+ *  @param[in]  footprint   - Size of the region (see #GetFootprint)
+ *  @param[in]  isInit      - Initialize the indexes
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Region too small or not matching its indexes
+ */
+bool RS9110_Ring::Attach (void *memory, unsigned long footprint, bool isInit)
+{
+    TControl *control = (TControl *) memory;
+
+
+    if((memory == NULL) || (footprint <= GetFootprint(LEN_SIZE)))
+    {
+        return false;
+    }
+
+    if(isInit == true)
+    {
+        control->head = 0;
+        control->tail = 0;
+        control->size = footprint - sizeof(TControl);
+    }
+    else if((control->size != (footprint - sizeof(TControl))) ||
+            (control->head >= control->size) || (control->tail >= control->size))
+    {
+        return false;
+    }
+
+    _control    = control;
+    _data       = (char *) &control[1];
+    _size       = footprint - sizeof(TControl);
+    _head       = control->head;
+    _tail       = control->tail;
+    _reserved   = 0;
+    _isCorrupt  = false;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Detach
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Forgets the memory region.
+ */
+void RS9110_Ring::Detach ()
+{
+    _control    = NULL;
+    _data       = NULL;
+}
+
+
+/*!
+ *  @brief  IsAttached
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether the ring lies over a memory region.
+ *
+ *  @return bool
+ */
+bool RS9110_Ring::IsAttached ()
+{
+    return (_control != NULL);
+}
+
+
+/*!
+ *  @brief  Reserve
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reserves room for a record (producer). The record is not seen by the
+ *      consumer until #Commit.
+ *
+ *  @param[in]  size    - Size of the record (in bytes)
+ *
+ *  @return Where to write the record (NULL if no room)
+ */
+char * RS9110_Ring::Reserve (unsigned short size)
+{
+    unsigned long head;
+    unsigned long tail;
+    unsigned long ringSize;
+    unsigned long need = LEN_SIZE + size;
+
+
+    if((_control == NULL) || (_isCorrupt == true) || (size > MAX_RECORD))
+    {
+        return NULL;
+    }
+
+    head        = _head;
+    tail        = _control->tail;
+    ringSize    = _size;
+
+    if(tail >= ringSize)
+    {
+        _isCorrupt = true;
+        return NULL;
+    }
+
+    /* One byte always left free: head == tail means empty */
+    if(head >= tail)
+    {
+        if((ringSize - head) >= need)
+        {
+            if(((ringSize - head) == need) && (tail == 0))
+            {
+                return NULL;
+            }
+        }
+        else
+        {
+            /* The record starts again at 0 */
+            if(need >= tail)
+            {
+                return NULL;
+            }
+
+            head = 0;
+        }
+    }
+    else if((tail - head) <= need)
+    {
+        return NULL;
+    }
+
+    _reserved = head;
+
+    return &_data[head + LEN_SIZE];
+}
+
+
+/*!
+ *  @brief  Commit
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Publishes the record reserved by the last #Reserve (producer).
+ *
+ *  @param[in]  size    - Size of the record written (not above the size reserved)
+ */
+void RS9110_Ring::Commit (unsigned short size)
+{
+    unsigned long next;
+
+
+    if((_control == NULL) || (_isCorrupt == true))
+    {
+        return;
+    }
+
+    /* Skip the end of the ring if the record was reserved at 0 */
+    if((_reserved != _head) && ((_size - _head) >= LEN_SIZE))
+    {
+        unsigned short wrap = LEN_WRAP;
+
+
+        memcpy(&_data[_head], &wrap, LEN_SIZE);
+    }
+
+    memcpy(&_data[_reserved], &size, LEN_SIZE);
+
+    next = _reserved + LEN_SIZE + size;
+
+    if(next == _size)
+    {
+        next = 0;
+    }
+
+    /* The record is complete before the consumer sees it */
+    RS9110_MEMORY_BARRIER();
+
+    _head           = next;
+    _control->head  = next;
+}
+
+
+/*!
+ *  @brief  Write
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies a record into the ring (producer).
+ *
+ *  @param[in]  data    - Record
+ *  @param[in]  size    - Size of the record (in bytes)
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - No room
+ */
+bool RS9110_Ring::Write (const char *data, unsigned short size)
+{
+    char *record = Reserve(size);
+
+
+    if(record == NULL)
+    {
+        return false;
+    }
+
+    memcpy(record, data, size);
+    Commit(size);
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Peek
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the oldest record, in place (consumer). It stays in the ring
+ *      until #Release. The head written by the producer and the length of the
+ *      record are checked first: a record not lying between the tail and the
+ *      head makes the ring corrupt.
+ *
+ *  @param[out] size    - Size of the record (in bytes)
+ *
+ *  @return Record (NULL if empty or corrupt)
+ */
+const char * RS9110_Ring::Peek (unsigned short &size)
+{
+    unsigned long   head;
+    unsigned long   end;
+    unsigned short  length;
+
+
+    if((_control == NULL) || (_isCorrupt == true))
+    {
+        return NULL;
+    }
+
+    head = _control->head;
+
+    /* The record is read after its index */
+    RS9110_MEMORY_BARRIER();
+
+    if(head >= _size)
+    {
+        _isCorrupt = true;
+        return NULL;
+    }
+
+    if(head == _tail)
+    {
+        return NULL;
+    }
+
+    if(((_size - _tail) < LEN_SIZE) || (GetLength(&_data[_tail]) == LEN_WRAP))
+    {
+        /* Only a producer gone back to 0 skips the end */
+        if(head > _tail)
+        {
+            _isCorrupt = true;
+            return NULL;
+        }
+
+        _tail           = 0;
+        _control->tail  = 0;
+
+        if(head == 0)
+        {
+            return NULL;
+        }
+    }
+
+    end     = ((head > _tail) ? head : _size);
+    length  = GetLength(&_data[_tail]);
+
+    if((end - _tail) < ((unsigned long) LEN_SIZE + length))
+    {
+        _isCorrupt = true;
+        return NULL;
+    }
+
+    size = length;
+
+    return &_data[_tail + LEN_SIZE];
+}
+
+
+/*!
+ *  @brief  Release
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees the record returned by the last #Peek (consumer).
+ */
+void RS9110_Ring::Release ()
+{
+    unsigned short  size;
+    unsigned long   next;
+
+
+    if(Peek(size) == NULL)
+    {
+        return;
+    }
+
+    next = _tail + LEN_SIZE + size;
+
+    if(next == _size)
+    {
+        next = 0;
+    }
+
+    /* Done with the record before the producer may overwrite it */
+    RS9110_MEMORY_BARRIER();
+
+    _tail           = next;
+    _control->tail  = next;
+}
+
+
+/*!
+ *  @brief  IsEmpty
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether there is no record to read.
+ *
+ *  @return bool
+ */
+bool RS9110_Ring::IsEmpty ()
+{
+    unsigned short size;
+
+
+    return (Peek(size) == NULL);
+}
+
+
+/*!
+ *  @brief  IsCorrupt
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether a wrong index or record was found in the region. The
+ *      ring stays unusable until it is attached again.
+ *
+ *  @return bool
+ */
+bool RS9110_Ring::IsCorrupt ()
+{
+    return _isCorrupt;
+}
+
+
+/*!
+ *  @brief  GetFootprint
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the size of the memory region holding a ring.
+ *
+ *  @param[in]  dataSize    - Bytes for the records (2 more per record)
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_Ring::GetFootprint (unsigned long dataSize)
+{
+    return sizeof(TControl) + dataSize;
+}
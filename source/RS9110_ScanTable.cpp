@@ -0,0 +1,926 @@
+#include "RS9110_ScanTable.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckScanEntries       [((RS9110_ScanTable::MAX_ENTRIES >= 1) && (RS9110_ScanTable::MAX_ENTRIES < 0xFFFF)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver whose scan answers are collected
+ *
+ */
+RS9110_ScanTable::RS9110_ScanTable (RS9110_UART &rs)
+  : _rs(rs)
+{
+    Clear();
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_ScanTable::~RS9110_ScanTable ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Collects the OK of Scan (starts a new batch), NextScan (appends to the
+ *      batch), GetMACOfAPs and GetNetworkType (joined by position with the batch).
+ *      Must be called after every #RS9110_UART::ProcessMessage; other messages
+ *      are ignored.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not a scan related answer
+ */
+bool RS9110_ScanTable::ProcessResponse (unsigned long nowMs)
+{
+    const void *response;
+    int         length;
+
+
+    if(_rs.GetResponseType() != RS9110_UART::RESP_TYPE_OK)
+    {
+        return false;
+    }
+
+    response = _rs.GetResponse(length);
+
+    if((response == NULL) || (length < 0))
+    {
+        length = 0;
+    }
+
+    switch(_rs.GetLastCommand())
+    {
+        case RS9110_UART::CMD_SCAN:
+            for(unsigned int i = 0; i < _batchSize; i++)
+            {
+                if(_batch[i] != NONE)
+                {
+                    _entries[_batch[i]].inBatch = false;
+                }
+            }
+
+            _batchSize = 0;
+
+            AddScanResults((const RS9110_UART::TScan *) response, length / sizeof(RS9110_UART::TScan), nowMs);
+        break;
+
+        case RS9110_UART::CMD_NEXT_SCAN:
+            AddScanResults((const RS9110_UART::TScan *) response, length / sizeof(RS9110_UART::TScan), nowMs);
+        break;
+
+        case RS9110_UART::CMD_GET_MAC_APS:
+            JoinBSSIDs((const RS9110_UART::TBssid *) response, length / sizeof(RS9110_UART::TBssid));
+        break;
+
+        case RS9110_UART::CMD_GET_NETWORK_TYPE:
+            JoinNetworkTypes((const RS9110_UART::TNetworkType *) response, length / sizeof(RS9110_UART::TNetworkType));
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetNumAccessPoints
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of access points in the table.
+ *
+ *  @return unsigned int
+ */
+unsigned int RS9110_ScanTable::GetNumAccessPoints ()
+{
+    return _numEntries;
+}
+
+
+/*!
+ *  @brief  FindBySSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the strongest access point announcing the SSID.
+ *
+ *  @param[in]  ssid        - SSID
+ *  @param[out] accessPoint - Copy of the access point
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - SSID not seen
+ */
+bool RS9110_ScanTable::FindBySSID (const char *ssid, TAccessPoint &accessPoint)
+{
+    const TAccessPoint *best = NULL;
+
+
+    if(ssid == NULL)
+    {
+        return false;
+    }
+
+    for(unsigned short i = _bucketsSsid[HashSSID(ssid) % HASH_BUCKETS]; i != NONE; i = _entries[i].nextSsid)
+    {
+        const TAccessPoint *ap = &_entries[i].ap;
+
+        if((strcmp(ap->ssid, ssid) == 0) && ((best == NULL) || (IsStronger(*ap, *best) == true)))
+        {
+            best = ap;
+        }
+    }
+
+    if(best == NULL)
+    {
+        return false;
+    }
+
+    memcpy(&accessPoint, best, sizeof(accessPoint));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  FindByBSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the access point with the BSSID.
+ *
+ *  @param[in]  bssid       - BSSID (#RS9110_UART::MAC_ADDRESS_LEN bytes)
+ *  @param[out] accessPoint - Copy of the access point
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - BSSID not seen
+ */
+bool RS9110_ScanTable::FindByBSSID (const unsigned char *bssid, TAccessPoint &accessPoint)
+{
+    unsigned short index;
+
+
+    if(bssid == NULL)
+    {
+        return false;
+    }
+
+    index = LookupBSSID(bssid);
+
+    if(index == NONE)
+    {
+        return false;
+    }
+
+    memcpy(&accessPoint, &_entries[index].ap, sizeof(accessPoint));
+
+    return true;
+}
+
+
+/*!
+ *  @brief  GetStrongest
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies the k strongest access points, strongest first. The selection
+ *      keeps a heap of k elements in the output array, so it takes
+ *      O(n log k) instead of sorting the whole table.
+ *
+ *  @param[out] accessPoints    - Array of at least k elements
+ *  @param[in]  k               - Number of access points wanted
+ *
+ *  @return Number of access points copied
+ */
+unsigned int RS9110_ScanTable::GetStrongest (TAccessPoint *accessPoints, unsigned int k)
+{
+    unsigned int size = 0;
+
+
+    if((accessPoints == NULL) || (k == 0))
+    {
+        return 0;
+    }
+
+    /* Heap with the weakest of the selected ones on top */
+    for(unsigned int i = 0; i < MAX_ENTRIES; i++)
+    {
+        if(_entries[i].isUsed == false)
+        {
+            continue;
+        }
+
+        if(size < k)
+        {
+            memcpy(&accessPoints[size], &_entries[i].ap, sizeof(TAccessPoint));
+            SiftUp(accessPoints, size);
+            size++;
+        }
+        else if(IsStronger(_entries[i].ap, accessPoints[0]) == true)
+        {
+            memcpy(&accessPoints[0], &_entries[i].ap, sizeof(TAccessPoint));
+            SiftDown(accessPoints, size, 0);
+        }
+    }
+
+    /* Move the weakest to the end, one by one */
+    for(unsigned int last = size; last > 1; last--)
+    {
+        TAccessPoint tmp;
+
+        memcpy(&tmp, &accessPoints[0], sizeof(tmp));
+        memcpy(&accessPoints[0], &accessPoints[last - 1], sizeof(tmp));
+        memcpy(&accessPoints[last - 1], &tmp, sizeof(tmp));
+
+        SiftDown(accessPoints, last - 1, 0);
+    }
+
+    return size;
+}
+
+
+/*!
+ *  @brief  Expire
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops the access points not seen for a while.
+ *
+ *  @param[in]  nowMs       - Current time (ms)
+ *  @param[in]  maxAgeMs    - Maximum time since last seen (ms)
+ *
+ *  @return Number of access points dropped
+ */
+unsigned int RS9110_ScanTable::Expire (unsigned long nowMs, unsigned long maxAgeMs)
+{
+    unsigned int num = 0;
+
+
+    for(unsigned short i = 0; i < MAX_ENTRIES; i++)
+    {
+        if((_entries[i].isUsed == true) && ((nowMs - _entries[i].ap.lastSeenMs) > maxAgeMs))
+        {
+            Release(i);
+            num++;
+        }
+    }
+
+    return num;
+}
+
+
+/*!
+ *  @brief  Clear
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops every access point.
+ */
+void RS9110_ScanTable::Clear ()
+{
+    memset(_entries, 0, sizeof(_entries));
+
+    for(unsigned short i = 0; i < MAX_ENTRIES; i++)
+    {
+        _entries[i].nextSsid    = (unsigned short) ((((unsigned int) i + 1) < MAX_ENTRIES) ? (i + 1) : NONE);
+        _entries[i].nextBssid   = NONE;
+    }
+
+    for(unsigned int i = 0; i < HASH_BUCKETS; i++)
+    {
+        _bucketsSsid[i]  = NONE;
+        _bucketsBssid[i] = NONE;
+    }
+
+    _numEntries = 0;
+    _free       = 0;
+    _batchSize  = 0;
+}
+
+
+/*!
+ *  @brief  AddScanResults
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Appends a page of scan results to the batch. Each record updates an
+ *      access point known by its SSID only (and not in the batch yet) or
+ *      creates a new one.
+ *
+ *  @param[in]  scan    - Scan records
+ *  @param[in]  num     - Number of records
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_ScanTable::AddScanResults (const RS9110_UART::TScan *scan, unsigned int num, unsigned long nowMs)
+{
+    char ssid[RS9110_UART::MAX_SSID_LEN + 1];
+
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        unsigned short  index = NONE;
+        TEntry         *entry;
+
+        memcpy(ssid, scan[i].ssid, RS9110_UART::MAX_SSID_LEN);
+        ssid[RS9110_UART::MAX_SSID_LEN] = '\0';
+
+        for(unsigned short j = _bucketsSsid[HashSSID(ssid) % HASH_BUCKETS]; j != NONE; j = _entries[j].nextSsid)
+        {
+            if((_entries[j].ap.hasBssid == false) && (_entries[j].inBatch == false) && (strcmp(_entries[j].ap.ssid, ssid) == 0))
+            {
+                index = j;
+                break;
+            }
+        }
+
+        if(index == NONE)
+        {
+            index = Allocate();
+            entry = &_entries[index];
+
+            strcpy(entry->ap.ssid, ssid);
+            entry->ap.nwType = RS9110_UART::NW_TYPE_RSP_MAX;
+
+            LinkSSID(index);
+        }
+
+        entry = &_entries[index];
+        entry->ap.secMode       = scan[i].mode;
+        entry->ap.rssi          = scan[i].rssi;
+        entry->ap.lastSeenMs    = nowMs;
+
+        if(_batchSize < MAX_ENTRIES)
+        {
+            entry->inBatch = true;
+            _batch[_batchSize++] = index;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  JoinBSSIDs
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Gives each access point of the batch its BSSID. If the BSSID was already
+ *      known, the fresh scan data is moved to that access point.
+ *
+ *  @param[in]  bssid   - BSSID records (same order as the batch)
+ *  @param[in]  num     - Number of records
+ */
+void RS9110_ScanTable::JoinBSSIDs (const RS9110_UART::TBssid *bssid, unsigned int num)
+{
+    char ssid[RS9110_UART::MAX_SSID_LEN + 1];
+
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        int             pos;
+        unsigned short  index;
+        unsigned short  known;
+        TEntry         *entry;
+
+        memcpy(ssid, bssid[i].ssid, RS9110_UART::MAX_SSID_LEN);
+        ssid[RS9110_UART::MAX_SSID_LEN] = '\0';
+
+        pos = FindInBatch(i, ssid, true);
+
+        if(pos < 0)
+        {
+            continue;
+        }
+
+        index = _batch[pos];
+        entry = &_entries[index];
+        known = LookupBSSID(bssid[i].bssid);
+
+        if(known == index)
+        {
+            continue;
+        }
+
+        if(known != NONE)
+        {
+            TEntry *target = &_entries[known];
+
+            if(strcmp(target->ap.ssid, ssid) != 0)
+            {
+                UnlinkSSID(known);
+                strcpy(target->ap.ssid, ssid);
+                LinkSSID(known);
+            }
+
+            target->ap.secMode      = entry->ap.secMode;
+            target->ap.rssi         = entry->ap.rssi;
+            target->ap.lastSeenMs   = entry->ap.lastSeenMs;
+
+            if(entry->ap.nwType != RS9110_UART::NW_TYPE_RSP_MAX)
+            {
+                target->ap.nwType = entry->ap.nwType;
+            }
+
+            Release(index);
+
+            target->inBatch = true;
+            _batch[pos]     = known;
+        }
+        else
+        {
+            if(entry->ap.hasBssid == true)
+            {
+                UnlinkBSSID(index);
+            }
+
+            memcpy(entry->ap.bssid, bssid[i].bssid, sizeof(entry->ap.bssid));
+            entry->ap.hasBssid = true;
+
+            LinkBSSID(index);
+        }
+    }
+}
+
+
+/*!
+ *  @brief  JoinNetworkTypes
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Gives each access point of the batch its network type.
+ *
+ *  @param[in]  nwType  - Network type records (same order as the batch)
+ *  @param[in]  num     - Number of records
+ */
+void RS9110_ScanTable::JoinNetworkTypes (const RS9110_UART::TNetworkType *nwType, unsigned int num)
+{
+    char ssid[RS9110_UART::MAX_SSID_LEN + 1];
+
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        int pos;
+
+        memcpy(ssid, nwType[i].ssid, RS9110_UART::MAX_SSID_LEN);
+        ssid[RS9110_UART::MAX_SSID_LEN] = '\0';
+
+        pos = FindInBatch(i, ssid, false);
+
+        if(pos >= 0)
+        {
+            _entries[_batch[pos]].ap.nwType = nwType[i].nwType;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  FindInBatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Finds the batch position matching a record of a parallel answer: the same
+ *      position if the SSID matches, otherwise the first position with that SSID.
+ *
+ *  @param[in]  position        - Position of the record in the answer
+ *  @param[in]  ssid            - SSID of the record
+ *  @param[in]  withoutBssid    - Fall back only to access points without BSSID
+ *
+ *  @return Position in the batch (-1 if not found)
+ */
+int RS9110_ScanTable::FindInBatch (unsigned int position, const char *ssid, bool withoutBssid)
+{
+    if((position < _batchSize) && (_batch[position] != NONE) &&
+       (strcmp(_entries[_batch[position]].ap.ssid, ssid) == 0))
+    {
+        return (int) position;
+    }
+
+    for(unsigned int i = 0; i < _batchSize; i++)
+    {
+        if((_batch[i] != NONE) &&
+           ((withoutBssid == false) || (_entries[_batch[i]].ap.hasBssid == false)) &&
+           (strcmp(_entries[_batch[i]].ap.ssid, ssid) == 0))
+        {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+
+/*!
+ *  @brief  Allocate
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes an entry from the free list or, if the table is full, reuses the
+ *      access point seen longest ago.
+ *
+ *  @return Index of the entry
+ */
+unsigned short RS9110_ScanTable::Allocate ()
+{
+    unsigned short index;
+
+
+    if(_free == NONE)
+    {
+        index = 0;
+
+        for(unsigned short i = 1; i < MAX_ENTRIES; i++)
+        {
+            if((long) (_entries[i].ap.lastSeenMs - _entries[index].ap.lastSeenMs) < 0)
+            {
+                index = i;
+            }
+        }
+
+        Release(index);
+    }
+
+    index = _free;
+    _free = _entries[index].nextSsid;
+
+    memset(&_entries[index], 0, sizeof(TEntry));
+    _entries[index].isUsed      = true;
+    _entries[index].nextSsid    = NONE;
+    _entries[index].nextBssid   = NONE;
+
+    _numEntries++;
+
+    return index;
+}
+
+
+/*!
+ *  @brief  Release
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Removes an access point from the indexes and the batch and returns its
+ *      entry to the free list.
+ *
+ *  @param[in]  index   - Index of the entry
+ */
+void RS9110_ScanTable::Release (unsigned short index)
+{
+    TEntry *entry = &_entries[index];
+
+
+    UnlinkSSID(index);
+
+    if(entry->ap.hasBssid == true)
+    {
+        UnlinkBSSID(index);
+    }
+
+    if(entry->inBatch == true)
+    {
+        for(unsigned int i = 0; i < _batchSize; i++)
+        {
+            if(_batch[i] == index)
+            {
+                _batch[i] = NONE;
+            }
+        }
+    }
+
+    entry->isUsed   = false;
+    entry->inBatch  = false;
+    entry->nextSsid = _free;
+    _free           = index;
+
+    _numEntries--;
+}
+
+
+/*!
+ *  @brief  LinkSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds an entry to the SSID index.
+ *
+ *  @param[in]  index   - Index of the entry
+ */
+void RS9110_ScanTable::LinkSSID (unsigned short index)
+{
+    unsigned short *bucket = &_bucketsSsid[HashSSID(_entries[index].ap.ssid) % HASH_BUCKETS];
+
+
+    _entries[index].nextSsid = *bucket;
+    *bucket = index;
+}
+
+
+/*!
+ *  @brief  UnlinkSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Removes an entry from the SSID index.
+ *
+ *  @param[in]  index   - Index of the entry
+ */
+void RS9110_ScanTable::UnlinkSSID (unsigned short index)
+{
+    unsigned short *link = &_bucketsSsid[HashSSID(_entries[index].ap.ssid) % HASH_BUCKETS];
+
+
+    while(*link != NONE)
+    {
+        if(*link == index)
+        {
+            *link = _entries[index].nextSsid;
+            break;
+        }
+
+        link = &_entries[*link].nextSsid;
+    }
+
+    _entries[index].nextSsid = NONE;
+}
+
+
+/*!
+ *  @brief  LinkBSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Adds an entry to the BSSID index.
+ *
+ *  @param[in]  index   - Index of the entry
+ */
+void RS9110_ScanTable::LinkBSSID (unsigned short index)
+{
+    unsigned short *bucket = &_bucketsBssid[HashBSSID(_entries[index].ap.bssid) % HASH_BUCKETS];
+
+
+    _entries[index].nextBssid = *bucket;
+    *bucket = index;
+}
+
+
+/*!
+ *  @brief  UnlinkBSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Removes an entry from the BSSID index.
+ *
+ *  @param[in]  index   - Index of the entry
+ */
+void RS9110_ScanTable::UnlinkBSSID (unsigned short index)
+{
+    unsigned short *link = &_bucketsBssid[HashBSSID(_entries[index].ap.bssid) % HASH_BUCKETS];
+
+
+    while(*link != NONE)
+    {
+        if(*link == index)
+        {
+            *link = _entries[index].nextBssid;
+            break;
+        }
+
+        link = &_entries[*link].nextBssid;
+    }
+
+    _entries[index].nextBssid = NONE;
+}
+
+
+/*!
+ *  @brief  LookupBSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Looks for the entry of a BSSID in the BSSID index.
+ *
+ *  @param[in]  bssid   - BSSID
+ *
+ *  @return Index of the entry (NONE if not found)
+ */
+unsigned short RS9110_ScanTable::LookupBSSID (const unsigned char *bssid)
+{
+    for(unsigned short i = _bucketsBssid[HashBSSID(bssid) % HASH_BUCKETS]; i != NONE; i = _entries[i].nextBssid)
+    {
+        if(memcmp(_entries[i].ap.bssid, bssid, RS9110_UART::MAC_ADDRESS_LEN) == 0)
+        {
+            return i;
+        }
+    }
+
+    return NONE;
+}
+
+
+/*!
+ *  @brief  HashSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      FNV-1a hash of an SSID (zero-ended).
+ *
+ *  @param[in]  ssid    - SSID
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_ScanTable::HashSSID (const char *ssid)
+{
+    unsigned long hash = 2166136261UL;
+
+
+    for(unsigned int i = 0; (i < RS9110_UART::MAX_SSID_LEN) && (ssid[i] != '\0'); i++)
+    {
+        hash = ((hash ^ (unsigned char) ssid[i]) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return hash;
+}
+
+
+/*!
+ *  @brief  HashBSSID
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      FNV-1a hash of a BSSID.
+ *
+ *  @param[in]  bssid   - BSSID
+ *
+ *  @return unsigned long
+ */
+unsigned long RS9110_ScanTable::HashBSSID (const unsigned char *bssid)
+{
+    unsigned long hash = 2166136261UL;
+
+
+    for(unsigned int i = 0; i < RS9110_UART::MAC_ADDRESS_LEN; i++)
+    {
+        hash = ((hash ^ bssid[i]) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return hash;
+}
+
+
+/*!
+ *  @brief  IsStronger
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Compares two access points by RSSI (-dBm, the lower the stronger), the
+ *      most recently seen first on ties.
+ *
+ *  @param[in]  ap1 - Access point
+ *  @param[in]  ap2 - Access point
+ *
+ *  @return bool
+ *  @retval true    - ap1 is stronger than ap2
+ *  @retval false   - Otherwise
+ */
+bool RS9110_ScanTable::IsStronger (const TAccessPoint &ap1, const TAccessPoint &ap2)
+{
+    if(ap1.rssi != ap2.rssi)
+    {
+        return (ap1.rssi < ap2.rssi);
+    }
+
+    return ((long) (ap1.lastSeenMs - ap2.lastSeenMs) > 0);
+}
+
+
+/*!
+ *  @brief  SiftUp
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves an element up the heap (weakest on top) until its parent is weaker.
+ *
+ *  @param[in,out]  heap    - Heap
+ *  @param[in]      pos     - Position of the element
+ */
+void RS9110_ScanTable::SiftUp (TAccessPoint *heap, unsigned int pos)
+{
+    TAccessPoint tmp;
+
+
+    while(pos > 0)
+    {
+        unsigned int parent = (pos - 1) / 2;
+
+        if(IsStronger(heap[parent], heap[pos]) == false)
+        {
+            break;
+        }
+
+        memcpy(&tmp, &heap[parent], sizeof(tmp));
+        memcpy(&heap[parent], &heap[pos], sizeof(tmp));
+        memcpy(&heap[pos], &tmp, sizeof(tmp));
+
+        pos = parent;
+    }
+}
+
+
+/*!
+ *  @brief  SiftDown
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Moves an element down the heap (weakest on top) until its children are
+ *      stronger.
+ *
+ *  @param[in,out]  heap    - Heap
+ *  @param[in]      size    - Number of elements in the heap
+ *  @param[in]      pos     - Position of the element
+ */
+void RS9110_ScanTable::SiftDown (TAccessPoint *heap, unsigned int size, unsigned int pos)
+{
+    TAccessPoint tmp;
+
+
+    for(;;)
+    {
+        unsigned int weakest = pos;
+        unsigned int left    = (2 * pos) + 1;
+        unsigned int right   = left + 1;
+
+        if((left < size) && (IsStronger(heap[weakest], heap[left]) == true))
+        {
+            weakest = left;
+        }
+
+        if((right < size) && (IsStronger(heap[weakest], heap[right]) == true))
+        {
+            weakest = right;
+        }
+
+        if(weakest == pos)
+        {
+            break;
+        }
+
+        memcpy(&tmp, &heap[pos], sizeof(tmp));
+        memcpy(&heap[pos], &heap[weakest], sizeof(tmp));
+        memcpy(&heap[weakest], &tmp, sizeof(tmp));
+
+        pos = weakest;
+    }
+}
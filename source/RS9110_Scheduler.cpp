@@ -0,0 +1,398 @@
+#include "RS9110_Scheduler.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckSchedulerJobs     [((RS9110_MAX_SCHEDULER_JOBS > 0) && (RS9110_MAX_SCHEDULER_JOBS <= 255)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver used to issue the commands
+ *
+ */
+RS9110_Scheduler::RS9110_Scheduler (RS9110_UART &rs)
+  : _rs(rs),
+    _maxBypass(DEFAULT_MAX_BYPASS),
+    _numBypassed(0),
+    _numPending(0),
+    _numExpected(0),
+    _isExpected(false),
+    _isAutoSleepAck(false)
+{
+    memset(_queues, 0, sizeof(_queues));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Scheduler::~RS9110_Scheduler ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetMaxBypass
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets how many commands of the other classes may be issued while bulk
+ *      data is waiting before a bulk command goes first.
+ *
+ *  @param[in]  maxBypass   - Commands (1 alternates control and bulk)
+ */
+void RS9110_Scheduler::SetMaxBypass (unsigned char maxBypass)
+{
+    _maxBypass = ((maxBypass > 0) ? maxBypass : 1);
+}
+
+
+/*!
+ *  @brief  SetAutoSleepAck
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      When enabled, every SLEEP from the module queues its KeepSleeping ACK in
+ *      the power class, ahead of everything else queued.
+ *
+ *  @param[in]  isEnabled   - Enable/disable
+ */
+void RS9110_Scheduler::SetAutoSleepAck (bool isEnabled)
+{
+    _isAutoSleepAck = isEnabled;
+}
+
+
+/*!
+ *  @brief  Post
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Queues a command and issues it at once if the driver is not waiting for
+ *      the answer of another one.
+ *
+ *  @param[in]  eClass  - Priority class
+ *  @param[in]  issue   - Writes one command thru the driver
+ *  @param[in]  context - Given back to issue (kept until it is called)
+ *
+ *  @return bool
+ *  @retval true    - Queued
+ *  @retval false   - Wrong argument or queue of the class full
+ */
+bool RS9110_Scheduler::Post (EClass eClass, TIssue issue, void *context)
+{
+    TQueue *queue;
+    TJob   *job;
+
+
+    if((eClass >= CLASS_MAX) || (issue == NULL))
+    {
+        return false;
+    }
+
+    queue = &_queues[eClass];
+
+    if(queue->count >= MAX_JOBS)
+    {
+        return false;
+    }
+
+    job             = &queue->jobs[(queue->head + queue->count) % MAX_JOBS];
+    job->issue      = issue;
+    job->context    = context;
+    queue->count++;
+
+    Dispatch();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees the line on the OK/ERROR of the command issued (the last one of
+ *      the commands issued together, see #Expect) and issues the next one.
+ *      Must be called after every #RS9110_UART::ProcessMessage.
+ *
+ *  @return bool
+ *  @retval true    - Message consumed
+ *  @retval false   - Not related to the scheduler
+ */
+bool RS9110_Scheduler::ProcessResponse ()
+{
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_SLEEP:
+            if(_isAutoSleepAck == false)
+            {
+                return false;
+            }
+
+            if(Post(CLASS_POWER, IssueSleepAck) == true)
+            {
+                _stats.numSleepAcks++;
+            }
+        break;
+
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if(_numPending == 0)
+            {
+                return false;
+            }
+
+            if(--_numPending == 0)
+            {
+                Dispatch();
+            }
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Abort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops all the queued commands and stops waiting for an answer (i.e.
+ *      after a reset or a timeout).
+ */
+void RS9110_Scheduler::Abort ()
+{
+    for(unsigned char i = 0; i < CLASS_MAX; i++)
+    {
+        _queues[i].head     = 0;
+        _queues[i].count    = 0;
+    }
+
+    _numBypassed    = 0;
+    _numPending     = 0;
+}
+
+
+/*!
+ *  @brief  Expect
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Called by an issue function writing several commands without waiting
+ *      (i.e. #RS9110_SendWindow): the next command is issued once all of
+ *      them are answered. 0 reports that nothing was written.
+ *
+ *  @param[in]  numAnswers  - OK/ERROR expected for the commands written
+ */
+void RS9110_Scheduler::Expect (unsigned char numAnswers)
+{
+    _numExpected    = numAnswers;
+    _isExpected     = true;
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether no command is waiting for its answer.
+ *
+ *  @return bool
+ */
+bool RS9110_Scheduler::IsIdle ()
+{
+    return (_numPending == 0);
+}
+
+
+/*!
+ *  @brief  GetNumQueued
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of commands of a class not issued yet.
+ *
+ *  @param[in]  eClass  - Priority class
+ *
+ *  @return unsigned char (0 if wrong class)
+ */
+unsigned char RS9110_Scheduler::GetNumQueued (EClass eClass)
+{
+    return ((eClass < CLASS_MAX) ? _queues[eClass].count : 0);
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_Scheduler::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  Dispatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issues queued commands until one of them has to be answered. Commands
+ *      not written are dropped.
+ */
+void RS9110_Scheduler::Dispatch ()
+{
+    int     eClass;
+    TQueue *queue;
+    TJob    job;
+    bool    isWritten;
+
+
+    while((_numPending == 0) && ((eClass = NextClass()) >= 0))
+    {
+        queue = &_queues[eClass];
+
+        if(eClass == CLASS_BULK)
+        {
+            if(_queues[CLASS_CONTROL].count > 0)
+            {
+                _stats.numPromoted++;
+            }
+
+            _numBypassed = 0;
+        }
+        else if(_queues[CLASS_BULK].count > 0)
+        {
+            _numBypassed++;
+        }
+
+        memcpy(&job, &queue->jobs[queue->head], sizeof(job));
+        queue->head = (unsigned char) ((queue->head + 1) % MAX_JOBS);
+        queue->count--;
+
+        /* Commands posted from the issue function wait for this one */
+        _numPending = 1;
+        _isExpected = false;
+
+        isWritten = ((job.issue(job.context, _rs) == true) && (_rs.GetLastCommand() != RS9110_UART::CMD_MAX));
+
+        if(_isExpected == true)
+        {
+            /* Several commands written, told by the issue function */
+            isWritten   = (_numExpected > 0);
+            _numPending = _numExpected;
+        }
+        else if(isWritten == true)
+        {
+            /* The ACK of a SLEEP is not answered */
+            _numPending = ((_rs.GetLastCommand() != RS9110_UART::CMD_KEEP_SLEEPING) ? 1 : 0);
+        }
+        else
+        {
+            _numPending = 0;
+        }
+
+        if(isWritten == true)
+        {
+            _stats.numIssued[eClass]++;
+        }
+        else
+        {
+            _stats.numNotSent++;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  NextClass
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Picks the class of the next command: the highest one with commands
+ *      queued, unless bulk data has been bypassed too many times.
+ *
+ *  @return int (#EClass, -1 if nothing queued)
+ */
+int RS9110_Scheduler::NextClass ()
+{
+    if(_queues[CLASS_POWER].count > 0)
+    {
+        return CLASS_POWER;
+    }
+
+    if((_queues[CLASS_BULK].count > 0) &&
+       ((_queues[CLASS_CONTROL].count == 0) || (_numBypassed >= _maxBypass)))
+    {
+        return CLASS_BULK;
+    }
+
+    if(_queues[CLASS_CONTROL].count > 0)
+    {
+        return CLASS_CONTROL;
+    }
+
+    return -1;
+}
+
+
+/*!
+ *  @brief  IssueSleepAck
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function of the ACK queued by #SetAutoSleepAck.
+ *
+ *  @param[in]  context - Not used
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_Scheduler::IssueSleepAck (void *context, RS9110_UART &rs)
+{
+    (void) context;
+
+    return rs.KeepSleeping();
+}
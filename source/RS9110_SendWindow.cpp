@@ -0,0 +1,603 @@
+#include "RS9110_SendWindow.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckSendWindow        [((RS9110_MAX_SEND_WINDOW > 0) && (RS9110_MAX_SEND_WINDOW <= RS9110_MAX_SEND_QUEUE)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs          - Driver used to send
+ *  @param[in]  completion  - Called when a send is acknowledged or dropped (may be NULL)
+ *  @param[in]  context     - Given back to the completion
+ *
+ */
+RS9110_SendWindow::RS9110_SendWindow (RS9110_UART &rs, TCompletion completion, void *context)
+  : _rs(rs),
+    _scheduler(NULL),
+    _completion(completion),
+    _context(context),
+    _fifoHead(0),
+    _fifoCount(0),
+    _numQueued(0),
+    _maxWindow(MAX_WINDOW),
+    _nextSeq(0),
+    _isPosted(false)
+{
+    memset(_entries, 0, sizeof(_entries));
+    memset(_windows, 0, sizeof(_windows));
+    memset(&_stats, 0, sizeof(_stats));
+
+    SetMaxWindow(MAX_WINDOW);
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_SendWindow::~RS9110_SendWindow ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetMaxWindow
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the largest number of sends in flight per socket (1 is
+ *      stop-and-wait) and starts every socket with it.
+ *
+ *  @param[in]  maxWindow   - Sends in flight per socket (1 to #MAX_WINDOW)
+ */
+void RS9110_SendWindow::SetMaxWindow (unsigned char maxWindow)
+{
+    if(maxWindow == 0)
+    {
+        maxWindow = 1;
+    }
+    else if(maxWindow > MAX_WINDOW)
+    {
+        maxWindow = MAX_WINDOW;
+    }
+
+    _maxWindow = maxWindow;
+
+    for(unsigned char i = 0; i < RS9110_UART::MAX_SOCKET_HANDLE; i++)
+    {
+        _windows[i].window = (unsigned short) (maxWindow * WINDOW_ONE);
+    }
+}
+
+
+/*!
+ *  @brief  SetScheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the sends thru the bulk class of a scheduler: the sends the
+ *      windows allow are written together when it gives the line, so queued
+ *      control and power commands go between two bursts. NULL (the default)
+ *      writes them at once. To be set while #IsIdle.
+ *
+ *  @param[in]  scheduler   - Scheduler of the driver (NULL if none)
+ */
+void RS9110_SendWindow::SetScheduler (RS9110_Scheduler *scheduler)
+{
+    _scheduler = scheduler;
+    _isPosted  = false;
+
+    Pump();
+}
+
+
+/*!
+ *  @brief  Submit
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Queues a send and writes it at once if the window of the socket allows.
+ *
+ *  @param[in]  socketId    - Socket handle of an already open socket
+ *  @param[in]  socketType  - SOCKET_TCP or SOCKET_UDP
+ *  @param[in]  hostIpAddr  - Destination IP Address (UDP only, kept until completion)
+ *  @param[in]  hostPort    - Destination Port (UDP only)
+ *  @param[in]  data        - Byte stream (kept until completion)
+ *  @param[in]  dataSize    - Length of the byte stream
+ *
+ *  @return bool
+ *  @retval true    - Queued
+ *  @retval false   - Wrong argument or queue full
+ */
+bool RS9110_SendWindow::Submit (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort, const char *data, unsigned int dataSize)
+{
+    TEntry *entry = NULL;
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       ((socketType != RS9110_UART::SOCKET_TCP) && (socketType != RS9110_UART::SOCKET_UDP)) ||
+       (data == NULL) || (dataSize == 0))
+    {
+        return false;
+    }
+
+    for(unsigned char i = 0; (i < MAX_QUEUE) && (entry == NULL); i++)
+    {
+        if(_entries[i].state == ENTRY_FREE)
+        {
+            entry = &_entries[i];
+        }
+    }
+
+    if(entry == NULL)
+    {
+        return false;
+    }
+
+    entry->data         = data;
+    entry->host         = hostIpAddr;
+    entry->size         = dataSize;
+    entry->offset       = 0;
+    entry->chunk        = 0;
+    entry->seq          = _nextSeq++;
+    entry->hostPort     = hostPort;
+    entry->socketId     = socketId;
+    entry->socketType   = (unsigned char) socketType;
+    entry->state        = ENTRY_QUEUED;
+
+    _numQueued++;
+
+    Pump();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Matches an OK/ERROR with the oldest send in flight, adapts the window of
+ *      its socket and writes the sends the windows allow. Must be called after
+ *      every #RS9110_UART::ProcessMessage.
+ *
+ *  @return bool
+ *  @retval true    - Answer consumed
+ *  @retval false   - Not related to the sends
+ */
+bool RS9110_SendWindow::ProcessResponse ()
+{
+    unsigned char   index;
+    TEntry         *entry;
+    TWindow        *window;
+
+
+    if((_fifoCount == 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+    {
+        return false;
+    }
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            /* Nothing to do */
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    index       = _fifo[_fifoHead];
+    entry       = &_entries[index];
+    window      = &_windows[entry->socketId - RS9110_UART::MIN_SOCKET_HANDLE];
+    _fifoHead   = (unsigned char) ((_fifoHead + 1) % MAX_QUEUE);
+    _fifoCount--;
+    window->inFlight--;
+
+    if(_rs.GetResponseType() == RS9110_UART::RESP_TYPE_OK)
+    {
+        _stats.numAcked++;
+
+        /* Additive increase: one send per window of OKs */
+        if((window->isRecovering == false) && (window->window < (_maxWindow * WINDOW_ONE)))
+        {
+            window->window += (unsigned short) ((WINDOW_ONE * WINDOW_ONE) / window->window);
+
+            if(window->window > (_maxWindow * WINDOW_ONE))
+            {
+                window->window = (unsigned short) (_maxWindow * WINDOW_ONE);
+            }
+        }
+
+        entry->offset += entry->chunk;
+        entry->chunk   = 0;
+
+        if(entry->offset >= entry->size)
+        {
+            Complete(index, true, RS9110_UART::ERROR_NONE);
+        }
+        else
+        {
+            entry->state = ENTRY_QUEUED;
+        }
+    }
+    else if(_rs.GetErrorCode() == RS9110_UART::ERROR_SEND_DATA_TOO_FAST)
+    {
+        _stats.numThrottled++;
+
+        /* Multiplicative decrease, once per episode */
+        if(window->isRecovering == false)
+        {
+            window->window       = (unsigned short) (window->window / 2);
+            window->isRecovering = true;
+
+            if(window->window < WINDOW_ONE)
+            {
+                window->window = WINDOW_ONE;
+            }
+        }
+
+        /* Written again from the same offset */
+        entry->chunk = 0;
+        entry->state = ENTRY_QUEUED;
+    }
+    else
+    {
+        Complete(index, false, _rs.GetErrorCode());
+    }
+
+    if(window->inFlight == 0)
+    {
+        window->isRecovering = false;
+    }
+
+    Pump();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Abort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops all the sends (i.e. after a reset or a link loss), notifying every
+ *      one of them as not sent. The windows are kept. The scheduler, if any,
+ *      must be aborted too.
+ */
+void RS9110_SendWindow::Abort ()
+{
+    for(unsigned char i = 0; i < MAX_QUEUE; i++)
+    {
+        if((_entries[i].state == ENTRY_QUEUED) || (_entries[i].state == ENTRY_IN_FLIGHT))
+        {
+            Complete(i, false, RS9110_UART::ERROR_NONE);
+        }
+    }
+
+    for(unsigned char i = 0; i < RS9110_UART::MAX_SOCKET_HANDLE; i++)
+    {
+        _windows[i].inFlight        = 0;
+        _windows[i].isRecovering    = false;
+    }
+
+    _fifoHead   = 0;
+    _fifoCount  = 0;
+    _isPosted   = false;
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether there is no send in flight, so another command may be issued.
+ *
+ *  @return bool
+ */
+bool RS9110_SendWindow::IsIdle ()
+{
+    return (_fifoCount == 0);
+}
+
+
+/*!
+ *  @brief  GetNumQueued
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of sends not completed yet (in flight included).
+ *
+ *  @return unsigned char
+ */
+unsigned char RS9110_SendWindow::GetNumQueued ()
+{
+    return _numQueued;
+}
+
+
+/*!
+ *  @brief  GetWindow
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of sends allowed in flight on a socket.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return unsigned char (0 if wrong socket)
+ */
+unsigned char RS9110_SendWindow::GetWindow (unsigned char socketId)
+{
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return 0;
+    }
+
+    return (unsigned char) (_windows[socketId - RS9110_UART::MIN_SOCKET_HANDLE].window / WINDOW_ONE);
+}
+
+
+/*!
+ *  @brief  GetInFlight
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of sends of a socket waiting for their OK/ERROR.
+ *
+ *  @param[in]  socketId    - Socket handle
+ *
+ *  @return unsigned char (0 if wrong socket)
+ */
+unsigned char RS9110_SendWindow::GetInFlight (unsigned char socketId)
+{
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        return 0;
+    }
+
+    return _windows[socketId - RS9110_UART::MIN_SOCKET_HANDLE].inFlight;
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_SendWindow::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  Pump
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes queued sends, oldest first, while the windows allow. With a
+ *      scheduler they are only posted, #IssueBulk writes them.
+ */
+void RS9110_SendWindow::Pump ()
+{
+    int index;
+
+
+    if(_scheduler != NULL)
+    {
+        if((_isPosted == false) && (NextEntry() >= 0))
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueBulk, this) == false)
+            {
+                _isPosted = false;
+            }
+        }
+
+        return;
+    }
+
+    while((index = NextEntry()) >= 0)
+    {
+        SendEntry((unsigned char) index);
+    }
+}
+
+
+/*!
+ *  @brief  NextEntry
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Looks for the oldest queued send whose socket has room in its window.
+ *      A TCP socket has at most one send in flight: a send rejected with
+ *      ERROR_SEND_DATA_TOO_FAST would otherwise be overtaken by the next one.
+ *
+ *  @return Index of the entry (-1 if none)
+ */
+int RS9110_SendWindow::NextEntry ()
+{
+    TWindow *window;
+    int      index = -1;
+
+
+    for(unsigned char i = 0; i < MAX_QUEUE; i++)
+    {
+        if(_entries[i].state != ENTRY_QUEUED)
+        {
+            continue;
+        }
+
+        window = &_windows[_entries[i].socketId - RS9110_UART::MIN_SOCKET_HANDLE];
+
+        if((window->isRecovering == false) &&
+           ((window->inFlight * WINDOW_ONE) < (window->window & ~(WINDOW_ONE - 1))) &&
+           ((_entries[i].socketType != RS9110_UART::SOCKET_TCP) || (window->inFlight == 0)) &&
+           ((index < 0) || ((long) (_entries[i].seq - _entries[index].seq) < 0)))
+        {
+            index = i;
+        }
+    }
+
+    return index;
+}
+
+
+/*!
+ *  @brief  SendEntry
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command of a send. A send that cannot be written is dropped.
+ *
+ *  @param[in]  index   - Entry
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Send dropped
+ */
+bool RS9110_SendWindow::SendEntry (unsigned char index)
+{
+    TEntry         *entry = &_entries[index];
+    unsigned int    sent;
+
+
+    sent = _rs.Send(entry->socketId, (RS9110_UART::ESocketType) entry->socketType, entry->host, entry->hostPort,
+                    &entry->data[entry->offset], (entry->size - entry->offset));
+
+    if((sent == 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+    {
+        Complete(index, false, RS9110_UART::ERROR_NONE);
+        return false;
+    }
+
+    entry->chunk = sent;
+    entry->state = ENTRY_IN_FLIGHT;
+
+    _fifo[(_fifoHead + _fifoCount) % MAX_QUEUE] = index;
+    _fifoCount++;
+    _windows[entry->socketId - RS9110_UART::MIN_SOCKET_HANDLE].inFlight++;
+    _stats.numCommands++;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Complete
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Notifies the completion of an entry, then frees it. The entry is
+ *      neither written, aborted nor reused by a send submitted from the
+ *      completion.
+ *
+ *  @param[in]  index       - Entry
+ *  @param[in]  isSent      - Fully acknowledged
+ *  @param[in]  eErrorCode  - Error code of the ERROR that dropped it (if any)
+ */
+void RS9110_SendWindow::Complete (unsigned char index, bool isSent, RS9110_UART::EErrorCode eErrorCode)
+{
+    TEntry *entry = &_entries[index];
+
+
+    entry->state = ENTRY_COMPLETING;
+
+    if(isSent == true)
+    {
+        _stats.numCompleted++;
+    }
+    else
+    {
+        _stats.numFailed++;
+    }
+
+    if(_completion != NULL)
+    {
+        _completion(_context, entry->socketId, entry->data, entry->size, isSent, eErrorCode);
+    }
+
+    entry->state = ENTRY_FREE;
+    _numQueued--;
+}
+
+
+/*!
+ *  @brief  IssueBulk
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #Pump: writes the sends the windows allow and
+ *      tells the scheduler how many answers to wait for.
+ *
+ *  @param[in]  context - Send window
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_SendWindow::IssueBulk (void *context, RS9110_UART &rs)
+{
+    RS9110_SendWindow  *window      = (RS9110_SendWindow *) context;
+    unsigned char       numWritten  = 0;
+    int                 index;
+
+
+    (void) rs;
+
+    window->_isPosted = false;
+
+    while((index = window->NextEntry()) >= 0)
+    {
+        if(window->SendEntry((unsigned char) index) == true)
+        {
+            numWritten++;
+        }
+    }
+
+    window->_scheduler->Expect(numWritten);
+
+    return (numWritten > 0);
+}
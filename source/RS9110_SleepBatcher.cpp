@@ -0,0 +1,610 @@
+#include "RS9110_SleepBatcher.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckSleepBatch        [((RS9110_MAX_SLEEP_BATCH > 0) && (RS9110_MAX_SLEEP_BATCH <= 255)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs          - Driver used to send
+ *  @param[in]  completion  - Called when a send is acknowledged or dropped (may be NULL)
+ *  @param[in]  context     - Given back to the completion
+ *
+ */
+RS9110_SleepBatcher::RS9110_SleepBatcher (RS9110_UART &rs, TCompletion completion, void *context)
+  : _rs(rs),
+    _scheduler(NULL),
+    _completion(completion),
+    _context(context),
+    _head(0),
+    _count(0),
+    _batch(0),
+    _chunk(0),
+    _isPowerSave(false),
+    _isBusy(false),
+    _isPosted(false),
+    _eState(STATE_AWAKE)
+{
+    memset(_entries, 0, sizeof(_entries));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_SleepBatcher::~RS9110_SleepBatcher ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  SetScheduler
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Routes the commands thru a scheduler: the sends in its bulk class, the
+ *      ACK of a wake window in its power class (its own automatic ACK must
+ *      then be off). NULL (the default) writes them at once. To be set while
+ *      #IsIdle.
+ *
+ *  @param[in]  scheduler   - Scheduler of the driver (NULL if none)
+ */
+void RS9110_SleepBatcher::SetScheduler (RS9110_Scheduler *scheduler)
+{
+    _scheduler = scheduler;
+    _isPosted  = false;
+
+    Dispatch();
+}
+
+
+/*!
+ *  @brief  SetPowerSave
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Tells whether the module is in power mode 1 or 2 (to be called once
+ *      #RS9110_UART::PowerMode is answered OK). Turning it off writes the sends
+ *      held.
+ *
+ *  @param[in]  isEnabled   - Power save on/off
+ */
+void RS9110_SleepBatcher::SetPowerSave (bool isEnabled)
+{
+    _isPowerSave = isEnabled;
+
+    if(isEnabled == false)
+    {
+        _eState = STATE_AWAKE;
+        Dispatch();
+    }
+}
+
+
+/*!
+ *  @brief  Submit
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Queues a send. It is written at once unless the module sleeps; then it
+ *      is held until the next wake window or until its latency bound. If
+ *      there is no room left the module is woken up to make some.
+ *
+ *  @param[in]  socketId        - Socket handle of an already open socket
+ *  @param[in]  socketType      - SOCKET_TCP or SOCKET_UDP
+ *  @param[in]  hostIpAddr      - Destination IP Address (UDP only, kept until completion)
+ *  @param[in]  hostPort        - Destination Port (UDP only)
+ *  @param[in]  data            - Byte stream (kept until completion)
+ *  @param[in]  dataSize        - Length of the byte stream
+ *  @param[in]  maxLatencyMs    - Longest time it may be held (0 wakes the module)
+ *  @param[in]  nowMs           - Current time (ms)
+ *
+ *  @return bool
+ *  @retval true    - Queued
+ *  @retval false   - Wrong argument or queue full
+ */
+bool RS9110_SleepBatcher::Submit (unsigned char socketId, RS9110_UART::ESocketType socketType, const char *hostIpAddr, unsigned short hostPort,
+                                  const char *data, unsigned int dataSize, unsigned long maxLatencyMs, unsigned long nowMs)
+{
+    TEntry *entry;
+
+
+    if((socketId < RS9110_UART::MIN_SOCKET_HANDLE) || (socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       ((socketType != RS9110_UART::SOCKET_TCP) && (socketType != RS9110_UART::SOCKET_UDP)) ||
+       (data == NULL) || (dataSize == 0))
+    {
+        return false;
+    }
+
+    if(_count >= MAX_HELD)
+    {
+        Wake();
+        Dispatch();
+
+        return false;
+    }
+
+    entry               = &_entries[(_head + _count) % MAX_HELD];
+    entry->data         = data;
+    entry->host         = hostIpAddr;
+    entry->size         = dataSize;
+    entry->offset       = 0;
+    entry->deadlineMs   = nowMs + maxLatencyMs;
+    entry->hostPort     = hostPort;
+    entry->socketId     = socketId;
+    entry->socketType   = (unsigned char) socketType;
+    _count++;
+
+    if(maxLatencyMs == 0)
+    {
+        Wake();
+    }
+
+    Dispatch();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Opens a wake window on SLEEP and matches an OK/ERROR with the send in
+ *      flight, writing the next command (or the ACK once the batch is done).
+ *      Must be called after every #RS9110_UART::ProcessMessage.
+ *
+ *  @return bool
+ *  @retval true    - Message consumed
+ *  @retval false   - Not related to the batcher
+ */
+bool RS9110_SleepBatcher::ProcessResponse ()
+{
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_SLEEP:
+            if(_isPowerSave == false)
+            {
+                return false;
+            }
+
+            _stats.numWindows++;
+            _eState = STATE_WINDOW;
+            _batch  = 0;
+        break;
+
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if((_isBusy == false) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+            {
+                return false;
+            }
+
+            _isBusy = false;
+
+            if(_rs.GetResponseType() == RS9110_UART::RESP_TYPE_OK)
+            {
+                _entries[_head].offset += _chunk;
+
+                if(_entries[_head].offset >= _entries[_head].size)
+                {
+                    Complete(true, RS9110_UART::ERROR_NONE);
+                }
+            }
+            else if(_rs.GetErrorCode() != RS9110_UART::ERROR_SEND_DATA_TOO_FAST)
+            {
+                Complete(false, _rs.GetErrorCode());
+            }
+        break;
+
+        default:
+            return false;
+        break;
+    }
+
+    Dispatch();
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Wakes the module if a send held would miss its latency bound, or
+ *      writes again an ACK that could not be written. To be called
+ *      periodically.
+ *
+ *  @param[in]  nowMs   - Current time (ms)
+ */
+void RS9110_SleepBatcher::Poll (unsigned long nowMs)
+{
+    if(_eState == STATE_WINDOW)
+    {
+        Dispatch();
+        return;
+    }
+
+    if(_eState != STATE_ASLEEP)
+    {
+        return;
+    }
+
+    for(unsigned char i = 0; i < _count; i++)
+    {
+        if((long) (_entries[(_head + i) % MAX_HELD].deadlineMs - nowMs) <= 0)
+        {
+            Wake();
+            Dispatch();
+            return;
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Abort
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Drops all the sends (i.e. after a reset), notifying every one of them
+ *      as not sent. The scheduler, if any, must be aborted too.
+ */
+void RS9110_SleepBatcher::Abort ()
+{
+    while(_count > 0)
+    {
+        Complete(false, RS9110_UART::ERROR_NONE);
+    }
+
+    _isBusy     = false;
+    _isPosted   = false;
+    _eState     = STATE_AWAKE;
+}
+
+
+/*!
+ *  @brief  GetState
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the sleep state of the module as seen by the batcher.
+ *
+ *  @return EState
+ */
+RS9110_SleepBatcher::EState RS9110_SleepBatcher::GetState ()
+{
+    return _eState;
+}
+
+
+/*!
+ *  @brief  IsIdle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Checks whether no send is in flight, so another command may be issued.
+ *
+ *  @return bool
+ */
+bool RS9110_SleepBatcher::IsIdle ()
+{
+    return (_isBusy == false);
+}
+
+
+/*!
+ *  @brief  GetNumHeld
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of sends not completed yet.
+ *
+ *  @return unsigned char
+ */
+unsigned char RS9110_SleepBatcher::GetNumHeld ()
+{
+    return _count;
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the statistics.
+ *
+ *  @param[out] stats   - Copy of the statistics
+ */
+void RS9110_SleepBatcher::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  Dispatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command of the oldest send unless the module sleeps,
+ *      or the ACK when a wake window has nothing left to write. With a
+ *      scheduler the command is only posted, #IssueSend or #IssueAck
+ *      writes it.
+ */
+void RS9110_SleepBatcher::Dispatch ()
+{
+    if(_isBusy == true)
+    {
+        return;
+    }
+
+    if(_scheduler == NULL)
+    {
+        if(SendHead() == false)
+        {
+            SendAck();
+        }
+    }
+    else if(_isPosted == false)
+    {
+        if((_count > 0) && (_eState != STATE_ASLEEP))
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, this) == false)
+            {
+                _isPosted = false;
+            }
+        }
+        else if((_count == 0) && (_eState == STATE_WINDOW))
+        {
+            /* Set first: an idle scheduler runs the job within Post */
+            _isPosted = true;
+
+            if(_scheduler->Post(RS9110_Scheduler::CLASS_POWER, IssueAck, this) == false)
+            {
+                _isPosted = false;
+            }
+        }
+    }
+}
+
+
+/*!
+ *  @brief  SendHead
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next command of the oldest send unless the module sleeps.
+ *      Sends that cannot be written are dropped.
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Nothing to write
+ */
+bool RS9110_SleepBatcher::SendHead ()
+{
+    TEntry *entry;
+
+
+    while((_count > 0) && (_eState != STATE_ASLEEP))
+    {
+        entry   = &_entries[_head];
+        _chunk  = _rs.Send(entry->socketId, (RS9110_UART::ESocketType) entry->socketType, entry->host, entry->hostPort,
+                           &entry->data[entry->offset], (entry->size - entry->offset));
+
+        if((_chunk == 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+        {
+            Complete(false, RS9110_UART::ERROR_NONE);
+        }
+        else
+        {
+            _isBusy = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+ *  @brief  SendAck
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sends the module back to sleep when its wake window has nothing left
+ *      to write.
+ *
+ *  @return bool
+ *  @retval true    - ACK written
+ *  @retval false   - Not due or not written
+ */
+bool RS9110_SleepBatcher::SendAck ()
+{
+    if((_count > 0) || (_eState != STATE_WINDOW))
+    {
+        return false;
+    }
+
+    /* Still awake until the ACK is written */
+    if(_rs.KeepSleeping() == false)
+    {
+        return false;
+    }
+
+    _eState = STATE_ASLEEP;
+    _stats.numAcks++;
+
+    return true;
+}
+
+
+/*!
+ *  @brief  Wake
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Lets the sends held be written while the module sleeps: the first
+ *      command wakes it up. It is sent back to sleep at its next SLEEP.
+ */
+void RS9110_SleepBatcher::Wake ()
+{
+    if(_eState == STATE_ASLEEP)
+    {
+        _stats.numWakes++;
+        _eState = STATE_AWAKE;
+        _batch  = 0;
+    }
+}
+
+
+/*!
+ *  @brief  Complete
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Frees the oldest send and notifies its completion.
+ *
+ *  @param[in]  isSent      - Fully acknowledged
+ *  @param[in]  eErrorCode  - Error code of the ERROR that dropped it (if any)
+ */
+void RS9110_SleepBatcher::Complete (bool isSent, RS9110_UART::EErrorCode eErrorCode)
+{
+    TEntry entry;
+
+
+    memcpy(&entry, &_entries[_head], sizeof(entry));
+    _head = (unsigned char) ((_head + 1) % MAX_HELD);
+    _count--;
+
+    if(isSent == true)
+    {
+        _stats.numCompleted++;
+
+        if(++_batch > _stats.maxBatch)
+        {
+            _stats.maxBatch = _batch;
+        }
+    }
+    else
+    {
+        _stats.numFailed++;
+    }
+
+    if(_completion != NULL)
+    {
+        _completion(_context, entry.socketId, entry.data, entry.size, isSent, eErrorCode);
+    }
+}
+
+
+/*!
+ *  @brief  IssueSend
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #Dispatch in the bulk class: writes the next
+ *      command of the oldest send, or posts the ACK if none is left.
+ *
+ *  @param[in]  context - Sleep batcher
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_SleepBatcher::IssueSend (void *context, RS9110_UART &rs)
+{
+    RS9110_SleepBatcher *batcher = (RS9110_SleepBatcher *) context;
+
+
+    (void) rs;
+
+    batcher->_isPosted = false;
+
+    if(batcher->SendHead() == true)
+    {
+        return true;
+    }
+
+    batcher->Dispatch();
+
+    return false;
+}
+
+
+/*!
+ *  @brief  IssueAck
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Issue function posted by #Dispatch in the power class: writes the ACK
+ *      of the wake window, or posts the sends submitted meanwhile.
+ *
+ *  @param[in]  context - Sleep batcher
+ *  @param[in]  rs      - Driver
+ *
+ *  @return bool
+ */
+bool RS9110_SleepBatcher::IssueAck (void *context, RS9110_UART &rs)
+{
+    RS9110_SleepBatcher *batcher = (RS9110_SleepBatcher *) context;
+
+
+    (void) rs;
+
+    batcher->_isPosted = false;
+
+    if(batcher->SendAck() == true)
+    {
+        return true;
+    }
+
+    /* An ACK not written waits for #Poll rather than being posted again */
+    if(batcher->_count > 0)
+    {
+        batcher->Dispatch();
+    }
+
+    return false;
+}
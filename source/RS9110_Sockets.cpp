@@ -0,0 +1,1169 @@
+#include "RS9110_Sockets.h"
+
+#include <string.h>
+
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckSocketDescriptors [((RS9110_MAX_SOCKET_DESCRIPTORS > 0) && (RS9110_MAX_SOCKET_DESCRIPTORS <= 127)) ? 1 : -1];
+typedef char CheckSocketRxBuffer    [((RS9110_MAX_SOCKET_RX_BUFFER >= 64) && (RS9110_MAX_SOCKET_RX_BUFFER <= 0xFFFE)) ? 1 : -1];
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  rs  - Driver of the module
+ *
+ */
+RS9110_Sockets::RS9110_Sockets (RS9110_UART &rs)
+  : _rs(rs),
+    _command(RS9110_UART::CMD_MAX),
+    _fd(0),
+    _chunk(0),
+    _next(0),
+    _nextPort(MIN_EPHEMERAL_PORT)
+{
+    for(unsigned char i = 0; i < MAX_DESCRIPTORS; i++)
+    {
+        _descriptors[i].state       = STATE_FREE;
+        _descriptors[i].isQueued    = false;
+        _descriptors[i].handle      = 0;
+    }
+
+    memset(_owners, -1, sizeof(_owners));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Sockets::~RS9110_Sockets ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Socket
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Creates a descriptor. Nothing is sent to the module until #Connect or
+ *      #Listen.
+ *
+ *  @param[in]  eType   - STREAM (TCP) or DGRAM (UDP)
+ *
+ *  @return int
+ *  @retval >=0 - Descriptor
+ *  @retval <0  - #EResult
+ */
+int RS9110_Sockets::Socket (EType eType)
+{
+    if((eType != TYPE_STREAM) && (eType != TYPE_DGRAM))
+    {
+        return RESULT_INVALID;
+    }
+
+    for(unsigned char i = 0; i < MAX_DESCRIPTORS; i++)
+    {
+        TDescriptor &descriptor = _descriptors[i];
+
+
+        if(descriptor.state != STATE_FREE)
+        {
+            continue;
+        }
+
+        descriptor.state        = STATE_CREATED;
+        descriptor.type         = (unsigned char) eType;
+        descriptor.isListening  = false;
+        descriptor.isQueued     = false;
+        descriptor.handle       = 0;
+        descriptor.localPort    = 0;
+        descriptor.remotePort   = 0;
+        descriptor.host[0]      = '\0';
+        descriptor.error        = RESULT_OK;
+        descriptor.isReset      = false;
+        descriptor.errorCode    = RS9110_UART::ERROR_NONE;
+        descriptor.rxOffset     = 0;
+        descriptor.rxRing.Attach(descriptor.rxMemory, RS9110_Ring::GetFootprint(RX_BUFFER_SIZE), true);
+
+        return i;
+    }
+
+    return RESULT_NO_DESCRIPTORS;
+}
+
+
+/*!
+ *  @brief  Bind
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Sets the local port used when the descriptor is opened.
+ *
+ *  @param[in]  fd          - Descriptor
+ *  @param[in]  localPort   - Local port on the module
+ *
+ *  @return int (#EResult)
+ */
+int RS9110_Sockets::Bind (int fd, unsigned short localPort)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    if(descriptor->state != STATE_CREATED)
+    {
+        return RESULT_INVALID;
+    }
+
+    descriptor->localPort = localPort;
+
+    return RESULT_OK;
+}
+
+
+/*!
+ *  @brief  Connect
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Opens a TCP connection (STREAM) or a UDP socket with a fixed peer
+ *      (DGRAM). The first call returns RESULT_IN_PROGRESS; later calls
+ *      return it until the module answers, then RESULT_OK or the error.
+ *      A local port is picked if none was bound.
+ *
+ *  @param[in]  fd      - Descriptor
+ *  @param[in]  host    - Address of the peer ("a.b.c.d")
+ *  @param[in]  port    - Port of the peer
+ *
+ *  @return int (#EResult)
+ */
+int RS9110_Sockets::Connect (int fd, const char *host, unsigned short port)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    switch(descriptor->state)
+    {
+        case STATE_CREATED:
+            if((host == NULL) || (strlen(host) > MAX_ADDRESS_LEN))
+            {
+                return RESULT_INVALID;
+            }
+
+            if(descriptor->localPort == 0)
+            {
+                descriptor->localPort = _nextPort;
+                _nextPort = (unsigned short) ((_nextPort < MAX_EPHEMERAL_PORT) ? (_nextPort + 1) : MIN_EPHEMERAL_PORT);
+            }
+
+            strcpy(descriptor->host, host);
+            descriptor->remotePort  = port;
+            descriptor->state       = STATE_OPENING;
+            descriptor->isQueued    = true;
+
+            Dispatch();
+
+            return RESULT_IN_PROGRESS;
+
+        case STATE_OPENING:
+            return RESULT_IN_PROGRESS;
+
+        case STATE_OPEN:
+            return ((descriptor->isListening == false) ? RESULT_OK : RESULT_INVALID);
+
+        default:
+        {
+            /* Closed: the reason once, then reset */
+            int error = TakeError(*descriptor);
+
+
+            return ((error != RESULT_OK) ? error : RESULT_RESET);
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Listen
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Opens a listening TCP socket (STREAM) or a UDP socket taking any peer
+ *      (DGRAM) on the bound port. Answered as #Connect.
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return int (#EResult)
+ */
+int RS9110_Sockets::Listen (int fd)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    switch(descriptor->state)
+    {
+        case STATE_CREATED:
+            if(descriptor->localPort == 0)
+            {
+                return RESULT_INVALID;
+            }
+
+            descriptor->isListening = true;
+            descriptor->state       = STATE_OPENING;
+            descriptor->isQueued    = true;
+
+            Dispatch();
+
+            return RESULT_IN_PROGRESS;
+
+        case STATE_OPENING:
+            return RESULT_IN_PROGRESS;
+
+        case STATE_OPEN:
+            return ((descriptor->isListening == true) ? RESULT_OK : RESULT_INVALID);
+
+        default:
+        {
+            /* Closed: the reason once, then reset */
+            int error = TakeError(*descriptor);
+
+
+            return ((error != RESULT_OK) ? error : RESULT_RESET);
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Send
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes data to the peer of an open descriptor. STREAM descriptors may
+ *      take part of it (as much as one AT+RSI_SND carries), DGRAM descriptors
+ *      take the whole datagram or nothing.
+ *
+ *  @param[in]  fd      - Descriptor
+ *  @param[in]  data    - Data
+ *  @param[in]  size    - Size of the data (in bytes)
+ *
+ *  @return int
+ *  @retval >=0 - Bytes taken
+ *  @retval <0  - #EResult
+ */
+int RS9110_Sockets::Send (int fd, const char *data, unsigned int size)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    if((descriptor->type == TYPE_DGRAM) && (descriptor->isListening == true))
+    {
+        /* No peer: SendTo */
+        return RESULT_NOT_CONNECTED;
+    }
+
+    return Write(*descriptor, data, size, descriptor->host, descriptor->remotePort);
+}
+
+
+/*!
+ *  @brief  SendTo
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes a datagram to any peer from a listening DGRAM descriptor.
+ *
+ *  @param[in]  fd      - Descriptor
+ *  @param[in]  data    - Datagram
+ *  @param[in]  size    - Size of the datagram (in bytes)
+ *  @param[in]  host    - Address of the peer ("a.b.c.d")
+ *  @param[in]  port    - Port of the peer
+ *
+ *  @return int
+ *  @retval >=0 - Bytes taken
+ *  @retval <0  - #EResult
+ */
+int RS9110_Sockets::SendTo (int fd, const char *data, unsigned int size, const char *host, unsigned short port)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    if((descriptor->type != TYPE_DGRAM) || (host == NULL) || (strlen(host) > MAX_ADDRESS_LEN))
+    {
+        return RESULT_INVALID;
+    }
+
+    return Write(*descriptor, data, size, host, port);
+}
+
+
+/*!
+ *  @brief  Recv
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reads from the receive buffer of a descriptor: as many bytes as fit
+ *      (STREAM) or one datagram, truncated to the buffer (DGRAM).
+ *
+ *  @param[in]  fd      - Descriptor
+ *  @param[out] buffer  - Destination
+ *  @param[in]  size    - Size of the destination (in bytes)
+ *
+ *  @return int
+ *  @retval >0  - Bytes read
+ *  @retval 0   - End of stream (closed and nothing left)
+ *  @retval <0  - #EResult
+ */
+int RS9110_Sockets::Recv (int fd, char *buffer, unsigned int size)
+{
+    return RecvFrom(fd, buffer, size, NULL, NULL);
+}
+
+
+/*!
+ *  @brief  RecvFrom
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      As #Recv, also giving the source of DGRAM data.
+ *
+ *  @param[in]  fd      - Descriptor
+ *  @param[out] buffer  - Destination
+ *  @param[in]  size    - Size of the destination (in bytes)
+ *  @param[out] host    - Source address, MAX_ADDRESS_LEN + 1 bytes (DGRAM only, may be NULL)
+ *  @param[out] port    - Source port (DGRAM only, may be NULL)
+ *
+ *  @return int (as #Recv)
+ */
+int RS9110_Sockets::RecvFrom (int fd, char *buffer, unsigned int size, char *host, unsigned short *port)
+{
+    TDescriptor    *descriptor = Lookup(fd);
+    const char     *record;
+    unsigned short  length;
+    unsigned int    read = 0;
+    int             error;
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    if((buffer == NULL) && (size > 0))
+    {
+        return RESULT_INVALID;
+    }
+
+    if((descriptor->state == STATE_CREATED) || (descriptor->state == STATE_OPENING))
+    {
+        return RESULT_NOT_CONNECTED;
+    }
+
+    if(descriptor->type == TYPE_DGRAM)
+    {
+        TDatagramHeader header;
+
+
+        record = descriptor->rxRing.Peek(length);
+
+        if(record != NULL)
+        {
+            memcpy(&header, record, sizeof(header));
+            read = length - sizeof(header);
+            read = ((read < size) ? read : size);
+            memcpy(buffer, &record[sizeof(header)], read);
+            descriptor->rxRing.Release();
+
+            if(host != NULL)
+            {
+                RS9110_UART::Format(host, MAX_ADDRESS_LEN + 1, "%u.%u.%u.%u",
+                                    header.address[0], header.address[1], header.address[2], header.address[3]);
+            }
+
+            if(port != NULL)
+            {
+                *port = header.port;
+            }
+
+            return (int) read;
+        }
+    }
+    else
+    {
+        while((descriptor->isReset == false) && (read < size) && ((record = descriptor->rxRing.Peek(length)) != NULL))
+        {
+            unsigned int part = length - descriptor->rxOffset;
+
+
+            part = ((part < (size - read)) ? part : (size - read));
+            memcpy(&buffer[read], &record[descriptor->rxOffset], part);
+            read                    += part;
+            descriptor->rxOffset    += part;
+
+            if(descriptor->rxOffset == length)
+            {
+                descriptor->rxRing.Release();
+                descriptor->rxOffset = 0;
+            }
+        }
+
+        if(read > 0)
+        {
+            return (int) read;
+        }
+    }
+
+    error = TakeError(*descriptor);
+
+    if(error != RESULT_OK)
+    {
+        return error;
+    }
+
+    /* End of stream once the buffered data is read */
+    return ((descriptor->state == STATE_CLOSED) ? 0 : RESULT_WOULD_BLOCK);
+}
+
+
+/*!
+ *  @brief  Close
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Closes a descriptor. Its buffered data is dropped and the module
+ *      socket is closed in the background; the descriptor is given again by
+ *      #Socket once the module answers.
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return int (#EResult)
+ */
+int RS9110_Sockets::Close (int fd)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    if(descriptor == NULL)
+    {
+        return RESULT_BAD_DESCRIPTOR;
+    }
+
+    switch(descriptor->state)
+    {
+        case STATE_OPENING:
+            if(descriptor->isQueued == true)
+            {
+                Release(*descriptor, STATE_FREE);
+            }
+            else
+            {
+                /* Closed once the open in flight is answered */
+                descriptor->state = STATE_CLOSING;
+            }
+        break;
+
+        case STATE_OPEN:
+            descriptor->state       = STATE_CLOSING;
+            descriptor->isQueued    = true;
+        break;
+
+        default:
+            /* Created or closed */
+            Release(*descriptor, STATE_FREE);
+        break;
+    }
+
+    descriptor->rxRing.Detach();
+    Dispatch();
+
+    return RESULT_OK;
+}
+
+
+/*!
+ *  @brief  Poll
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Reports the descriptors ready, without waiting: the caller polls again
+ *      after feeding the next frame thru #ProcessResponse. Wrong descriptors
+ *      get POLL_ERR.
+ *
+ *  @param[in,out]  fds     - Descriptors and events wanted, events got
+ *  @param[in]      numFds  - Number of descriptors
+ *
+ *  @return int
+ *  @retval >=0 - Descriptors with events
+ *  @retval <0  - #EResult
+ */
+int RS9110_Sockets::Poll (TPollFd *fds, unsigned int numFds)
+{
+    int numReady = 0;
+
+
+    if((fds == NULL) && (numFds > 0))
+    {
+        return RESULT_INVALID;
+    }
+
+    Dispatch();
+
+    for(unsigned int i = 0; i < numFds; i++)
+    {
+        TDescriptor    *descriptor  = Lookup(fds[i].fd);
+        unsigned char   revents     = 0;
+
+
+        if(descriptor == NULL)
+        {
+            revents = POLL_ERR;
+        }
+        else
+        {
+            if((descriptor->rxRing.IsEmpty() == false) || (descriptor->state == STATE_CLOSED))
+            {
+                revents |= POLL_IN;
+            }
+
+            if((descriptor->state == STATE_OPEN) && (_command == RS9110_UART::CMD_MAX))
+            {
+                revents |= POLL_OUT;
+            }
+
+            if((descriptor->error != RESULT_OK) || (descriptor->isReset == true))
+            {
+                revents |= POLL_ERR;
+            }
+
+            if(descriptor->state == STATE_CLOSED)
+            {
+                revents |= POLL_HUP;
+            }
+
+            revents &= (unsigned char) (fds[i].events | POLL_ERR | POLL_HUP);
+        }
+
+        fds[i].revents = revents;
+
+        if(revents != 0)
+        {
+            numReady++;
+        }
+    }
+
+    return numReady;
+}
+
+
+/*!
+ *  @brief  ProcessResponse
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Handles the message just parsed by the driver: the OK/ERROR of the
+ *      command in flight, READ frames (to the receive buffer of their
+ *      descriptor) and CLOSE. Then writes the next open or close.
+ *
+ *  @return bool
+ *  @retval true    - Message handled
+ *  @retval false   - Not related to the sockets
+ */
+bool RS9110_Sockets::ProcessResponse ()
+{
+    bool bRtn = true;
+
+
+    switch(_rs.GetResponseType())
+    {
+        case RS9110_UART::RESP_TYPE_OK:
+        case RS9110_UART::RESP_TYPE_ERROR:
+            if((_command == RS9110_UART::CMD_MAX) || (_rs.GetLastCommand() != _command))
+            {
+                return false;
+            }
+
+            Answered(_rs.GetResponseType() == RS9110_UART::RESP_TYPE_OK);
+        break;
+
+        case RS9110_UART::RESP_TYPE_READ:
+            Received();
+        break;
+
+        case RS9110_UART::RESP_TYPE_CLOSE:
+            Closed();
+        break;
+
+        default:
+            bRtn = false;
+        break;
+    }
+
+    Dispatch();
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  GetHandle
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the module handle of a descriptor.
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return Handle (0 if not open)
+ */
+unsigned char RS9110_Sockets::GetHandle (int fd)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    return ((descriptor != NULL) ? descriptor->handle : 0);
+}
+
+
+/*!
+ *  @brief  GetErrorCode
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the error code of the last ERROR answer of a descriptor
+ *      (after RESULT_MODULE_ERROR).
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return RS9110_UART::EErrorCode
+ */
+RS9110_UART::EErrorCode RS9110_Sockets::GetErrorCode (int fd)
+{
+    TDescriptor *descriptor = Lookup(fd);
+
+
+    return ((descriptor != NULL) ? descriptor->errorCode : RS9110_UART::ERROR_NONE);
+}
+
+
+/*!
+ *  @brief  GetStats
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Takes a snapshot of the counters.
+ *
+ *  @param[out] stats   - Copy of the counters
+ */
+void RS9110_Sockets::GetStats (TStats &stats)
+{
+    memcpy(&stats, &_stats, sizeof(stats));
+}
+
+
+/*!
+ *  @brief  Lookup
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Finds a descriptor in use by the application.
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return TDescriptor* (NULL if free, closing or out of range)
+ */
+RS9110_Sockets::TDescriptor * RS9110_Sockets::Lookup (int fd)
+{
+    if((fd < 0) || (fd >= MAX_DESCRIPTORS) ||
+       (_descriptors[fd].state == STATE_FREE) || (_descriptors[fd].state == STATE_CLOSING))
+    {
+        return NULL;
+    }
+
+    return &_descriptors[fd];
+}
+
+
+/*!
+ *  @brief  TakeError
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the error pending on a descriptor and clears it. A closed
+ *      DGRAM descriptor, or a reset STREAM one, keeps returning RESULT_RESET
+ *      afterwards.
+ *
+ *  @param[in]  descriptor  - Descriptor
+ *
+ *  @return int (#EResult)
+ */
+int RS9110_Sockets::TakeError (TDescriptor &descriptor)
+{
+    int error = descriptor.error;
+
+
+    descriptor.error = RESULT_OK;
+
+    if((error == RESULT_OK) &&
+       (((descriptor.state == STATE_CLOSED) && (descriptor.type == TYPE_DGRAM)) || (descriptor.isReset == true)))
+    {
+        error = RESULT_RESET;
+    }
+
+    return error;
+}
+
+
+/*!
+ *  @brief  Write
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes data straight to AT+RSI_SND if the module is free.
+ *
+ *  @param[in]  descriptor  - Descriptor
+ *  @param[in]  data        - Data
+ *  @param[in]  size        - Size of the data (in bytes)
+ *  @param[in]  host        - Peer (UDP only)
+ *  @param[in]  port        - Port of the peer (UDP only)
+ *
+ *  @return int (bytes taken or #EResult)
+ */
+int RS9110_Sockets::Write (TDescriptor &descriptor, const char *data, unsigned int size, const char *host, unsigned short port)
+{
+    RS9110_UART::ESocketType    socketType;
+    unsigned int                sent;
+    int                         error = TakeError(descriptor);
+
+
+    if(error != RESULT_OK)
+    {
+        return error;
+    }
+
+    switch(descriptor.state)
+    {
+        case STATE_OPEN:
+        break;
+
+        case STATE_OPENING:
+            return RESULT_WOULD_BLOCK;
+
+        case STATE_CLOSED:
+            return RESULT_RESET;
+
+        default:
+            return RESULT_NOT_CONNECTED;
+    }
+
+    if((data == NULL) || (size == 0))
+    {
+        return ((size == 0) ? 0 : RESULT_INVALID);
+    }
+
+    if(_command != RS9110_UART::CMD_MAX)
+    {
+        return RESULT_WOULD_BLOCK;
+    }
+
+    socketType = ((descriptor.type == TYPE_STREAM) ? RS9110_UART::SOCKET_TCP : RS9110_UART::SOCKET_UDP);
+
+    if(descriptor.type == TYPE_DGRAM)
+    {
+        unsigned int maxSize = RS9110_UART::GetMaxSendSize(descriptor.handle, socketType, host, port);
+
+
+        /* A datagram is never split */
+        if(RS9110_UART::FitByteStuffing(maxSize, data, size) < size)
+        {
+            return RESULT_INVALID;
+        }
+    }
+
+    sent = _rs.Send(descriptor.handle, socketType, host, port, data, size);
+
+    if((sent == 0) || (_rs.GetLastCommand() != RS9110_UART::CMD_SEND_DATA))
+    {
+        return RESULT_INVALID;
+    }
+
+    _command    = RS9110_UART::CMD_SEND_DATA;
+    _fd         = (unsigned char) (&descriptor - _descriptors);
+    _chunk      = sent;
+    _stats.numCommands++;
+
+    return (int) sent;
+}
+
+
+/*!
+ *  @brief  Dispatch
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the next queued open or close, if the module is free, serving
+ *      the descriptors in round robin.
+ */
+void RS9110_Sockets::Dispatch ()
+{
+    for(unsigned char i = 0; (i < MAX_DESCRIPTORS) && (_command == RS9110_UART::CMD_MAX); i++)
+    {
+        unsigned char fd = (unsigned char) ((_next + i) % MAX_DESCRIPTORS);
+
+
+        if(Issue(fd) == true)
+        {
+            _next = (unsigned char) ((fd + 1) % MAX_DESCRIPTORS);
+        }
+    }
+}
+
+
+/*!
+ *  @brief  Issue
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes the open or close queued by a descriptor. A command that cannot
+ *      be written fails the open at once (or frees the descriptor being
+ *      closed).
+ *
+ *  @param[in]  fd  - Descriptor
+ *
+ *  @return bool
+ *  @retval true    - Command written
+ *  @retval false   - Nothing written
+ */
+bool RS9110_Sockets::Issue (unsigned char fd)
+{
+    TDescriptor            &descriptor  = _descriptors[fd];
+    RS9110_UART::ECommand   command;
+    bool                    bRtn;
+
+
+    if(descriptor.isQueued == false)
+    {
+        return false;
+    }
+
+    descriptor.isQueued = false;
+
+    if(descriptor.state == STATE_CLOSING)
+    {
+        command = RS9110_UART::CMD_CLOSE_SOCKET;
+        bRtn    = _rs.CloseSocket(descriptor.handle);
+
+        if(bRtn == false)
+        {
+            Release(descriptor, STATE_FREE);
+        }
+    }
+    else
+    {
+        if(descriptor.type == TYPE_STREAM)
+        {
+            command = ((descriptor.isListening == true) ? RS9110_UART::CMD_OPEN_LTCP_SOCKET : RS9110_UART::CMD_OPEN_TCP_SOCKET);
+            bRtn    = ((descriptor.isListening == true) ?
+                       _rs.OpenListeningTcpSocket(descriptor.localPort) :
+                       _rs.OpenTcpSocket(descriptor.host, descriptor.remotePort, descriptor.localPort));
+        }
+        else
+        {
+            command = ((descriptor.isListening == true) ? RS9110_UART::CMD_OPEN_LUDP_SOCKET : RS9110_UART::CMD_OPEN_UDP_SOCKET);
+            bRtn    = ((descriptor.isListening == true) ?
+                       _rs.OpenListeningUdpSocket(descriptor.localPort) :
+                       _rs.OpenUdpSocket(descriptor.host, descriptor.remotePort, descriptor.localPort));
+        }
+
+        if(bRtn == false)
+        {
+            descriptor.state    = STATE_CLOSED;
+            descriptor.error    = RESULT_INVALID;
+        }
+    }
+
+    if(bRtn == true)
+    {
+        _command    = command;
+        _fd         = fd;
+        _stats.numCommands++;
+    }
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  Answered
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Handles the OK/ERROR of the command in flight.
+ *
+ *  @param[in]  isOk    - OK received
+ */
+void RS9110_Sockets::Answered (bool isOk)
+{
+    TDescriptor            &descriptor  = _descriptors[_fd];
+    RS9110_UART::ECommand   command     = _command;
+    RS9110_UART::EErrorCode eErrorCode  = (isOk ? RS9110_UART::ERROR_NONE : _rs.GetErrorCode());
+
+
+    _command = RS9110_UART::CMD_MAX;
+
+    switch(command)
+    {
+        case RS9110_UART::CMD_SEND_DATA:
+            if(isOk == true)
+            {
+                _stats.bytesSent += _chunk;
+            }
+            else
+            {
+                _stats.numSendErrors++;
+
+                if(descriptor.state == STATE_OPEN)
+                {
+                    descriptor.error        = RESULT_MODULE_ERROR;
+                    descriptor.errorCode    = eErrorCode;
+                }
+            }
+        break;
+
+        case RS9110_UART::CMD_CLOSE_SOCKET:
+            Release(descriptor, STATE_FREE);
+        break;
+
+        default:
+        {
+            /* Opens: the handle comes in the OK */
+            int             length;
+            unsigned char  *response    = (unsigned char *) _rs.GetResponse(length);
+            unsigned char   handle      = (((isOk == true) && (length > 0)) ? response[0] : 0);
+
+
+            if((handle == 0) || (handle > RS9110_UART::MAX_SOCKET_HANDLE))
+            {
+                if(descriptor.state == STATE_CLOSING)
+                {
+                    Release(descriptor, STATE_FREE);
+                }
+                else
+                {
+                    descriptor.state        = STATE_CLOSED;
+                    descriptor.error        = RESULT_MODULE_ERROR;
+                    descriptor.errorCode    = eErrorCode;
+                }
+
+                break;
+            }
+
+            descriptor.handle       = handle;
+            _owners[handle - 1]     = (signed char) _fd;
+
+            if(descriptor.state == STATE_CLOSING)
+            {
+                /* Closed by the application meanwhile */
+                descriptor.isQueued = true;
+            }
+            else
+            {
+                descriptor.state = STATE_OPEN;
+            }
+        }
+        break;
+    }
+}
+
+
+/*!
+ *  @brief  Received
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies a READ frame to the receive buffer of its descriptor, with its
+ *      source for DGRAM descriptors. Data not fitting is dropped.
+ */
+void RS9110_Sockets::Received ()
+{
+    RS9110_UART::TReadTCP   readTCP;
+    RS9110_UART::TReadUDP   readUDP;
+    TDescriptor            *descriptor;
+    char                   *record;
+
+
+    _rs.Read(readTCP);
+
+    if((readTCP.socketId == 0) || (readTCP.socketId > RS9110_UART::MAX_SOCKET_HANDLE) ||
+       (_owners[readTCP.socketId - 1] < 0))
+    {
+        return;
+    }
+
+    descriptor = &_descriptors[_owners[readTCP.socketId - 1]];
+
+    if(descriptor->state != STATE_OPEN)
+    {
+        return;
+    }
+
+    if(descriptor->type == TYPE_DGRAM)
+    {
+        TDatagramHeader header;
+
+
+        _rs.Read(readUDP);
+        memcpy(header.address, readUDP.address, sizeof(header.address));
+        header.port = (unsigned short) ((((unsigned char *) &readUDP.srcPort)[0] << 8) |
+                                        ((unsigned char *) &readUDP.srcPort)[1]);
+
+        record = descriptor->rxRing.Reserve((unsigned short) (sizeof(header) + readUDP.size));
+
+        if(record == NULL)
+        {
+            _stats.bytesDropped += readUDP.size;
+            return;
+        }
+
+        memcpy(record, &header, sizeof(header));
+        memcpy(&record[sizeof(header)], readUDP.data, readUDP.size);
+        descriptor->rxRing.Commit((unsigned short) (sizeof(header) + readUDP.size));
+
+        _stats.bytesReceived += readUDP.size;
+    }
+    else
+    {
+        record = ((descriptor->isReset == false) ? descriptor->rxRing.Reserve(readTCP.size) : NULL);
+
+        if(record == NULL)
+        {
+            /* A gap in the stream: reset rather than lose it silently */
+            descriptor->isReset = true;
+            descriptor->error   = RESULT_RESET;
+            _stats.bytesDropped += readTCP.size;
+            return;
+        }
+
+        memcpy(record, readTCP.data, readTCP.size);
+        descriptor->rxRing.Commit(readTCP.size);
+
+        _stats.bytesReceived += readTCP.size;
+    }
+}
+
+
+/*!
+ *  @brief  Closed
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Marks the descriptors whose handle was closed by the module. Their
+ *      buffered data can still be read.
+ */
+void RS9110_Sockets::Closed ()
+{
+    for(unsigned char i = 0; i < RS9110_UART::MAX_SOCKET_HANDLE; i++)
+    {
+        TDescriptor *descriptor;
+
+
+        if((_owners[i] < 0) || (_rs.IsSocketOpen((unsigned char) (i + 1)) == true))
+        {
+            continue;
+        }
+
+        descriptor = &_descriptors[_owners[i]];
+
+        /* A close in flight is answered by its own OK/ERROR */
+        if((_command == RS9110_UART::CMD_CLOSE_SOCKET) && (_fd == _owners[i]))
+        {
+            continue;
+        }
+
+        Release(*descriptor, ((descriptor->state == STATE_CLOSING) ? STATE_FREE : STATE_CLOSED));
+    }
+}
+
+
+/*!
+ *  @brief  Release
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Unmaps the module handle of a descriptor.
+ *
+ *  @param[in]  descriptor  - Descriptor
+ *  @param[in]  eState      - New state (STATE_FREE or STATE_CLOSED)
+ */
+void RS9110_Sockets::Release (TDescriptor &descriptor, EState eState)
+{
+    if((descriptor.handle > 0) && (descriptor.handle <= RS9110_UART::MAX_SOCKET_HANDLE))
+    {
+        _owners[descriptor.handle - 1] = -1;
+    }
+
+    descriptor.handle   = 0;
+    descriptor.isQueued = false;
+    descriptor.state    = (unsigned char) eState;
+}
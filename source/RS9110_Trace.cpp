@@ -0,0 +1,410 @@
+#include "RS9110_Trace.h"
+
+#include "RS9110_UART.h"
+#include "RS9110_Barrier.h"
+
+#include <string.h>
+
+#if defined (WIN32)
+#include <windows.h>
+#elif defined (__linux__)
+#include <time.h>
+#endif /* WIN32 */
+
+
+static const unsigned int   TRACE_MASK      = RS9110_Trace::MAX_TRACE_ENTRIES - 1;
+static const unsigned int   MAX_READABLE    = RS9110_Trace::MAX_TRACE_ENTRIES - 1;     /* Slot being written excluded */
+
+/* Compile-time check of RS9110_Config.h */
+typedef char CheckTraceEntries      [((RS9110_Trace::MAX_TRACE_ENTRIES & TRACE_MASK) == 0) ? 1 : -1];
+
+static const unsigned int   TID_COMMANDS    = 1;
+static const unsigned int   TID_UNSOLICITED = 2;
+static const unsigned int   TID_REJECTED    = 3;
+
+static const char *TRACE_HEADER =
+    "{\"traceEvents\":[\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Commands\"}},\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"Unsolicited\"}},\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"Rejected\"}}";
+
+static const char *TRACE_FOOTER = "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+
+
+/*!
+ *  @brief  Constructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Constructor.
+ *
+ *  @param[in]  clock   - Time source in microseconds (NULL uses #RS9110_Trace::MonotonicClock)
+ *
+ */
+RS9110_Trace::RS9110_Trace (TClock clock)
+  : _clock((clock != NULL) ? clock : MonotonicClock),
+    _head(0)
+{
+    memset(_entries, 0, sizeof(_entries));
+}
+
+
+/*!
+ *  @brief  Destructor
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *    Destructor.
+ *
+ */
+RS9110_Trace::~RS9110_Trace ()
+{
+    /* Nothing to do */
+}
+
+
+/*!
+ *  @brief  Record
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Stores a new entry in the ring, overwriting the oldest one when it is full.
+ *      There must be a single producer (the context driving #RS9110_UART); readers
+ *      never block it.
+ *
+ *  @param[in]  eEvent      - Kind of event
+ *  @param[in]  type        - Command (TX) or response type (RX)
+ *  @param[in]  socketId    - Socket handle (0 if none)
+ *  @param[in]  length      - Length of the frame (in bytes)
+ *  @param[in]  errorCode   - Error code (RX only)
+ */
+void RS9110_Trace::Record (EEvent eEvent, unsigned char type, unsigned char socketId, unsigned short length, unsigned char errorCode)
+{
+    unsigned long   head    = _head;
+    TEntry         *entry   = &_entries[head & TRACE_MASK];
+
+
+    entry->timestamp    = _clock();
+    entry->event        = (unsigned char) eEvent;
+    entry->type         = type;
+    entry->socketId     = socketId;
+    entry->errorCode    = errorCode;
+    entry->length       = length;
+
+    /* Publish the entry once it is complete (release) */
+    RS9110_MEMORY_BARRIER();
+    _head = head + 1;
+}
+
+
+/*!
+ *  @brief  Clear
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Discards all the entries. Producer only: it must be called from the
+ *      context calling #Record, never from a reader (a reader may still get
+ *      the copy of an entry discarded by the call).
+ */
+void RS9110_Trace::Clear ()
+{
+    _head = 0;
+}
+
+
+/*!
+ *  @brief  GetNumEntries
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Returns the number of entries that can be read. The slot the producer
+ *      writes next is never exposed, so at most MAX_TRACE_ENTRIES - 1.
+ *
+ *  @return unsigned int
+ */
+unsigned int RS9110_Trace::GetNumEntries ()
+{
+    unsigned long head = _head;
+
+
+    return ((head < MAX_READABLE) ? (unsigned int) head : MAX_READABLE);
+}
+
+
+/*!
+ *  @brief  GetEntry
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Copies an entry of the ring, being 0 the oldest one. The copy is discarded
+ *      if the producer overwrote the entry while it was being read.
+ *
+ *  @param[in]  index   - Position of the entry (oldest first)
+ *  @param[out] entry   - Copy of the entry
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Index out of range or entry overwritten
+ */
+bool RS9110_Trace::GetEntry (unsigned int index, TEntry &entry)
+{
+    unsigned long head = _head;
+    unsigned long num  = ((head < MAX_READABLE) ? head : MAX_READABLE);
+    unsigned long pos;
+
+
+    if(index >= num)
+    {
+        return false;
+    }
+
+    /* Acquire: the entries published up to head are complete */
+    RS9110_MEMORY_BARRIER();
+
+    pos = head - num + index;
+    memcpy(&entry, &_entries[pos & TRACE_MASK], sizeof(entry));
+
+    /* The copy is done before checking that the producer is not in the slot */
+    RS9110_MEMORY_BARRIER();
+
+    return ((_head - pos) < MAX_TRACE_ENTRIES);
+}
+
+
+/*!
+ *  @brief  ExportChromeTrace
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Dumps the ring in Chrome trace / Perfetto JSON format. Every command is
+ *      drawn as a slice lasting until its OK/ERROR, unsolicited messages
+ *      (READ, CLOSE, SLEEP) and rejected frames are drawn as instant events.
+ *
+ *  @param[in]  persistor   - Destination of the JSON document
+ *
+ *  @return bool
+ *  @retval true    - OK
+ *  @retval false   - Write error
+ */
+bool RS9110_Trace::ExportChromeTrace (IPersistor *persistor)
+{
+    TEntry              entry;
+    TEntry              command;
+    bool                isPending   = false;
+    bool                isFirst     = true;
+    bool                bRtn;
+    unsigned long long  base        = 0;
+    unsigned int        num         = GetNumEntries();
+
+
+    if(persistor == NULL)
+    {
+        return false;
+    }
+
+    bRtn = WriteString(persistor, TRACE_HEADER);
+
+    for(unsigned int i = 0; (i < num) && (bRtn == true); i++)
+    {
+        if(GetEntry(i, entry) == false)
+        {
+            continue;
+        }
+
+        if(isFirst == true)
+        {
+            base    = entry.timestamp;
+            isFirst = false;
+        }
+
+        switch(entry.event)
+        {
+            case EVENT_TX:
+                if(isPending == true)
+                {
+                    bRtn = WriteCommand(persistor, command, NULL, base);
+                }
+
+                memcpy(&command, &entry, sizeof(command));
+                isPending = true;
+            break;
+
+            case EVENT_RX:
+                if((isPending == true) &&
+                   ((entry.type == RS9110_UART::RESP_TYPE_OK) || (entry.type == RS9110_UART::RESP_TYPE_ERROR)))
+                {
+                    bRtn = WriteCommand(persistor, command, &entry, base);
+                    isPending = false;
+                }
+                else
+                {
+                    bRtn = WriteInstant(persistor, entry, base);
+                }
+            break;
+
+            default:
+                bRtn = WriteInstant(persistor, entry, base);
+            break;
+        }
+    }
+
+    if((bRtn == true) && (isPending == true))
+    {
+        bRtn = WriteCommand(persistor, command, NULL, base);
+    }
+
+    if(bRtn == true)
+    {
+        bRtn = WriteString(persistor, TRACE_FOOTER);
+    }
+
+    return bRtn;
+}
+
+
+/*!
+ *  @brief  MonotonicClock
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Default time source: CLOCK_MONOTONIC on Linux and the performance counter
+ *      on Windows. There is no OS clock on the MCU, so a clock must be given
+ *      to the constructor there (this one always returns 0).
+ *
+ *  @return Time in microseconds
+ */
+unsigned long long RS9110_Trace::MonotonicClock ()
+{
+#if defined (WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (((counter.QuadPart / frequency.QuadPart) * 1000000) +
+            (((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart));
+#elif defined (AVR32)
+    return 0;
+#elif defined (__linux__)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000));
+#else
+    return 0;
+#endif /* WIN32 */
+}
+
+
+/*!
+ *  @brief  WriteCommand
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes a command as a slice lasting until its response or, when it got no
+ *      response, as an instant event.
+ *
+ *  @param[in]  persistor   - Destination
+ *  @param[in]  command     - TX entry
+ *  @param[in]  response    - OK/ERROR entry (NULL if none)
+ *  @param[in]  base        - Timestamp of the oldest entry
+ *
+ *  @return bool
+ */
+bool RS9110_Trace::WriteCommand (IPersistor *persistor, const TEntry &command, const TEntry *response, unsigned long long base)
+{
+    char line[256];
+
+
+    if(response != NULL)
+    {
+        RS9110_UART::Format(line, sizeof(line),
+                            ",\n{\"name\":\"%s\",\"cat\":\"command\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu,"
+                            "\"args\":{\"socket\":%u,\"txLen\":%u,\"rxLen\":%u,\"response\":\"%s\",\"error\":%u}}",
+                            RS9110_UART::GetCommandName((RS9110_UART::ECommand) command.type), TID_COMMANDS,
+                            command.timestamp - base, response->timestamp - command.timestamp,
+                            command.socketId, command.length, response->length,
+                            RS9110_UART::GetResponseName((RS9110_UART::EResponseType) response->type), response->errorCode);
+    }
+    else
+    {
+        RS9110_UART::Format(line, sizeof(line),
+                            ",\n{\"name\":\"%s\",\"cat\":\"command\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%llu,"
+                            "\"args\":{\"socket\":%u,\"txLen\":%u}}",
+                            RS9110_UART::GetCommandName((RS9110_UART::ECommand) command.type), TID_COMMANDS,
+                            command.timestamp - base, command.socketId, command.length);
+    }
+
+    return WriteString(persistor, line);
+}
+
+
+/*!
+ *  @brief  WriteInstant
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes an unsolicited message (READ, CLOSE, SLEEP), an unexpected
+ *      response or a rejected frame as an instant event.
+ *
+ *  @param[in]  persistor   - Destination
+ *  @param[in]  entry       - RX entry
+ *  @param[in]  base        - Timestamp of the oldest entry
+ *
+ *  @return bool
+ */
+bool RS9110_Trace::WriteInstant (IPersistor *persistor, const TEntry &entry, unsigned long long base)
+{
+    char line[256];
+
+
+    if(entry.event == EVENT_RX)
+    {
+        RS9110_UART::Format(line, sizeof(line),
+                            ",\n{\"name\":\"%s\",\"cat\":\"unsolicited\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%llu,"
+                            "\"args\":{\"socket\":%u,\"rxLen\":%u,\"error\":%u}}",
+                            RS9110_UART::GetResponseName((RS9110_UART::EResponseType) entry.type), TID_UNSOLICITED,
+                            entry.timestamp - base, entry.socketId, entry.length, entry.errorCode);
+    }
+    else
+    {
+        RS9110_UART::Format(line, sizeof(line),
+                            ",\n{\"name\":\"rejected\",\"cat\":\"rejected\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%llu,"
+                            "\"args\":{\"rxLen\":%u}}",
+                            TID_REJECTED, entry.timestamp - base, entry.length);
+    }
+
+    return WriteString(persistor, line);
+}
+
+
+/*!
+ *  @brief  WriteString
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Writes a zero-ended string thru the persistor.
+ *
+ *  @param[in]  persistor   - Destination
+ *  @param[in]  str         - String to write
+ *
+ *  @return bool
+ */
+bool RS9110_Trace::WriteString (IPersistor *persistor, const char *str)
+{
+    return persistor->Write((unsigned char *) str, strlen(str));
+}
@@ -1,20 +1,17 @@
 #include "RS9110_UART.h"
 
 #include "IPersistor.h"
+#include "RS9110_Trace.h"
+#include "RS9110_Pacer.h"
+#include "RS9110_Energy.h"
+#include "RS9110_Probes.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 
-#if defined (WIN32)
-#define _snprintf_s     _snprintf_s
-#elif defined (AVR32)
-#define _snprintf_s     snprintf
-#define _snprintf       snprintf
-#endif /* WIN32 */
-
-
-static const char *COMMAND[] =
+const char * const RS9110_UART_Base::COMMAND[] =
 {
     "AT+RSI_BAND=",
     "AT+RSI_INIT",
@@ -54,29 +51,49 @@ static const char *COMMAND[] =
 	"AT+RSI_CFGGET?"
 };
 
-static const char *NETWORK_TYPE_STR[] =
+const char * const RS9110_UART_Base::NETWORK_TYPE_STR[] =
 {
     "INFRASTRUCTURE",
     "IBSS",
     "IBSS_SEC"
 };
 
+static const char *RESPONSE_TYPE_STR[] =
+{
+    "OK",
+    "ERROR",
+    "AT+RSI_READ",
+    "AT+RSI_CLOSE",
+    "SLEEP"
+};
+
 static const char *CMD_RESP_OK      = "OK";
 static const char *CMD_RESP_ERROR   = "ERROR";
 static const char *CMD_RESP_READ    = "AT+RSI_READ";
 static const char *CMD_RESP_CLOSE   = "AT+RSI_CLOSE";
 static const char *CMD_RESP_SLEEP   = "SLEEP";
 
-static const char *CMD_END          = "\r\n";
+const char * const RS9110_UART_Base::CMD_END = "\r\n";
 
 static const unsigned char CMD_RESP_OK_LEN      = strlen(CMD_RESP_OK);
 static const unsigned char CMD_RESP_ERROR_LEN	= strlen(CMD_RESP_ERROR);
 static const unsigned char CMD_RESP_READ_LEN    = strlen(CMD_RESP_READ);
-static const unsigned char CMD_END_LEN          = strlen(CMD_END);
+static const unsigned char CMD_RESP_CLOSE_LEN   = strlen(CMD_RESP_CLOSE);
+const unsigned char RS9110_UART_Base::CMD_END_LEN = strlen(CMD_END);
 
+/* Compile-time checks of RS9110_Config.h */
+typedef RS9110_UART_Base Cfg;
+typedef char CheckBufferSize        [(Cfg::MAX_BUFFER_SIZE >= 128) ? 1 : -1];
+typedef char CheckBufferScan        [(Cfg::MAX_BUFFER_SIZE >= (sizeof(Cfg::TBssid) * Cfg::MAX_NUM_SCAN_RESULTS)) ? 1 : -1];
+typedef char CheckBufferNwParams    [(Cfg::MAX_BUFFER_SIZE >= sizeof(Cfg::TNetworkParamsExt)) ? 1 : -1];
+typedef char CheckBufferConfig      [(Cfg::MAX_BUFFER_SIZE >= (sizeof(Cfg::TStoredConfig) + (RS9110_FEATURE_WEP ? sizeof(Cfg::TStoredConfigWEP) : 0))) ? 1 : -1];
+typedef char CheckNumberSockets     [((Cfg::MAX_NUMBER_SOCKETS >= 1) && (Cfg::MAX_NUMBER_SOCKETS <= Cfg::MAX_SOCKET_HANDLE)) ? 1 : -1];
+typedef char CheckNumScanResults    [((Cfg::MAX_NUM_SCAN_RESULTS >= 1) && (Cfg::MAX_NUM_SCAN_RESULTS <= 10)) ? 1 : -1];
+typedef char CheckDNSGetResp        [((Cfg::MAX_DNSGET_RESP >= 1) && (Cfg::MAX_DNSGET_RESP <= 10)) ? 1 : -1];
 
-static bool         IsValidString       (const char *string, int maxLen = -1);
-static unsigned int SendByteStuffing    (char *destination, unsigned int &dstSize, const char *source, unsigned int srcSize);
+/* Byte stuffing is sized a word (4 bytes) at a time */
+static const unsigned int   STUFFING_WORD_LEN   = 4;
+typedef char CheckStuffingWord      [(sizeof(unsigned int) == STUFFING_WORD_LEN) ? 1 : -1];
 
 
 
@@ -88,17 +105,29 @@ static unsigned int SendByteStuffing    (char *destination, unsigned int &dstSiz
  *
  *    Constructor.
  *
- *  @param[in]  persistor   - Pointer to the persistor
- *
  */
-RS9110_UART::RS9110_UART (IPersistor *persistor)
-  : _persistor(persistor),
+RS9110_UART_Base::RS9110_UART_Base ()
+  : _trace(NULL),
+    _pacer(NULL),
+    _energy(NULL),
     _responseLength(0),
     _lastCommand(CMD_MAX),
     _responseType(RESP_TYPE_MAX),
-    _errorCode(ERROR_NONE)
+    _errorCode(ERROR_NONE),
+    _nwParamsLength(0),
+    _commandLength(0),
+    _commandSocketId(0),
+    _isRetryPending(false)
 {
     memset(_buffer, 0, sizeof(_buffer));
+    memset(&_counters, 0, sizeof(_counters));
+    memset(&_pendingSocket, 0, sizeof(_pendingSocket));
+
+    memset(_nwParams, 0, sizeof(_nwParams));
+
+    _pendingSocket.type = SOCKET_MAX;
+
+    ResetSocketTable();
 }
 
 
@@ -111,56 +140,172 @@ RS9110_UART::RS9110_UART (IPersistor *persistor)
  *    Destructor.
  *
  */
-RS9110_UART::~RS9110_UART ()
+RS9110_UART_Base::~RS9110_UART_Base ()
 {
     /* Nothing to do */
 }
 
 
 /*!
- *  @brief  SetPersistor
+ *  @brief  SetTrace
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Set the trace ring where every command sent and every message received
+ *      is recorded. NULL disables the tracing.
+ *
+ *  @param[in]  trace   - Pointer to the trace ring
+ *
+ */
+void RS9110_UART_Base::SetTrace (RS9110_Trace *trace)
+{
+    _trace = trace;
+}
+
+
+/*!
+ *  @brief  GetTrace
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Get which trace ring is used.
+ *
+ *  @return Pointer to the trace ring
+ *
+ */
+RS9110_Trace * RS9110_UART_Base::GetTrace ()
+{
+    return _trace;
+}
+
+
+/*!
+ *  @brief  SetPacer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Set the pacer that holds commands back to avoid ERROR_CMD_TOO_FAST and
+ *      writes again the ones rejected (see #RS9110_UART_T::Poll). NULL disables
+ *      the pacing.
+ *
+ *  @param[in]  pacer   - Pointer to the pacer
+ *
+ */
+void RS9110_UART_Base::SetPacer (RS9110_Pacer *pacer)
+{
+    _pacer = pacer;
+}
+
+
+/*!
+ *  @brief  GetPacer
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Get which pacer is used.
+ *
+ *  @return Pointer to the pacer
+ *
+ */
+RS9110_Pacer * RS9110_UART_Base::GetPacer ()
+{
+    return _pacer;
+}
+
+
+/*!
+ *  @brief  SetEnergyMeter
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Set the meter that accounts the time spent in every power state and
+ *      the wake cycles. NULL disables the accounting.
+ *
+ *  @param[in]  energy  - Pointer to the energy meter
+ *
+ */
+void RS9110_UART_Base::SetEnergyMeter (RS9110_Energy *energy)
+{
+    _energy = energy;
+}
+
+
+/*!
+ *  @brief  GetEnergyMeter
+ *
+ *  @details
+ *  <b>Details:</b><p>
+ *
+ *      Get which energy meter is used.
+ *
+ *  @return Pointer to the energy meter
+ *
+ */
+RS9110_Energy * RS9110_UART_Base::GetEnergyMeter ()
+{
+    return _energy;
+}
+
+
+/*!
+ *  @brief  GetCommandName
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Set which persistor must be used (only Write method).
+ *      Returns the AT command string of the given command.
  *
- *  @param[in]  persistor   - Pointer to the persistor
+ *  @param[in]  command - Command type
  *
+ *  @return const char *
  */
-void RS9110_UART::SetPersistor (IPersistor *persistor)
+const char * RS9110_UART_Base::GetCommandName (ECommand command)
 {
-    if(persistor != NULL)
+    if(command >= CMD_MAX)
     {
-        _persistor = persistor;
+        return "";
     }
+
+    return COMMAND[command];
 }
 
 
 /*!
- *  @brief  GetPersistor
+ *  @brief  GetResponseName
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Get which persistor is used.
+ *      Returns the string which identifies the given response type.
  *
- *  @return Pointer to the persistor
+ *  @param[in]  responseType    - Response type
  *
+ *  @return const char *
  */
-IPersistor * RS9110_UART::GetPersistor ()
+const char * RS9110_UART_Base::GetResponseName (EResponseType responseType)
 {
-    return _persistor;
+    if(responseType >= RESP_TYPE_MAX)
+    {
+        return "";
+    }
+
+    return RESPONSE_TYPE_STR[responseType];
 }
 
 
 /*!
- *  @brief  ProcessMessage
+ *  @brief  ParseMessage
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Set which persistor must be used (only Write method).
+ *      Parses an incoming message and updates the driver state. Only called
+ *      from #RS9110_UART_T::ProcessMessage, the single entry point.
  *
  *  @param[in]  message     - Pointer to the beginning of the incoming message
  *  @param[in]  size        - Size of the incoming message (in bytes)
@@ -169,14 +314,27 @@ IPersistor * RS9110_UART::GetPersistor ()
  *  @retval true    - OK
  *  @retval false   - Response is not complete, too long or unknown
  */
-bool RS9110_UART::ProcessMessage (char *message, int size)
+bool RS9110_UART_Base::ParseMessage (char *message, int size)
 {
     bool bRtn = true;
 
 
+    RS9110_PROBE(process_message_entry, size, 0);
+
+    _counters.bytesRead += size;
+
     if(memcmp(&message[size - 2], CMD_END, CMD_END_LEN) != 0)
     {
         _responseLength = -1;
+        _counters.rejectedFrames++;
+
+        if(_trace != NULL)
+        {
+            _trace->Record(RS9110_Trace::EVENT_RX_REJECTED, RESP_TYPE_MAX, 0, (unsigned short) size);
+        }
+
+        RS9110_PROBE(process_message_return, RESP_TYPE_MAX, false);
+
         return false;
     }
 
@@ -195,6 +353,7 @@ bool RS9110_UART::ProcessMessage (char *message, int size)
                 if(_responseLength <= MAX_BUFFER_SIZE)
                 {
                     memcpy(_buffer, &message[CMD_RESP_OK_LEN], _responseLength);
+                    _commandLength = 0;
                 }
                 else
                 {
@@ -220,6 +379,7 @@ bool RS9110_UART::ProcessMessage (char *message, int size)
             {
                 _responseLength = size - CMD_RESP_READ_LEN - CMD_END_LEN;
                 memcpy(_buffer, &message[CMD_RESP_READ_LEN], _responseLength);
+                _commandLength  = 0;
             }
             else
             {
@@ -242,6 +402,58 @@ bool RS9110_UART::ProcessMessage (char *message, int size)
         break;
     }
 
+    /* Before a paced retry clears the answer */
+    if(_trace != NULL)
+    {
+        unsigned char socketId = 0;
+
+        if((_responseType == RESP_TYPE_READ) && (_responseLength > 0))
+        {
+            socketId = (unsigned char) _buffer[0];
+        }
+        else if((_responseType == RESP_TYPE_CLOSE) && (size > (CMD_RESP_CLOSE_LEN + CMD_END_LEN)))
+        {
+            socketId = (unsigned char) message[CMD_RESP_CLOSE_LEN];
+        }
+
+        _trace->Record(((bRtn == true) ? RS9110_Trace::EVENT_RX : RS9110_Trace::EVENT_RX_REJECTED),
+                       _responseType, socketId, (unsigned short) size, _errorCode);
+    }
+
+    if(bRtn == true)
+    {
+        _counters.frames[_responseType]++;
+
+        if(_responseType == RESP_TYPE_ERROR)
+        {
+            CountError(_errorCode);
+        }
+
+        if((_pacer != NULL) && (_pacer->Answered(_lastCommand, _responseType, _errorCode, (_commandLength > 0)) == true))
+        {
+            /* Written again by RS9110_UART_T::Poll, no answer yet */
+            _isRetryPending = true;
+            _responseType   = RESP_TYPE_MAX;
+            _errorCode      = ERROR_NONE;
+        }
+        else
+        {
+            UpdateNetworkParameters();
+            UpdateSocketTable(message, size);
+
+            if(_energy != NULL)
+            {
+                _energy->Received(_responseType, _lastCommand);
+            }
+        }
+    }
+    else
+    {
+        _counters.rejectedFrames++;
+    }
+
+    RS9110_PROBE(process_message_return, _responseType, bRtn);
+
     return bRtn;
 }
 
@@ -256,7 +468,7 @@ bool RS9110_UART::ProcessMessage (char *message, int size)
  *
  *  @return EResponseType
  */
-RS9110_UART::EResponseType RS9110_UART::GetResponseType ()
+RS9110_UART_Base::EResponseType RS9110_UART_Base::GetResponseType ()
 {
     return _responseType;
 }
@@ -272,13 +484,13 @@ RS9110_UART::EResponseType RS9110_UART::GetResponseType ()
  *
  *  @return ECommand
  */
-RS9110_UART::ECommand RS9110_UART::GetLastCommand ()
+RS9110_UART_Base::ECommand RS9110_UART_Base::GetLastCommand ()
 {
     return _lastCommand;
 }
 
 
-void * RS9110_UART::GetResponse (int &responseLength)
+void * RS9110_UART_Base::GetResponse (int &responseLength)
 {
     responseLength = _responseLength;
 
@@ -291,7 +503,7 @@ void * RS9110_UART::GetResponse (int &responseLength)
 }
 
 
-void RS9110_UART::Read (TReadUDP &readUDP)
+void RS9110_UART_Base::Read (TReadUDP &readUDP)
 {
     TReadUDP *tmp = (TReadUDP *) _buffer;
 
@@ -307,7 +519,7 @@ void RS9110_UART::Read (TReadUDP &readUDP)
 }
 
 
-void RS9110_UART::Read (TReadTCP &readTCP)
+void RS9110_UART_Base::Read (TReadTCP &readTCP)
 {
     TReadTCP *tmp = (TReadTCP *) _buffer;
 
@@ -331,1194 +543,1059 @@ void RS9110_UART::Read (TReadTCP &readTCP)
  *
  *  @return ECommand
  */
-RS9110_UART::EErrorCode RS9110_UART::GetErrorCode ()
+RS9110_UART_Base::EErrorCode RS9110_UART_Base::GetErrorCode ()
 {
     return _errorCode;
 }
 
 
 /*!
- *  @brief  Band
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command configures the band in which the module has to be configured.
- *
- *  @param[in]  eBand     - Type of band
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::Band (EBand eBand)
-{
-    if(eBand >= BAND_MAX)
-    {
-        SetLastCommand(CMD_MAX);
-        return false;
-    }
-
-    return GenericCommandInt(CMD_BAND, eBand);
-}
-
-
-/*!
- *  @brief  Init
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command programs the RS9110-N-11-2X module's Baseband and RF components.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::Init ()
-{
-    return GenericCommand(CMD_INIT);
-}
-
-
-/*!
- *  @brief  GetNumScanResults
+ *  @brief  GetCounters
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is to get the number of networks already scanned by the "Scan"
- *      or "Next Scan" command.
+ *      Takes a snapshot of the traffic counters (frames per response type, bytes
+ *      written/read, byte stuffing expansion and error codes received).
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[out] counters    - Copy of the counters
  */
-bool RS9110_UART::GetNumScanResults ()
+void RS9110_UART_Base::GetCounters (TCounters &counters)
 {
-    return GenericCommand(CMD_GET_SCAN_RESULTS);
+    memcpy(&counters, &_counters, sizeof(counters));
 }
 
 
 /*!
- *  @brief  SetNumScanResults
+ *  @brief  GetErrorCount
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command configures the number of scan results the module returns for
- *      the Scan and NextScan commands.
+ *      Returns how many times the module answered with the given error code.
  *
- *  @param[in]  value   - Number of scan results (Min = 1, Max = #MAX_NUM_SCAN_RESULTS)
+ *  @param[in]  eErrorCode  - Error code
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @return unsigned long
  */
-bool RS9110_UART::SetNumScanResults (unsigned char value)
+unsigned long RS9110_UART_Base::GetErrorCount (EErrorCode eErrorCode)
 {
-    if((value <= 0) || (value > MAX_NUM_SCAN_RESULTS))
+    for(unsigned char i = 0; i < MAX_ERROR_COUNTERS; i++)
     {
-        SetLastCommand(CMD_MAX);
-        return false;
+        if((_counters.errors[i].count > 0) && (_counters.errors[i].code == (unsigned char) eErrorCode))
+        {
+            return _counters.errors[i].count;
+        }
     }
 
-    return GenericCommandInt(CMD_SET_SCAN_RESULTS, value);
+    return 0;
 }
 
 
 /*!
- *  @brief  PassiveScan
+ *  @brief  ResetCounters
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command enables the module to scan for networks without sending a probe
- *      request from the module.
- *
- *  @param[in]  channels    - Channels passive scan is to be done
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *      Sets all the traffic counters to zero.
  */
-bool RS9110_UART::PassiveScan (unsigned int channels)
+void RS9110_UART_Base::ResetCounters ()
 {
-    return GenericCommandInt(CMD_PASSIVE_SCAN, (unsigned int) channels);
+    memset(&_counters, 0, sizeof(_counters));
 }
 
 
 /*!
- *  @brief  Scan
+ *  @brief  GetSocketInfo
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command scans in all the channels or the channel specified in the command #RS9110_UART::SetNumScanResults.
+ *      Returns what the driver knows about an open socket (type, ports and
+ *      remote address) without asking the module. The table is kept up to date
+ *      from the OK of every open/close command, the unsolicited "AT+RSI_CLOSE"
+ *      messages and the OK of Reset/Disassociate (which close all of them).
+ *      Only #MAX_NUMBER_SOCKETS sockets have an entry: the ones opened beyond
+ *      are still reported as open, without details.
  *
- *  @param[in]  channels    - Channel Number
- *  @param[in]  ssid        - SSID (Max length is #MAX_SSID_LEN)
+ *  @param[in]  socketId    - Socket handle
+ *  @param[out] socketInfo  - Copy of the entry
  *
  *  @return bool
  *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @retval false   - Socket not open or without entry
  */
-bool RS9110_UART::Scan (unsigned char channel, const char *ssid)
+bool RS9110_UART_Base::GetSocketInfo (unsigned char socketId, TSocketInfo &socketInfo)
 {
-    bool bRtn;
+    TSocketInfo *entry;
 
 
-    if(IsValidString(ssid) == false)
+    if(IsSocketOpen(socketId) == false)
     {
-        _snprintf_s(_buffer, sizeof(_buffer), "%s%d%s", COMMAND[CMD_SCAN], channel, CMD_END);
+        return false;
     }
-    else
-    {
-        if(strlen(ssid) > MAX_SSID_LEN)
-        {
-            SetLastCommand(CMD_MAX);
-            return false;
-        }
 
-        _snprintf_s(_buffer, sizeof(_buffer), "%s%d,%s%s", COMMAND[CMD_SCAN], channel, ssid, CMD_END);
-    }
+    entry = FindSocketEntry(socketId);
 
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+    if(entry == NULL)
+    {
+        return false;
+    }
 
-    SetLastCommand(CMD_SCAN, bRtn);
+    memcpy(&socketInfo, entry, sizeof(socketInfo));
 
-    return bRtn;
+    return true;
 }
 
 
 /*!
- *  @brief  NextScan
+ *  @brief  IsSocketOpen
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command returns the number of results (set by the command RS9110_UART::SetNumScanResults)
- *      obtained by #RS9110_UART::Scan.
+ *      Checks whether the socket handle is open according to the socket table.
+ *
+ *  @param[in]  socketId    - Socket handle
  *
  *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
  */
-bool RS9110_UART::NextScan ()
+bool RS9110_UART_Base::IsSocketOpen (unsigned char socketId)
 {
-    return GenericCommand(CMD_NEXT_SCAN);
+    if(IsValidSocketId(socketId) == false)
+    {
+        return false;
+    }
+
+    return ((_openSockets & (1 << (socketId - MIN_SOCKET_HANDLE))) != 0);
 }
 
 
 /*!
- *  @brief  GetMACOfAPs
+ *  @brief  GetOpenSockets
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command returns the MAC addresses of the Access Points returned by the "Scan" command.
+ *      Returns the open sockets as a bit mask, being bit 0 the handle #MIN_SOCKET_HANDLE.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @return unsigned char
  */
-bool RS9110_UART::GetMACOfAPs ()
+unsigned char RS9110_UART_Base::GetOpenSockets ()
 {
-    return GenericCommand(CMD_GET_MAC_APS);
+    return _openSockets;
 }
 
 
 /*!
- *  @brief  GetNetworkType
+ *  @brief  GetNumOpenSockets
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command returns the network type of the scanned AP.
+ *      Returns the number of open sockets according to the socket table.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @return unsigned char
  */
-bool RS9110_UART::GetNetworkType ()
+unsigned char RS9110_UART_Base::GetNumOpenSockets ()
 {
-    return GenericCommand(CMD_GET_NETWORK_TYPE);
+    return _numOpenSockets;
 }
 
 
 /*!
- *  @brief  SetNetworkType
+ *  @brief  ResetSocketTable
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command configures the type of network the module wishes to join.
- *
- *  @param[in]  eNWType     - Type of the network to be created/joined
- *  @param[in]  eIBSSType   - Type of IBSS network (optional if #NW_TYPE_INFRASTRUCTURE is chosen)
- *  @param[in]  channel     - Channel in which the IBSS network has to be created (optional if #NW_TYPE_INFRASTRUCTURE is chosen)
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *      Marks all the sockets as closed (i.e. after a hardware reset of the module
+ *      the driver was not told about).
  */
-bool RS9110_UART::SetNetworkType (ENetworkType eNWType, EIBSSType eIBSSType, unsigned char channel)
+void RS9110_UART_Base::ResetSocketTable ()
 {
-    bool bRtn;
-
-
-    switch(eNWType)
-    {
-        case NW_TYPE_INFRASTRUCTURE:
-            _snprintf_s(_buffer, sizeof(_buffer), "%s%s%s", COMMAND[CMD_SET_NETWORK_TYPE], NETWORK_TYPE_STR[eNWType], CMD_END);
-        break;
-
-        case NW_TYPE_IBSS:
-        case NW_TYPE_IBSS_SEC:
-            _snprintf_s(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_SET_NETWORK_TYPE], NETWORK_TYPE_STR[eNWType], eIBSSType, channel, CMD_END);
-        break;
-
-        default:
-            SetLastCommand(CMD_MAX);
-            return false;
-        break;
-    }
-
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+    memset(_sockets, 0, sizeof(_sockets));
 
-    SetLastCommand(CMD_SET_NETWORK_TYPE, bRtn);
-
-    return bRtn;
+    _openSockets    = 0;
+    _numOpenSockets = 0;
 }
 
 
 /*!
- *  @brief  PSK
+ *  @brief  IsNetworkParametersCached
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command configures the PSK (Pre Shared Key) that is used for creating
- *      secured access.
- *
- *  @param[in]  psk - Preshared key (Max length is #MAX_PSK_LEN)
+ *      Checks whether the cached network parameters are still valid.
  *
  *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
  */
-bool RS9110_UART::PSK (const char *psk)
+bool RS9110_UART_Base::IsNetworkParametersCached ()
 {
-    if(IsValidString(psk, MAX_PSK_LEN_EXT) == false)
-    {
-        SetLastCommand(CMD_MAX);
-        return false;
-    }
-
-    return GenericCommandStr(CMD_PSK, psk);
+    return (_nwParamsLength > 0);
 }
 
 
 /*!
- *  @brief  SetWEPKeys
+ *  @brief  GetCachedNetworkParameters
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is issued to supply WEP keys to the module, if the AP is in WEP mode.
+ *      Returns the last answer to "AT+RSI_NWPARAMS?" (#TNetworkParams or
+ *      #TNetworkParamsExt depending on the PSK length feature) as long as nothing
+ *      the driver has seen since then could have changed it:
+ *      - OK to Join, Disassociate, IPConfiguration, any socket open/close,
+ *        SetFeatureSelect, Init or Reset.
+ *      - ERROR to Join.
+ *      - ERROR_DEAUTH_FROM_AP or ERROR_IP_EXPIRED from any command.
+ *      - Unsolicited "AT+RSI_CLOSE".
  *
- *  @param[in]  keyIndex    - Key index to be used to select the key.
- *  @param[in]  key2        - 2nd key of AP
- *  @param[in]  key3        - 3rd key of AP
- *  @param[in]  key4        - 4th key of AP
+ *  @param[out] length  - Length of the parameters (in bytes)
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @return Pointer to the parameters (NULL if invalidated)
  */
-bool RS9110_UART::SetWEPKeys (unsigned char keyIndex, char *key2, char *key3, char *key4)
+const void * RS9110_UART_Base::GetCachedNetworkParameters (int &length)
 {
-    bool bRtn;
-
-
-    if((keyIndex > 3) ||
-       (IsValidString(key2, MAX_PSK_LEN) == false) ||
-       (IsValidString(key3, MAX_PSK_LEN) == false) ||
-       (IsValidString(key4, MAX_PSK_LEN) == false))
-    {
-        SetLastCommand(CMD_MAX);
-        return false;
-    }
-
-    _snprintf_s(_buffer, sizeof(_buffer), "%s%d,%s,%s,%s%s", COMMAND[CMD_WEP_KEYS], keyIndex, key2, key3, key4, CMD_END);
-
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
-
-    SetLastCommand(CMD_WEP_KEYS, bRtn);
+    length = _nwParamsLength;
 
-    return bRtn;
+    return ((_nwParamsLength > 0) ? _nwParams : NULL);
 }
 
 
 /*!
- *  @brief  AuthMode
+ *  @brief  InvalidateNetworkParameters
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command configures the mode of security during the WLAN connection setup.
- *
- *  @param[in]  eAuthMode   - Authentication mode
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *      Drops the cached network parameters, so the next
+ *      #RS9110_UART_T::RefreshNetworkParameters asks the module again.
  */
-bool RS9110_UART::AuthMode (EAuthMode eAuthMode)
+void RS9110_UART_Base::InvalidateNetworkParameters ()
 {
-    return GenericCommandInt(CMD_AUTH_MODE, eAuthMode);
+    _nwParamsLength = 0;
 }
 
 
 /*!
- *  @brief  Join
+ *  @brief  IsRetryPending
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to join a network.
- *
- *  @param[in]  ssid        - SSID
- *  @param[in]  eTxRate     - Transmit Power level
- *  @param[in]  eTxPower    - Rate at which the data has to be transmitted
+ *      Checks whether a command rejected for pacing is waiting to be written
+ *      again by #RS9110_UART_T::Poll.
  *
  *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
  */
-bool RS9110_UART::Join (const char *ssid, ETxRate eTxRate, ETxPower eTxPower)
+bool RS9110_UART_Base::IsRetryPending ()
 {
-    bool bRtn;
-
-
-    if(IsValidString(ssid, MAX_SSID_LEN) == false)
-    {
-        SetLastCommand(CMD_MAX);
-        return false;
-    }
-
-    _snprintf_s(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_JOIN], ssid, eTxRate, eTxPower, CMD_END);
-
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
-
-    SetLastCommand(CMD_JOIN, bRtn);
-
-    return bRtn;
+    return _isRetryPending;
 }
 
 
 /*!
- *  @brief  Disassociate
+ *  @brief  SetLastCommand
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is issued to request the module to disassociate (disconnect)
- *      from an Access Point.
+ *      Help method to assign values to multiple variables.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  command         - Command to be sent
+ *  @param[in]  isTransmitted   - Was it transmitted thru the persistor?
  */
-bool RS9110_UART::Disassociate ()
+void RS9110_UART_Base::SetLastCommand (ECommand command, bool isTransmitted)
 {
-    return GenericCommand(CMD_DISASSOCIATE);
+	_lastCommand    = ((isTransmitted == true) ? command : CMD_MAX);
+    _responseType   = RESP_TYPE_MAX;
+    _responseLength = 0;
+    _isRetryPending = false;
 }
 
 
 /*!
- *  @brief  PowerMode
+ *  @brief  SetLastCommand
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command configures the power mode.
- *
- *  @param[in]  powerMode   - Power mode
+ *      Parses the begginig of the incoming message looking for the type of message.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  message - Incoming message
  */
-bool RS9110_UART::PowerMode	(EPowerMode powerMode)
+void RS9110_UART_Base::ProcessResponseType (const char *message)
 {
-	return GenericCommandInt(CMD_POWER_MODE, powerMode);
-}
-
-
-/*!
- *  @brief  KeepSleeping
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This is not actually a command. This is an ACK to the module which must be sent as a response to the
- *      #RESP_TYPE_SLEEP response type. Sending this message back to the module makes it go to sleep again.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::KeepSleeping ()
-{
-	return GenericCommand(CMD_KEEP_SLEEPING);
-}
-
-
-/*!
- *  @brief  SetSleepTimer
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command configures the sleep timer which is used in Power Mode 1 when
- *      the module has not established the Wi-Fi connection.
- *
- *  @param[in]  milliseconds    - Time the module goes to sleep
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::SetSleepTimer (unsigned int milliseconds)
-{
-	if((milliseconds == 0) || (milliseconds > MAX_SLEEP_TIME_MS))
+    if(strstr(message, CMD_RESP_OK) == message)
+    {
+        _responseType = RESP_TYPE_OK;
+    }
+    else if(strstr(message, CMD_RESP_ERROR) == message)
+    {
+        _responseType = RESP_TYPE_ERROR;
+    }
+    else if(strstr(message, CMD_RESP_READ) == message)
+    {
+        _responseType = RESP_TYPE_READ;
+    }
+    else if(strstr(message, CMD_RESP_CLOSE) == message)
+    {
+        _responseType = RESP_TYPE_CLOSE;
+    }
+	else if(strstr(message, CMD_RESP_SLEEP) == message)
 	{
-		//_lastCommand = CMD_MAX;
-        //_responseType = RESP_TYPE_MAX;
-        SetLastCommand(CMD_MAX);
-		return false;
+		_responseType = RESP_TYPE_SLEEP;
 	}
-
-	return GenericCommandInt(CMD_SLEEP_TIMER, milliseconds);
+    else
+    {
+        _responseType = RESP_TYPE_MAX;
+    }
 }
 
 
 /*!
- *  @brief  SetFeatureSelect
+ *  @brief  Transmitted
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to enable some configurable features.
+ *      Updates the counters, the trace ring and the energy meter once a command
+ *      has been written thru the persistor, and remembers its length in case it
+ *      has to be written again.
  *
- *  @param[in]  value   - Configurable features
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  command     - Command type
+ *  @param[in]  size        - Length of the command (in bytes)
+ *  @param[in]  socketId    - Socket handle the command refers to (0 if none)
  */
-bool RS9110_UART::SetFeatureSelect (TFeatureSelect value)
+void RS9110_UART_Base::Transmitted (ECommand command, unsigned int size, unsigned char socketId)
 {
-    return GenericCommandInt(CMD_FEATURE_SELECT, (unsigned int) value.value);
-}
-
+    _counters.bytesWritten += size;
+    _commandLength          = size;
+    _commandSocketId        = socketId;
 
-/*!
- *  @brief  IPConfiguration
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command configures the IP address, subnet mask and default gateway of the TCP/IP stack.
- *
- *  @param[in]  eDHCPMode   - IP address in manual or DHCP mode
- *  @param[in]  ipAddr      - IP address in dotted decimal format
- *  @param[in]  subNetwork  - Subnet mask in dotted decimal format
- *  @param[in]  gateway     - Gateway in the dotted decimal format
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::IPConfiguration (EDHCPMode eDHCPMode, const char *ipAddr, const char *subNetwork, const char *gateway)
-{
-	bool bRtn = false;
+    if(_trace != NULL)
+    {
+        _trace->Record(RS9110_Trace::EVENT_TX, command, socketId, (unsigned short) size);
+    }
 
+    if(_energy != NULL)
+    {
+        unsigned char powerMode = 0;
 
-	switch(eDHCPMode)
-	{
-		case DHCP_MANUAL:
-			if((IsValidString(ipAddr)		== false) ||
-			   (IsValidString(subNetwork)	== false) ||
-			   (IsValidString(gateway)		== false))
-			{
-                SetLastCommand(CMD_MAX);
-			}
-			else
-			{
-				_snprintf_s(_buffer, sizeof(_buffer), "%s%d,%s,%s,%s%s", COMMAND[CMD_IP_CONF], eDHCPMode, ipAddr, subNetwork, gateway, CMD_END);
-
-				bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
-
-                SetLastCommand(CMD_IP_CONF, bRtn);
-			}
-		break;
-
-		case DHCP_DHCP:
-			_snprintf_s(_buffer, sizeof(_buffer), "%s%d,0,0%s", COMMAND[CMD_IP_CONF], eDHCPMode, CMD_END);
-
-			bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
-
-            SetLastCommand(CMD_IP_CONF, bRtn);
-		break;
-
-		default:
-            SetLastCommand(CMD_MAX);
-		break;
-	}
+        /* "AT+RSI_PWMODE=<mode>" is still in the buffer */
+        if(command == CMD_POWER_MODE)
+        {
+            powerMode = (unsigned char) (_buffer[strlen(COMMAND[CMD_POWER_MODE])] - '0');
+        }
 
-	return bRtn;
+        _energy->Transmitted(command, size, powerMode);
+    }
 }
 
 
 /*!
- *  @brief  OpenTcpSocket
+ *  @brief  Pace
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command opens a client TCP socket and attempts to connect it to the
- *      specified "port" on a server defined by "host".
- *
- *  @param[in]  hostIpAddr  - Destination IP Address of the target server
- *  @param[in]  targetPort  - The target port
- *  @param[in]  localPort   - Local Port on the RS9110-N-11-2X module (allowed range #MIN_TCP_SOCKET_PORT to #MAX_TCP_SOCKET_PORT)
+ *      Holds a command back as long as the pacer (if any) requires. Called right
+ *      before the command is written.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  command     - Command type
  */
-bool RS9110_UART::OpenTcpSocket (const char *hostIpAddr, unsigned short targetPort, unsigned short localPort)
+void RS9110_UART_Base::Pace (ECommand command)
 {
-	bool bRtn;
-
-
-	if((IsValidString(hostIpAddr) == false) || (IsValidLocalTcpPort(localPort) == false))
-	{
-        SetLastCommand(CMD_MAX);
-		return false;
-	}
-
-	_snprintf_s(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_OPEN_TCP_SOCKET], hostIpAddr, targetPort, localPort, CMD_END);
-
-	bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
-
-    SetLastCommand(CMD_OPEN_TCP_SOCKET, bRtn);
-
-	return bRtn;
+    if(_pacer != NULL)
+    {
+        _pacer->Hold(command);
+    }
 }
 
 
 /*!
- *  @brief  OpenListeningUdpSocket
+ *  @brief  IsRetryDue
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command opens a User Datagram Protocol (UDP) socket and binds to a specified port.
- *
- *  @param[in]  localPort   - Local port on the module
+ *      Checks whether the command rejected for pacing may be written again now.
  *
  *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
  */
-bool RS9110_UART::OpenListeningUdpSocket  (unsigned short localPort)
+bool RS9110_UART_Base::IsRetryDue ()
 {
-    return GenericCommandInt(CMD_OPEN_LUDP_SOCKET, localPort);
+    return ((_isRetryPending == true) && ((_pacer == NULL) || (_pacer->GetWait(_lastCommand) == 0)));
 }
 
 
 /*!
- *  @brief  OpenUdpSocket
+ *  @brief  AbandonRetry
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command opens a User Datagram Protocol (UDP) socket and links to the
- *      remote system's specific host and port address.
- *
- *  @param[in]  hostIpAddr   - IP Address of the Target server
- *  @param[in]  targetPort   - Target port (0 to 65535)
- *  @param[in]  localPort    - Local port on the module
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *      Reports the rejection of a command that could not be written again as
+ *      its answer.
  */
-bool RS9110_UART::OpenUdpSocket (const char *hostIpAddr, unsigned short targetPort, unsigned short localPort)
+void RS9110_UART_Base::AbandonRetry ()
 {
-	bool bRtn;
-
-
-	if(IsValidString(hostIpAddr) == false)
-	{
-        SetLastCommand(CMD_MAX);
-		return false;
-	}
-
-	_snprintf_s(_buffer, sizeof(_buffer), "%s%s,%d,%d%s", COMMAND[CMD_OPEN_UDP_SOCKET], hostIpAddr, targetPort, localPort, CMD_END);
-
-	bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+    _isRetryPending = false;
+    _responseType   = RESP_TYPE_ERROR;
+    _errorCode      = ERROR_CMD_TOO_FAST;
+    _responseLength = 0;
 
-    SetLastCommand(CMD_OPEN_UDP_SOCKET, bRtn);
+    ExpectClose(0);
 
-	return bRtn;
+    if(_energy != NULL)
+    {
+        _energy->Received(_responseType, _lastCommand);
+    }
 }
 
 
 /*!
- *  @brief  OpenListeningTcpSocket
+ *  @brief  CountError
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This commands opens a TCP listening socket on the local IP address and
- *      the specified "port".
+ *      Increases the counter of the given error code. Codes are stored in order of
+ *      first occurrence; once all the slots are used, #TCounters::otherErrors is increased.
  *
- *  @param[in]  localPort    - Local port on the module
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  eErrorCode  - Error code received
  */
-bool RS9110_UART::OpenListeningTcpSocket  (unsigned short localPort)
+void RS9110_UART_Base::CountError (EErrorCode eErrorCode)
 {
-    return GenericCommandInt(CMD_OPEN_LTCP_SOCKET, localPort);
+    for(unsigned char i = 0; i < MAX_ERROR_COUNTERS; i++)
+    {
+        if(_counters.errors[i].count == 0)
+        {
+            _counters.errors[i].code = (unsigned char) eErrorCode;
+        }
+
+        if(_counters.errors[i].code == (unsigned char) eErrorCode)
+        {
+            _counters.errors[i].count++;
+            return;
+        }
+    }
+
+    _counters.otherErrors++;
 }
 
 
 /*!
- *  @brief  GetSocketStatus
+ *  @brief  ExpectSocket
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command retrieves handles of active socket connections established
- *      through the listening socket.
- *
- *  @param[in]  socketId    - TCP listening socket handle for an already open listening socket in the module
+ *      Keeps the parameters of the socket being opened until the module answers
+ *      with its handle.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  socketType  - Socket type
+ *  @param[in]  hostIpAddr  - Remote IP address in dotted decimal format (NULL if none)
+ *  @param[in]  remotePort  - Remote port (0 if none)
+ *  @param[in]  localPort   - Local port
  */
-bool RS9110_UART::GetSocketStatus (unsigned char socketId)
+void RS9110_UART_Base::ExpectSocket (ESocketType socketType, const char *hostIpAddr, unsigned short remotePort, unsigned short localPort)
 {
-	if(IsValidSocketId(socketId) == false)
-	{
-        SetLastCommand(CMD_MAX);
-		return false;
-	}
+    memset(&_pendingSocket, 0, sizeof(_pendingSocket));
+
+    _pendingSocket.type         = (unsigned char) socketType;
+    _pendingSocket.localPort    = localPort;
+    _pendingSocket.remotePort   = remotePort;
 
-    return GenericCommandInt(CMD_GET_SOCKET_STATUS, socketId);
+    if(ParseAddress(hostIpAddr, _pendingSocket.remoteAddress) == false)
+    {
+        memset(_pendingSocket.remoteAddress, 0, sizeof(_pendingSocket.remoteAddress));
+    }
 }
 
 
 /*!
- *  @brief  CloseSocket
+ *  @brief  ExpectClose
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command closes a TCP/UDP socket in the module.
+ *      Keeps the handle of the socket being closed until the module answers.
  *
- *  @param[in]  socketId    - Socket handle of an already open socket
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  socketId    - Socket handle
  */
-bool RS9110_UART::CloseSocket (unsigned char socketId)
+void RS9110_UART_Base::ExpectClose (unsigned char socketId)
 {
-	if(IsValidSocketId(socketId) == false)
-	{
-        SetLastCommand(CMD_MAX);
-		return false;
-	}
+    memset(&_pendingSocket, 0, sizeof(_pendingSocket));
 
-    return GenericCommandInt(CMD_CLOSE_SOCKET, socketId);
+    _pendingSocket.id   = socketId;
+    _pendingSocket.type = SOCKET_MAX;
 }
 
 
 /*!
- *  @brief  CloseSocket
+ *  @brief  UpdateSocketTable
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command sends a byte stream to the socket specified by the socket handle.
- *
- *  @param[in]  socketId    - Socket handle of an already open socket
- *  @param[in]  socketType  - Socket type
- *  @param[in]  hostIpAddr  - Destination IP Address
- *  @param[in]  hostPort    - Destination Port
- *  @param[in]  data        - Byte stream
- *  @param[in]  dataSize    - Length of the byte stream
+ *      Applies a valid incoming message to the socket table:
+ *      - OK to an open command: the handle returned gets the pending parameters.
+ *      - OK to CloseSocket, unsolicited "AT+RSI_CLOSE<hn>": the handle is released.
+ *      - OK to GetSocketStatus: remote address and port of the connection.
+ *      - OK to Reset/Disassociate: every socket is released.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  message     - Incoming message
+ *  @param[in]  size        - Size of the incoming message (in bytes)
  */
-unsigned int RS9110_UART::Send (unsigned char socketId, ESocketType socketType, const char *hostIpAddr, unsigned short hostPort, const char *data, unsigned int dataSize)
+void RS9110_UART_Base::UpdateSocketTable (const char *message, int size)
 {
-	bool         bRtn;
-    unsigned int sendLen;
-    unsigned int maxDataLen;
+    const unsigned char *response = (const unsigned char *) _buffer;
+    unsigned char        socketId;
+    TSocketInfo         *entry;
 
 
-    if(IsValidSocketId(socketId) == false)
+    switch(_responseType)
     {
-        SetLastCommand(CMD_MAX);
-        return 0;
-    }
+        case RESP_TYPE_OK:
+            switch(_lastCommand)
+            {
+                case CMD_OPEN_TCP_SOCKET:
+                case CMD_OPEN_LUDP_SOCKET:
+                case CMD_OPEN_UDP_SOCKET:
+                case CMD_OPEN_LTCP_SOCKET:
+                    socketId = response[0];
+
+                    if((_pendingSocket.type != SOCKET_MAX) &&
+                       (_responseLength >= (int) sizeof(TSocket)) &&
+                       (IsValidSocketId(socketId) == true))
+                    {
+                        CloseSocketEntry(socketId);
+
+                        entry = FindSocketEntry(0);
+
+                        if(entry != NULL)
+                        {
+                            memcpy(entry, &_pendingSocket, sizeof(TSocketInfo));
+                            entry->id = socketId;
+                        }
+
+                        _openSockets |= (unsigned char) (1 << (socketId - MIN_SOCKET_HANDLE));
+                        _numOpenSockets++;
+                    }
+                break;
+
+                case CMD_CLOSE_SOCKET:
+                    CloseSocketEntry(_pendingSocket.id);
+                break;
+
+                case CMD_GET_SOCKET_STATUS:
+                    socketId = response[0];
+
+                    entry    = ((IsSocketOpen(socketId) == true) ? FindSocketEntry(socketId) : NULL);
+
+                    if((_responseLength >= (int) sizeof(TSocketStatus)) && (entry != NULL))
+                    {
+                        const TSocketStatus *status = (const TSocketStatus *) _buffer;
+                        const unsigned char *port   = (const unsigned char *) &status->port;
+
+                        memcpy(entry->remoteAddress, status->address, sizeof(entry->remoteAddress));
+                        entry->remotePort = (unsigned short) ((port[0] << 8) | port[1]);
+                    }
+                break;
+
+                case CMD_RESET:
+                case CMD_DISASSOCIATE:
+                    ResetSocketTable();
+                break;
+
+                default:
+                    /* Nothing to do */
+                break;
+            }
 
-    /* Command and Parameters */
-    switch(socketType)
-    {
-        case SOCKET_TCP:
-            _snprintf_s(_buffer, sizeof(_buffer), "%s%d,0,0,0,", COMMAND[CMD_SEND_DATA], socketId);
-            maxDataLen = MAX_SEND_DATA_SIZE_TCP;
+            ExpectClose(0);
         break;
 
-        case SOCKET_UDP:
-            _snprintf_s(_buffer, sizeof(_buffer), "%s%d,0,%s,%d,", COMMAND[CMD_SEND_DATA], socketId, hostIpAddr, hostPort);
-            maxDataLen = MAX_SEND_DATA_SIZE_UDP;
+        case RESP_TYPE_ERROR:
+            ExpectClose(0);
+        break;
+
+        case RESP_TYPE_CLOSE:
+            if(size > (CMD_RESP_CLOSE_LEN + CMD_END_LEN))
+            {
+                CloseSocketEntry((unsigned char) message[CMD_RESP_CLOSE_LEN]);
+            }
         break;
 
         default:
-            SetLastCommand(CMD_MAX);
-            return 0;
+            /* Nothing to do */
         break;
     }
-
-    /* Fill data after byte stuffing */
-    unsigned int destSize = maxDataLen;
-    unsigned int hdr = strlen(_buffer);
-    sendLen = SendByteStuffing(&_buffer[strlen(_buffer)], destSize, data, dataSize);
-
-    /* End of Command */
-    _snprintf(&_buffer[hdr + destSize], sizeof(_buffer), "%s", CMD_END);
-
-	bRtn = _persistor->Write((unsigned char *) _buffer, (hdr + destSize + strlen(CMD_END)));
-
-    SetLastCommand(CMD_SEND_DATA, bRtn);
-
-    return sendLen;
 }
 
 
 /*!
- *  @brief  GetDNS
+ *  @brief  UpdateNetworkParameters
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to send the domain name of a website to the module
- *      to resolve the IP address.
- *
- *  @param[in]  domainName  - Domain name of the target website
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *      Stores the answer to "AT+RSI_NWPARAMS?" or invalidates it when a valid
+ *      incoming message shows that the parameters may have changed.
  */
-bool RS9110_UART::GetDNS (const char *domainName)
+void RS9110_UART_Base::UpdateNetworkParameters ()
 {
-    if(IsValidString(domainName) == false)
+    switch(_responseType)
     {
-        SetLastCommand(CMD_MAX);
-        return false;
-    }
+        case RESP_TYPE_OK:
+            switch(_lastCommand)
+            {
+                case CMD_GET_NETWORK_PARAMS:
+                    /* Never cached truncated */
+                    if((_responseLength > 0) && (_responseLength <= (int) sizeof(_nwParams)))
+                    {
+                        _nwParamsLength = _responseLength;
+                        memcpy(_nwParams, _buffer, _nwParamsLength);
+                    }
+                    else
+                    {
+                        InvalidateNetworkParameters();
+                    }
+                break;
+
+                case CMD_INIT:
+                case CMD_JOIN:
+                case CMD_DISASSOCIATE:
+                case CMD_FEATURE_SELECT:
+                case CMD_IP_CONF:
+                case CMD_OPEN_TCP_SOCKET:
+                case CMD_OPEN_LUDP_SOCKET:
+                case CMD_OPEN_UDP_SOCKET:
+                case CMD_OPEN_LTCP_SOCKET:
+                case CMD_CLOSE_SOCKET:
+                case CMD_RESET:
+                    InvalidateNetworkParameters();
+                break;
+
+                default:
+                    /* Nothing to do */
+                break;
+            }
+        break;
 
-    return GenericCommandStr(CMD_GET_DNS, domainName);
-}
+        case RESP_TYPE_ERROR:
+            if((_lastCommand == CMD_JOIN) ||
+               (_errorCode == ERROR_DEAUTH_FROM_AP) ||
+               (_errorCode == ERROR_IP_EXPIRED))
+            {
+                InvalidateNetworkParameters();
+            }
+        break;
 
+        case RESP_TYPE_CLOSE:
+            InvalidateNetworkParameters();
+        break;
 
-/*!
- *  @brief  GetFirmwareVersion
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command is used to retrieve the firmware version in the module.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::GetFirmwareVersion ()
-{
-    return GenericCommand(CMD_FW_VERSION);
+        default:
+            /* Nothing to do */
+        break;
+    }
 }
 
 
 /*!
- *  @brief  GetNetworkParameters
+ *  @brief  CloseSocketEntry
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to retrieve the WLAN connection and IP parameters.
+ *      Releases an entry of the socket table (if open).
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  socketId    - Socket handle
  */
-bool RS9110_UART::GetNetworkParameters ()
+void RS9110_UART_Base::CloseSocketEntry (unsigned char socketId)
 {
-    return GenericCommand(CMD_GET_NETWORK_PARAMS);
-}
+    TSocketInfo *entry;
 
 
-/*!
- *  @brief  Reset
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command acts as a software reset to the module.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::Reset ()
-{
-    return GenericCommand(CMD_RESET);
-}
+    if(IsSocketOpen(socketId) == false)
+    {
+        return;
+    }
 
+    entry = FindSocketEntry(socketId);
 
-/*!
- *  @brief  GetMACAddress
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command is used to retrieve the MAC address of the module.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::GetMACAddress ()
-{
-    return GenericCommand(CMD_GET_MAC);
-}
-
+    if(entry != NULL)
+    {
+        memset(entry, 0, sizeof(TSocketInfo));
+    }
 
-/*!
- *  @brief  GetRSSI
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command is used to get the signal strength of the Access Point or
- *      network that the module is connected to.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::GetRSSI ()
-{
-    return GenericCommand(CMD_GET_RSSI);
+    _openSockets &= (unsigned char) ~(1 << (socketId - MIN_SOCKET_HANDLE));
+    _numOpenSockets--;
 }
 
 
 /*!
- *  @brief  SaveConfiguration
+ *  @brief  FindSocketEntry
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to save the parameters of an access point to internal memory.
+ *      Looks for the entry of the socket table holding a handle.
  *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @param[in]  socketId    - Socket handle (0 to get a free entry)
+ *
+ *  @return Entry (NULL if none)
  */
-bool RS9110_UART::SaveConfiguration ()
+RS9110_UART_Base::TSocketInfo * RS9110_UART_Base::FindSocketEntry (unsigned char socketId)
 {
-    return GenericCommand(CMD_SAVE_CONFIG);
+    for(unsigned char i = 0; i < MAX_NUMBER_SOCKETS; i++)
+    {
+        if(_sockets[i].id == socketId)
+        {
+            return &_sockets[i];
+        }
+    }
+
+    return NULL;
 }
 
 
 /*!
- *  @brief  Configuration
+ *  @brief  ParseAddress
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      This command is used to enable or disable the feature of automatic joining
- *      to a pre-configured Access Point on power up.
+ *      Converts an IP address in dotted decimal format (i.e. "192.168.1.10")
+ *      into #NW_ADDRESS_LEN bytes.
  *
- *  @pram[in]   eConfig - Enable/Disable the auto-join
+ *  @param[in]  string  - IP address in dotted decimal format
+ *  @param[out] address - Array of #NW_ADDRESS_LEN bytes
  *
  *  @return bool
  *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
+ *  @retval false   - NULL or malformed address
  */
-bool RS9110_UART::Configuration (EConfiguration eConfig)
+bool RS9110_UART_Base::ParseAddress (const char *string, unsigned char *address)
 {
-    if(eConfig >= CONFIG_MAX)
+    unsigned int value;
+    unsigned int digits;
+
+
+    if(string == NULL)
     {
-        SetLastCommand(CMD_MAX);
         return false;
     }
 
-    return GenericCommandInt(CMD_ENABLE_CONFIG, eConfig);
-}
+    for(unsigned char i = 0; i < NW_ADDRESS_LEN; i++)
+    {
+        value  = 0;
+        digits = 0;
 
+        while((*string >= '0') && (*string <= '9') && (digits < 3))
+        {
+            value = (value * 10) + (*string++ - '0');
+            digits++;
+        }
 
-/*!
- *  @brief  GetConfiguration
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      This command is used to get the configuration values that have been
- *      stored in the module's memory.
- *
- *  @return bool
- *  @retval true    - OK
- *  @retval false   - Wrong argument or command not sent
- */
-bool RS9110_UART::GetConfiguration ()
-{
-    return GenericCommand(CMD_GET_CONFIG);
-}
+        if((digits == 0) || (value > 255))
+        {
+            return false;
+        }
 
+        address[i] = (unsigned char) value;
 
-/*!
- *  @brief  SetLastCommand
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      Help method to assign values to multiple variables.
- *
- *  @param[in]  command         - Command to be sent
- *  @param[in]  isTransmitted   - Was it transmitted thru the persistor?
- */
-void RS9110_UART::SetLastCommand (ECommand command, bool isTransmitted)
-{
-	_lastCommand    = ((isTransmitted == true) ? command : CMD_MAX);
-    _responseType   = RESP_TYPE_MAX;
-    _responseLength = 0;
+        if(*string != (((i + 1) < NW_ADDRESS_LEN) ? '.' : '\0'))
+        {
+            return false;
+        }
+
+        string++;
+    }
+
+    return true;
 }
 
 
 /*!
- *  @brief  SetLastCommand
+ *  @brief  IsValidString
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Parses the begginig of the incoming message looking for the type of message.
+ *      Checks whether the string (byte array zero-ended) is valid. That means the
+ *      string is not NULL, is not empty and its length is not larger than
+ *      the maximum (this last is optional).
  *
- *  @param[in]  message - Incoming message
+ *  @param[in]  string - String to analyze
+ *  @param[in]  maxLen - Maximum length
+ *
+ *  @return bool
  */
-void RS9110_UART::ProcessResponseType (const char *message)
+bool RS9110_UART_Base::IsValidString (const char *string, int maxLen)
 {
-    if(strstr(message, CMD_RESP_OK) == message)
-    {
-        _responseType = RESP_TYPE_OK;
-    }
-    else if(strstr(message, CMD_RESP_ERROR) == message)
-    {
-        _responseType = RESP_TYPE_ERROR;
-    }
-    else if(strstr(message, CMD_RESP_READ) == message)
-    {
-        _responseType = RESP_TYPE_READ;
-    }
-    else if(strstr(message, CMD_RESP_CLOSE) == message)
+    bool bRtn = true;
+
+
+    if(maxLen < 0)
     {
-        _responseType = RESP_TYPE_CLOSE;
+        if((string == NULL) || (strlen(string) == 0))
+        {
+            bRtn = false;
+        }
     }
-	else if(strstr(message, CMD_RESP_SLEEP) == message)
-	{
-		_responseType = RESP_TYPE_SLEEP;
-	}
     else
     {
-        _responseType = RESP_TYPE_MAX;
+	    if((string == NULL) || (strlen(string) == 0) || (((int) strlen(string)) > maxLen))
+	    {
+		    bRtn = false;
+	    }
     }
+
+	return bRtn;
 }
 
 
 /*!
- *  @brief  IsValidSocketId
+ *  @brief  GetMaxSendSize
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Checks whether the socket is within the valid values
- *      (Min = #MIN_SOCKET_HANDLE, Max = #MAX_SOCKET_HANDLE).
+ *      Returns the room left for the stuffed payload of an "AT+RSI_SND" with
+ *      the given header: #MAX_SEND_DATA_SIZE_TCP or #MAX_SEND_DATA_SIZE_UDP,
+ *      limited by what fits in the buffer. Send() stops stuffing when less than
+ *      2 bytes are left, so a payload stuffed to this size may not fit whole.
  *
- *  @param[in]  socketId - Socket handle
+ *  @param[in]  socketId    - Socket handle
+ *  @param[in]  socketType  - SOCKET_TCP or SOCKET_UDP
+ *  @param[in]  hostIpAddr  - Destination IP Address (UDP only)
+ *  @param[in]  hostPort    - Destination Port (UDP only)
  *
- *  @return bool
+ *  @return unsigned int (0 if wrong socket type)
  */
-inline bool RS9110_UART::IsValidSocketId (unsigned char socketId)
+unsigned int RS9110_UART_Base::GetMaxSendSize (unsigned char socketId, ESocketType socketType, const char *hostIpAddr, unsigned short hostPort)
 {
-    return ((socketId >= MIN_SOCKET_HANDLE) && (socketId <= MAX_SOCKET_HANDLE));
-}
+    char            header[64];
+    unsigned int    maxDataLen;
+    unsigned int    hdr;
 
 
-/*!
- *  @brief  IsValidLocalTcpPort
- *
- *  @details
- *  <b>Details:</b><p>
- *
- *      Checks whether the TCP port is within the valid values
- *      (Min = #MIN_TCP_SOCKET_PORT, Max = #MAX_TCP_SOCKET_PORT).
- *
- *  @param[in]  socketId - Socket handle
- *
- *  @return bool
- */
-inline bool RS9110_UART::IsValidLocalTcpPort (unsigned short port)
-{
-    return ((port >= MIN_TCP_SOCKET_PORT) && (port <= MAX_TCP_SOCKET_PORT));
+    switch(socketType)
+    {
+        case SOCKET_TCP:
+            Format(header, sizeof(header), "%s%d,0,0,0,", COMMAND[CMD_SEND_DATA], socketId);
+            maxDataLen = MAX_SEND_DATA_SIZE_TCP;
+        break;
+
+        case SOCKET_UDP:
+            Format(header, sizeof(header), "%s%d,0,%s,%d,", COMMAND[CMD_SEND_DATA], socketId,
+                        (hostIpAddr != NULL) ? hostIpAddr : "", hostPort);
+            maxDataLen = MAX_SEND_DATA_SIZE_UDP;
+        break;
+
+        default:
+            return 0;
+        break;
+    }
+
+    hdr = strlen(header);
+
+    if(maxDataLen > (MAX_BUFFER_SIZE - hdr - CMD_END_LEN))
+    {
+        maxDataLen = MAX_BUFFER_SIZE - hdr - CMD_END_LEN;
+    }
+
+    return maxDataLen;
 }
 
 
 /*!
- *  @brief  GenericCommand
+ *  @brief  CountEscapedBytes
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Generic command sender. No arguments are nedded.
- *      i.e. "AT+RSI_RESET\r\n"
+ *      Counts the 0xDB bytes of a word without branching: every byte equal to
+ *      0xDB becomes 0 and then gets its highest bit set (other bytes get it
+ *      cleared), the bits being added up by the final multiplication.
  *
- *  @param[in]  command - Command type
+ *  @param[in]  source  - #STUFFING_WORD_LEN bytes (any alignment)
  *
- *  @return bool
+ *  @return unsigned int
  */
-bool RS9110_UART::GenericCommand (ECommand command)
+static unsigned int CountEscapedBytes (const char *source)
 {
-    bool bRtn;
+    unsigned int word;
+    unsigned int match;
 
 
-    _snprintf_s(_buffer, sizeof(_buffer), "%s%s", COMMAND[command], CMD_END);
+    memcpy(&word, source, STUFFING_WORD_LEN);
 
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+    word   ^= 0xDBDBDBDBU;
+    match   = ~((((word & 0x7F7F7F7FU) + 0x7F7F7F7FU) | word) | 0x7F7F7F7FU);
 
-    SetLastCommand(command, bRtn);
-
-    return bRtn;
+    return (((match >> 7) * 0x01010101U) >> 24);
 }
 
 
 /*!
- *  @brief  GenericCommandInt
+ *  @brief  GetStuffedSize
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Generic command sender. Integer value is needed as argument.
- *      i.e. "AT+RSI_CTCP=1\r\n"
+ *      Returns the length of a byte stream after byte stuffing, without
+ *      writing anything. Every 0xDB takes 2 bytes; a 0x0D 0x0A pair takes
+ *      2 bytes either way.
  *
- *  @param[in]  command - Command type
- *  @param[in]  value   - Integer value
+ *  @param[in]  source  - Pointer to the source buffer/array
+ *  @param[in]  srcSize - Length of the data in the source buffer/array
  *
- *  @return bool
+ *  @return unsigned int
  */
-bool RS9110_UART::GenericCommandInt (ECommand command, int value)
+unsigned int RS9110_UART_Base::GetStuffedSize (const char *source, unsigned int srcSize)
 {
-    bool bRtn;
-
+    unsigned int size   = srcSize;
+    unsigned int pos    = 0;
 
-    _snprintf_s(_buffer, sizeof(_buffer), "%s%d%s", COMMAND[command], value, CMD_END);
 
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+    for(; (pos + STUFFING_WORD_LEN) <= srcSize; pos += STUFFING_WORD_LEN)
+    {
+        size += CountEscapedBytes(&source[pos]);
+    }
 
-    SetLastCommand(command, bRtn);
+    for(; pos < srcSize; pos++)
+    {
+        if(source[pos] == (char) 0xDB)
+        {
+            size++;
+        }
+    }
 
-    return bRtn;
+    return size;
 }
 
 
 /*!
- *  @brief  GenericCommandStr
+ *  @brief  FitByteStuffing
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Generic command sender. Byte array (zero-ended) is needed as argument.
- *      i.e. "AT+RSI_CTCP=1\r\n"
+ *      Works out what #SendByteStuffing would do with the same arguments,
+ *      without writing anything: the number of source bytes taken and the
+ *      length after byte stuffing. Given #GetMaxSendSize as dstSize, it is the
+ *      largest prefix Send() takes whole.
  *
- *  @param[in]  command - Command type
- *  @param[in]  str     - String argument
+ *      Whole words are taken while at least 2 bytes would be left after them
+ *      (a 0x0D 0x0A pair takes 2 bytes either way, so only the 0xDB count
+ *      matters), the last bytes go one by one as in #SendByteStuffing.
  *
- *  @return bool
+ *  @param[in,out]  dstSize     - Input as max length after byte stuffing. Output as length of the bytes taken after byte stuffing
+ *  @param[in]      source      - Pointer to the source buffer/array
+ *  @param[in]      srcSize     - Length of the data in the source buffer/array
+ *
+ *  @return unsigned int (source bytes taken)
  */
-bool RS9110_UART::GenericCommandStr (ECommand command, const char *str)
+unsigned int RS9110_UART_Base::FitByteStuffing (unsigned int &dstSize, const char *source, unsigned int srcSize)
 {
-    bool bRtn;
+    unsigned int pos        = 0;
+    unsigned int stuffed    = 0;
 
 
-    _snprintf_s(_buffer, sizeof(_buffer), "%s%s%s", COMMAND[command], str, CMD_END);
+    while((pos + STUFFING_WORD_LEN) <= srcSize)
+    {
+        unsigned int size = STUFFING_WORD_LEN + CountEscapedBytes(&source[pos]);
 
-    bRtn = _persistor->Write((unsigned char *) _buffer, strlen(_buffer));
+        if((stuffed + size + 2) > dstSize)
+        {
+            break;
+        }
 
-    SetLastCommand(command, bRtn);
+        stuffed += size;
+        pos     += STUFFING_WORD_LEN;
+    }
 
-    return bRtn;
+    /* Second byte of a pair started by the last word */
+    if((pos > 0) && (pos < srcSize) && (source[pos - 1] == (char) 0x0D) && (source[pos] == (char) 0x0A))
+    {
+        stuffed++;
+        pos++;
+    }
+
+    while(((dstSize - stuffed) >= 2) && (pos < srcSize))
+    {
+        if(((srcSize - pos) >= 2) && (source[pos] == (char) 0x0D) && (source[pos + 1] == (char) 0x0A))
+        {
+            stuffed += 2;
+            pos     += 2;
+        }
+        else if(source[pos] == (char) 0xDB)
+        {
+            stuffed += 2;
+            pos++;
+        }
+        else
+        {
+            stuffed++;
+            pos++;
+        }
+    }
+
+    dstSize = stuffed;
+
+    return pos;
 }
 
 
 /*!
- *  @brief  IsValidString
+ *  @brief  Format
  *
  *  @details
  *  <b>Details:</b><p>
  *
- *      Checks whether the string (byte array zero-ended) is valid. That means the
- *      string is not NULL, is not empty and its length is not larger than
- *      the maximum (this last is optional).
+ *      snprintf() for every platform: the output is truncated to fit and is
+ *      always NUL terminated. Used by the driver and its companion classes
+ *      instead of per-file "_snprintf_s" macros.
  *
- *  @param[in]  string - String to analyze
- *  @param[in]  maxLen - Maximum length
+ *  @param[in]  destination - Pointer to the destination buffer
+ *  @param[in]  size        - Size of the destination buffer (in bytes)
+ *  @param[in]  format      - printf() format
  *
- *  @return bool
+ *  @return int (length written, negative if truncated or failed)
  */
-static bool IsValidString (const char *string, int maxLen)
+int RS9110_UART_Base::Format (char *destination, unsigned int size, const char *format, ...)
 {
-    bool bRtn = true;
+    va_list args;
+    int     length;
 
 
-    if(maxLen < 0)
+    if((destination == NULL) || (size == 0))
     {
-        if((string == NULL) || (strlen(string) == 0))
-        {
-            bRtn = false;
-        }
+        return -1;
     }
-    else
+
+    va_start(args, format);
+#if defined (WIN32)
+    length = _vsnprintf_s(destination, size, _TRUNCATE, format, args);
+#else
+    length = vsnprintf(destination, size, format, args);
+    destination[size - 1] = '\0';
+
+    if(length >= (int) size)
     {
-	    if((string == NULL) || (strlen(string) == 0) || (((int) strlen(string)) > maxLen))
-	    {
-		    bRtn = false;
-	    }
+        length = -1;
     }
+#endif /* WIN32 */
+    va_end(args);
 
-	return bRtn;
+    return length;
 }
 
 
@@ -1540,15 +1617,17 @@ static bool IsValidString (const char *string, int maxLen)
  *
  *  @return bool
  */
-static unsigned int SendByteStuffing (char *destination, unsigned int &dstSize, const char *source, unsigned int srcSize)
+unsigned int RS9110_UART_Base::SendByteStuffing (char *destination, unsigned int &dstSize, const char *source, unsigned int srcSize)
 {
 	const char *pos     = source;
     int         tmpSize = (int) dstSize;
 
 
+    RS9110_PROBE(stuffing_entry, srcSize, dstSize);
+
 	while((tmpSize >= 2) && (srcSize >= 1))
 	{
-		if((*pos == (char) 0x0D) && (*(pos+1) == (char) 0x0A))
+		if((srcSize >= 2) && (*pos == (char) 0x0D) && (*(pos+1) == (char) 0x0A))
 		{
 			*destination++ = (char) 0xDB;
 			*destination++ = (char) 0xDC;
@@ -1574,5 +1653,11 @@ static unsigned int SendByteStuffing (char *destination, unsigned int &dstSize,
 
     dstSize -= tmpSize;
 
+    RS9110_PROBE(stuffing_return, (pos - source), dstSize);
+
 	return ((unsigned int) (pos - source));
 }
+
+
+/* Driver bound to #IPersistor */
+template class RS9110_UART_T<IPersistor>;
@@ -6,7 +6,8 @@
 
 PersistorWin32Mock::PersistorWin32Mock ()
 {
-    buffer = new char[2000];
+    buffer      = new char[2000];
+    isFailing   = false;
 }
 
 
@@ -33,6 +34,11 @@ bool PersistorWin32Mock::Close ()
 
 bool PersistorWin32Mock::Write (unsigned char *data, unsigned int size)
 {
+    if(isFailing == true)
+    {
+        return false;
+    }
+
     memcpy(buffer, data, size);
     buffer[size] = '\0';
     bufferSize = size;
@@ -56,3 +62,9 @@ unsigned int PersistorWin32Mock::GetBufferSize ()
 {
     return bufferSize;
 }
+
+
+void PersistorWin32Mock::SetWriteFailure (bool isFailing)
+{
+    this->isFailing = isFailing;
+}
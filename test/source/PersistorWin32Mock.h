@@ -24,11 +24,14 @@ public:
 
     unsigned int GetBufferSize ();
 
+    void SetWriteFailure (bool isFailing);
+
 
 private:
 
     char           *buffer;
     unsigned int    bufferSize;
+    bool            isFailing;
 
 };
 
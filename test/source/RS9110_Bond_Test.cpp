@@ -0,0 +1,306 @@
+#pragma once
+
+#include "RS9110_Bond_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char           OK[]        = "OK\r\n";
+static const unsigned int   SND_HEADER  = 19;       /* "AT+RSI_SND=1,0,0,0," */
+static const unsigned int   READ_HEADER = 14;       /* "AT+RSI_READ" + socket + size */
+
+
+void RS9110_Bond_Test::setUp ()
+{
+    tx          = new RS9110_Bond();
+    rx          = new RS9110_Bond(Delivered, this);
+    streamSize  = 0;
+
+    for(unsigned char i = 0; i < NUM_LINKS; i++)
+    {
+        mockTx[i]   = new PersistorWin32Mock();
+        mockRx[i]   = new PersistorWin32Mock();
+        rsTx[i]     = new RS9110_UART(mockTx[i]);
+        rsRx[i]     = new RS9110_UART(mockRx[i]);
+
+        CPPUNIT_ASSERT(rsTx[i]->OpenTcpSocket("192.168.1.10", 8000, 1234) == true);
+        CPPUNIT_ASSERT(rsTx[i]->ProcessMessage("OK\x01\r\n", 5) == true);
+        CPPUNIT_ASSERT(rsRx[i]->OpenTcpSocket("192.168.1.10", 8000, 1234) == true);
+        CPPUNIT_ASSERT(rsRx[i]->ProcessMessage("OK\x01\r\n", 5) == true);
+
+        CPPUNIT_ASSERT(tx->AddLink(*rsTx[i], 1) == i);
+        CPPUNIT_ASSERT(rx->AddLink(*rsRx[i], 1) == i);
+    }
+}
+
+
+void RS9110_Bond_Test::tearDown ()
+{
+    delete tx;
+    delete rx;
+
+    for(unsigned char i = 0; i < NUM_LINKS; i++)
+    {
+        delete rsTx[i];
+        delete rsRx[i];
+        delete mockTx[i];
+        delete mockRx[i];
+    }
+}
+
+
+void RS9110_Bond_Test::Delivered (void *context, const char *data, unsigned int dataSize)
+{
+    RS9110_Bond_Test *test = (RS9110_Bond_Test *) context;
+
+
+    CPPUNIT_ASSERT((test->streamSize + dataSize) <= MAX_STREAM);
+    memcpy(&test->stream[test->streamSize], data, dataSize);
+    test->streamSize += dataSize;
+}
+
+
+void RS9110_Bond_Test::Answer (unsigned char link, const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(rsTx[link]->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(tx->ProcessResponse(link, nowMs) == true);
+}
+
+
+/* Acknowledges the chunk written on a link and hands it to the peer (in two READ frames if split) */
+void RS9110_Bond_Test::Forward (unsigned char link, unsigned long nowMs, unsigned int split)
+{
+    char            frame[READ_HEADER + RS9110_Bond::HEADER_LEN + RS9110_Bond::MAX_CHUNK + 2];
+    char            chunk[RS9110_Bond::HEADER_LEN + RS9110_Bond::MAX_CHUNK];
+    unsigned int    size    = mockTx[link]->GetBufferSize() - SND_HEADER - 2;
+    unsigned int    offset  = 0;
+
+
+    CPPUNIT_ASSERT(memcmp(mockTx[link]->GetBufferData(), "AT+RSI_SND=1,0,0,0,", SND_HEADER) == 0);
+    memcpy(chunk, &mockTx[link]->GetBufferData()[SND_HEADER], size);
+
+    Answer(link, OK, 4, nowMs);
+
+    while(offset < size)
+    {
+        unsigned int part = (((split > 0) && (offset == 0)) ? split : (size - offset));
+
+
+        memcpy(frame, "AT+RSI_READ\x01", 12);
+        frame[12] = (char) (part & 0xFF);
+        frame[13] = (char) (part >> 8);
+        memcpy(&frame[READ_HEADER], &chunk[offset], part);
+        memcpy(&frame[READ_HEADER + part], "\r\n", 2);
+
+        CPPUNIT_ASSERT(rsRx[link]->ProcessMessage(frame, READ_HEADER + part + 2) == true);
+        CPPUNIT_ASSERT(rx->ProcessResponse(link, nowMs) == true);
+
+        offset += part;
+    }
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Bond_Test);
+
+
+void RS9110_Bond_Test::StripeTest ()
+{
+    RS9110_Bond::TStats     stats;
+    RS9110_Bond::TLinkStats linkStats;
+    char                    data[1200];
+
+
+    for(unsigned int i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (char) ('A' + (i % 26));
+    }
+
+    /* Both links idle: one chunk each, then wait */
+    CPPUNIT_ASSERT(tx->Write(data, sizeof(data), 0) == 2 * RS9110_Bond::MAX_CHUNK);
+    CPPUNIT_ASSERT(tx->IsIdle() == false);
+    CPPUNIT_ASSERT(tx->Write(data, sizeof(data), 0) == 0);
+
+    /* The second chunk arrives first and is held */
+    Forward(1, 10);
+    CPPUNIT_ASSERT(streamSize == 0);
+    Forward(0, 20);
+    CPPUNIT_ASSERT(streamSize == 2 * RS9110_Bond::MAX_CHUNK);
+    CPPUNIT_ASSERT(tx->IsIdle() == true);
+
+    /* Link 1 answered faster, so it takes the rest (reassembled from two frames) */
+    CPPUNIT_ASSERT(tx->GetLinkStats(1, linkStats) == true);
+    CPPUNIT_ASSERT(linkStats.bytesPerSecond == ((RS9110_Bond::HEADER_LEN + RS9110_Bond::MAX_CHUNK) * 100));
+    CPPUNIT_ASSERT(tx->Write(&data[2 * RS9110_Bond::MAX_CHUNK], sizeof(data) - (2 * RS9110_Bond::MAX_CHUNK), 30) == 176);
+    Forward(1, 40, 3);
+
+    CPPUNIT_ASSERT(streamSize == sizeof(data));
+    CPPUNIT_ASSERT(memcmp(stream, data, sizeof(data)) == 0);
+
+    rx->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numDelivered == 3);
+    CPPUNIT_ASSERT(stats.numReordered == 1);
+    CPPUNIT_ASSERT(stats.maxHeld == 1);
+    CPPUNIT_ASSERT(stats.numOverflows == 0);
+
+    CPPUNIT_ASSERT(tx->GetLinkStats(1, linkStats) == true);
+    CPPUNIT_ASSERT(linkStats.numChunks == 2);
+    CPPUNIT_ASSERT(linkStats.numBytes == RS9110_Bond::MAX_CHUNK + 176);
+    CPPUNIT_ASSERT(tx->GetLinkStats(2, linkStats) == false);
+}
+
+
+void RS9110_Bond_Test::ThroughputTest ()
+{
+    static const unsigned long  LATENCY_MS[NUM_LINKS] = { 10, 30 };
+    RS9110_Bond::TStats         stats;
+    RS9110_Bond::TLinkStats     fast;
+    RS9110_Bond::TLinkStats     slow;
+    unsigned long               dueMs[NUM_LINKS] = { 0, 0 };
+    char                        block[RS9110_Bond::MAX_CHUNK];
+    unsigned int                numWritten = 0;
+
+
+    /* One letter per chunk, to check the order on the other side */
+    for(unsigned long nowMs = 1; nowMs < 400; nowMs++)
+    {
+        for(unsigned char i = 0; i < NUM_LINKS; i++)
+        {
+            if((dueMs[i] != 0) && (dueMs[i] <= nowMs))
+            {
+                Forward(i, nowMs);
+                dueMs[i] = 0;
+            }
+        }
+
+        memset(block, 'a' + (numWritten % 26), sizeof(block));
+
+        if((numWritten < (MAX_STREAM / sizeof(block))) && (tx->Write(block, sizeof(block), nowMs) == sizeof(block)))
+        {
+            numWritten++;
+        }
+
+        for(unsigned char i = 0; i < NUM_LINKS; i++)
+        {
+            CPPUNIT_ASSERT(tx->GetLinkStats(i, fast) == true);
+
+            if((fast.isBusy == true) && (dueMs[i] == 0))
+            {
+                dueMs[i] = nowMs + LATENCY_MS[i];
+            }
+        }
+    }
+
+    CPPUNIT_ASSERT(tx->IsIdle() == true);
+    CPPUNIT_ASSERT(streamSize == (numWritten * sizeof(block)));
+
+    for(unsigned int i = 0; i < numWritten; i++)
+    {
+        CPPUNIT_ASSERT(stream[i * sizeof(block)] == (char) ('a' + (i % 26)));
+    }
+
+    /* The fast link carries about three times more */
+    tx->GetLinkStats(0, fast);
+    tx->GetLinkStats(1, slow);
+    CPPUNIT_ASSERT(fast.bytesPerSecond > (2 * slow.bytesPerSecond));
+    CPPUNIT_ASSERT(fast.numChunks >= (2 * slow.numChunks));
+    CPPUNIT_ASSERT((fast.numChunks + slow.numChunks) == numWritten);
+
+    rx->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numOverflows == 0);
+    CPPUNIT_ASSERT(stats.numDelivered == numWritten);
+}
+
+
+void RS9110_Bond_Test::FailoverTest ()
+{
+    RS9110_Bond::TStats     stats;
+    RS9110_Bond::TLinkStats linkStats;
+
+
+    CPPUNIT_ASSERT(tx->Write("0123456789", 10, 0) == 10);
+    CPPUNIT_ASSERT(tx->Write("abcdefghij", 10, 0) == 10);
+
+    /* Paced: sent again on the same link */
+    Answer(0, "ERROR\x40\r\n", 8, 5);
+    CPPUNIT_ASSERT(tx->GetLinkStats(0, linkStats) == true);
+    CPPUNIT_ASSERT(linkStats.isUp == true);
+    CPPUNIT_ASSERT(linkStats.isBusy == true);
+    CPPUNIT_ASSERT(memcmp(&mockTx[0]->GetBufferData()[SND_HEADER], "\x00\x00\x00\x00\x00\x0A" "0123456789", 16) == 0);
+
+    /* Link 0 fails: its chunk waits for link 1 */
+    Answer(0, "ERROR\xFA\r\n", 8, 10);
+    CPPUNIT_ASSERT(tx->GetLinkStats(0, linkStats) == true);
+    CPPUNIT_ASSERT(linkStats.isUp == false);
+    CPPUNIT_ASSERT(linkStats.numFailed == 2);
+    CPPUNIT_ASSERT(tx->Write("KLMNOPQRST", 10, 10) == 0);
+    CPPUNIT_ASSERT(tx->IsIdle() == false);
+
+    Forward(1, 20);
+    CPPUNIT_ASSERT(memcmp(&mockTx[1]->GetBufferData()[SND_HEADER], "\x00\x00\x00\x00\x00\x0A" "0123456789", 16) == 0);
+    Forward(1, 30);
+    CPPUNIT_ASSERT(streamSize == 20);
+    CPPUNIT_ASSERT(memcmp(stream, "0123456789abcdefghij", 20) == 0);
+
+    /* A chunk seen twice is dropped */
+    CPPUNIT_ASSERT(tx->Write("KLMNOPQRST", 10, 40) == 10);
+    Forward(1, 50);
+    CPPUNIT_ASSERT(rsRx[0]->ProcessMessage((char *) "AT+RSI_READ\x01\x10\x00\x00\x00\x00\x02\x00\x0AKLMNOPQRST\r\n", 32) == true);
+    CPPUNIT_ASSERT(rx->ProcessResponse(0, 60) == true);
+    rx->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numDuplicates == 1);
+    CPPUNIT_ASSERT(streamSize == 30);
+
+    /* Link 1 closed by the peer while busy: the chunk goes back to link 0 */
+    CPPUNIT_ASSERT(tx->SetLinkUp(0, true) == true);
+    CPPUNIT_ASSERT(tx->Write("uvwxyz", 6, 60) == 6);
+    CPPUNIT_ASSERT(tx->Write("UVWXYZ", 6, 60) == 6);
+    CPPUNIT_ASSERT(rsTx[1]->ProcessMessage((char *) "AT+RSI_CLOSE\x01\r\n", 15) == true);
+    CPPUNIT_ASSERT(tx->ProcessResponse(1, 70) == true);
+    CPPUNIT_ASSERT(tx->GetLinkStats(1, linkStats) == true);
+    CPPUNIT_ASSERT(linkStats.isUp == false);
+
+    Forward(0, 80);
+    CPPUNIT_ASSERT(tx->IsIdle() == false);
+    Forward(0, 90);
+    CPPUNIT_ASSERT(tx->IsIdle() == true);
+
+    rx->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numReordered == 1);
+    CPPUNIT_ASSERT(streamSize == 42);
+    CPPUNIT_ASSERT(memcmp(&stream[30], "uvwxyzUVWXYZ", 12) == 0);
+}
+
+
+void RS9110_Bond_Test::OverflowTest ()
+{
+    RS9110_Bond::TStats stats;
+    char                frame[] = "AT+RSI_READ\x01\x07\x00\x00\x00\x00\x00\x00\x01?\r\n";
+
+
+    /* Chunks 1 to MAX_REORDER are held waiting for chunk 0 */
+    for(unsigned long seq = 1; seq <= RS9110_Bond::MAX_REORDER; seq++)
+    {
+        frame[17] = (char) seq;
+        frame[20] = (char) ('a' + seq);
+        CPPUNIT_ASSERT(rsRx[1]->ProcessMessage(frame, sizeof(frame) - 1) == true);
+        CPPUNIT_ASSERT(rx->ProcessResponse(1, seq) == true);
+    }
+
+    CPPUNIT_ASSERT(rx->IsBroken() == false);
+
+    /* One more cannot be held: the stream is broken rather than stalled */
+    frame[17] = (char) (RS9110_Bond::MAX_REORDER + 1);
+    CPPUNIT_ASSERT(rsRx[1]->ProcessMessage(frame, sizeof(frame) - 1) == true);
+    CPPUNIT_ASSERT(rx->ProcessResponse(1, 10) == true);
+    CPPUNIT_ASSERT(rx->IsBroken() == true);
+
+    frame[17] = 0;
+    CPPUNIT_ASSERT(rsRx[0]->ProcessMessage(frame, sizeof(frame) - 1) == true);
+    CPPUNIT_ASSERT(rx->ProcessResponse(0, 20) == true);
+    CPPUNIT_ASSERT(streamSize == 0);
+
+    rx->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numOverflows == 1);
+    CPPUNIT_ASSERT(stats.numDelivered == 0);
+    CPPUNIT_ASSERT(tx->IsBroken() == false);
+}
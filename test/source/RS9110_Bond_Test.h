@@ -0,0 +1,51 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Bond.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Bond_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Bond_Test);
+    CPPUNIT_TEST(StripeTest);
+    CPPUNIT_TEST(ThroughputTest);
+    CPPUNIT_TEST(FailoverTest);
+    CPPUNIT_TEST(OverflowTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void StripeTest ();
+    void ThroughputTest ();
+    void FailoverTest ();
+    void OverflowTest ();
+
+
+protected:
+
+    static const unsigned char  NUM_LINKS   = 2;
+    static const unsigned int   MAX_STREAM  = 8192;
+
+    static void Delivered   (void *context, const char *data, unsigned int dataSize);
+
+    void Answer     (unsigned char link, const char *response, int size, unsigned long nowMs);
+    void Forward    (unsigned char link, unsigned long nowMs, unsigned int split = 0);
+
+    PersistorWin32Mock     *mockTx[NUM_LINKS];
+    PersistorWin32Mock     *mockRx[NUM_LINKS];
+    RS9110_UART            *rsTx[NUM_LINKS];
+    RS9110_UART            *rsRx[NUM_LINKS];
+    RS9110_Bond            *tx;
+    RS9110_Bond            *rx;
+
+    char                    stream[MAX_STREAM];
+    unsigned int            streamSize;
+
+};
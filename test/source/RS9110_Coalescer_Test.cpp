@@ -0,0 +1,196 @@
+#pragma once
+
+#include "RS9110_Coalescer_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]  = "OK\r\n";
+
+
+void RS9110_Coalescer_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    coalescer   = new RS9110_Coalescer(*rs);
+
+    ClearWritten();
+}
+
+
+void RS9110_Coalescer_Test::tearDown ()
+{
+    delete coalescer;
+    delete rs;
+    delete mockFile;
+}
+
+
+bool RS9110_Coalescer_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+void RS9110_Coalescer_Test::ClearWritten ()
+{
+    mockFile->Write((unsigned char *) "", 0);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Coalescer_Test);
+
+
+void RS9110_Coalescer_Test::MergeTest ()
+{
+    RS9110_Coalescer::TStats stats;
+
+
+    CPPUNIT_ASSERT(coalescer->Enable(1, 20) == true);
+    CPPUNIT_ASSERT(coalescer->IsEnabled(1) == true);
+    CPPUNIT_ASSERT(coalescer->IsEnabled(2) == false);
+
+    /* Held until the delay of the oldest byte */
+    CPPUNIT_ASSERT(coalescer->Write(1, "abc", 3, 1000) == 3);
+    CPPUNIT_ASSERT(coalescer->Write(1, "\r\n", 2, 1005) == 2);
+    CPPUNIT_ASSERT(coalescer->Write(1, "def", 3, 1010) == 3);
+    CPPUNIT_ASSERT(coalescer->GetPending(1) == 8);
+    coalescer->Poll(1019);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+
+    coalescer->Poll(1020);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,abc\xDB\xDC""def\r\n") == 0);
+    CPPUNIT_ASSERT(coalescer->GetPending(1) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* Explicit flush */
+    CPPUNIT_ASSERT(coalescer->Write(1, "g", 1, 2000) == 1);
+    CPPUNIT_ASSERT(coalescer->Flush(1) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,g\r\n") == 0);
+
+    ClearWritten();
+    CPPUNIT_ASSERT(coalescer->Flush(1) == true);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+
+    /* Dropped on close */
+    CPPUNIT_ASSERT(coalescer->Write(1, "h", 1, 3000) == 1);
+    coalescer->Discard(1);
+    coalescer->Poll(4000);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+
+    coalescer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numWrites == 5);
+    CPPUNIT_ASSERT(stats.numCoalesced == 2);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(stats.numDelayFlushes == 1);
+    CPPUNIT_ASSERT(stats.numSizeFlushes == 0);
+
+    /* Wrong arguments */
+    CPPUNIT_ASSERT(coalescer->Enable(0) == false);
+    CPPUNIT_ASSERT(coalescer->Enable(8) == false);
+    CPPUNIT_ASSERT(coalescer->Write(1, "a", 0, 0) == 0);
+    CPPUNIT_ASSERT(coalescer->Flush(2) == false);
+}
+
+
+void RS9110_Coalescer_Test::SizeTest ()
+{
+    static char data[1000];
+    RS9110_Coalescer::TStats stats;
+
+
+    CPPUNIT_ASSERT(RS9110_UART::GetMaxSendSize(1, RS9110_UART::SOCKET_TCP) == RS9110_UART::MAX_SEND_DATA_SIZE_TCP);
+    CPPUNIT_ASSERT(RS9110_UART::GetMaxSendSize(1, RS9110_UART::SOCKET_UDP, "192.168.1.2", 8000) == RS9110_UART::MAX_SEND_DATA_SIZE_UDP);
+    CPPUNIT_ASSERT(RS9110_UART::GetMaxSendSize(1, RS9110_UART::SOCKET_LTCP) == 0);
+
+    CPPUNIT_ASSERT(coalescer->Enable(1) == true);
+    memset(data, 'A', sizeof(data));
+
+    /* The write that does not fit fills the command, the rest is left to the caller */
+    CPPUNIT_ASSERT(coalescer->Write(1, data, 1000, 0) == 1000);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+    CPPUNIT_ASSERT(coalescer->Write(1, data, 1000, 0) == 459);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (19 + 1459 + 2));
+    CPPUNIT_ASSERT(coalescer->GetPending(1) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* Budgeted after byte stuffing */
+    memset(data, 0xDB, sizeof(data));
+    CPPUNIT_ASSERT(coalescer->Write(1, data, 500, 0) == 500);
+    CPPUNIT_ASSERT(coalescer->Write(1, data, 500, 0) == 230);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (19 + 1460 + 2));
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_SEND_DATA);
+
+    coalescer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(stats.numSizeFlushes == 2);
+}
+
+
+void RS9110_Coalescer_Test::DisableTest ()
+{
+    RS9110_Coalescer::TStats stats;
+
+
+    /* Sockets not coalesced are sent at once */
+    CPPUNIT_ASSERT(coalescer->Write(2, "abc", 3, 0) == 3);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=2,0,0,0,abc\r\n") == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* Out of slots */
+    CPPUNIT_ASSERT(coalescer->Enable(1) == true);
+    CPPUNIT_ASSERT(coalescer->Enable(3) == true);
+    CPPUNIT_ASSERT(coalescer->Enable(4) == (RS9110_Coalescer::MAX_SLOTS > 2));
+
+    /* Disabling sends the pending bytes and frees the slot */
+    ClearWritten();
+    CPPUNIT_ASSERT(coalescer->Write(3, "xyz", 3, 0) == 3);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+    CPPUNIT_ASSERT(coalescer->Disable(3) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=3,0,0,0,xyz\r\n") == 0);
+    CPPUNIT_ASSERT(coalescer->IsEnabled(3) == false);
+    CPPUNIT_ASSERT(coalescer->Disable(3) == false);
+    CPPUNIT_ASSERT(coalescer->Enable(5) == true);
+
+    coalescer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(stats.numWrites == 2);
+}
+
+
+void RS9110_Coalescer_Test::SchedulerTest ()
+{
+    RS9110_Scheduler scheduler(*rs);
+
+
+    coalescer->SetScheduler(&scheduler);
+    CPPUNIT_ASSERT(coalescer->Enable(1, 20) == true);
+
+    /* Only coalesced sockets are written */
+    CPPUNIT_ASSERT(coalescer->Write(2, "x", 1, 1000) == 0);
+
+    /* The flush waits for the line, bytes written meanwhile go with it */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    CPPUNIT_ASSERT(coalescer->Write(1, "abc", 3, 1000) == 3);
+    CPPUNIT_ASSERT(coalescer->Flush(1) == true);
+    CPPUNIT_ASSERT(coalescer->Write(1, "def", 3, 1005) == 3);
+    CPPUNIT_ASSERT(coalescer->Disable(1) == false);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    /* Control commands queued meanwhile go first */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    ClearWritten();
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,abcdef\r\n") == 0);
+    CPPUNIT_ASSERT(coalescer->GetPending(1) == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+    CPPUNIT_ASSERT(coalescer->Disable(1) == true);
+}
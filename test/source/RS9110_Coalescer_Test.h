@@ -0,0 +1,42 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Coalescer.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Coalescer_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Coalescer_Test);
+    CPPUNIT_TEST(MergeTest);
+    CPPUNIT_TEST(SizeTest);
+    CPPUNIT_TEST(DisableTest);
+    CPPUNIT_TEST(SchedulerTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void MergeTest ();
+    void SizeTest ();
+    void DisableTest ();
+    void SchedulerTest ();
+
+
+protected:
+
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+
+    void ClearWritten ();
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Coalescer               *coalescer;
+
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "RS9110_DNSCache_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char   DNS_ANSWER[]    = "OK\x02\xC0\xA8\x01\x0A\xC0\xA8\x01\x0B\r\n";
+static const int    DNS_ANSWER_LEN  = sizeof(DNS_ANSWER) - 1;
+
+
+void RS9110_DNSCache_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    dns         = new RS9110_DNSCache(*rs, 1000, 100);
+}
+
+
+void RS9110_DNSCache_Test::tearDown ()
+{
+    delete dns;
+    delete rs;
+    delete mockFile;
+}
+
+
+unsigned long RS9110_DNSCache_Test::BytesWritten ()
+{
+    RS9110_UART::TCounters counters;
+
+
+    rs->GetCounters(counters);
+
+    return counters.bytesWritten;
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_DNSCache_Test);
+
+
+void RS9110_DNSCache_Test::ResolveTest ()
+{
+    RS9110_UART::TDNSGet    result;
+    unsigned long           written;
+
+
+    CPPUNIT_ASSERT(dns->Resolve(NULL, 0, result) == RS9110_DNSCache::RESULT_ERROR);
+    CPPUNIT_ASSERT(dns->Resolve("", 0, result) == RS9110_DNSCache::RESULT_ERROR);
+
+    CPPUNIT_ASSERT(dns->Resolve("www.redpine.com", 0, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_GET_DNS);
+    CPPUNIT_ASSERT(dns->IsQueryInFlight() == true);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) DNS_ANSWER, DNS_ANSWER_LEN) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(10) == true);
+    CPPUNIT_ASSERT(dns->IsQueryInFlight() == false);
+
+    /* Hits do not touch the module (names are case-insensitive) */
+    written = BytesWritten();
+
+    CPPUNIT_ASSERT(dns->Resolve("WWW.Redpine.com", 500, result) == RS9110_DNSCache::RESULT_HIT);
+    CPPUNIT_ASSERT(result.numIPs == 2);
+    CPPUNIT_ASSERT(memcmp(result.address[1], "\xC0\xA8\x01\x0B", 4) == 0);
+    CPPUNIT_ASSERT(BytesWritten() == written);
+
+    /* Expired */
+    CPPUNIT_ASSERT(dns->Resolve("www.redpine.com", 1010, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(BytesWritten() > written);
+
+    dns->Clear();
+    CPPUNIT_ASSERT(dns->ProcessResponse(1020) == false);
+}
+
+
+void RS9110_DNSCache_Test::CoalescingTest ()
+{
+    RS9110_UART::TDNSGet    result;
+    unsigned long           written;
+
+
+    CPPUNIT_ASSERT(dns->Resolve("a.example.com", 0, result) == RS9110_DNSCache::RESULT_PENDING);
+    written = BytesWritten();
+
+    /* Same name shares the query, other names wait */
+    CPPUNIT_ASSERT(dns->Resolve("a.example.com", 1, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(dns->Resolve("a.example.com", 2, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(dns->Resolve("b.example.com", 3, result) == RS9110_DNSCache::RESULT_BUSY);
+    CPPUNIT_ASSERT(BytesWritten() == written);
+
+    /* Unrelated messages are ignored */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x01\r\n", 15) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(4) == false);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) DNS_ANSWER, DNS_ANSWER_LEN) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(5) == true);
+    CPPUNIT_ASSERT(dns->Resolve("a.example.com", 6, result) == RS9110_DNSCache::RESULT_HIT);
+    CPPUNIT_ASSERT(dns->Resolve("b.example.com", 7, result) == RS9110_DNSCache::RESULT_PENDING);
+
+    /* A lost answer does not block the cache forever */
+    CPPUNIT_ASSERT(dns->Resolve("c.example.com", 8, result) == RS9110_DNSCache::RESULT_BUSY);
+    CPPUNIT_ASSERT(dns->Resolve("c.example.com", 7 + RS9110_DNSCache::QUERY_TIMEOUT_MS, result) == RS9110_DNSCache::RESULT_PENDING);
+}
+
+
+void RS9110_DNSCache_Test::NegativeCacheTest ()
+{
+    RS9110_UART::TDNSGet    result;
+    unsigned long           written;
+
+
+    CPPUNIT_ASSERT(dns->Resolve("down.example.com", 0, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\xA4\r\n", 8) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(10) == true);
+
+    written = BytesWritten();
+
+    CPPUNIT_ASSERT(dns->Resolve("down.example.com", 50, result) == RS9110_DNSCache::RESULT_NEGATIVE);
+    CPPUNIT_ASSERT(dns->GetLastError("down.example.com") == RS9110_UART::ERROR_DNS_RESP_TIMEOUT);
+    CPPUNIT_ASSERT(BytesWritten() == written);
+
+    CPPUNIT_ASSERT(dns->Resolve("down.example.com", 110, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) DNS_ANSWER, DNS_ANSWER_LEN) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(120) == true);
+    CPPUNIT_ASSERT(dns->GetLastError("down.example.com") == RS9110_UART::ERROR_NONE);
+
+    dns->Invalidate("down.example.com");
+    CPPUNIT_ASSERT(dns->Resolve("down.example.com", 130, result) == RS9110_DNSCache::RESULT_PENDING);
+
+    /* Not a DNS failure (not associated): not cached, asked again */
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\xF9\r\n", 8) == true);
+    CPPUNIT_ASSERT(dns->ProcessResponse(140) == true);
+    CPPUNIT_ASSERT(dns->IsQueryInFlight() == false);
+    CPPUNIT_ASSERT(dns->GetLastError("down.example.com") == RS9110_UART::ERROR_NONE);
+
+    written = BytesWritten();
+    CPPUNIT_ASSERT(dns->Resolve("down.example.com", 150, result) == RS9110_DNSCache::RESULT_PENDING);
+    CPPUNIT_ASSERT(BytesWritten() > written);
+}
+
+
+void RS9110_DNSCache_Test::EvictionTest ()
+{
+    RS9110_UART::TDNSGet    result;
+    char                    name[16];
+
+
+    for(unsigned int i = 0; i <= RS9110_DNSCache::MAX_ENTRIES; i++)
+    {
+        _snprintf_s(name, sizeof(name), "host%u", i);
+
+        CPPUNIT_ASSERT(dns->Resolve(name, i, result) == RS9110_DNSCache::RESULT_PENDING);
+        CPPUNIT_ASSERT(rs->ProcessMessage((char *) DNS_ANSWER, DNS_ANSWER_LEN) == true);
+        CPPUNIT_ASSERT(dns->ProcessResponse(i) == true);
+
+        /* Keeps host0 as the most recently used */
+        CPPUNIT_ASSERT(dns->Resolve("host0", i, result) == RS9110_DNSCache::RESULT_HIT);
+    }
+
+    /* host1 was the least recently used */
+    CPPUNIT_ASSERT(dns->Resolve("host1", 20, result) == RS9110_DNSCache::RESULT_PENDING);
+}
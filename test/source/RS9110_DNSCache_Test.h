@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_DNSCache.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_DNSCache_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_DNSCache_Test);
+    CPPUNIT_TEST(ResolveTest);
+    CPPUNIT_TEST(CoalescingTest);
+    CPPUNIT_TEST(NegativeCacheTest);
+    CPPUNIT_TEST(EvictionTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void ResolveTest ();
+    void CoalescingTest ();
+    void NegativeCacheTest ();
+    void EvictionTest ();
+
+
+protected:
+
+    unsigned long BytesWritten ();
+
+    PersistorWin32Mock     *mockFile;
+    RS9110_UART            *rs;
+    RS9110_DNSCache        *dns;
+
+};
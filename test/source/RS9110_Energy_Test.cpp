@@ -0,0 +1,145 @@
+#pragma once
+
+#include "RS9110_Energy_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+unsigned long long RS9110_Energy_Test::nowUs = 0;
+
+
+void RS9110_Energy_Test::setUp ()
+{
+    nowUs       = 0;
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    meter       = new RS9110_Energy(FakeClock);
+
+    rs->SetEnergyMeter(meter);
+}
+
+
+void RS9110_Energy_Test::tearDown ()
+{
+    delete rs;
+    delete meter;
+    delete mockFile;
+}
+
+
+unsigned long long RS9110_Energy_Test::FakeClock ()
+{
+    return nowUs;
+}
+
+
+void RS9110_Energy_Test::Receive (unsigned long long now, const char *message)
+{
+    nowUs = now;
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) message, strlen(message)) == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Energy_Test);
+
+
+void RS9110_Energy_Test::DutyCycleTest ()
+{
+    RS9110_Energy::TStats stats;
+
+
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM0);
+
+    /* Power mode 1 once the module answers OK */
+    nowUs = 1000;
+    CPPUNIT_ASSERT(rs->PowerMode(RS9110_UART::PW_MODE_1) == true);
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM0);
+    Receive(1500, "OK\r\n");
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM1_AWAKE);
+
+    /* First SLEEP: the module was already awake */
+    Receive(2500, "SLEEP\r\n");
+    nowUs = 3000;
+    CPPUNIT_ASSERT(rs->KeepSleeping() == true);
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM1_ASLEEP);
+
+    /* Woken up by the module */
+    Receive(13000, "SLEEP\r\n");
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM1_AWAKE);
+    nowUs = 13200;
+    CPPUNIT_ASSERT(rs->Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, "ABCD", 4) == 4);
+    Receive(13400, "OK\r\n");
+    nowUs = 13500;
+    CPPUNIT_ASSERT(rs->KeepSleeping() == true);
+
+    /* Woken up by the host */
+    nowUs = 20000;
+    CPPUNIT_ASSERT(rs->Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, "AB", 2) == 2);
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM1_AWAKE);
+    Receive(20100, "OK\r\n");
+
+    /* Back to power mode 0 */
+    nowUs = 21000;
+    CPPUNIT_ASSERT(rs->PowerMode(RS9110_UART::PW_MODE_0) == true);
+    Receive(21100, "OK\r\n");
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM0);
+
+    nowUs = 22000;
+    meter->GetStats(stats);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM0] == 2400);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM1_AWAKE] == 3100);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM1_ASLEEP] == 16500);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM2_AWAKE] == 0);
+    CPPUNIT_ASSERT(stats.numWakes == 1);
+    CPPUNIT_ASSERT(stats.numHostWakes == 1);
+    CPPUNIT_ASSERT(stats.numAcks == 2);
+    CPPUNIT_ASSERT(stats.totalWakeToAckUs == 1000);
+    CPPUNIT_ASSERT(stats.maxWakeToAckUs == 500);
+
+    /* 25 bytes in the second wake; 23 + 17 (AT+RSI_PWMODE=0) in the third one */
+    CPPUNIT_ASSERT(stats.totalWakeBytes == 65);
+    CPPUNIT_ASSERT(stats.maxWakeBytes == 40);
+
+    /* A rejected power mode keeps the previous one */
+    nowUs = 23000;
+    CPPUNIT_ASSERT(rs->PowerMode(RS9110_UART::PW_MODE_2) == true);
+    Receive(23100, "ERROR\x01\r\n");
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM0);
+}
+
+
+void RS9110_Energy_Test::EnergyTest ()
+{
+    RS9110_Energy::TStats stats;
+
+
+    meter->SetCurrent(RS9110_Energy::STATE_PM0,         100000);
+    meter->SetCurrent(RS9110_Energy::STATE_PM2_AWAKE,   50000);
+    meter->SetCurrent(RS9110_Energy::STATE_PM2_ASLEEP,  1000);
+
+    CPPUNIT_ASSERT(rs->PowerMode(RS9110_UART::PW_MODE_2) == true);
+    Receive(2000, "OK\r\n");
+    Receive(3000, "SLEEP\r\n");
+    nowUs = 4000;
+    CPPUNIT_ASSERT(rs->KeepSleeping() == true);
+
+    /* 2 ms at 100 mA + 2 ms at 50 mA + 1 s at 1 mA = 1300 uC */
+    nowUs = 1004000;
+    meter->GetStats(stats);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM2_ASLEEP] == 1000000);
+    CPPUNIT_ASSERT(stats.chargeUC == 1300);
+    CPPUNIT_ASSERT(stats.energyUJ == 4290);
+
+    meter->SetSupplyVoltage(1800);
+    meter->GetStats(stats);
+    CPPUNIT_ASSERT(stats.energyUJ == 2340);
+
+    /* Reset keeps the state */
+    meter->Reset();
+    nowUs = 1005000;
+    meter->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numAcks == 0);
+    CPPUNIT_ASSERT(stats.timeUs[RS9110_Energy::STATE_PM2_ASLEEP] == 1000);
+    CPPUNIT_ASSERT(stats.chargeUC == 1);
+    CPPUNIT_ASSERT(meter->GetState() == RS9110_Energy::STATE_PM2_ASLEEP);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Energy.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Energy_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Energy_Test);
+    CPPUNIT_TEST(DutyCycleTest);
+    CPPUNIT_TEST(EnergyTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void DutyCycleTest ();
+    void EnergyTest ();
+
+
+protected:
+
+    static unsigned long long FakeClock ();
+
+    void Receive    (unsigned long long now, const char *message);
+
+    static unsigned long long   nowUs;
+
+    PersistorWin32Mock         *mockFile;
+    RS9110_UART                *rs;
+    RS9110_Energy              *meter;
+
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "RS9110_FairQueue_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]              = "OK\r\n";
+static const char ERROR_TOO_FAST[]  = "ERROR\x40\r\n";
+static const char ERROR_NO_SOCKET[] = "ERROR\x29\r\n";
+
+
+void RS9110_FairQueue_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    queue       = new RS9110_FairQueue(*rs, Completion, this);
+
+    memset(completed, 0, sizeof(completed));
+    numCompleted    = 0;
+    numDropped      = 0;
+}
+
+
+void RS9110_FairQueue_Test::tearDown ()
+{
+    delete queue;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_FairQueue_Test::Completion (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                                        bool isSent, RS9110_UART::EErrorCode eErrorCode)
+{
+    RS9110_FairQueue_Test *test = (RS9110_FairQueue_Test *) context;
+
+
+    if(isSent == true)
+    {
+        test->completed[test->numCompleted++] = socketId;
+    }
+    else
+    {
+        test->numDropped++;
+    }
+}
+
+
+bool RS9110_FairQueue_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+void RS9110_FairQueue_Test::Answer (const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(queue->ProcessResponse(nowMs) == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_FairQueue_Test);
+
+
+void RS9110_FairQueue_Test::WeightTest ()
+{
+    static char bulk[RS9110_UART::MAX_SEND_DATA_SIZE_TCP];
+    static const unsigned char ORDER[] = { 1, 2, 2, 1, 2, 1 };
+
+
+    memset(bulk, 'A', sizeof(bulk));
+
+    /* Full commands: weight 2 gets two of them per round */
+    CPPUNIT_ASSERT(queue->SetWeight(2, 2) == true);
+
+    for(int i = 0; i < 3; i++)
+    {
+        CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, bulk, 1400, 0) == true);
+        CPPUNIT_ASSERT(queue->Submit(2, RS9110_UART::SOCKET_TCP, NULL, 0, bulk, 1400, 0) == true);
+    }
+
+    CPPUNIT_ASSERT(queue->IsIdle() == false);
+    CPPUNIT_ASSERT(queue->GetNumQueued(1) == 3);
+
+    for(int i = 0; i < 6; i++)
+    {
+        Answer(OK, 4, 0);
+    }
+
+    CPPUNIT_ASSERT(numCompleted == 6);
+    CPPUNIT_ASSERT(memcmp(completed, ORDER, sizeof(ORDER)) == 0);
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+
+    /* Small sends of a socket do not wait behind the bulk of another one */
+    numCompleted = 0;
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, bulk, 1400, 0) == true);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, bulk, 1400, 0) == true);
+    CPPUNIT_ASSERT(queue->Submit(3, RS9110_UART::SOCKET_UDP, "192.168.1.2", 8000, "ctl", 3, 0) == true);
+    Answer(OK, 4, 0);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=3,0,192.168.1.2,8000,ctl\r\n") == 0);
+    Answer(OK, 4, 0);
+    Answer(OK, 4, 0);
+    CPPUNIT_ASSERT(completed[1] == 3);
+
+    /* Wrong arguments */
+    CPPUNIT_ASSERT(queue->SetWeight(1, 0) == false);
+    CPPUNIT_ASSERT(queue->SetWeight(8, 1) == false);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_LUDP, NULL, 0, "a", 1, 0) == false);
+    CPPUNIT_ASSERT(queue->Submit(0, RS9110_UART::SOCKET_TCP, NULL, 0, "a", 1, 0) == false);
+}
+
+
+void RS9110_FairQueue_Test::RateTest ()
+{
+    static char data[100];
+
+
+    memset(data, 'B', sizeof(data));
+
+    /* 1000 bytes/s, 200 bytes of burst */
+    CPPUNIT_ASSERT(queue->SetRateLimit(1, 1000, 200, 0) == true);
+
+    for(int i = 0; i < 4; i++)
+    {
+        CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, data, sizeof(data), 0) == true);
+    }
+
+    Answer(OK, 4, 0);
+    Answer(OK, 4, 0);
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+    CPPUNIT_ASSERT(queue->GetNumQueued(1) == 2);
+
+    /* Other sockets are not held */
+    CPPUNIT_ASSERT(queue->Submit(2, RS9110_UART::SOCKET_TCP, NULL, 0, "x", 1, 10) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=2,0,0,0,x\r\n") == 0);
+    Answer(OK, 4, 10);
+
+    queue->Poll(99);
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+    queue->Poll(100);
+    CPPUNIT_ASSERT(queue->IsIdle() == false);
+    Answer(OK, 4, 100);
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+
+    /* A long pause refills up to the burst */
+    queue->Poll(60000);
+    Answer(OK, 4, 60000);
+    CPPUNIT_ASSERT(queue->GetNumQueued(1) == 0);
+    CPPUNIT_ASSERT(numCompleted == 5);
+
+    /* Cap removed */
+    CPPUNIT_ASSERT(queue->SetRateLimit(1, 0, 0, 60000) == true);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, data, sizeof(data), 60000) == true);
+    CPPUNIT_ASSERT(queue->IsIdle() == false);
+}
+
+
+void RS9110_FairQueue_Test::StatsTest ()
+{
+    RS9110_FairQueue::TSocketStats stats;
+
+
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "\xDB", 1, 1000) == true);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "b", 1, 1010) == true);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "c", 1, 1020) == true);
+
+    /* Rejected commands are sent again, other errors drop the send */
+    Answer(ERROR_TOO_FAST, 8, 1030);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,\xDB\xDD\r\n") == 0);
+    Answer(OK, 4, 1040);
+    Answer(ERROR_NO_SOCKET, 8, 1050);
+    Answer(OK, 4, 1100);
+
+    CPPUNIT_ASSERT(queue->GetSocketStats(1, stats) == true);
+    CPPUNIT_ASSERT(stats.numQueued == 0);
+    CPPUNIT_ASSERT(stats.maxQueued == 3);
+    CPPUNIT_ASSERT(stats.numCommands == 4);
+    CPPUNIT_ASSERT(stats.numCompleted == 2);
+    CPPUNIT_ASSERT(stats.numFailed == 1);
+    CPPUNIT_ASSERT(stats.stuffedBytes == 3);
+    CPPUNIT_ASSERT(stats.numWaits == 3);
+    CPPUNIT_ASSERT(stats.totalWaitMs == (0 + 30 + 30));
+    CPPUNIT_ASSERT(stats.maxWaitMs == 30);
+    CPPUNIT_ASSERT(queue->GetSocketStats(0, stats) == false);
+
+    /* Abort drops everything */
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "d", 1, 2000) == true);
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "e", 1, 2000) == true);
+    queue->Abort();
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+    CPPUNIT_ASSERT(queue->GetNumQueued(1) == 0);
+    CPPUNIT_ASSERT(numDropped == 3);
+}
+
+
+void RS9110_FairQueue_Test::SchedulerTest ()
+{
+    RS9110_Scheduler scheduler(*rs);
+
+
+    queue->SetScheduler(&scheduler);
+
+    CPPUNIT_ASSERT(queue->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1, 0) == true);
+    CPPUNIT_ASSERT(queue->Submit(2, RS9110_UART::SOCKET_TCP, NULL, 0, "B", 1, 0) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,A\r\n") == 0);
+
+    /* A control command queued meanwhile goes before the next send */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    Answer(OK, 4, 10);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(queue->ProcessResponse(20) == false);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=2,0,0,0,B\r\n") == 0);
+
+    Answer(OK, 4, 30);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(numCompleted == 2);
+    CPPUNIT_ASSERT(queue->IsIdle() == true);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_FairQueue.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_FairQueue_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_FairQueue_Test);
+    CPPUNIT_TEST(WeightTest);
+    CPPUNIT_TEST(RateTest);
+    CPPUNIT_TEST(StatsTest);
+    CPPUNIT_TEST(SchedulerTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void WeightTest ();
+    void RateTest ();
+    void StatsTest ();
+    void SchedulerTest ();
+
+
+protected:
+
+    static void Completion (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                            bool isSent, RS9110_UART::EErrorCode eErrorCode);
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+
+    void Answer     (const char *response, int size, unsigned long nowMs);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_FairQueue               *queue;
+    unsigned char                   completed[16];      /* Socket of every completed send */
+    unsigned int                    numCompleted;
+    unsigned int                    numDropped;
+
+};
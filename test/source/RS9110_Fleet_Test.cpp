@@ -0,0 +1,203 @@
+#pragma once
+
+#include "RS9110_Fleet_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[] = "OK\r\n";
+
+
+void RS9110_Fleet_Test::setUp ()
+{
+    for(unsigned short i = 0; i < NUM_MODULES; i++)
+    {
+        mockFiles[i]    = new PersistorWin32Mock();
+        rs[i]           = new RS9110_UART(mockFiles[i]);
+
+        mockFiles[i]->Write((unsigned char *) "", 0);
+    }
+
+    provision   = new RS9110_Provision(*rs[0]);
+    fleet       = new RS9110_Fleet(2);
+
+    /* Spread over both reactors in turn */
+    CPPUNIT_ASSERT(fleet->Add(*rs[0], provision) == 0);
+    CPPUNIT_ASSERT(fleet->Add(*rs[1]) == 1);
+    CPPUNIT_ASSERT(fleet->Add(*rs[2]) == 2);
+    CPPUNIT_ASSERT(fleet->Add(*rs[3]) == 3);
+}
+
+
+void RS9110_Fleet_Test::tearDown ()
+{
+    delete fleet;
+    delete provision;
+
+    for(unsigned short i = 0; i < NUM_MODULES; i++)
+    {
+        delete rs[i];
+        delete mockFiles[i];
+    }
+}
+
+
+void RS9110_Fleet_Test::Answer (unsigned short module, const char *command, const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(strcmp(mockFiles[module]->GetBufferData(), command) == 0);
+    CPPUNIT_ASSERT(fleet->ProcessMessage(module, (char *) response, size, nowMs) == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Fleet_Test);
+
+
+void RS9110_Fleet_Test::CensusTest ()
+{
+    RS9110_Fleet::TResult   result;
+    RS9110_Fleet::TCensus   census[4];
+
+
+    CPPUNIT_ASSERT(fleet->GetReactor(0) == 0);
+    CPPUNIT_ASSERT(fleet->GetReactor(1) == 1);
+    CPPUNIT_ASSERT(fleet->GetReactor(2) == 0);
+    CPPUNIT_ASSERT(fleet->GetReactor(3) == 1);
+
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_NONE, 0) == false);
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_VERSION, 0) == true);
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_RSSI, 0) == false);
+    CPPUNIT_ASSERT(fleet->IsDone() == false);
+
+    /* Every reactor only issues on its own modules */
+    CPPUNIT_ASSERT(fleet->Poll(0, 10) == 2);
+    CPPUNIT_ASSERT(strcmp(mockFiles[0]->GetBufferData(), "AT+RSI_FWVERSION?\r\n") == 0);
+    CPPUNIT_ASSERT(strcmp(mockFiles[1]->GetBufferData(), "") == 0);
+    CPPUNIT_ASSERT(fleet->Poll(1, 10) == 2);
+
+    Answer(0, "AT+RSI_FWVERSION?\r\n", "OK4.7.1\r\n",   9,  50);
+    Answer(1, "AT+RSI_FWVERSION?\r\n", "OK4.7.1\r\n",   9,  60);
+    Answer(2, "AT+RSI_FWVERSION?\r\n", "OK4.6.0\r\n",   9,  70);
+    CPPUNIT_ASSERT(fleet->Poll(0, 80) == 0);
+    CPPUNIT_ASSERT(fleet->Poll(1, 80) == 1);
+
+    /* The last one never answers */
+    CPPUNIT_ASSERT(fleet->Poll(1, 10009) == 1);
+    CPPUNIT_ASSERT(fleet->Poll(1, 10010) == 0);
+    CPPUNIT_ASSERT(fleet->IsDone() == true);
+
+    CPPUNIT_ASSERT(fleet->GetResult(1, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_DONE);
+    CPPUNIT_ASSERT(strcmp(result.version, "4.7.1") == 0);
+    CPPUNIT_ASSERT(result.elapsedMs == 50);
+    CPPUNIT_ASSERT(fleet->GetResult(3, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_FAILED);
+    CPPUNIT_ASSERT(result.failedCommand == RS9110_UART::CMD_FW_VERSION);
+    CPPUNIT_ASSERT(result.errorCode == RS9110_UART::ERROR_NONE);
+    CPPUNIT_ASSERT(fleet->GetResult(4, result) == false);
+
+    CPPUNIT_ASSERT(fleet->GetCensus(census, 4) == 2);
+    CPPUNIT_ASSERT((strcmp(census[0].version, "4.7.1") == 0) && (census[0].count == 2));
+    CPPUNIT_ASSERT((strcmp(census[1].version, "4.6.0") == 0) && (census[1].count == 1));
+    CPPUNIT_ASSERT(fleet->GetCensus(census, 1) == 1);
+
+    /* RSSI with an ERROR answer */
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_RSSI, 20000) == true);
+    fleet->Poll(0, 20000);
+    fleet->Poll(1, 20000);
+    Answer(0, "AT+RSI_RSSI?\r\n", "OK\x20\r\n",     5, 20010);
+    Answer(1, "AT+RSI_RSSI?\r\n", "OK\x30\r\n",     5, 20010);
+    Answer(2, "AT+RSI_RSSI?\r\n", "ERROR\xC9\r\n",  8, 20010);
+
+    /* Unsolicited frames do not end it */
+    CPPUNIT_ASSERT(fleet->ProcessMessage(3, (char *) "SLEEP\r\n", 7, 20020) == true);
+    CPPUNIT_ASSERT(fleet->IsDone() == false);
+    Answer(3, "AT+RSI_RSSI?\r\n", "OK\x40\r\n",     5, 20030);
+    CPPUNIT_ASSERT(fleet->IsDone() == true);
+
+    CPPUNIT_ASSERT(fleet->GetResult(1, result) == true);
+    CPPUNIT_ASSERT(result.rssi == 0x30);
+    CPPUNIT_ASSERT(fleet->GetResult(2, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_FAILED);
+    CPPUNIT_ASSERT(result.errorCode == RS9110_UART::ERROR_RSSI_UNASSOC);
+    CPPUNIT_ASSERT(fleet->GetCensus(census, 4) == 0);
+}
+
+
+void RS9110_Fleet_Test::ProvisionTest ()
+{
+    RS9110_Fleet::TResult       result;
+    RS9110_Fleet::TReactorStats stats;
+
+
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_PROVISION, 0) == true);
+    fleet->Poll(0, 0);
+    fleet->Poll(1, 0);
+
+    /* Modules without a provisioning fail at once */
+    CPPUNIT_ASSERT(fleet->GetResult(1, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_FAILED);
+    CPPUNIT_ASSERT(result.failedCommand == RS9110_UART::CMD_MAX);
+    fleet->GetReactorStats(1, stats);
+    CPPUNIT_ASSERT(stats.numBusy == 0);
+    CPPUNIT_ASSERT(stats.numFailed == 2);
+
+    CPPUNIT_ASSERT(fleet->GetResult(0, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_RUNNING);
+    Answer(0, "AT+RSI_CFGGET?\r\n", "ERROR\xFC\r\n", 8, 10);
+
+    CPPUNIT_ASSERT(fleet->IsDone() == true);
+    CPPUNIT_ASSERT(fleet->GetResult(0, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_FAILED);
+    CPPUNIT_ASSERT(result.failedCommand == RS9110_UART::CMD_GET_CONFIG);
+    CPPUNIT_ASSERT(result.errorCode == RS9110_UART::ERROR_ILLEGAL_PARAMS);
+
+    /* Aborted before every reactor ran */
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_PROVISION, 100) == true);
+    fleet->Poll(0, 100);
+    fleet->Abort();
+    CPPUNIT_ASSERT(fleet->IsDone() == true);
+    CPPUNIT_ASSERT(provision->GetState() != RS9110_Provision::STATE_RUNNING);
+    CPPUNIT_ASSERT(fleet->GetResult(3, result) == true);
+    CPPUNIT_ASSERT(result.status == RS9110_Fleet::STATUS_IDLE);
+}
+
+
+void RS9110_Fleet_Test::RebalanceTest ()
+{
+    RS9110_Fleet::TReactorStats stats;
+
+
+    CPPUNIT_ASSERT(fleet->Pin(0, 2) == false);
+    CPPUNIT_ASSERT(fleet->Pin(4, 0) == false);
+
+    /* Modules 0 and 2 are chatty, both on reactor 0 */
+    for(unsigned short i = 0; i < 10; i++)
+    {
+        fleet->ProcessMessage(0, (char *) "SLEEP\r\n", 7, i);
+        fleet->ProcessMessage(2, (char *) "SLEEP\r\n", 7, i);
+    }
+
+    fleet->ProcessMessage(1, (char *) "SLEEP\r\n", 7, 10);
+    fleet->ProcessMessage(3, (char *) "SLEEP\r\n", 7, 10);
+
+    fleet->GetReactorStats(0, stats);
+    CPPUNIT_ASSERT(stats.load == 20);
+
+    /* One chatty module swaps sides, one quiet one comes back */
+    CPPUNIT_ASSERT(fleet->Rebalance() == 2);
+    CPPUNIT_ASSERT(fleet->GetReactor(0) != fleet->GetReactor(2));
+    fleet->GetReactorStats(0, stats);
+    CPPUNIT_ASSERT(stats.load == 0);
+    CPPUNIT_ASSERT(stats.numModules == 2);
+
+    /* Nothing to balance */
+    CPPUNIT_ASSERT(fleet->Rebalance() == 0);
+
+    /* Busy modules move with their work */
+    CPPUNIT_ASSERT(fleet->Start(RS9110_Fleet::OP_RSSI, 0) == true);
+    CPPUNIT_ASSERT(fleet->Pin(1, 0) == true);
+    fleet->GetReactorStats(0, stats);
+    CPPUNIT_ASSERT(stats.numBusy == 3);
+    CPPUNIT_ASSERT(fleet->Poll(0, 0) == 3);
+    CPPUNIT_ASSERT(strcmp(mockFiles[1]->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Fleet.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Fleet_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Fleet_Test);
+    CPPUNIT_TEST(CensusTest);
+    CPPUNIT_TEST(ProvisionTest);
+    CPPUNIT_TEST(RebalanceTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void CensusTest ();
+    void ProvisionTest ();
+    void RebalanceTest ();
+
+
+protected:
+
+    static const unsigned short NUM_MODULES = 4;
+
+    void Answer     (unsigned short module, const char *command, const char *response, int size, unsigned long nowMs);
+
+    PersistorWin32Mock             *mockFiles[NUM_MODULES];
+    RS9110_UART                    *rs[NUM_MODULES];
+    RS9110_Provision               *provision;
+    RS9110_Fleet                   *fleet;
+
+};
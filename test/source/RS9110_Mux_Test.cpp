@@ -0,0 +1,404 @@
+#pragma once
+
+#include "RS9110_Mux_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+#include <string.h>
+
+
+static const char   OK[]    = "OK\r\n";
+
+
+void RS9110_Mux_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    mux         = new RS9110_Mux(*rs);
+    numEvents   = 0;
+
+    mux->SetNotify(Notify, this);
+
+    for(unsigned char i = 0; i < NUM_CLIENTS; i++)
+    {
+        CPPUNIT_ASSERT(txRing[i].Attach(memory[i][0], RS9110_Ring::GetFootprint(RING_SIZE), true) == true);
+        CPPUNIT_ASSERT(rxRing[i].Attach(memory[i][1], RS9110_Ring::GetFootprint(RING_SIZE), true) == true);
+        CPPUNIT_ASSERT(reader[i].Attach(memory[i][1], RS9110_Ring::GetFootprint(RING_SIZE), false) == true);
+        CPPUNIT_ASSERT(mux->Attach(&txRing[i], &rxRing[i]) == i);
+    }
+
+    mockFile->Write((unsigned char *) "", 0);
+}
+
+
+void RS9110_Mux_Test::tearDown ()
+{
+    delete mux;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_Mux_Test::Notify (void *context, unsigned char client, const RS9110_Mux::TEvent &event)
+{
+    RS9110_Mux_Test *test = (RS9110_Mux_Test *) context;
+
+
+    CPPUNIT_ASSERT(test->numEvents < MAX_EVENTS);
+    test->eventClient[test->numEvents] = client;
+    memcpy(&test->events[test->numEvents], &event, sizeof(event));
+    test->numEvents++;
+}
+
+
+void RS9110_Mux_Test::Answer (const char *response, int size)
+{
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+}
+
+
+/* Opens a TCP virtual socket and checks the handle given by the module */
+void RS9110_Mux_Test::Open (unsigned char client, unsigned char vsock, unsigned char handle)
+{
+    RS9110_Mux::TRequest    request;
+    char                    response[] = "OK\x01\r\n";
+
+
+    memset(&request, 0, sizeof(request));
+    request.type        = RS9110_Mux::REQ_OPEN;
+    request.vsock       = vsock;
+    request.socketType  = RS9110_UART::SOCKET_TCP;
+    request.remotePort  = 8000;
+    request.localPort   = (unsigned short) (5000 + handle);
+    strcpy(request.host, "192.168.1.10");
+
+    CPPUNIT_ASSERT(mux->Request(client, request) == true);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_OPEN_TCP_SOCKET);
+
+    response[2] = (char) handle;
+    Answer(response, 5);
+
+    CPPUNIT_ASSERT(mux->GetHandle(client, vsock) == handle);
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+}
+
+
+void RS9110_Mux_Test::WriteRecord (unsigned char client, unsigned char vsock, const char *data, unsigned short size)
+{
+    RS9110_Mux::TDataHeader header;
+    char                   *record = txRing[client].Reserve((unsigned short) (sizeof(header) + size));
+
+
+    CPPUNIT_ASSERT(record != NULL);
+
+    memset(&header, 0, sizeof(header));
+    header.vsock = vsock;
+    memcpy(record, &header, sizeof(header));
+    memcpy(&record[sizeof(header)], data, size);
+
+    txRing[client].Commit((unsigned short) (sizeof(header) + size));
+}
+
+
+void RS9110_Mux_Test::CompareStream (const char *expected)
+{
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == strlen(expected));
+    CPPUNIT_ASSERT(memcmp(mockFile->GetBufferData(), expected, strlen(expected)) == 0);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Mux_Test);
+
+
+void RS9110_Mux_Test::ArbitrationTest ()
+{
+    RS9110_Mux::TRequest        request;
+    RS9110_Mux::TClientStats    stats;
+
+
+    memset(&request, 0, sizeof(request));
+    request.type        = RS9110_Mux::REQ_OPEN;
+    request.vsock       = 1;
+    request.socketType  = RS9110_UART::SOCKET_TCP;
+    request.remotePort  = 8000;
+    request.localPort   = 1234;
+    strcpy(request.host, "192.168.1.10");
+
+    /* Client 0 gets the module, the rest wait in their queues */
+    CPPUNIT_ASSERT(mux->Request(0, request) == true);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_OPEN_TCP_SOCKET);
+
+    request.socketType  = RS9110_UART::SOCKET_UDP;
+    request.vsock       = 2;
+    CPPUNIT_ASSERT(mux->Request(0, request) == true);
+
+    request.socketType  = RS9110_UART::SOCKET_LTCP;
+    request.vsock       = 1;
+    request.localPort   = 80;
+    CPPUNIT_ASSERT(mux->Request(1, request) == true);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_OPEN_TCP_SOCKET);
+
+    /* Not valid: in use, out of range, not attached, wrong type */
+    CPPUNIT_ASSERT(mux->Request(1, request) == false);
+    request.vsock = 0;
+    CPPUNIT_ASSERT(mux->Request(1, request) == false);
+    request.vsock = RS9110_Mux::MAX_VSOCKETS + 1;
+    CPPUNIT_ASSERT(mux->Request(1, request) == false);
+    request.vsock = 3;
+    CPPUNIT_ASSERT(mux->Request(NUM_CLIENTS, request) == false);
+    request.socketType = RS9110_UART::SOCKET_MULTICAST;
+    CPPUNIT_ASSERT(mux->Request(1, request) == false);
+
+    /* Round robin: client 1 goes before the second open of client 0 */
+    Answer("OK\x01\r\n", 5);
+    CPPUNIT_ASSERT(numEvents == 1);
+    CPPUNIT_ASSERT((eventClient[0] == 0) && (events[0].type == RS9110_Mux::EVT_OPENED) && (events[0].vsock == 1) && (events[0].isOk == 1));
+    CPPUNIT_ASSERT(mux->GetHandle(0, 1) == 1);
+    CompareStream("AT+RSI_LTCP=80\r\n");
+
+    Answer("ERROR\xFC\r\n", 8);
+    CPPUNIT_ASSERT(numEvents == 2);
+    CPPUNIT_ASSERT((eventClient[1] == 1) && (events[1].type == RS9110_Mux::EVT_OPENED) && (events[1].isOk == 0));
+    CPPUNIT_ASSERT(events[1].errorCode == RS9110_UART::ERROR_ILLEGAL_PARAMS);
+    CPPUNIT_ASSERT(mux->GetHandle(1, 1) == 0);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_OPEN_UDP_SOCKET);
+
+    Answer("OK\x02\r\n", 5);
+    CPPUNIT_ASSERT(numEvents == 3);
+    CPPUNIT_ASSERT((eventClient[2] == 0) && (events[2].vsock == 2) && (events[2].isOk == 1));
+    CPPUNIT_ASSERT(mux->GetHandle(0, 2) == 2);
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+
+    /* A failed open frees the virtual socket */
+    request.socketType  = RS9110_UART::SOCKET_LTCP;
+    request.vsock       = 1;
+    CPPUNIT_ASSERT(mux->Request(1, request) == true);
+
+    /* Answers not related to the mux are left alone */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x05\r\n", 15) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+    CPPUNIT_ASSERT(numEvents == 3);
+
+    CPPUNIT_ASSERT(mux->GetClientStats(0, stats) == true);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(mux->GetClientStats(1, stats) == true);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(mux->GetClientStats(NUM_CLIENTS, stats) == false);
+}
+
+
+void RS9110_Mux_Test::SendTest ()
+{
+    RS9110_Mux::TRequest        wake;
+    RS9110_Mux::TClientStats    stats;
+    char                        big[2000];
+    unsigned int                chunk;
+
+
+    Open(0, 1, 1);
+    Open(1, 3, 2);
+
+    memset(&wake, 0, sizeof(wake));
+    wake.type = RS9110_Mux::REQ_WAKE;
+
+    /* The payload goes from the ring to the module, one record per client in turn */
+    WriteRecord(0, 1, "hello", 5);
+    WriteRecord(0, 1, "world", 5);
+    WriteRecord(1, 3, "abc", 3);
+    CPPUNIT_ASSERT(mux->Request(0, wake) == true);
+    CompareStream("AT+RSI_SND=1,0,0,0,hello\r\n");
+
+    Answer(OK, 4);
+    CompareStream("AT+RSI_SND=2,0,0,0,abc\r\n");
+
+    /* Too fast: kept, and written again on its next turn */
+    Answer("ERROR\x40\r\n", 8);
+    CompareStream("AT+RSI_SND=1,0,0,0,world\r\n");
+    Answer(OK, 4);
+    CompareStream("AT+RSI_SND=2,0,0,0,abc\r\n");
+    Answer(OK, 4);
+
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+    CPPUNIT_ASSERT(txRing[0].IsEmpty() == true);
+    CPPUNIT_ASSERT(txRing[1].IsEmpty() == true);
+    CPPUNIT_ASSERT(numEvents == 2);
+
+    /* Larger than one AT+RSI_SND: split, acknowledged as one record */
+    memset(big, 'z', sizeof(big));
+    WriteRecord(0, 1, big, sizeof(big));
+    mux->Poll();
+    chunk = mockFile->GetBufferSize() - strlen("AT+RSI_SND=1,0,0,0,") - 2;
+    CPPUNIT_ASSERT((chunk > 0) && (chunk <= RS9110_UART::GetMaxSendSize(1, RS9110_UART::SOCKET_TCP)));
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (strlen("AT+RSI_SND=1,0,0,0,") + sizeof(big) - chunk + 2));
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(txRing[0].IsEmpty() == true);
+
+    /* Not open or rejected by the module: dropped */
+    WriteRecord(0, 5, "lost", 4);
+    WriteRecord(0, 1, "fail", 4);
+    mux->Poll();
+    CPPUNIT_ASSERT(numEvents == 3);
+    CPPUNIT_ASSERT((events[2].type == RS9110_Mux::EVT_SEND_FAILED) && (events[2].vsock == 5));
+    Answer("ERROR\xFA\r\n", 8);
+    CPPUNIT_ASSERT(numEvents == 4);
+    CPPUNIT_ASSERT((events[3].type == RS9110_Mux::EVT_SEND_FAILED) && (events[3].errorCode == RS9110_UART::ERROR_INVALID_SKT));
+    CPPUNIT_ASSERT(txRing[0].IsEmpty() == true);
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+
+    CPPUNIT_ASSERT(mux->GetClientStats(0, stats) == true);
+    CPPUNIT_ASSERT(stats.numSent == 3);
+    CPPUNIT_ASSERT(stats.numSendFailed == 2);
+    CPPUNIT_ASSERT(stats.bytesSent == (10 + sizeof(big)));
+    CPPUNIT_ASSERT(stats.numCommands == 6);
+    CPPUNIT_ASSERT(mux->GetClientStats(1, stats) == true);
+    CPPUNIT_ASSERT(stats.numSent == 1);
+    CPPUNIT_ASSERT(stats.bytesSent == 3);
+    CPPUNIT_ASSERT(stats.numCommands == 3);
+    CPPUNIT_ASSERT(stats.numSendFailed == 0);
+}
+
+
+void RS9110_Mux_Test::ReceiveTest ()
+{
+    RS9110_Mux::TDataHeader     header;
+    RS9110_Mux::TClientStats    stats;
+    const char                 *record;
+    unsigned short              size;
+    char                        frame[14 + 1400 + 2 + 1];
+
+
+    Open(0, 1, 1);
+    Open(1, 4, 2);
+    numEvents = 0;
+
+    /* Routed by handle to the RX ring of its owner */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_READ\x02\x03\x00xyz\r\n", 19) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+
+    CPPUNIT_ASSERT(reader[0].IsEmpty() == true);
+    record = reader[1].Peek(size);
+    CPPUNIT_ASSERT((record != NULL) && (size == (sizeof(header) + 3)));
+    memcpy(&header, record, sizeof(header));
+    CPPUNIT_ASSERT(header.vsock == 4);
+    CPPUNIT_ASSERT(memcmp(&record[sizeof(header)], "xyz", 3) == 0);
+    reader[1].Release();
+
+    /* Unknown handle: ignored */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_READ\x05\x01\x00q\r\n", 17) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+    CPPUNIT_ASSERT(reader[0].IsEmpty() == true);
+    CPPUNIT_ASSERT(reader[1].IsEmpty() == true);
+
+    /* RX ring full: data dropped, the client told once */
+    memcpy(frame, "AT+RSI_READ\x01\x78\x05", 14);
+    memset(&frame[14], 'r', 1400);
+    memcpy(&frame[14 + 1400], "\r\n", 3);
+
+    for(unsigned int i = 0; i < 4; i++)
+    {
+        CPPUNIT_ASSERT(rs->ProcessMessage(frame, sizeof(frame) - 1) == true);
+        CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+    }
+
+    CPPUNIT_ASSERT(numEvents == 1);
+    CPPUNIT_ASSERT((eventClient[0] == 0) && (events[0].type == RS9110_Mux::EVT_OVERFLOW) && (events[0].vsock == 1));
+
+    CPPUNIT_ASSERT(mux->GetClientStats(0, stats) == true);
+    CPPUNIT_ASSERT(stats.bytesReceived == 2 * 1400);
+    CPPUNIT_ASSERT(stats.numOverflows == 2);
+    CPPUNIT_ASSERT(mux->GetClientStats(1, stats) == true);
+    CPPUNIT_ASSERT(stats.bytesReceived == 3);
+
+    /* Room again: delivered and a later overflow is told again */
+    reader[0].Release();
+    reader[0].Release();
+    CPPUNIT_ASSERT(rs->ProcessMessage(frame, sizeof(frame) - 1) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+    CPPUNIT_ASSERT((reader[0].Peek(size) != NULL) && (size == (sizeof(header) + 1400)));
+}
+
+
+void RS9110_Mux_Test::CloseTest ()
+{
+    RS9110_Mux::TRequest request;
+
+
+    Open(0, 1, 1);
+    Open(1, 1, 2);
+    Open(1, 2, 3);
+    numEvents = 0;
+
+    /* Closed by the peer */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x02\r\n", 15) == true);
+    CPPUNIT_ASSERT(mux->ProcessResponse() == true);
+    CPPUNIT_ASSERT(numEvents == 1);
+    CPPUNIT_ASSERT((eventClient[0] == 1) && (events[0].type == RS9110_Mux::EVT_CLOSED) && (events[0].vsock == 1));
+    CPPUNIT_ASSERT(mux->GetHandle(1, 1) == 0);
+    CPPUNIT_ASSERT(mux->GetHandle(1, 2) == 3);
+
+    /* Closed by the client */
+    memset(&request, 0, sizeof(request));
+    request.type    = RS9110_Mux::REQ_CLOSE;
+    request.vsock   = 1;
+    CPPUNIT_ASSERT(mux->Request(1, request) == false);
+    CPPUNIT_ASSERT(mux->Request(0, request) == true);
+    CompareStream("AT+RSI_CLS=1\r\n");
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(numEvents == 2);
+    CPPUNIT_ASSERT((eventClient[1] == 0) && (events[1].type == RS9110_Mux::EVT_CLOSED) && (events[1].isOk == 1));
+    CPPUNIT_ASSERT(mux->GetHandle(0, 1) == 0);
+
+    /* Detached: its sockets are closed silently, then the slot is freed */
+    WriteRecord(1, 2, "gone", 4);
+    CPPUNIT_ASSERT(mux->Detach(1) == true);
+    CPPUNIT_ASSERT(mux->Detach(1) == false);
+    CPPUNIT_ASSERT(mux->IsAttached(1) == false);
+    CompareStream("AT+RSI_CLS=3\r\n");
+    CPPUNIT_ASSERT(mux->Attach(&txRing[1], &rxRing[1]) == NUM_CLIENTS);
+    CPPUNIT_ASSERT(mux->Detach(NUM_CLIENTS) == true);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(numEvents == 2);
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+    CPPUNIT_ASSERT(rs->IsSocketOpen(3) == false);
+    CPPUNIT_ASSERT(mux->Attach(&txRing[1], &rxRing[1]) == 1);
+    CPPUNIT_ASSERT(mux->IsAttached(1) == true);
+}
+
+
+void RS9110_Mux_Test::CorruptTest ()
+{
+    RS9110_Mux::TRequest    wake;
+    char                   *data    = (char *) memory[0][0] + RS9110_Ring::GetFootprint(0);
+    unsigned short          length  = RING_SIZE;
+
+
+    Open(0, 1, 1);
+    Open(1, 2, 2);
+    numEvents = 0;
+
+    memset(&wake, 0, sizeof(wake));
+    wake.type = RS9110_Mux::REQ_WAKE;
+
+    /* A record running past the head: told, detached and its sockets closed */
+    WriteRecord(0, 1, "hello", 5);
+    memcpy(data, &length, sizeof(length));
+    CPPUNIT_ASSERT(mux->Request(0, wake) == true);
+    CompareStream("AT+RSI_CLS=1\r\n");
+    CPPUNIT_ASSERT(numEvents == 1);
+    CPPUNIT_ASSERT((eventClient[0] == 0) && (events[0].type == RS9110_Mux::EVT_DETACHED));
+    CPPUNIT_ASSERT(mux->IsAttached(0) == false);
+    CPPUNIT_ASSERT(mux->Detach(0) == false);
+
+    /* The other client goes on */
+    WriteRecord(1, 2, "abc", 3);
+    CPPUNIT_ASSERT(mux->Request(1, wake) == true);
+    Answer(OK, 4);
+    CompareStream("AT+RSI_SND=2,0,0,0,abc\r\n");
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(numEvents == 1);
+    CPPUNIT_ASSERT(mux->IsIdle() == true);
+    CPPUNIT_ASSERT(mux->IsAttached(1) == true);
+}
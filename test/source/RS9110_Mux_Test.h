@@ -0,0 +1,59 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Mux.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Mux_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Mux_Test);
+    CPPUNIT_TEST(ArbitrationTest);
+    CPPUNIT_TEST(SendTest);
+    CPPUNIT_TEST(ReceiveTest);
+    CPPUNIT_TEST(CloseTest);
+    CPPUNIT_TEST(CorruptTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void ArbitrationTest ();
+    void SendTest ();
+    void ReceiveTest ();
+    void CloseTest ();
+    void CorruptTest ();
+
+
+protected:
+
+    static const unsigned char  NUM_CLIENTS = 2;
+    static const unsigned long  RING_SIZE   = 4096;
+    static const unsigned int   MAX_EVENTS  = 16;
+
+    static void Notify  (void *context, unsigned char client, const RS9110_Mux::TEvent &event);
+
+    void Answer         (const char *response, int size);
+    void Open           (unsigned char client, unsigned char vsock, unsigned char handle);
+    void WriteRecord    (unsigned char client, unsigned char vsock, const char *data, unsigned short size);
+    void CompareStream  (const char *expected);
+
+    PersistorWin32Mock         *mockFile;
+    RS9110_UART                *rs;
+    RS9110_Mux                 *mux;
+
+    unsigned long               memory[NUM_CLIENTS][2][(RING_SIZE + 64) / sizeof(unsigned long)];
+    RS9110_Ring                 txRing[NUM_CLIENTS];
+    RS9110_Ring                 rxRing[NUM_CLIENTS];
+    RS9110_Ring                 reader[NUM_CLIENTS];    /* Client side of the RX rings */
+
+    unsigned char               eventClient[MAX_EVENTS];
+    RS9110_Mux::TEvent          events[MAX_EVENTS];
+    unsigned int                numEvents;
+
+};
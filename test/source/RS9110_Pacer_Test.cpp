@@ -0,0 +1,184 @@
+#pragma once
+
+#include "RS9110_Pacer_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]              = "OK\r\n";
+static const char ERROR_TOO_FAST[]  = "ERROR\xC5\r\n";
+
+unsigned long long  RS9110_Pacer_Test::now          = 0;
+unsigned long       RS9110_Pacer_Test::lastDelay    = 0;
+
+
+void RS9110_Pacer_Test::setUp ()
+{
+    now         = 1000000;
+    lastDelay   = 0;
+
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    pacer       = new RS9110_Pacer(Clock, Delay);
+    trace       = new RS9110_Trace(Clock);
+
+    rs->SetPacer(pacer);
+    rs->SetTrace(trace);
+}
+
+
+void RS9110_Pacer_Test::tearDown ()
+{
+    delete trace;
+    delete pacer;
+    delete rs;
+    delete mockFile;
+}
+
+
+unsigned long long RS9110_Pacer_Test::Clock ()
+{
+    return now;
+}
+
+
+void RS9110_Pacer_Test::Delay (unsigned long us)
+{
+    lastDelay   = us;
+    now        += us;
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Pacer_Test);
+
+
+void RS9110_Pacer_Test::RetryTest ()
+{
+    RS9110_UART::TCounters  counters;
+    RS9110_Pacer::TStats    stats;
+    RS9110_Trace::TEntry    entry;
+
+
+    CPPUNIT_ASSERT(rs->GetPacer() == pacer);
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+
+    /* Rejected 100 us after the command: no answer yet, not written again at once */
+    now += 100;
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) ERROR_TOO_FAST, 8) == true);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_MAX);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_GET_RSSI);
+    CPPUNIT_ASSERT(rs->IsRetryPending() == true);
+    CPPUNIT_ASSERT(pacer->GetGap(RS9110_UART::CMD_GET_RSSI) == RS9110_Pacer::MIN_STEP_US);
+    CPPUNIT_ASSERT(pacer->GetWait(RS9110_UART::CMD_GET_RSSI) == RS9110_Pacer::MIN_STEP_US);
+
+    /* The trace still shows the rejection */
+    CPPUNIT_ASSERT(trace->GetNumEntries() == 2);
+    CPPUNIT_ASSERT(trace->GetEntry(1, entry) == true);
+    CPPUNIT_ASSERT(entry.event == RS9110_Trace::EVENT_RX);
+    CPPUNIT_ASSERT(entry.type == RS9110_UART::RESP_TYPE_ERROR);
+    CPPUNIT_ASSERT(entry.errorCode == RS9110_UART::ERROR_CMD_TOO_FAST);
+
+    /* Written again by the poll once the new gap has elapsed, never waiting */
+    now += RS9110_Pacer::MIN_STEP_US - 1;
+    CPPUNIT_ASSERT(rs->Poll() == true);
+    CPPUNIT_ASSERT(rs->IsRetryPending() == true);
+
+    now += 1;
+    CPPUNIT_ASSERT(rs->Poll() == true);
+    CPPUNIT_ASSERT(rs->IsRetryPending() == false);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_GET_RSSI);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+    CPPUNIT_ASSERT(lastDelay == 0);
+
+    rs->GetCounters(counters);
+    CPPUNIT_ASSERT(counters.bytesWritten == (2 * strlen("AT+RSI_RSSI?\r\n")));
+
+    /* The OK of the retry is the answer, every OK shortens the gap */
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_OK);
+    CPPUNIT_ASSERT(pacer->GetGap(RS9110_UART::CMD_GET_RSSI) == (RS9110_Pacer::MIN_STEP_US - (RS9110_Pacer::MIN_STEP_US >> 4)));
+
+    pacer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numRejected == 1);
+    CPPUNIT_ASSERT(stats.numRetried == 1);
+
+    /* Other commands keep their own gap */
+    CPPUNIT_ASSERT(pacer->GetGap(RS9110_UART::CMD_INIT) == 0);
+}
+
+
+void RS9110_Pacer_Test::HoldTest ()
+{
+    RS9110_Pacer::TStats stats;
+
+
+    pacer->SetGap(RS9110_UART::CMD_INIT, 2000);
+
+    /* Held back only for what is left of the gap */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    now += 500;
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    now += 300;
+    CPPUNIT_ASSERT(rs->Init() == true);
+    CPPUNIT_ASSERT(lastDelay == 1700);
+
+    /* Not held back once the gap has elapsed */
+    lastDelay = 0;
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    now += 5000;
+    CPPUNIT_ASSERT(rs->Init() == true);
+    CPPUNIT_ASSERT(lastDelay == 0);
+
+    /* Sends are not paced */
+    pacer->SetGap(RS9110_UART::CMD_SEND_DATA, 5000);
+    CPPUNIT_ASSERT(rs->Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1) == 1);
+    CPPUNIT_ASSERT(lastDelay == 0);
+
+    pacer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numHeld == 1);
+    CPPUNIT_ASSERT(stats.totalHeldUs == 1700);
+}
+
+
+void RS9110_Pacer_Test::LimitTest ()
+{
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+
+    /* Given up after the maximum number of retries */
+    for(unsigned char i = 0; i < RS9110_Pacer::MAX_RETRIES; i++)
+    {
+        CPPUNIT_ASSERT(rs->ProcessMessage((char *) ERROR_TOO_FAST, 8) == true);
+        CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_MAX);
+
+        now += pacer->GetWait(RS9110_UART::CMD_GET_RSSI);
+        CPPUNIT_ASSERT(rs->Poll() == true);
+    }
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) ERROR_TOO_FAST, 8) == true);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_ERROR);
+    CPPUNIT_ASSERT(rs->GetErrorCode() == RS9110_UART::ERROR_CMD_TOO_FAST);
+    CPPUNIT_ASSERT(pacer->GetGap(RS9110_UART::CMD_GET_RSSI) == (8 * RS9110_Pacer::MIN_STEP_US));
+
+    /* Not written again once the command has been overwritten by a READ */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_READ\x01\x05\x00 abcd\r\n", 21) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) ERROR_TOO_FAST, 8) == true);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_ERROR);
+
+    /* Overwritten while waiting for the poll: the rejection is the answer */
+    now += RS9110_Pacer::MAX_GAP_US;
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) ERROR_TOO_FAST, 8) == true);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_MAX);
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_READ\x01\x05\x00 abcd\r\n", 21) == true);
+
+    now += RS9110_Pacer::MAX_GAP_US;
+    CPPUNIT_ASSERT(rs->Poll() == false);
+    CPPUNIT_ASSERT(rs->IsRetryPending() == false);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_GET_RSSI);
+    CPPUNIT_ASSERT(rs->GetResponseType() == RS9110_UART::RESP_TYPE_ERROR);
+    CPPUNIT_ASSERT(rs->GetErrorCode() == RS9110_UART::ERROR_CMD_TOO_FAST);
+
+    /* Nothing pending */
+    CPPUNIT_ASSERT(rs->Poll() == true);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Pacer.h"
+#include "RS9110_Trace.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Pacer_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Pacer_Test);
+    CPPUNIT_TEST(RetryTest);
+    CPPUNIT_TEST(HoldTest);
+    CPPUNIT_TEST(LimitTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void RetryTest ();
+    void HoldTest ();
+    void LimitTest ();
+
+
+protected:
+
+    static unsigned long long   Clock   ();
+    static void                 Delay   (unsigned long us);
+
+    static unsigned long long   now;
+    static unsigned long        lastDelay;
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Pacer                   *pacer;
+    RS9110_Trace                   *trace;
+
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "RS9110_Packer_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]      = "OK\r\n";
+static const char HOST[]    = "192.168.1.2";
+static const unsigned int   HEADER_LEN  = 32;       /* "AT+RSI_SND=1,0,192.168.1.2,8000," */
+
+
+void RS9110_Packer_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    packer      = new RS9110_Packer(*rs);
+
+    mockFile->Write((unsigned char *) "", 0);
+}
+
+
+void RS9110_Packer_Test::tearDown ()
+{
+    delete packer;
+    delete rs;
+    delete mockFile;
+}
+
+
+bool RS9110_Packer_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Packer_Test);
+
+
+void RS9110_Packer_Test::PackTest ()
+{
+    RS9110_Packer::TStats stats;
+    int dst;
+
+
+    dst = packer->Open(1, HOST, 8000);
+    CPPUNIT_ASSERT(dst >= 0);
+    CPPUNIT_ASSERT(packer->GetMaxStuffedSize(dst) == RS9110_UART::MAX_SEND_DATA_SIZE_UDP);
+
+    CPPUNIT_ASSERT(packer->Append(dst, "t=21;", 5) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "h=\xDB;", 4) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "p=7;", 4) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 13);
+    CPPUNIT_ASSERT(packer->GetStuffedSize(dst) == 14);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,t=21;h=\xDB\xDD;p=7;\r\n") == 0);
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 0);
+
+    packer->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numRecords == 3);
+    CPPUNIT_ASSERT(stats.numDatagrams == 1);
+    CPPUNIT_ASSERT(stats.payloadBytes == 13);
+    CPPUNIT_ASSERT(stats.stuffedBytes == 14);
+
+    /* Wrong arguments */
+    CPPUNIT_ASSERT(packer->Open(0, HOST, 8000) == -1);
+    CPPUNIT_ASSERT(packer->Open(1, "192.168.1", 8000) == -1);
+    CPPUNIT_ASSERT(packer->Append(dst, "a", 0) == RS9110_Packer::RESULT_ERROR);
+    CPPUNIT_ASSERT(packer->Append(-1, "a", 1) == RS9110_Packer::RESULT_ERROR);
+
+    /* Destinations */
+    for(int i = 1; i < RS9110_Packer::MAX_DESTINATIONS; i++)
+    {
+        CPPUNIT_ASSERT(packer->Open(2, HOST, (unsigned short) (8000 + i)) >= 0);
+    }
+
+    CPPUNIT_ASSERT(packer->Open(2, HOST, 9000) == -1);
+    CPPUNIT_ASSERT(packer->Close(dst) == true);
+    CPPUNIT_ASSERT(packer->Close(dst) == false);
+    CPPUNIT_ASSERT(packer->Open(2, HOST, 9000) == dst);
+}
+
+
+void RS9110_Packer_Test::FullTest ()
+{
+    static char record[1500];
+    int dst = packer->Open(1, HOST, 8000);
+
+
+    memset(record, 'A', sizeof(record));
+
+    /* The record that does not fit starts the next datagram */
+    for(int i = 0; i < 14; i++)
+    {
+        CPPUNIT_ASSERT(packer->Append(dst, record, 100) == RS9110_Packer::RESULT_PACKED);
+    }
+
+    CPPUNIT_ASSERT(packer->Append(dst, record, 100) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1400 + 2));
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 100);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* Records are never split */
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1473) == RS9110_Packer::RESULT_TOO_LARGE);
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 100);
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 100 + 2));
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* A datagram left full is sent at once */
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1471) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1471 + 2));
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1000) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1000) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1000 + 2));
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 1000);
+}
+
+
+void RS9110_Packer_Test::StuffingTest ()
+{
+    static char record[1500];
+    int dst = packer->Open(1, HOST, 8000);
+
+
+    memset(record, 'A', sizeof(record));
+
+    /* Send() takes a stuffed size equal to the room only if it ends with a 2 byte sequence */
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1470) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "\r\n", 2) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1472 + 2));
+    CPPUNIT_ASSERT(memcmp(&mockFile->GetBufferData()[HEADER_LEN + 1470], "\xDB\xDC\r\n", 4) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1470) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "\r", 1) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1470) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "\xDB", 1) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1472 + 2));
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    CPPUNIT_ASSERT(packer->Append(dst, record, 1470) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, "AB", 2) == RS9110_Packer::RESULT_SENT);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == (HEADER_LEN + 1470 + 2));
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 2);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+
+    /* A datagram ending with 0x0D is not paired with the byte after it */
+    CPPUNIT_ASSERT(packer->Append(dst, "x\r\n", 3) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,x\xDB\xDC\r\n") == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(packer->Append(dst, "y\r", 2) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,y\r\r\n") == 0);
+}
+
+
+void RS9110_Packer_Test::SchedulerTest ()
+{
+    RS9110_Scheduler    scheduler(*rs);
+    char                record[RS9110_Packer::BUFFER_SIZE - 4];
+    int                 dst;
+
+
+    memset(record, 'r', sizeof(record));
+
+    packer->SetScheduler(&scheduler);
+    dst = packer->Open(1, HOST, 8000);
+
+    /* The datagram waits for the line, records that fit go with it */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    CPPUNIT_ASSERT(packer->Append(dst, "t=21;", 5) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Flush(dst) == true);
+    CPPUNIT_ASSERT(packer->Append(dst, "p=7;", 4) == RS9110_Packer::RESULT_PACKED);
+    CPPUNIT_ASSERT(packer->Append(dst, record, sizeof(record)) == RS9110_Packer::RESULT_BUSY);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,t=21;p=7;\r\n") == 0);
+    CPPUNIT_ASSERT(packer->GetPending(dst) == 0);
+
+    /* Room again once sent */
+    CPPUNIT_ASSERT(packer->Append(dst, record, sizeof(record)) == RS9110_Packer::RESULT_PACKED);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Packer.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Packer_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Packer_Test);
+    CPPUNIT_TEST(PackTest);
+    CPPUNIT_TEST(FullTest);
+    CPPUNIT_TEST(StuffingTest);
+    CPPUNIT_TEST(SchedulerTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void PackTest ();
+    void FullTest ();
+    void StuffingTest ();
+    void SchedulerTest ();
+
+
+protected:
+
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Packer                  *packer;
+
+};
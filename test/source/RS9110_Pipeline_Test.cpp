@@ -0,0 +1,224 @@
+#pragma once
+
+#include "RS9110_Pipeline_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]          = "OK\r\n";
+static const char IP_CONF_OK[]  = "OK\x00\x23\xA7\x1B\x8D\x31\xC0\xA8\x01\x0A\xFF\xFF\xFF\x00\xC0\xA8\x01\x01\r\n";
+
+
+void RS9110_Pipeline_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    pipeline    = new RS9110_Pipeline(*rs);
+
+    memset(&target, 0, sizeof(target));
+    target.band         = RS9110_UART::BAND_2_4_GHZ;
+    target.channel      = 11;
+    target.nwType       = RS9110_UART::NW_TYPE_INFRASTRUCTURE;
+    target.secMode      = RS9110_UART::SEC_MODE_WPA2;
+    target.txRate       = RS9110_UART::TX_RATE_AUTO;
+    target.txPower      = RS9110_UART::TX_POWER_HIGH;
+    target.dhcpMode     = RS9110_UART::DHCP_MANUAL;
+    strcpy(target.ssid,     "Redpine");
+    strcpy(target.psk,      "secret123");
+    strcpy(target.address,  "192.168.001.010");
+    strcpy(target.subnet,   "255.255.255.000");
+    strcpy(target.gateway,  "192.168.001.001");
+
+    target.numSockets               = 2;
+    target.sockets[0].type          = RS9110_UART::SOCKET_TCP;
+    strcpy(target.sockets[0].host,  "192.168.001.100");
+    target.sockets[0].remotePort    = 5000;
+    target.sockets[0].localPort     = 5001;
+    target.sockets[1].type          = RS9110_UART::SOCKET_LUDP;
+    target.sockets[1].localPort     = 8000;
+
+    pipeline->SetTarget(target);
+}
+
+
+void RS9110_Pipeline_Test::tearDown ()
+{
+    delete pipeline;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_Pipeline_Test::Answer (const char *command, const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), command) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(pipeline->ProcessResponse(nowMs) == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Pipeline_Test);
+
+
+void RS9110_Pipeline_Test::BringUpTest ()
+{
+    CPPUNIT_ASSERT(pipeline->Start(0) == true);
+    CPPUNIT_ASSERT(pipeline->Start(0) == false);
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_RUNNING);
+    CPPUNIT_ASSERT(pipeline->GetStep() == RS9110_Pipeline::STEP_BAND);
+
+    /* Every command is sent while the OK of the previous one is processed */
+    Answer("AT+RSI_BAND=0\r\n",                                             OK, 4, 10);
+    Answer("AT+RSI_INIT\r\n",                                               "OK\x00\x23\xA7\x1B\x8D\x31\r\n", 10, 20);
+    Answer("AT+RSI_SCAN=11,Redpine\r\n",                                    OK, 4, 30);
+    Answer("AT+RSI_NETWORK=INFRASTRUCTURE\r\n",                             OK, 4, 40);
+    Answer("AT+RSI_PSK=secret123\r\n",                                      OK, 4, 50);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",                                   OK, 4, 60);
+    Answer("AT+RSI_IPCONF=0,192.168.001.010,255.255.255.000,192.168.001.001\r\n", IP_CONF_OK, sizeof(IP_CONF_OK) - 1, 70);
+    Answer("AT+RSI_TCP=192.168.001.100,5000,5001\r\n",                      "OK\x03\r\n", 5, 80);
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_RUNNING);
+    Answer("AT+RSI_LUDP=8000\r\n",                                          "OK\x05\r\n", 5, 90);
+
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_DONE);
+    CPPUNIT_ASSERT(pipeline->GetFailure() == RS9110_Pipeline::FAILURE_NONE);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(0) == 3);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(1) == 5);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(2) == 0);
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 2);
+
+    /* Nothing else is consumed once done */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    CPPUNIT_ASSERT(pipeline->ProcessResponse(100) == false);
+}
+
+
+void RS9110_Pipeline_Test::StepsTest ()
+{
+    RS9110_Pipeline::TTarget    learned;
+    char                        params[2 + sizeof(RS9110_UART::TNetworkParams) + 2];
+    unsigned int                steps;
+
+
+    /* Open network with an unknown channel, DHCP and no sockets */
+    target.channel      = 0;
+    target.secMode      = RS9110_UART::SEC_MODE_OPEN;
+    target.dhcpMode     = RS9110_UART::DHCP_DHCP;
+    target.numSockets   = 0;
+    pipeline->SetTarget(target);
+
+    steps = pipeline->GetRequiredSteps();
+    CPPUNIT_ASSERT((steps & (1 << RS9110_Pipeline::STEP_PSK)) == 0);
+    CPPUNIT_ASSERT((steps & (1 << RS9110_Pipeline::STEP_OPEN_SOCKETS)) == 0);
+    CPPUNIT_ASSERT((steps & (1 << RS9110_Pipeline::STEP_GET_PARAMS)) != 0);
+
+    /* Module already configured: only scan, join and IP */
+    CPPUNIT_ASSERT(pipeline->Start(0, ~((1 << RS9110_Pipeline::STEP_BAND) | (1 << RS9110_Pipeline::STEP_INIT) | (1 << RS9110_Pipeline::STEP_NETWORK_TYPE))) == true);
+
+    memset(params, 0, sizeof(params));
+    memcpy(params, "OK", 2);
+    params[2 + offsetof(RS9110_UART::TNetworkParams, channel)] = 6;
+    memcpy(&params[sizeof(params) - 2], "\r\n", 2);
+
+    Answer("AT+RSI_SCAN=0,Redpine\r\n",         OK, 4, 10);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       OK, 4, 20);
+    Answer("AT+RSI_IPCONF=1,0,0\r\n",           IP_CONF_OK, sizeof(IP_CONF_OK) - 1, 30);
+    Answer("AT+RSI_NWPARAMS?\r\n",              params, sizeof(params), 40);
+
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_DONE);
+
+    pipeline->GetTarget(learned);
+    CPPUNIT_ASSERT(learned.channel == 6);
+    CPPUNIT_ASSERT((pipeline->GetRequiredSteps() & (1 << RS9110_Pipeline::STEP_GET_PARAMS)) == 0);
+
+    /* 63 byte PSK mode: feature select bit 3 before the PSK */
+    target.isPskExt = true;
+    pipeline->SetTarget(target);
+    CPPUNIT_ASSERT((pipeline->GetRequiredSteps() & (1 << RS9110_Pipeline::STEP_FEATURE_SELECT)) == 0);
+
+    target.secMode = RS9110_UART::SEC_MODE_WPA2;
+    pipeline->SetTarget(target);
+    CPPUNIT_ASSERT(pipeline->Start(100, (1 << RS9110_Pipeline::STEP_FEATURE_SELECT) | (1 << RS9110_Pipeline::STEP_PSK)) == true);
+    Answer("AT+RSI_FEAT_SEL=8\r\n",            OK, 4, 110);
+    Answer("AT+RSI_PSK=secret123\r\n",         OK, 4, 120);
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_DONE);
+
+    /* A full scan ignores the known channel */
+    CPPUNIT_ASSERT(pipeline->Start(100, (1 << RS9110_Pipeline::STEP_SCAN), true) == true);
+    Answer("AT+RSI_SCAN=0,Redpine\r\n",         OK, 4, 110);
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_DONE);
+}
+
+
+void RS9110_Pipeline_Test::ErrorTest ()
+{
+    CPPUNIT_ASSERT(pipeline->Start(0, (1 << RS9110_Pipeline::STEP_JOIN) | (1 << RS9110_Pipeline::STEP_IP_CONF)) == true);
+
+    /* The failing step and its error code are reported */
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       "ERROR\xEC\r\n", 8, 10);
+
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_FAILED);
+    CPPUNIT_ASSERT(pipeline->GetStep() == RS9110_Pipeline::STEP_JOIN);
+    CPPUNIT_ASSERT(pipeline->GetFailure() == RS9110_Pipeline::FAILURE_ERROR);
+    CPPUNIT_ASSERT(pipeline->GetErrorCode() == RS9110_UART::ERROR_NO_NW);
+    CPPUNIT_ASSERT(strcmp(RS9110_Pipeline::GetStepName(pipeline->GetStep()), "JOIN") == 0);
+
+    /* A socket type that cannot be opened is not sent */
+    target.sockets[1].type = RS9110_UART::SOCKET_MULTICAST;
+    pipeline->SetTarget(target);
+
+    CPPUNIT_ASSERT(pipeline->Start(100, (1 << RS9110_Pipeline::STEP_OPEN_SOCKETS)) == true);
+    Answer("AT+RSI_TCP=192.168.001.100,5000,5001\r\n", "OK\x01\r\n", 5, 110);
+
+    /* The socket already opened is closed first */
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_RUNNING);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(0) == 1);
+    Answer("AT+RSI_CLS=1\r\n",                 OK, 4, 120);
+
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_FAILED);
+    CPPUNIT_ASSERT(pipeline->GetStep() == RS9110_Pipeline::STEP_OPEN_SOCKETS);
+    CPPUNIT_ASSERT(pipeline->GetFailure() == RS9110_Pipeline::FAILURE_NOT_SENT);
+    CPPUNIT_ASSERT(pipeline->GetErrorCode() == RS9110_UART::ERROR_NONE);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(0) == 0);
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 0);
+
+    /* A close not answered in time leaves the socket open */
+    target.numSockets = 3;
+    target.sockets[1].type = RS9110_UART::SOCKET_LUDP;
+    target.sockets[2].type = RS9110_UART::SOCKET_LUDP;
+    target.sockets[2].localPort = 8001;
+    pipeline->SetTarget(target);
+
+    CPPUNIT_ASSERT(pipeline->Start(200, (1 << RS9110_Pipeline::STEP_OPEN_SOCKETS)) == true);
+    Answer("AT+RSI_TCP=192.168.001.100,5000,5001\r\n", "OK\x01\r\n", 5, 210);
+    Answer("AT+RSI_LUDP=8000\r\n",             "OK\x02\r\n", 5, 220);
+    Answer("AT+RSI_LUDP=8001\r\n",             "ERROR\xEC\r\n", 8, 230);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_CLS=2\r\n") == 0);
+    CPPUNIT_ASSERT(pipeline->Poll(230 + RS9110_Pipeline::DEFAULT_TIMEOUT_MS) == RS9110_Pipeline::STATE_RUNNING);
+    Answer("AT+RSI_CLS=1\r\n",                 OK, 4, 240);
+
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_FAILED);
+    CPPUNIT_ASSERT(pipeline->GetFailure() == RS9110_Pipeline::FAILURE_ERROR);
+    CPPUNIT_ASSERT(pipeline->GetErrorCode() == RS9110_UART::ERROR_NO_NW);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(0) == 0);
+    CPPUNIT_ASSERT(pipeline->GetSocketId(1) == 2);
+}
+
+
+void RS9110_Pipeline_Test::TimeoutTest ()
+{
+    pipeline->SetTimeout(300);
+
+    CPPUNIT_ASSERT(pipeline->Start(1000) == true);
+    CPPUNIT_ASSERT(pipeline->Poll(1299) == RS9110_Pipeline::STATE_RUNNING);
+    CPPUNIT_ASSERT(pipeline->Poll(1300) == RS9110_Pipeline::STATE_FAILED);
+    CPPUNIT_ASSERT(pipeline->GetStep() == RS9110_Pipeline::STEP_BAND);
+    CPPUNIT_ASSERT(pipeline->GetFailure() == RS9110_Pipeline::FAILURE_TIMEOUT);
+
+    /* A late answer is ignored */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(pipeline->ProcessResponse(1400) == false);
+
+    pipeline->Stop();
+    CPPUNIT_ASSERT(pipeline->GetState() == RS9110_Pipeline::STATE_IDLE);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Pipeline.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Pipeline_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Pipeline_Test);
+    CPPUNIT_TEST(BringUpTest);
+    CPPUNIT_TEST(StepsTest);
+    CPPUNIT_TEST(ErrorTest);
+    CPPUNIT_TEST(TimeoutTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void BringUpTest ();
+    void StepsTest ();
+    void ErrorTest ();
+    void TimeoutTest ();
+
+
+protected:
+
+    void Answer     (const char *command, const char *response, int size, unsigned long nowMs);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Pipeline                *pipeline;
+    RS9110_Pipeline::TTarget        target;
+
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "RS9110_Provision_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]          = "OK\r\n";
+static const char IP_CONF_OK[]  = "OK\x00\x23\xA7\x1B\x8D\x31\xC0\xA8\x01\x0A\xFF\xFF\xFF\x00\xC0\xA8\x01\x01\r\n";
+
+
+void RS9110_Provision_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    provision   = new RS9110_Provision(*rs);
+
+    memset(&target, 0, sizeof(target));
+    target.band         = RS9110_UART::BAND_2_4_GHZ;
+    target.nwType       = RS9110_UART::NW_TYPE_INFRASTRUCTURE;
+    target.secMode      = RS9110_UART::SEC_MODE_WPA2;
+    target.txRate       = RS9110_UART::TX_RATE_AUTO;
+    target.txPower      = RS9110_UART::TX_POWER_HIGH;
+    target.dhcpMode     = RS9110_UART::DHCP_MANUAL;
+    strcpy(target.ssid,     "Redpine");
+    strcpy(target.psk,      "secret123");
+    strcpy(target.address,  "192.168.1.10");
+    strcpy(target.subnet,   "255.255.255.0");
+    strcpy(target.gateway,  "192.168.1.1");
+
+    provision->SetTarget(target);
+
+    /* Same configuration as stored by the module */
+    memset(&stored, 0, sizeof(stored));
+    stored.isValid      = RS9110_Provision::CONFIG_VALID;
+    stored.channel      = 6;
+    stored.nwType       = 0x01;
+    stored.secMode      = RS9110_UART::SEC_MODE_WPA2;
+    stored.dataRate     = RS9110_UART::TX_RATE_AUTO;
+    stored.powerLevel   = RS9110_UART::TX_POWER_HIGH;
+    stored.dhcp         = 0x00;
+    memcpy(stored.psk,      "secret123", 9);
+    memcpy(stored.ssid,     "Redpine", 7);
+    memcpy(stored.address,  "\xC0\xA8\x01\x0A", 4);
+    memcpy(stored.subnet,   "\xFF\xFF\xFF\x00", 4);
+    memcpy(stored.gateway,  "\xC0\xA8\x01\x01", 4);
+}
+
+
+void RS9110_Provision_Test::tearDown ()
+{
+    delete provision;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_Provision_Test::Answer (const char *command, const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), command) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(provision->ProcessResponse(nowMs) == true);
+}
+
+
+void RS9110_Provision_Test::AnswerConfig (unsigned long nowMs)
+{
+    char response[2 + sizeof(RS9110_UART::TStoredConfig) + 2];
+
+
+    memcpy(response, "OK", 2);
+    memcpy(&response[2], &stored, sizeof(stored));
+    memcpy(&response[sizeof(response) - 2], "\r\n", 2);
+
+    Answer("AT+RSI_CFGGET?\r\n", response, sizeof(response), nowMs);
+}
+
+
+void RS9110_Provision_Test::BringUp (unsigned long nowMs)
+{
+    char params[2 + sizeof(RS9110_UART::TNetworkParams) + 2];
+
+
+    memset(params, 0, sizeof(params));
+    memcpy(params, "OK", 2);
+    params[2 + offsetof(RS9110_UART::TNetworkParams, channel)] = 6;
+    memcpy(&params[sizeof(params) - 2], "\r\n", 2);
+
+    Answer("AT+RSI_BAND=0\r\n",                 OK, 4, nowMs + 10);
+    Answer("AT+RSI_INIT\r\n",                   "OK\x00\x23\xA7\x1B\x8D\x31\r\n", 10, nowMs + 20);
+    Answer("AT+RSI_SCAN=0,Redpine\r\n",         OK, 4, nowMs + 30);
+    Answer("AT+RSI_NETWORK=INFRASTRUCTURE\r\n", OK, 4, nowMs + 40);
+    Answer("AT+RSI_PSK=secret123\r\n",          OK, 4, nowMs + 50);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       OK, 4, nowMs + 60);
+    Answer("AT+RSI_IPCONF=0,192.168.1.10,255.255.255.0,192.168.1.1\r\n", IP_CONF_OK, sizeof(IP_CONF_OK) - 1, nowMs + 70);
+    Answer("AT+RSI_NWPARAMS?\r\n",              params, sizeof(params), nowMs + 80);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Provision_Test);
+
+
+void RS9110_Provision_Test::DiffTest ()
+{
+    RS9110_UART::TStoredConfig  changed;
+    unsigned char               config[sizeof(RS9110_UART::TStoredConfig) + sizeof(RS9110_UART::TStoredConfigWEP)];
+    RS9110_UART::TStoredConfigWEP *wep = (RS9110_UART::TStoredConfigWEP *) &config[sizeof(RS9110_UART::TStoredConfig)];
+
+
+    CPPUNIT_ASSERT(RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &stored, sizeof(stored)) == 0);
+    CPPUNIT_ASSERT(RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &stored, sizeof(stored) - 1) == RS9110_Provision::FIELD_VALID);
+    CPPUNIT_ASSERT(RS9110_Provision::DiffStoredConfig(target, NULL, 0) == RS9110_Provision::FIELD_VALID);
+
+    /* Valid flag is small endian */
+    memcpy(&changed, &stored, sizeof(changed));
+    ((unsigned char *) &changed.isValid)[0] = 0x00;
+    ((unsigned char *) &changed.isValid)[1] = 0x01;
+    CPPUNIT_ASSERT(RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) == RS9110_Provision::FIELD_VALID);
+
+    /* Every field on its own */
+    memcpy(&changed, &stored, sizeof(changed));
+    changed.channel     = 11;
+    changed.powerLevel  = RS9110_UART::TX_POWER_LOW;
+    changed.ssid[7]     = 'X';
+    changed.gateway[3]  = 0xFE;
+    CPPUNIT_ASSERT(RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) ==
+                   (RS9110_Provision::FIELD_POWER_LEVEL | RS9110_Provision::FIELD_SSID | RS9110_Provision::FIELD_ADDRESS));
+
+    target.channel = 6;
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) & RS9110_Provision::FIELD_CHANNEL) != 0);
+
+    /* Addresses are not compared with DHCP */
+    target.dhcpMode = RS9110_UART::DHCP_DHCP;
+    changed.dhcp    = 0x01;
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) & RS9110_Provision::FIELD_ADDRESS) == 0);
+
+    /* PSK over 32 bytes unless 63 byte mode is stored */
+    strcpy(target.psk, "0123456789012345678901234567890123456789");
+    memcpy(changed.psk, target.psk, 32);
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) & RS9110_Provision::FIELD_PSK) != 0);
+    memcpy(changed.psk, target.psk, strlen(target.psk));
+    changed.featureSelect[0] = RS9110_Provision::FEATURE_PSK_EXT;
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, (unsigned char *) &changed, sizeof(changed)) & RS9110_Provision::FIELD_PSK) == 0);
+
+    /* WEP configuration only present with bit 7 of the feature select */
+    target.secMode      = RS9110_UART::SEC_MODE_WEP;
+    target.authMode     = RS9110_UART::AUTH_MODE_WEP_SHARED;
+    target.wepKeyIndex  = 1;
+    strcpy(target.wepKeys[1], "ABCDEF0123");
+    changed.secMode     = RS9110_UART::SEC_MODE_WEP;
+
+    memset(config, 0, sizeof(config));
+    memcpy(config, &changed, sizeof(changed));
+    wep->authMode       = RS9110_UART::AUTH_MODE_WEP_SHARED;
+    wep->index          = 1;
+    memcpy(wep->keys[1], "ABCDEF0123", 10);
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, config, sizeof(config)) & RS9110_Provision::FIELD_WEP) != 0);
+
+    ((RS9110_UART::TStoredConfig *) config)->featureSelect[0] |= RS9110_Provision::FEATURE_WEP_CONFIG;
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, config, sizeof(config)) & RS9110_Provision::FIELD_WEP) == 0);
+    CPPUNIT_ASSERT((RS9110_Provision::DiffStoredConfig(target, config, sizeof(changed)) & RS9110_Provision::FIELD_WEP) != 0);
+}
+
+
+void RS9110_Provision_Test::AutoJoinTest ()
+{
+    CPPUNIT_ASSERT(provision->Start(0) == true);
+    CPPUNIT_ASSERT(provision->Start(0) == false);
+
+    /* Same configuration: nothing written, the module joins after the band */
+    AnswerConfig(10);
+    CPPUNIT_ASSERT(provision->GetResult() == RS9110_Provision::RESULT_AUTO_JOIN);
+    CPPUNIT_ASSERT(provision->GetDiff() == 0);
+    CPPUNIT_ASSERT(provision->GetPipeline().GetTarget().channel == 6);
+
+    Answer("AT+RSI_BAND=0\r\n", OK, 4, 20);
+    CPPUNIT_ASSERT(provision->GetState() == RS9110_Provision::STATE_DONE);
+
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    CPPUNIT_ASSERT(provision->ProcessResponse(30) == false);
+}
+
+
+void RS9110_Provision_Test::ReprovisionTest ()
+{
+    /* A different AP: stop the auto-join, bring up and store again */
+    stored.ssid[0] = 'X';
+
+    CPPUNIT_ASSERT(provision->Start(0) == true);
+    AnswerConfig(10);
+    CPPUNIT_ASSERT(provision->GetResult() == RS9110_Provision::RESULT_PROVISIONED);
+    CPPUNIT_ASSERT(provision->GetDiff() == RS9110_Provision::FIELD_SSID);
+
+    Answer("AT+RSI_CFGENABLE=0\r\n",    OK, 4, 20);
+    BringUp(20);
+    Answer("AT+RSI_CFGSAVE\r\n",        OK, 4, 100);
+    Answer("AT+RSI_CFGENABLE=1\r\n",    OK, 4, 110);
+
+    CPPUNIT_ASSERT(provision->GetState() == RS9110_Provision::STATE_DONE);
+
+    /* Failures are reported with the command and its error code */
+    CPPUNIT_ASSERT(provision->Start(200) == true);
+    AnswerConfig(210);
+    Answer("AT+RSI_CFGENABLE=0\r\n",    "ERROR\xF2\r\n", 8, 220);
+
+    CPPUNIT_ASSERT(provision->GetState() == RS9110_Provision::STATE_FAILED);
+    CPPUNIT_ASSERT(provision->GetFailedCommand() == RS9110_UART::CMD_ENABLE_CONFIG);
+    CPPUNIT_ASSERT(provision->GetErrorCode() == RS9110_UART::ERROR_MULTIPLE_1);
+}
+
+
+void RS9110_Provision_Test::NotEnabledTest ()
+{
+    provision->SetTimeout(500);
+
+    /* Nothing stored: no need to disable the auto-join first */
+    CPPUNIT_ASSERT(provision->Start(0) == true);
+    Answer("AT+RSI_CFGGET?\r\n",        "ERROR\xF2\r\n", 8, 10);
+    CPPUNIT_ASSERT(provision->GetResult() == RS9110_Provision::RESULT_PROVISIONED);
+    CPPUNIT_ASSERT(provision->GetDiff() == RS9110_Provision::FIELD_VALID);
+
+    BringUp(10);
+    Answer("AT+RSI_CFGSAVE\r\n",        OK, 4, 100);
+
+    /* Timeouts are reported with the command too */
+    CPPUNIT_ASSERT(provision->Poll(599) == RS9110_Provision::STATE_RUNNING);
+    CPPUNIT_ASSERT(provision->Poll(600) == RS9110_Provision::STATE_FAILED);
+    CPPUNIT_ASSERT(provision->GetFailedCommand() == RS9110_UART::CMD_ENABLE_CONFIG);
+    CPPUNIT_ASSERT(provision->GetErrorCode() == RS9110_UART::ERROR_NONE);
+}
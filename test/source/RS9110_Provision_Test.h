@@ -0,0 +1,43 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Provision.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Provision_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Provision_Test);
+    CPPUNIT_TEST(DiffTest);
+    CPPUNIT_TEST(AutoJoinTest);
+    CPPUNIT_TEST(ReprovisionTest);
+    CPPUNIT_TEST(NotEnabledTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void DiffTest ();
+    void AutoJoinTest ();
+    void ReprovisionTest ();
+    void NotEnabledTest ();
+
+
+protected:
+
+    void Answer       (const char *command, const char *response, int size, unsigned long nowMs);
+    void AnswerConfig (unsigned long nowMs);
+    void BringUp      (unsigned long nowMs);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Provision               *provision;
+    RS9110_Pipeline::TTarget        target;
+    RS9110_UART::TStoredConfig      stored;
+
+};
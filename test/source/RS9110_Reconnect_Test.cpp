@@ -0,0 +1,183 @@
+#pragma once
+
+#include "RS9110_Reconnect_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]          = "OK\r\n";
+static const char IP_CONF_OK[]  = "OK\x00\x23\xA7\x1B\x8D\x31\xC0\xA8\x01\x0A\xFF\xFF\xFF\x00\xC0\xA8\x01\x01\r\n";
+
+
+void RS9110_Reconnect_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    reconnect   = new RS9110_Reconnect(*rs);
+
+    memset(&profile, 0, sizeof(profile));
+    profile.band        = RS9110_UART::BAND_2_4_GHZ;
+    profile.nwType      = RS9110_UART::NW_TYPE_INFRASTRUCTURE;
+    profile.secMode     = RS9110_UART::SEC_MODE_WPA2;
+    profile.txRate      = RS9110_UART::TX_RATE_AUTO;
+    profile.txPower     = RS9110_UART::TX_POWER_HIGH;
+    profile.dhcpMode    = RS9110_UART::DHCP_DHCP;
+    strcpy(profile.ssid, "Redpine");
+    strcpy(profile.psk, "secret123");
+
+    reconnect->SetProfile(profile);
+}
+
+
+void RS9110_Reconnect_Test::tearDown ()
+{
+    delete reconnect;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_Reconnect_Test::Answer (const char *command, const char *response, int size, unsigned long nowMs)
+{
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), command) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(reconnect->ProcessResponse(nowMs) == true);
+}
+
+
+void RS9110_Reconnect_Test::BringUp ()
+{
+    char params[2 + sizeof(RS9110_UART::TNetworkParams) + 2];
+
+
+    memset(params, 0, sizeof(params));
+    memcpy(params, "OK", 2);
+    params[2 + offsetof(RS9110_UART::TNetworkParams, channel)] = 6;
+    memcpy(&params[sizeof(params) - 2], "\r\n", 2);
+
+    CPPUNIT_ASSERT(reconnect->Connect(0) == true);
+    CPPUNIT_ASSERT(reconnect->Connect(0) == false);
+    CPPUNIT_ASSERT(reconnect->GetState() == RS9110_Reconnect::STATE_CONNECTING);
+
+    Answer("AT+RSI_BAND=0\r\n",                 OK, 4, 10);
+    Answer("AT+RSI_INIT\r\n",                   "OK\x00\x23\xA7\x1B\x8D\x31\r\n", 10, 20);
+    Answer("AT+RSI_SCAN=0,Redpine\r\n",         OK, 4, 30);
+    Answer("AT+RSI_NETWORK=INFRASTRUCTURE\r\n", OK, 4, 40);
+    Answer("AT+RSI_PSK=secret123\r\n",          OK, 4, 50);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       OK, 4, 60);
+    Answer("AT+RSI_IPCONF=1,0,0\r\n",           IP_CONF_OK, sizeof(IP_CONF_OK) - 1, 70);
+    Answer("AT+RSI_NWPARAMS?\r\n",              params, sizeof(params), 80);
+
+    CPPUNIT_ASSERT(reconnect->GetState() == RS9110_Reconnect::STATE_CONNECTED);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Reconnect_Test);
+
+
+void RS9110_Reconnect_Test::FullBringUpTest ()
+{
+    RS9110_Reconnect::TProfile  learned;
+    RS9110_Reconnect::TStats    stats;
+
+
+    BringUp();
+
+    /* Channel learned from the network parameters */
+    reconnect->GetProfile(learned);
+    CPPUNIT_ASSERT(learned.channel == 6);
+
+    /* First bring-up is not a reconnection */
+    reconnect->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numReconnects == 0);
+
+    /* Unrelated answers are ignored */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    CPPUNIT_ASSERT(reconnect->ProcessResponse(100) == false);
+}
+
+
+void RS9110_Reconnect_Test::FastReconnectTest ()
+{
+    RS9110_Reconnect::TStats stats;
+
+
+    BringUp();
+
+    /* Deauthentication triggers the minimal sequence on the known channel */
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\xFD\r\n", 8) == true);
+    CPPUNIT_ASSERT(reconnect->ProcessResponse(1000) == true);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_FAST);
+
+    Answer("AT+RSI_SCAN=6,Redpine\r\n",         OK, 4, 1100);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       OK, 4, 1200);
+    Answer("AT+RSI_IPCONF=1,0,0\r\n",           IP_CONF_OK, sizeof(IP_CONF_OK) - 1, 1250);
+
+    CPPUNIT_ASSERT(reconnect->GetState() == RS9110_Reconnect::STATE_CONNECTED);
+
+    reconnect->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numReconnects == 1);
+    CPPUNIT_ASSERT(stats.successes[RS9110_Reconnect::LEVEL_FAST] == 1);
+    CPPUNIT_ASSERT(stats.lastReconnectMs == 250);
+    CPPUNIT_ASSERT(stats.maxReconnectMs == 250);
+    CPPUNIT_ASSERT(stats.lastLevel == RS9110_Reconnect::LEVEL_FAST);
+}
+
+
+void RS9110_Reconnect_Test::FallbackTest ()
+{
+    RS9110_Reconnect::TStats stats;
+
+
+    BringUp();
+    reconnect->SetTiming(1000, 500, 2);
+
+    CPPUNIT_ASSERT(reconnect->LinkLost(1000) == true);
+
+    /* Fast fails, rejoin fails, full fails twice */
+    Answer("AT+RSI_SCAN=6,Redpine\r\n",         "ERROR\xF3\r\n", 8, 1010);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_REJOIN);
+    Answer("AT+RSI_SCAN=6,Redpine\r\n",         OK, 4, 1020);
+    Answer("AT+RSI_NETWORK=INFRASTRUCTURE\r\n", OK, 4, 1030);
+    Answer("AT+RSI_PSK=secret123\r\n",          OK, 4, 1040);
+    Answer("AT+RSI_JOIN=Redpine,0,2\r\n",       "ERROR\xEC\r\n", 8, 1050);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_FULL);
+    Answer("AT+RSI_BAND=0\r\n",                 "ERROR\xF8\r\n", 8, 1060);
+
+    CPPUNIT_ASSERT(reconnect->Poll(1100) == RS9110_Reconnect::STATE_CONNECTING);
+    CPPUNIT_ASSERT(reconnect->Poll(1560) == RS9110_Reconnect::STATE_CONNECTING);
+    Answer("AT+RSI_BAND=0\r\n",                 "ERROR\xF8\r\n", 8, 1570);
+    CPPUNIT_ASSERT(reconnect->GetState() == RS9110_Reconnect::STATE_FAILED);
+
+    reconnect->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numFailures == 1);
+    CPPUNIT_ASSERT(stats.numReconnects == 0);
+
+    /* A new loss starts over */
+    CPPUNIT_ASSERT(reconnect->LinkLost(2000) == true);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_FAST);
+}
+
+
+void RS9110_Reconnect_Test::TimeoutTest ()
+{
+    BringUp();
+    reconnect->SetTiming(300, 0, 1);
+
+    CPPUNIT_ASSERT(reconnect->LinkLost(1000) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SCAN=6,Redpine\r\n") == 0);
+
+    CPPUNIT_ASSERT(reconnect->Poll(1299) == RS9110_Reconnect::STATE_CONNECTING);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_FAST);
+    CPPUNIT_ASSERT(reconnect->Poll(1300) == RS9110_Reconnect::STATE_CONNECTING);
+    CPPUNIT_ASSERT(reconnect->GetLevel() == RS9110_Reconnect::LEVEL_REJOIN);
+
+    /* Rejoin starts over from the scan */
+    Answer("AT+RSI_SCAN=6,Redpine\r\n",         OK, 4, 1310);
+    Answer("AT+RSI_NETWORK=INFRASTRUCTURE\r\n", OK, 4, 1320);
+
+    reconnect->Stop();
+    CPPUNIT_ASSERT(reconnect->GetState() == RS9110_Reconnect::STATE_IDLE);
+    CPPUNIT_ASSERT(reconnect->Poll(5000) == RS9110_Reconnect::STATE_IDLE);
+}
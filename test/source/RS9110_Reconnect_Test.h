@@ -0,0 +1,41 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Reconnect.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Reconnect_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Reconnect_Test);
+    CPPUNIT_TEST(FullBringUpTest);
+    CPPUNIT_TEST(FastReconnectTest);
+    CPPUNIT_TEST(FallbackTest);
+    CPPUNIT_TEST(TimeoutTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void FullBringUpTest ();
+    void FastReconnectTest ();
+    void FallbackTest ();
+    void TimeoutTest ();
+
+
+protected:
+
+    void Answer     (const char *command, const char *response, int size, unsigned long nowMs);
+    void BringUp    ();
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Reconnect               *reconnect;
+    RS9110_Reconnect::TProfile      profile;
+
+};
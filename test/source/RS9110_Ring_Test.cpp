@@ -0,0 +1,179 @@
+#pragma once
+
+#include "RS9110_Ring_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+#include <string.h>
+
+
+void RS9110_Ring_Test::setUp ()
+{
+    footprint   = RS9110_Ring::GetFootprint(DATA_SIZE);
+    producer    = new RS9110_Ring();
+    consumer    = new RS9110_Ring();
+
+    memset(memory, 0xAA, sizeof(memory));
+
+    CPPUNIT_ASSERT(footprint <= sizeof(memory));
+    CPPUNIT_ASSERT(producer->Attach(memory, footprint, true) == true);
+    CPPUNIT_ASSERT(consumer->Attach(memory, footprint, false) == true);
+}
+
+
+void RS9110_Ring_Test::tearDown ()
+{
+    delete producer;
+    delete consumer;
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Ring_Test);
+
+
+void RS9110_Ring_Test::AttachTest ()
+{
+    RS9110_Ring     ring;
+    unsigned short  size;
+
+
+    CPPUNIT_ASSERT(ring.IsAttached() == false);
+    CPPUNIT_ASSERT(ring.Reserve(1) == NULL);
+    CPPUNIT_ASSERT(ring.Peek(size) == NULL);
+    CPPUNIT_ASSERT(ring.Attach(NULL, footprint, true) == false);
+    CPPUNIT_ASSERT(ring.Attach(memory, 4, true) == false);
+
+    /* The size seen by the other side must match */
+    CPPUNIT_ASSERT(ring.Attach(memory, footprint - 1, false) == false);
+    CPPUNIT_ASSERT(ring.Attach(memory, footprint, false) == true);
+    CPPUNIT_ASSERT(ring.IsAttached() == true);
+    CPPUNIT_ASSERT(ring.IsEmpty() == true);
+
+    ring.Detach();
+    CPPUNIT_ASSERT(ring.IsAttached() == false);
+    CPPUNIT_ASSERT(producer->Write("abc", 3) == true);
+    CPPUNIT_ASSERT(ring.Write("abc", 3) == false);
+}
+
+
+void RS9110_Ring_Test::WrapTest ()
+{
+    const char     *record;
+    char           *reserved;
+    unsigned short  size;
+    char            data[40];
+
+
+    memset(data, 'x', sizeof(data));
+
+    /* 2 + 20 and 2 + 30 bytes: 12 bytes left at the end */
+    CPPUNIT_ASSERT(producer->Write(data, 20) == true);
+    CPPUNIT_ASSERT(producer->Write(data, 30) == true);
+
+    record = consumer->Peek(size);
+    CPPUNIT_ASSERT((record != NULL) && (size == 20));
+    consumer->Release();
+
+    /* Does not fit at the end: starts again at 0, in one piece */
+    reserved = producer->Reserve(15);
+    CPPUNIT_ASSERT(reserved == ((char *) memory + (footprint - DATA_SIZE) + 2));
+    memcpy(reserved, "0123456789ABCDE", 15);
+    producer->Commit(15);
+
+    record = consumer->Peek(size);
+    CPPUNIT_ASSERT((record != NULL) && (size == 30));
+    consumer->Release();
+
+    record = consumer->Peek(size);
+    CPPUNIT_ASSERT((record != NULL) && (size == 15));
+    CPPUNIT_ASSERT(record == reserved);
+    CPPUNIT_ASSERT(memcmp(record, "0123456789ABCDE", 15) == 0);
+    consumer->Release();
+
+    CPPUNIT_ASSERT(consumer->IsEmpty() == true);
+
+    /* Empty records are kept too */
+    CPPUNIT_ASSERT(producer->Write(data, 0) == true);
+    CPPUNIT_ASSERT((consumer->Peek(size) != NULL) && (size == 0));
+    consumer->Release();
+    CPPUNIT_ASSERT(consumer->IsEmpty() == true);
+}
+
+
+void RS9110_Ring_Test::FullTest ()
+{
+    unsigned short  size;
+    char            data[DATA_SIZE];
+
+
+    memset(data, 'y', sizeof(data));
+
+    /* A record filling the whole ring would make it look empty */
+    CPPUNIT_ASSERT(producer->Reserve(DATA_SIZE - 2) == NULL);
+    CPPUNIT_ASSERT(producer->Write(data, DATA_SIZE - 3) == true);
+    CPPUNIT_ASSERT(producer->Write(data, 0) == false);
+
+    CPPUNIT_ASSERT((consumer->Peek(size) != NULL) && (size == (DATA_SIZE - 3)));
+    consumer->Release();
+    CPPUNIT_ASSERT(consumer->IsEmpty() == true);
+
+    /* Head chasing the tail */
+    CPPUNIT_ASSERT(producer->Write(data, 10) == true);
+    CPPUNIT_ASSERT(producer->Write(data, 10) == true);
+    consumer->Release();
+    CPPUNIT_ASSERT(producer->Write(data, 30) == true);
+    CPPUNIT_ASSERT(producer->Write(data, 10) == false);
+    CPPUNIT_ASSERT(producer->Write(data, 9) == true);
+    CPPUNIT_ASSERT(producer->Write(data, 0) == false);
+
+    CPPUNIT_ASSERT((consumer->Peek(size) != NULL) && (size == 10));
+    consumer->Release();
+    CPPUNIT_ASSERT((consumer->Peek(size) != NULL) && (size == 30));
+    consumer->Release();
+    CPPUNIT_ASSERT((consumer->Peek(size) != NULL) && (size == 9));
+    consumer->Release();
+    CPPUNIT_ASSERT(consumer->IsEmpty() == true);
+}
+
+
+void RS9110_Ring_Test::CorruptTest ()
+{
+    char           *data   = (char *) memory + RS9110_Ring::GetFootprint(0);
+    unsigned short  length;
+    unsigned short  size;
+
+
+    /* Record longer than what the producer published */
+    CPPUNIT_ASSERT(producer->Write("0123456789", 10) == true);
+    length = 40;
+    memcpy(data, &length, sizeof(length));
+    CPPUNIT_ASSERT(consumer->Peek(size) == NULL);
+    CPPUNIT_ASSERT(consumer->IsCorrupt() == true);
+    CPPUNIT_ASSERT(consumer->IsEmpty() == true);
+    CPPUNIT_ASSERT(producer->IsCorrupt() == false);
+
+    /* Skip of the end while the head is still ahead */
+    CPPUNIT_ASSERT(producer->Attach(memory, footprint, true) == true);
+    CPPUNIT_ASSERT(consumer->Attach(memory, footprint, false) == true);
+    CPPUNIT_ASSERT(consumer->IsCorrupt() == false);
+    CPPUNIT_ASSERT(producer->Write("0123456789", 10) == true);
+    length = 0xFFFF;
+    memcpy(data, &length, sizeof(length));
+    CPPUNIT_ASSERT(consumer->Peek(size) == NULL);
+    CPPUNIT_ASSERT(consumer->IsCorrupt() == true);
+
+    /* Head out of the ring */
+    CPPUNIT_ASSERT(producer->Attach(memory, footprint, true) == true);
+    CPPUNIT_ASSERT(consumer->Attach(memory, footprint, false) == true);
+    memory[0] = DATA_SIZE + 2;
+    CPPUNIT_ASSERT(consumer->Peek(size) == NULL);
+    CPPUNIT_ASSERT(consumer->IsCorrupt() == true);
+
+    /* Tail out of the ring */
+    CPPUNIT_ASSERT(producer->Attach(memory, footprint, true) == true);
+    memory[1] = DATA_SIZE;
+    CPPUNIT_ASSERT(producer->Reserve(1) == NULL);
+    CPPUNIT_ASSERT(producer->IsCorrupt() == true);
+    memory[1] = 0;
+    CPPUNIT_ASSERT(producer->Write("abc", 3) == false);
+}
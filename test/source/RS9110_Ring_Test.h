@@ -0,0 +1,38 @@
+#pragma once
+
+#include "RS9110_Ring.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Ring_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Ring_Test);
+    CPPUNIT_TEST(AttachTest);
+    CPPUNIT_TEST(WrapTest);
+    CPPUNIT_TEST(FullTest);
+    CPPUNIT_TEST(CorruptTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void AttachTest ();
+    void WrapTest ();
+    void FullTest ();
+    void CorruptTest ();
+
+
+protected:
+
+    static const unsigned long  DATA_SIZE   = 64;
+
+    unsigned long               memory[(DATA_SIZE + 64) / sizeof(unsigned long)];
+    unsigned long               footprint;
+    RS9110_Ring                *producer;
+    RS9110_Ring                *consumer;
+
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "RS9110_ScanTable_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const unsigned char BSSID_A[RS9110_UART::MAC_ADDRESS_LEN] = { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0A };
+static const unsigned char BSSID_B[RS9110_UART::MAC_ADDRESS_LEN] = { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0B };
+static const unsigned char BSSID_C[RS9110_UART::MAC_ADDRESS_LEN] = { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0C };
+
+
+void RS9110_ScanTable_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    scanTable   = new RS9110_ScanTable(*rs);
+}
+
+
+void RS9110_ScanTable_Test::tearDown ()
+{
+    delete scanTable;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_ScanTable_Test::ScanAnswer (RS9110_UART::ECommand command, const char **ssids, const unsigned char *rssis, unsigned int num, unsigned long nowMs)
+{
+    char                message[2 + (RS9110_UART::MAX_NUM_SCAN_RESULTS * sizeof(RS9110_UART::TScan)) + 2];
+    RS9110_UART::TScan *scan = (RS9110_UART::TScan *) &message[2];
+
+
+    memcpy(message, "OK", 2);
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        memset(&scan[i], 0, sizeof(scan[i]));
+        strcpy(scan[i].ssid, ssids[i]);
+        scan[i].mode = RS9110_UART::SEC_MODE_RSP_WPA2;
+        scan[i].rssi = rssis[i];
+    }
+
+    memcpy(&message[2 + (num * sizeof(RS9110_UART::TScan))], "\r\n", 2);
+
+    if(command == RS9110_UART::CMD_SCAN)
+    {
+        CPPUNIT_ASSERT(rs->Scan(0) == true);
+    }
+    else
+    {
+        CPPUNIT_ASSERT(rs->NextScan() == true);
+    }
+
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, 4 + (num * sizeof(RS9110_UART::TScan))) == true);
+    CPPUNIT_ASSERT(scanTable->ProcessResponse(nowMs) == true);
+}
+
+
+void RS9110_ScanTable_Test::BSSIDAnswer (const char **ssids, const unsigned char (*bssids)[RS9110_UART::MAC_ADDRESS_LEN], unsigned int num)
+{
+    char                 message[2 + (RS9110_UART::MAX_NUM_SCAN_RESULTS * sizeof(RS9110_UART::TBssid)) + 2];
+    RS9110_UART::TBssid *bssid = (RS9110_UART::TBssid *) &message[2];
+
+
+    memcpy(message, "OK", 2);
+
+    for(unsigned int i = 0; i < num; i++)
+    {
+        memset(&bssid[i], 0, sizeof(bssid[i]));
+        strcpy(bssid[i].ssid, ssids[i]);
+        memcpy(bssid[i].bssid, bssids[i], sizeof(bssid[i].bssid));
+    }
+
+    memcpy(&message[2 + (num * sizeof(RS9110_UART::TBssid))], "\r\n", 2);
+
+    CPPUNIT_ASSERT(rs->GetMACOfAPs() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, 4 + (num * sizeof(RS9110_UART::TBssid))) == true);
+    CPPUNIT_ASSERT(scanTable->ProcessResponse(0) == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_ScanTable_Test);
+
+
+void RS9110_ScanTable_Test::CollectPagesTest ()
+{
+    const char                     *page1[]     = { "Office", "Lab" };
+    const unsigned char             rssi1[]     = { 40, 60 };
+    const char                     *page2[]     = { "Guest" };
+    const unsigned char             rssi2[]     = { 30 };
+    RS9110_ScanTable::TAccessPoint  ap;
+
+
+    ScanAnswer(RS9110_UART::CMD_SCAN, page1, rssi1, 2, 100);
+    ScanAnswer(RS9110_UART::CMD_NEXT_SCAN, page2, rssi2, 1, 200);
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == 3);
+
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Lab", ap) == true);
+    CPPUNIT_ASSERT(ap.rssi == 60);
+    CPPUNIT_ASSERT(ap.secMode == RS9110_UART::SEC_MODE_RSP_WPA2);
+    CPPUNIT_ASSERT(ap.hasBssid == false);
+    CPPUNIT_ASSERT(ap.nwType == RS9110_UART::NW_TYPE_RSP_MAX);
+    CPPUNIT_ASSERT(ap.lastSeenMs == 100);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Nowhere", ap) == false);
+
+    /* A new scan updates instead of duplicating */
+    ScanAnswer(RS9110_UART::CMD_SCAN, page2, rssi1, 1, 300);
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == 3);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Guest", ap) == true);
+    CPPUNIT_ASSERT(ap.rssi == 40);
+    CPPUNIT_ASSERT(ap.lastSeenMs == 300);
+
+    /* Other answers are ignored */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x20\r\n", 5) == true);
+    CPPUNIT_ASSERT(scanTable->ProcessResponse(400) == false);
+}
+
+
+void RS9110_ScanTable_Test::JoinTest ()
+{
+    const char                     *ssids[]     = { "Office", "Office", "Lab" };
+    const unsigned char             rssis[]     = { 40, 55, 70 };
+    const unsigned char             bssids[][RS9110_UART::MAC_ADDRESS_LEN] =
+    {
+        { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0A },
+        { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0B },
+        { 0x00, 0x23, 0xA7, 0x00, 0x00, 0x0C }
+    };
+    RS9110_ScanTable::TAccessPoint  ap;
+
+
+    ScanAnswer(RS9110_UART::CMD_SCAN, ssids, rssis, 3, 100);
+    BSSIDAnswer(ssids, bssids, 3);
+
+    CPPUNIT_ASSERT(rs->GetNetworkType() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OKLab\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\x01\r\n", 37) == true);
+    CPPUNIT_ASSERT(scanTable->ProcessResponse(100) == true);
+
+    CPPUNIT_ASSERT(scanTable->FindByBSSID(BSSID_B, ap) == true);
+    CPPUNIT_ASSERT(strcmp(ap.ssid, "Office") == 0);
+    CPPUNIT_ASSERT(ap.rssi == 55);
+    CPPUNIT_ASSERT(ap.hasBssid == true);
+
+    CPPUNIT_ASSERT(scanTable->FindByBSSID(BSSID_C, ap) == true);
+    CPPUNIT_ASSERT(ap.nwType == RS9110_UART::NW_TYPE_RSP_ADHOC);
+
+    /* Strongest of the APs sharing the SSID */
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Office", ap) == true);
+    CPPUNIT_ASSERT(memcmp(ap.bssid, BSSID_A, sizeof(ap.bssid)) == 0);
+
+    /* Second survey merges into the known BSSIDs */
+    const unsigned char rssis2[] = { 65, 35, 70 };
+
+    ScanAnswer(RS9110_UART::CMD_SCAN, ssids, rssis2, 3, 200);
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == 6);
+    BSSIDAnswer(ssids, bssids, 3);
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == 3);
+
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Office", ap) == true);
+    CPPUNIT_ASSERT(memcmp(ap.bssid, BSSID_B, sizeof(ap.bssid)) == 0);
+    CPPUNIT_ASSERT(ap.rssi == 35);
+    CPPUNIT_ASSERT(ap.lastSeenMs == 200);
+    CPPUNIT_ASSERT(scanTable->FindByBSSID(BSSID_C, ap) == true);
+    CPPUNIT_ASSERT(ap.nwType == RS9110_UART::NW_TYPE_RSP_ADHOC);
+}
+
+
+void RS9110_ScanTable_Test::StrongestTest ()
+{
+    const char                     *page1[]     = { "A", "B", "C", "D" };
+    const unsigned char             rssi1[]     = { 80, 20, 50, 35 };
+    const char                     *page2[]     = { "E", "F" };
+    const unsigned char             rssi2[]     = { 10, 90 };
+    RS9110_ScanTable::TAccessPoint  aps[8];
+
+
+    CPPUNIT_ASSERT(scanTable->GetStrongest(aps, 3) == 0);
+
+    ScanAnswer(RS9110_UART::CMD_SCAN, page1, rssi1, 4, 0);
+    ScanAnswer(RS9110_UART::CMD_NEXT_SCAN, page2, rssi2, 2, 0);
+
+    CPPUNIT_ASSERT(scanTable->GetStrongest(aps, 3) == 3);
+    CPPUNIT_ASSERT(strcmp(aps[0].ssid, "E") == 0);
+    CPPUNIT_ASSERT(strcmp(aps[1].ssid, "B") == 0);
+    CPPUNIT_ASSERT(strcmp(aps[2].ssid, "D") == 0);
+
+    CPPUNIT_ASSERT(scanTable->GetStrongest(aps, 8) == 6);
+    CPPUNIT_ASSERT(aps[3].rssi == 50);
+    CPPUNIT_ASSERT(aps[4].rssi == 80);
+    CPPUNIT_ASSERT(aps[5].rssi == 90);
+}
+
+
+void RS9110_ScanTable_Test::ExpireTest ()
+{
+    const char                     *page1[]     = { "Old" };
+    const char                     *page2[]     = { "New" };
+    const unsigned char             rssi[]      = { 40 };
+    RS9110_ScanTable::TAccessPoint  ap;
+    char                            ssid[8];
+
+
+    ScanAnswer(RS9110_UART::CMD_SCAN, page1, rssi, 1, 1000);
+    ScanAnswer(RS9110_UART::CMD_SCAN, page2, rssi, 1, 5000);
+
+    CPPUNIT_ASSERT(scanTable->Expire(6000, 2000) == 1);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("Old", ap) == false);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("New", ap) == true);
+
+    /* Full table reuses the access point seen longest ago */
+    for(unsigned int i = 0; i < RS9110_ScanTable::MAX_ENTRIES; i++)
+    {
+        const char *name = ssid;
+
+        _snprintf_s(ssid, sizeof(ssid), "AP%u", i);
+        ScanAnswer(RS9110_UART::CMD_SCAN, &name, rssi, 1, 6000 + i);
+    }
+
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == RS9110_ScanTable::MAX_ENTRIES);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("New", ap) == false);
+    CPPUNIT_ASSERT(scanTable->FindBySSID("AP0", ap) == true);
+
+    scanTable->Clear();
+    CPPUNIT_ASSERT(scanTable->GetNumAccessPoints() == 0);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_ScanTable.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_ScanTable_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_ScanTable_Test);
+    CPPUNIT_TEST(CollectPagesTest);
+    CPPUNIT_TEST(JoinTest);
+    CPPUNIT_TEST(StrongestTest);
+    CPPUNIT_TEST(ExpireTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void CollectPagesTest ();
+    void JoinTest ();
+    void StrongestTest ();
+    void ExpireTest ();
+
+
+protected:
+
+    void ScanAnswer     (RS9110_UART::ECommand command, const char **ssids, const unsigned char *rssis, unsigned int num, unsigned long nowMs);
+    void BSSIDAnswer    (const char **ssids, const unsigned char (*bssids)[RS9110_UART::MAC_ADDRESS_LEN], unsigned int num);
+
+    PersistorWin32Mock     *mockFile;
+    RS9110_UART            *rs;
+    RS9110_ScanTable       *scanTable;
+
+};
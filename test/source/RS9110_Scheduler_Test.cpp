@@ -0,0 +1,172 @@
+#pragma once
+
+#include "RS9110_Scheduler_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]      = "OK\r\n";
+static const char SLEEP[]   = "SLEEP\r\n";
+
+
+void RS9110_Scheduler_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    scheduler   = new RS9110_Scheduler(*rs);
+}
+
+
+void RS9110_Scheduler_Test::tearDown ()
+{
+    delete scheduler;
+    delete rs;
+    delete mockFile;
+}
+
+
+bool RS9110_Scheduler_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+bool RS9110_Scheduler_Test::IssueSend (void *context, RS9110_UART &rs)
+{
+    return (rs.Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, (const char *) context, 1) > 0);
+}
+
+
+bool RS9110_Scheduler_Test::IssueNone (void *context, RS9110_UART &rs)
+{
+    return false;
+}
+
+
+void RS9110_Scheduler_Test::Answer (const char *expected)
+{
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), expected) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Scheduler_Test);
+
+
+void RS9110_Scheduler_Test::PriorityTest ()
+{
+    RS9110_Scheduler::TStats stats;
+
+
+    /* Issued at once, the rest waits for its answer */
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "A") == true);
+    CPPUNIT_ASSERT(scheduler->IsIdle() == false);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "B") == true);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    CPPUNIT_ASSERT(scheduler->GetNumQueued(RS9110_Scheduler::CLASS_BULK) == 1);
+    CPPUNIT_ASSERT(scheduler->GetNumQueued(RS9110_Scheduler::CLASS_CONTROL) == 1);
+
+    /* Control goes before the bulk data queued before it */
+    Answer("AT+RSI_SND=1,0,0,0,A\r\n");
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+    CPPUNIT_ASSERT(scheduler->IsIdle() == true);
+
+    /* Answers of commands not issued by the scheduler */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == false);
+
+    /* Commands not written are dropped */
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueNone) == true);
+    CPPUNIT_ASSERT(scheduler->IsIdle() == true);
+
+    scheduler->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numIssued[RS9110_Scheduler::CLASS_BULK] == 2);
+    CPPUNIT_ASSERT(stats.numIssued[RS9110_Scheduler::CLASS_CONTROL] == 1);
+    CPPUNIT_ASSERT(stats.numNotSent == 1);
+
+    /* Wrong arguments and full queue */
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_MAX, IssueRSSI) == false);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, NULL) == false);
+
+    for(unsigned char i = 0; i <= RS9110_Scheduler::MAX_JOBS; i++)
+    {
+        CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    }
+
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == false);
+
+    scheduler->Abort();
+    CPPUNIT_ASSERT(scheduler->IsIdle() == true);
+    CPPUNIT_ASSERT(scheduler->GetNumQueued(RS9110_Scheduler::CLASS_CONTROL) == 0);
+}
+
+
+void RS9110_Scheduler_Test::StarvationTest ()
+{
+    RS9110_Scheduler::TStats stats;
+
+
+    scheduler->SetMaxBypass(2);
+
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "A") == true);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "B") == true);
+
+    for(int i = 0; i < 4; i++)
+    {
+        CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    }
+
+    /* The first control was issued with nothing waiting, then 2 bypass the bulk data */
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_SND=1,0,0,0,A\r\n");
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+
+    scheduler->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numPromoted == 1);
+    CPPUNIT_ASSERT(scheduler->IsIdle() == true);
+}
+
+
+void RS9110_Scheduler_Test::SleepAckTest ()
+{
+    RS9110_Scheduler::TStats stats;
+
+
+    /* Not handled unless enabled */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) SLEEP, 7) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == false);
+
+    scheduler->SetAutoSleepAck(true);
+
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "A") == true);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_BULK, IssueSend, (void *) "B") == true);
+    CPPUNIT_ASSERT(scheduler->Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+
+    /* The ACK goes right after the command in progress and is not answered */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) SLEEP, 7) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == true);
+    CPPUNIT_ASSERT(scheduler->GetNumQueued(RS9110_Scheduler::CLASS_POWER) == 1);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == true);
+    CPPUNIT_ASSERT(scheduler->GetNumQueued(RS9110_Scheduler::CLASS_POWER) == 0);
+    Answer("AT+RSI_RSSI?\r\n");
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+
+    /* Issued at once when idle */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) SLEEP, 7) == true);
+    CPPUNIT_ASSERT(scheduler->ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "ACK\r\n") == 0);
+    CPPUNIT_ASSERT(scheduler->IsIdle() == true);
+
+    scheduler->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numSleepAcks == 2);
+    CPPUNIT_ASSERT(stats.numIssued[RS9110_Scheduler::CLASS_POWER] == 2);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Scheduler_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Scheduler_Test);
+    CPPUNIT_TEST(PriorityTest);
+    CPPUNIT_TEST(StarvationTest);
+    CPPUNIT_TEST(SleepAckTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void PriorityTest ();
+    void StarvationTest ();
+    void SleepAckTest ();
+
+
+protected:
+
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+    static bool IssueSend   (void *context, RS9110_UART &rs);
+    static bool IssueNone   (void *context, RS9110_UART &rs);
+
+    void Answer             (const char *expected);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_Scheduler               *scheduler;
+
+};
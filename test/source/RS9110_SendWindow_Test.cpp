@@ -0,0 +1,290 @@
+#pragma once
+
+#include "RS9110_SendWindow_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]              = "OK\r\n";
+static const char ERROR_TOO_FAST[]  = "ERROR\x40\r\n";
+static const char HOST[]            = "192.168.1.2";
+
+
+void RS9110_SendWindow_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    window      = new RS9110_SendWindow(*rs, Completion, this);
+
+    memset(completed, 0, sizeof(completed));
+    numCompleted    = 0;
+    numDropped      = 0;
+    lastError       = RS9110_UART::ERROR_NONE;
+    numQueuedInCompletion   = 0;
+    resubmit                = false;
+}
+
+
+void RS9110_SendWindow_Test::tearDown ()
+{
+    delete window;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_SendWindow_Test::Completion (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                                         bool isSent, RS9110_UART::EErrorCode eErrorCode)
+{
+    RS9110_SendWindow_Test *test = (RS9110_SendWindow_Test *) context;
+
+
+    if(isSent == true)
+    {
+        test->completed[test->numCompleted++] = data[0];
+    }
+    else
+    {
+        test->numDropped++;
+        test->lastError = eErrorCode;
+    }
+
+    test->numQueuedInCompletion = test->window->GetNumQueued();
+
+    if(test->resubmit == true)
+    {
+        test->window->Submit(socketId, RS9110_UART::SOCKET_UDP, HOST, 8000, "E", 1);
+    }
+}
+
+
+bool RS9110_SendWindow_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+void RS9110_SendWindow_Test::Answer (const char *response, int size)
+{
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(window->ProcessResponse() == true);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_SendWindow_Test);
+
+
+void RS9110_SendWindow_Test::PipelineTest ()
+{
+    RS9110_SendWindow::TStats stats;
+
+
+    window->SetMaxWindow(2);
+
+    /* Two sends written without waiting, the third one waits for room */
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "A", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "B", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "C", 1) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,B\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 2);
+    CPPUNIT_ASSERT(window->GetNumQueued() == 3);
+    CPPUNIT_ASSERT(window->IsIdle() == false);
+
+    /* Other sockets have their own window */
+    CPPUNIT_ASSERT(window->Submit(2, RS9110_UART::SOCKET_UDP, HOST, 8000, "D", 1) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=2,0,192.168.1.2,8000,D\r\n") == 0);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,C\r\n") == 0);
+    Answer(OK, 4);
+    Answer(OK, 4);
+    Answer(OK, 4);
+
+    CPPUNIT_ASSERT(window->IsIdle() == true);
+    CPPUNIT_ASSERT(window->GetNumQueued() == 0);
+    CPPUNIT_ASSERT(numCompleted == 4);
+    CPPUNIT_ASSERT(memcmp(completed, "ABDC", 4) == 0);
+
+    window->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numCommands == 4);
+    CPPUNIT_ASSERT(stats.numAcked == 4);
+    CPPUNIT_ASSERT(stats.numCompleted == 4);
+
+    /* Answers with nothing in flight are not consumed */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(window->ProcessResponse() == false);
+
+    /* Wrong arguments */
+    CPPUNIT_ASSERT(window->Submit(0, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1) == false);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_LTCP, NULL, 0, "A", 1) == false);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "A", 0) == false);
+}
+
+
+void RS9110_SendWindow_Test::ThrottleTest ()
+{
+    RS9110_SendWindow::TStats stats;
+
+
+    window->SetMaxWindow(4);
+
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "A", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "B", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "C", 1) == true);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 3);
+
+    /* The first rejection halves the window, nothing is written until drained */
+    Answer(OK, 4);
+    Answer(ERROR_TOO_FAST, 8);
+    CPPUNIT_ASSERT(window->GetWindow(1) == 2);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "D", 1) == true);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 1);
+
+    Answer(ERROR_TOO_FAST, 8);
+    CPPUNIT_ASSERT(window->GetWindow(1) == 2);
+
+    /* Rejected sends go first, in order */
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 2);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,C\r\n") == 0);
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,D\r\n") == 0);
+    Answer(OK, 4);
+    Answer(OK, 4);
+
+    CPPUNIT_ASSERT(memcmp(completed, "ABCD", 4) == 0);
+    CPPUNIT_ASSERT(numDropped == 0);
+
+    /* Additive increase: half a send per OK with a window of 2 */
+    CPPUNIT_ASSERT(window->GetWindow(1) == 3);
+
+    window->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numThrottled == 2);
+    CPPUNIT_ASSERT(stats.numCommands == 6);
+}
+
+
+void RS9110_SendWindow_Test::ErrorTest ()
+{
+    window->SetMaxWindow(2);
+
+    /* Other errors drop the send */
+    CPPUNIT_ASSERT(window->Submit(3, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1) == true);
+    Answer("ERROR\xF5\r\n", 8);
+
+    CPPUNIT_ASSERT(numDropped == 1);
+    CPPUNIT_ASSERT(lastError == RS9110_UART::ERROR_TCP_CONN_CLOSED);
+    CPPUNIT_ASSERT(window->GetNumQueued() == 0);
+
+    /* Abort drops everything */
+    for(unsigned char i = 0; i < RS9110_SendWindow::MAX_QUEUE; i++)
+    {
+        CPPUNIT_ASSERT(window->Submit(3, RS9110_UART::SOCKET_TCP, NULL, 0, "B", 1) == true);
+    }
+
+    CPPUNIT_ASSERT(window->Submit(3, RS9110_UART::SOCKET_TCP, NULL, 0, "C", 1) == false);
+
+    window->Abort();
+    CPPUNIT_ASSERT(numDropped == (1 + RS9110_SendWindow::MAX_QUEUE));
+    CPPUNIT_ASSERT(window->IsIdle() == true);
+    CPPUNIT_ASSERT(window->GetInFlight(3) == 0);
+}
+
+
+void RS9110_SendWindow_Test::TcpOrderTest ()
+{
+    window->SetMaxWindow(4);
+
+    /* One send in flight per TCP socket */
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "AAAA", 4) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "BBBB", 4) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,AAAA\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 1);
+
+    /* Pipelined across TCP sockets */
+    CPPUNIT_ASSERT(window->Submit(2, RS9110_UART::SOCKET_TCP, NULL, 0, "CCCC", 4) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=2,0,0,0,CCCC\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetInFlight(2) == 1);
+
+    /* A rejected send is written again before the next one of its stream */
+    Answer(ERROR_TOO_FAST, 8);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,AAAA\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 1);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,AAAA\r\n") == 0);
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,BBBB\r\n") == 0);
+    Answer(OK, 4);
+
+    CPPUNIT_ASSERT(numCompleted == 3);
+    CPPUNIT_ASSERT(memcmp(completed, "CAB", 3) == 0);
+    CPPUNIT_ASSERT(window->IsIdle() == true);
+}
+
+
+void RS9110_SendWindow_Test::CompletionOrderTest ()
+{
+    /* The entry is still counted while its completion runs */
+    resubmit = true;
+
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "A", 1) == true);
+    Answer(OK, 4);
+
+    CPPUNIT_ASSERT(numQueuedInCompletion == 1);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,E\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetNumQueued() == 1);
+
+    resubmit = false;
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(memcmp(completed, "AE", 2) == 0);
+    CPPUNIT_ASSERT(window->GetNumQueued() == 0);
+}
+
+
+void RS9110_SendWindow_Test::SchedulerTest ()
+{
+    RS9110_Scheduler scheduler(*rs);
+
+
+    window->SetScheduler(&scheduler);
+    window->SetMaxWindow(2);
+
+    /* Sends wait for the line */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "A", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "B", 1) == true);
+    CPPUNIT_ASSERT(window->Submit(1, RS9110_UART::SOCKET_UDP, HOST, 8000, "C", 1) == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+    CPPUNIT_ASSERT(scheduler.GetNumQueued(RS9110_Scheduler::CLASS_BULK) == 1);
+
+    /* Then the sends the window allows are written together */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(window->ProcessResponse() == false);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,B\r\n") == 0);
+    CPPUNIT_ASSERT(window->GetInFlight(1) == 2);
+
+    /* A control command waits for both answers, then goes before the third send */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == false);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,B\r\n") == 0);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(window->ProcessResponse() == false);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,192.168.1.2,8000,C\r\n") == 0);
+
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+
+    CPPUNIT_ASSERT(memcmp(completed, "ABC", 3) == 0);
+    CPPUNIT_ASSERT(window->IsIdle() == true);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+}
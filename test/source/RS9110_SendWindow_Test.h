@@ -0,0 +1,54 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_SendWindow.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_SendWindow_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_SendWindow_Test);
+    CPPUNIT_TEST(PipelineTest);
+    CPPUNIT_TEST(ThrottleTest);
+    CPPUNIT_TEST(ErrorTest);
+    CPPUNIT_TEST(TcpOrderTest);
+    CPPUNIT_TEST(CompletionOrderTest);
+    CPPUNIT_TEST(SchedulerTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void PipelineTest ();
+    void ThrottleTest ();
+    void ErrorTest ();
+    void TcpOrderTest ();
+    void CompletionOrderTest ();
+    void SchedulerTest ();
+
+
+protected:
+
+    static void Completion (void *context, unsigned char socketId, const char *data, unsigned int dataSize,
+                            bool isSent, RS9110_UART::EErrorCode eErrorCode);
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+
+    void Answer     (const char *response, int size);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_SendWindow              *window;
+    char                            completed[16];      /* First byte of every completed send */
+    unsigned int                    numCompleted;
+    unsigned int                    numDropped;
+    RS9110_UART::EErrorCode         lastError;
+    unsigned char                   numQueuedInCompletion;
+    bool                            resubmit;
+
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "RS9110_SleepBatcher_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+
+static const char OK[]      = "OK\r\n";
+static const char SLEEP[]   = "SLEEP\r\n";
+static const char ACK[]     = "ACK\r\n";
+
+
+void RS9110_SleepBatcher_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    batcher     = new RS9110_SleepBatcher(*rs);
+
+    mockFile->Write((unsigned char *) "", 0);
+}
+
+
+void RS9110_SleepBatcher_Test::tearDown ()
+{
+    delete batcher;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_SleepBatcher_Test::Answer (const char *expected)
+{
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), expected) == 0);
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(batcher->ProcessResponse() == true);
+}
+
+
+void RS9110_SleepBatcher_Test::Sleep ()
+{
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) SLEEP, 7) == true);
+    CPPUNIT_ASSERT(batcher->ProcessResponse() == true);
+}
+
+
+bool RS9110_SleepBatcher_Test::IssueRSSI (void *context, RS9110_UART &rs)
+{
+    return rs.GetRSSI();
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_SleepBatcher_Test);
+
+
+void RS9110_SleepBatcher_Test::BatchTest ()
+{
+    RS9110_SleepBatcher::TStats stats;
+
+
+    /* Without power save nothing is held and SLEEP is not handled */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1, 1000, 0) == true);
+    Answer("AT+RSI_SND=1,0,0,0,A\r\n");
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) SLEEP, 7) == true);
+    CPPUNIT_ASSERT(batcher->ProcessResponse() == false);
+
+    /* Nothing to write: straight back to sleep */
+    batcher->SetPowerSave(true);
+    Sleep();
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_ASLEEP);
+
+    /* Held until the next wake window, then written in one burst */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "B", 1, 1000, 0) == true);
+    CPPUNIT_ASSERT(batcher->Submit(2, RS9110_UART::SOCKET_UDP, "192.168.1.2", 8000, "C", 1, 1000, 10) == true);
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "D", 1, 1000, 20) == true);
+    CPPUNIT_ASSERT(batcher->GetNumHeld() == 3);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    batcher->Poll(500);
+
+    Sleep();
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_WINDOW);
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+    Answer("AT+RSI_SND=2,0,192.168.1.2,8000,C\r\n");
+    Answer("AT+RSI_SND=1,0,0,0,D\r\n");
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_ASLEEP);
+    CPPUNIT_ASSERT(batcher->GetNumHeld() == 0);
+
+    batcher->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numWindows == 2);
+    CPPUNIT_ASSERT(stats.numAcks == 2);
+    CPPUNIT_ASSERT(stats.numWakes == 0);
+    CPPUNIT_ASSERT(stats.numCompleted == 4);
+    CPPUNIT_ASSERT(stats.maxBatch == 3);
+
+    /* ACK not written: still awake, written again by the poll */
+    mockFile->SetWriteFailure(true);
+    Sleep();
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_WINDOW);
+    mockFile->SetWriteFailure(false);
+    mockFile->Write((unsigned char *) "", 0);
+    batcher->Poll(600);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_ASLEEP);
+
+    /* Turning power save off writes what is held */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "E", 1, 1000, 0) == true);
+    batcher->SetPowerSave(false);
+    Answer("AT+RSI_SND=1,0,0,0,E\r\n");
+
+    /* Wrong arguments */
+    CPPUNIT_ASSERT(batcher->Submit(0, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1, 0, 0) == false);
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_LTCP, NULL, 0, "A", 1, 0, 0) == false);
+}
+
+
+void RS9110_SleepBatcher_Test::LatencyTest ()
+{
+    RS9110_SleepBatcher::TStats stats;
+
+
+    batcher->SetPowerSave(true);
+    Sleep();
+
+    /* Woken up before the latency bound is missed */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1, 100, 0) == true);
+    batcher->Poll(99);
+    CPPUNIT_ASSERT(batcher->IsIdle() == true);
+    batcher->Poll(100);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_AWAKE);
+    Answer("AT+RSI_SND=1,0,0,0,A\r\n");
+
+    /* Awake: written at once, the ACK waits for the send in flight */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "B", 1, 100, 200) == true);
+    Sleep();
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+
+    /* No latency allowed */
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "C", 1, 0, 300) == true);
+    Answer("AT+RSI_SND=1,0,0,0,C\r\n");
+
+    /* No room left */
+    Sleep();
+
+    for(unsigned char i = 0; i < RS9110_SleepBatcher::MAX_HELD; i++)
+    {
+        CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "D", 1, 1000, 400) == true);
+    }
+
+    CPPUNIT_ASSERT(batcher->IsIdle() == true);
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "D", 1, 1000, 400) == false);
+    CPPUNIT_ASSERT(batcher->IsIdle() == false);
+
+    batcher->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numWakes == 3);
+
+    batcher->Abort();
+    CPPUNIT_ASSERT(batcher->GetNumHeld() == 0);
+    CPPUNIT_ASSERT(batcher->IsIdle() == true);
+}
+
+
+void RS9110_SleepBatcher_Test::SchedulerTest ()
+{
+    RS9110_Scheduler scheduler(*rs);
+
+
+    batcher->SetScheduler(&scheduler);
+    batcher->SetPowerSave(true);
+
+    /* The ACK goes in the power class */
+    Sleep();
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_ASLEEP);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "A", 1, 1000, 0) == true);
+    CPPUNIT_ASSERT(batcher->Submit(1, RS9110_UART::SOCKET_TCP, NULL, 0, "B", 1, 1000, 10) == true);
+    Sleep();
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_SND=1,0,0,0,A\r\n") == 0);
+
+    /* The sends are bulk: a control command queued meanwhile goes first */
+    CPPUNIT_ASSERT(scheduler.Post(RS9110_Scheduler::CLASS_CONTROL, IssueRSSI) == true);
+    Answer("AT+RSI_SND=1,0,0,0,A\r\n");
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), "AT+RSI_RSSI?\r\n") == 0);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(batcher->ProcessResponse() == false);
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+
+    Answer("AT+RSI_SND=1,0,0,0,B\r\n");
+    CPPUNIT_ASSERT(scheduler.ProcessResponse() == true);
+    CPPUNIT_ASSERT(strcmp(mockFile->GetBufferData(), ACK) == 0);
+    CPPUNIT_ASSERT(batcher->GetState() == RS9110_SleepBatcher::STATE_ASLEEP);
+    CPPUNIT_ASSERT(batcher->GetNumHeld() == 0);
+    CPPUNIT_ASSERT(scheduler.IsIdle() == true);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_SleepBatcher.h"
+#include "RS9110_Scheduler.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_SleepBatcher_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_SleepBatcher_Test);
+    CPPUNIT_TEST(BatchTest);
+    CPPUNIT_TEST(LatencyTest);
+    CPPUNIT_TEST(SchedulerTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void BatchTest ();
+    void LatencyTest ();
+    void SchedulerTest ();
+
+
+protected:
+
+    void Answer     (const char *expected);
+    void Sleep      ();
+
+    static bool IssueRSSI   (void *context, RS9110_UART &rs);
+
+    PersistorWin32Mock             *mockFile;
+    RS9110_UART                    *rs;
+    RS9110_SleepBatcher            *batcher;
+
+};
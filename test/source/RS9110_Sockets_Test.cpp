@@ -0,0 +1,313 @@
+#pragma once
+
+#include "RS9110_Sockets_Test.h"
+
+#include <cppunit\config\SourcePrefix.h>
+
+#include <string.h>
+
+
+static const char   OK[]    = "OK\r\n";
+
+
+void RS9110_Sockets_Test::setUp ()
+{
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    sockets     = new RS9110_Sockets(*rs);
+
+    mockFile->Write((unsigned char *) "", 0);
+}
+
+
+void RS9110_Sockets_Test::tearDown ()
+{
+    delete sockets;
+    delete rs;
+    delete mockFile;
+}
+
+
+void RS9110_Sockets_Test::Answer (const char *response, int size)
+{
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) response, size) == true);
+    CPPUNIT_ASSERT(sockets->ProcessResponse() == true);
+}
+
+
+void RS9110_Sockets_Test::CompareStream (const char *expected)
+{
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == strlen(expected));
+    CPPUNIT_ASSERT(memcmp(mockFile->GetBufferData(), expected, strlen(expected)) == 0);
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Sockets_Test);
+
+
+void RS9110_Sockets_Test::StreamTest ()
+{
+    RS9110_Sockets::TStats  stats;
+    char                    buffer[16];
+    int                     fd;
+
+
+    fd = sockets->Socket(RS9110_Sockets::TYPE_STREAM);
+    CPPUNIT_ASSERT(fd == 0);
+    CPPUNIT_ASSERT(sockets->Send(fd, "x", 1) == RS9110_Sockets::RESULT_NOT_CONNECTED);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_NOT_CONNECTED);
+
+    /* Connect without bind: an ephemeral port */
+    CPPUNIT_ASSERT(sockets->Connect(fd, "192.168.1.10", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CompareStream("AT+RSI_TCP=192.168.1.10,8000,40000\r\n");
+    CPPUNIT_ASSERT(sockets->Connect(fd, "192.168.1.10", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CPPUNIT_ASSERT(sockets->Send(fd, "x", 1) == RS9110_Sockets::RESULT_WOULD_BLOCK);
+
+    Answer("OK\x03\r\n", 5);
+    CPPUNIT_ASSERT(sockets->Connect(fd, "192.168.1.10", 8000) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(sockets->GetHandle(fd) == 3);
+
+    /* Straight to the module, one send at a time */
+    CPPUNIT_ASSERT(sockets->Send(fd, "hello", 5) == 5);
+    CompareStream("AT+RSI_SND=3,0,0,0,hello\r\n");
+    CPPUNIT_ASSERT(sockets->Send(fd, "again", 5) == RS9110_Sockets::RESULT_WOULD_BLOCK);
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(sockets->Send(fd, "", 0) == 0);
+
+    /* Nothing yet, then a stream read in any slices */
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_WOULD_BLOCK);
+    Answer("AT+RSI_READ\x03\x04\x00" "abcd\r\n", 20);
+    Answer("AT+RSI_READ\x03\x03\x00" "efg\r\n", 19);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, 3) == 3);
+    CPPUNIT_ASSERT(memcmp(buffer, "abc", 3) == 0);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == 4);
+    CPPUNIT_ASSERT(memcmp(buffer, "defg", 4) == 0);
+
+    /* Closed by the peer: buffered data first, then end of stream */
+    Answer("AT+RSI_READ\x03\x02\x00hi\r\n", 18);
+    Answer("AT+RSI_CLOSE\x03\r\n", 15);
+    CPPUNIT_ASSERT(sockets->GetHandle(fd) == 0);
+    CPPUNIT_ASSERT(sockets->Send(fd, "x", 1) == RS9110_Sockets::RESULT_RESET);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == 2);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == 0);
+    CPPUNIT_ASSERT(sockets->Connect(fd, "192.168.1.10", 8000) == RS9110_Sockets::RESULT_RESET);
+
+    /* Nothing to close on the module any more */
+    mockFile->Write((unsigned char *) "", 0);
+    CPPUNIT_ASSERT(sockets->Close(fd) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(mockFile->GetBufferSize() == 0);
+    CPPUNIT_ASSERT(sockets->Close(fd) == RS9110_Sockets::RESULT_BAD_DESCRIPTOR);
+
+    sockets->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numCommands == 2);
+    CPPUNIT_ASSERT(stats.bytesSent == 5);
+    CPPUNIT_ASSERT(stats.bytesReceived == 9);
+    CPPUNIT_ASSERT(stats.bytesDropped == 0);
+}
+
+
+void RS9110_Sockets_Test::DatagramTest ()
+{
+    char                    buffer[16];
+    char                    host[RS9110_Sockets::MAX_ADDRESS_LEN + 1];
+    char                    big[1600];
+    unsigned short          port    = 0;
+    int                     fd;
+
+
+    fd = sockets->Socket(RS9110_Sockets::TYPE_DGRAM);
+    CPPUNIT_ASSERT(sockets->Listen(fd) == RS9110_Sockets::RESULT_INVALID);
+    CPPUNIT_ASSERT(sockets->Bind(fd, 5000) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(sockets->Listen(fd) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CPPUNIT_ASSERT(rs->GetLastCommand() == RS9110_UART::CMD_OPEN_LUDP_SOCKET);
+    CPPUNIT_ASSERT(sockets->Bind(fd, 5001) == RS9110_Sockets::RESULT_INVALID);
+    Answer("OK\x02\r\n", 5);
+    CPPUNIT_ASSERT(sockets->Listen(fd) == RS9110_Sockets::RESULT_OK);
+
+    /* Datagrams keep their bounds and source */
+    Answer("AT+RSI_READ\x02\x05\x00\xC0\xA8\x01\x07\x1F\x41hello\r\n", 27);
+    Answer("AT+RSI_READ\x02\x03\x00\xC0\xA8\x01\x08\x00\x35" "abc\r\n", 25);
+
+    CPPUNIT_ASSERT(sockets->RecvFrom(fd, buffer, 3, host, &port) == 3);
+    CPPUNIT_ASSERT(memcmp(buffer, "hel", 3) == 0);
+    CPPUNIT_ASSERT(strcmp(host, "192.168.1.7") == 0);
+    CPPUNIT_ASSERT(port == 8001);
+
+    CPPUNIT_ASSERT(sockets->RecvFrom(fd, buffer, sizeof(buffer), host, &port) == 3);
+    CPPUNIT_ASSERT(memcmp(buffer, "abc", 3) == 0);
+    CPPUNIT_ASSERT(strcmp(host, "192.168.1.8") == 0);
+    CPPUNIT_ASSERT(port == 53);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_WOULD_BLOCK);
+
+    /* Any peer thru SendTo; never split */
+    CPPUNIT_ASSERT(sockets->Send(fd, "x", 1) == RS9110_Sockets::RESULT_NOT_CONNECTED);
+    memset(big, 'b', sizeof(big));
+    CPPUNIT_ASSERT(sockets->SendTo(fd, big, sizeof(big), "192.168.1.7", 8001) == RS9110_Sockets::RESULT_INVALID);
+    CPPUNIT_ASSERT(sockets->SendTo(fd, "reply", 5, "192.168.1.7", 8001) == 5);
+    CompareStream("AT+RSI_SND=2,0,192.168.1.7,8001,reply\r\n");
+    Answer(OK, 4);
+
+    /* Fixed peer thru Connect */
+    fd = sockets->Socket(RS9110_Sockets::TYPE_DGRAM);
+    CPPUNIT_ASSERT(fd == 1);
+    CPPUNIT_ASSERT(sockets->Bind(fd, 6000) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(sockets->Connect(fd, "192.168.1.9", 7000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CompareStream("AT+RSI_UDP=192.168.1.9,7000,6000\r\n");
+    Answer("OK\x04\r\n", 5);
+    CPPUNIT_ASSERT(sockets->Send(fd, "ping", 4) == 4);
+    CompareStream("AT+RSI_SND=4,0,192.168.1.9,7000,ping\r\n");
+    Answer(OK, 4);
+
+    /* Closed: reset for datagrams */
+    Answer("AT+RSI_CLOSE\x04\r\n", 15);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_RESET);
+}
+
+
+void RS9110_Sockets_Test::PollTest ()
+{
+    RS9110_Sockets::TPollFd fds[3];
+    char                    buffer[8];
+    int                     fd0;
+    int                     fd1;
+
+
+    fd0 = sockets->Socket(RS9110_Sockets::TYPE_STREAM);
+    fd1 = sockets->Socket(RS9110_Sockets::TYPE_STREAM);
+
+    fds[0].fd       = fd0;
+    fds[0].events   = RS9110_Sockets::POLL_IN | RS9110_Sockets::POLL_OUT;
+    fds[1].fd       = fd1;
+    fds[1].events   = RS9110_Sockets::POLL_IN | RS9110_Sockets::POLL_OUT;
+    fds[2].fd       = 42;
+    fds[2].events   = RS9110_Sockets::POLL_IN;
+
+    /* Opens queued behind each other */
+    CPPUNIT_ASSERT(sockets->Bind(fd1, 80) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(sockets->Listen(fd1) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CPPUNIT_ASSERT(sockets->Connect(fd0, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CompareStream("AT+RSI_LTCP=80\r\n");
+
+    CPPUNIT_ASSERT(sockets->Poll(fds, 3) == 1);
+    CPPUNIT_ASSERT(fds[0].revents == 0);
+    CPPUNIT_ASSERT(fds[1].revents == 0);
+    CPPUNIT_ASSERT(fds[2].revents == RS9110_Sockets::POLL_ERR);
+
+    Answer("OK\x01\r\n", 5);
+    CompareStream("AT+RSI_TCP=10.0.0.1,8000,40000\r\n");
+
+    /* Open, but the module is busy with the other one */
+    CPPUNIT_ASSERT(sockets->Poll(fds, 2) == 0);
+
+    Answer("OK\x02\r\n", 5);
+    CPPUNIT_ASSERT(sockets->Poll(fds, 2) == 2);
+    CPPUNIT_ASSERT(fds[0].revents == RS9110_Sockets::POLL_OUT);
+    CPPUNIT_ASSERT(fds[1].revents == RS9110_Sockets::POLL_OUT);
+
+    /* Data on the listening socket (its peer connected) */
+    CPPUNIT_ASSERT(sockets->Send(fd0, "q", 1) == 1);
+    Answer("AT+RSI_READ\x01\x01\x00q\r\n", 17);
+    fds[1].events = RS9110_Sockets::POLL_IN;
+    CPPUNIT_ASSERT(sockets->Poll(fds, 2) == 1);
+    CPPUNIT_ASSERT(fds[0].revents == 0);
+    CPPUNIT_ASSERT(fds[1].revents == RS9110_Sockets::POLL_IN);
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(sockets->Recv(fd1, buffer, sizeof(buffer)) == 1);
+
+    /* Hang up */
+    Answer("AT+RSI_CLOSE\x02\r\n", 15);
+    fds[0].events = 0;
+    CPPUNIT_ASSERT(sockets->Poll(fds, 2) == 1);
+    CPPUNIT_ASSERT(fds[0].revents == RS9110_Sockets::POLL_HUP);
+    CPPUNIT_ASSERT(fds[1].revents == 0);
+
+    /* Closed by the application: the descriptor comes back after the answer */
+    CPPUNIT_ASSERT(sockets->Close(fd1) == RS9110_Sockets::RESULT_OK);
+    CompareStream("AT+RSI_CLS=1\r\n");
+    CPPUNIT_ASSERT(sockets->Recv(fd1, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_BAD_DESCRIPTOR);
+    CPPUNIT_ASSERT(sockets->Close(fd0) == RS9110_Sockets::RESULT_OK);
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_STREAM) == 0);
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_STREAM) == 2);
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_DGRAM) == 1);
+}
+
+
+void RS9110_Sockets_Test::ErrorTest ()
+{
+    RS9110_Sockets::TPollFd fds[1];
+    RS9110_Sockets::TStats  stats;
+    int                     fd;
+    char                    frame[14 + 1400 + 2 + 1];
+    char                    buffer[16];
+
+
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_MAX) == RS9110_Sockets::RESULT_INVALID);
+
+    for(unsigned char i = 0; i < RS9110_Sockets::MAX_DESCRIPTORS; i++)
+    {
+        CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_STREAM) == i);
+    }
+
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_STREAM) == RS9110_Sockets::RESULT_NO_DESCRIPTORS);
+
+    /* Open refused */
+    fd = 0;
+    CPPUNIT_ASSERT(sockets->Connect(fd, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    Answer("ERROR\xFC\r\n", 8);
+    CPPUNIT_ASSERT(sockets->Connect(fd, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_MODULE_ERROR);
+    CPPUNIT_ASSERT(sockets->GetErrorCode(fd) == RS9110_UART::ERROR_ILLEGAL_PARAMS);
+    CPPUNIT_ASSERT(sockets->Connect(fd, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_RESET);
+
+    /* Send refused: told by the next call, once */
+    fd = 1;
+    CPPUNIT_ASSERT(sockets->Connect(fd, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    Answer("OK\x01\r\n", 5);
+    CPPUNIT_ASSERT(sockets->Send(fd, "data", 4) == 4);
+    Answer("ERROR\x40\r\n", 8);
+
+    fds[0].fd       = fd;
+    fds[0].events   = RS9110_Sockets::POLL_OUT;
+    CPPUNIT_ASSERT(sockets->Poll(fds, 1) == 1);
+    CPPUNIT_ASSERT(fds[0].revents == (RS9110_Sockets::POLL_OUT | RS9110_Sockets::POLL_ERR));
+
+    CPPUNIT_ASSERT(sockets->Send(fd, "data", 4) == RS9110_Sockets::RESULT_MODULE_ERROR);
+    CPPUNIT_ASSERT(sockets->GetErrorCode(fd) == RS9110_UART::ERROR_SEND_DATA_TOO_FAST);
+    CPPUNIT_ASSERT(sockets->Send(fd, "data", 4) == 4);
+    Answer(OK, 4);
+
+    /* Receive buffer full: the stream has a gap, so it is reset for good */
+    memcpy(frame, "AT+RSI_READ\x01\x78\x05", 14);
+    memset(&frame[14], 'r', 1400);
+    memcpy(&frame[14 + 1400], "\r\n", 3);
+    Answer(frame, sizeof(frame) - 1);
+    Answer(frame, sizeof(frame) - 1);
+    Answer("AT+RSI_READ\x01\x02\x00hi\r\n", 18);
+
+    fds[0].events = RS9110_Sockets::POLL_IN;
+    CPPUNIT_ASSERT(sockets->Poll(fds, 1) == 1);
+    CPPUNIT_ASSERT((fds[0].revents & RS9110_Sockets::POLL_ERR) != 0);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_RESET);
+    CPPUNIT_ASSERT(sockets->Recv(fd, buffer, sizeof(buffer)) == RS9110_Sockets::RESULT_RESET);
+    CPPUNIT_ASSERT(sockets->Send(fd, "data", 4) == RS9110_Sockets::RESULT_RESET);
+
+    /* Closed while opening: closed on the module once opened */
+    fd = 2;
+    CPPUNIT_ASSERT(sockets->Connect(fd, "10.0.0.1", 8000) == RS9110_Sockets::RESULT_IN_PROGRESS);
+    CPPUNIT_ASSERT(sockets->Close(fd) == RS9110_Sockets::RESULT_OK);
+    Answer("OK\x02\r\n", 5);
+    CompareStream("AT+RSI_CLS=2\r\n");
+    Answer(OK, 4);
+    CPPUNIT_ASSERT(rs->IsSocketOpen(2) == false);
+    CPPUNIT_ASSERT(sockets->Socket(RS9110_Sockets::TYPE_STREAM) == 2);
+
+    /* Not related */
+    CPPUNIT_ASSERT(rs->ProcessMessage((char *) OK, 4) == true);
+    CPPUNIT_ASSERT(sockets->ProcessResponse() == false);
+
+    sockets->GetStats(stats);
+    CPPUNIT_ASSERT(stats.numSendErrors == 1);
+    CPPUNIT_ASSERT(stats.bytesSent == 4);
+    CPPUNIT_ASSERT(stats.bytesReceived == 1400);
+    CPPUNIT_ASSERT(stats.bytesDropped == 1402);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Sockets.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Sockets_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Sockets_Test);
+    CPPUNIT_TEST(StreamTest);
+    CPPUNIT_TEST(DatagramTest);
+    CPPUNIT_TEST(PollTest);
+    CPPUNIT_TEST(ErrorTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void StreamTest ();
+    void DatagramTest ();
+    void PollTest ();
+    void ErrorTest ();
+
+
+protected:
+
+    void Answer         (const char *response, int size);
+    void CompareStream  (const char *expected);
+
+    PersistorWin32Mock     *mockFile;
+    RS9110_UART            *rs;
+    RS9110_Sockets         *sockets;
+
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "RS9110_Trace_Test.h"
+
+#include "RS9110_UART.h"
+#include "RS9110_Trace.h"
+#include "PersistorWin32Mock.h"
+
+#include <string>
+#include <cppunit\config\SourcePrefix.h>
+
+
+static unsigned long long fakeTime = 0;
+
+static unsigned long long FakeClock ()
+{
+    fakeTime += 100;
+    return fakeTime;
+}
+
+
+class PersistorStringMock : public IPersistor
+{
+public:
+
+    virtual bool Open ()    { return true; }
+    virtual bool Close ()   { return true; }
+    virtual bool Read (unsigned char *buffer, unsigned int size) { return true; }
+
+    virtual bool Write (unsigned char *data, unsigned int size)
+    {
+        text.append((char *) data, size);
+        return true;
+    }
+
+    std::string text;
+};
+
+
+void RS9110_Trace_Test::setUp ()
+{
+    fakeTime    = 0;
+    mockFile    = new PersistorWin32Mock();
+    rs          = new RS9110_UART(mockFile);
+    trace       = new RS9110_Trace(FakeClock);
+
+    rs->SetTrace(trace);
+}
+
+
+void RS9110_Trace_Test::tearDown ()
+{
+    delete rs;
+    delete trace;
+    delete mockFile;
+}
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RS9110_Trace_Test);
+
+
+void RS9110_Trace_Test::RecordTest ()
+{
+    RS9110_Trace::TEntry entry;
+
+
+    CPPUNIT_ASSERT(rs->GetTrace() == trace);
+    CPPUNIT_ASSERT(trace->GetNumEntries() == 0);
+    CPPUNIT_ASSERT(trace->GetEntry(0, entry) == false);
+
+    rs->Send(3, RS9110_UART::SOCKET_TCP, NULL, 0, "abc", 3);
+    rs->ProcessMessage("OK\r\n", 4);
+    rs->ProcessMessage("AT+RSI_READ\x05\x03\x00" "abc\r\n", 19);
+    rs->ProcessMessage("AT+RSI_CLOSE\x05\r\n", 15);
+    rs->ProcessMessage("BAD", 3);
+    rs->Band(RS9110_UART::BAND_MAX);
+
+    CPPUNIT_ASSERT(trace->GetNumEntries() == 5);
+
+    CPPUNIT_ASSERT(trace->GetEntry(0, entry) == true);
+    CPPUNIT_ASSERT(entry.event == RS9110_Trace::EVENT_TX);
+    CPPUNIT_ASSERT(entry.type == RS9110_UART::CMD_SEND_DATA);
+    CPPUNIT_ASSERT(entry.socketId == 3);
+    CPPUNIT_ASSERT(entry.length == strlen("AT+RSI_SND=3,0,0,0,abc\r\n"));
+    CPPUNIT_ASSERT(entry.timestamp == 100);
+
+    CPPUNIT_ASSERT(trace->GetEntry(1, entry) == true);
+    CPPUNIT_ASSERT(entry.event == RS9110_Trace::EVENT_RX);
+    CPPUNIT_ASSERT(entry.type == RS9110_UART::RESP_TYPE_OK);
+    CPPUNIT_ASSERT(entry.timestamp == 200);
+
+    CPPUNIT_ASSERT(trace->GetEntry(2, entry) == true);
+    CPPUNIT_ASSERT(entry.type == RS9110_UART::RESP_TYPE_READ);
+    CPPUNIT_ASSERT(entry.socketId == 5);
+    CPPUNIT_ASSERT(entry.length == 19);
+
+    CPPUNIT_ASSERT(trace->GetEntry(3, entry) == true);
+    CPPUNIT_ASSERT(entry.type == RS9110_UART::RESP_TYPE_CLOSE);
+    CPPUNIT_ASSERT(entry.socketId == 5);
+
+    CPPUNIT_ASSERT(trace->GetEntry(4, entry) == true);
+    CPPUNIT_ASSERT(entry.event == RS9110_Trace::EVENT_RX_REJECTED);
+
+    trace->Clear();
+    CPPUNIT_ASSERT(trace->GetNumEntries() == 0);
+}
+
+
+void RS9110_Trace_Test::WrapAroundTest ()
+{
+    RS9110_Trace::TEntry entry;
+
+
+    for(unsigned int i = 0; i < (RS9110_Trace::MAX_TRACE_ENTRIES + 10); i++)
+    {
+        trace->Record(RS9110_Trace::EVENT_TX, RS9110_UART::CMD_INIT, 0, (unsigned short) i);
+    }
+
+    /* The slot the producer writes next is not readable */
+    CPPUNIT_ASSERT(trace->GetNumEntries() == (RS9110_Trace::MAX_TRACE_ENTRIES - 1));
+    CPPUNIT_ASSERT(trace->GetEntry(0, entry) == true);
+    CPPUNIT_ASSERT(entry.length == 11);
+    CPPUNIT_ASSERT(trace->GetEntry(RS9110_Trace::MAX_TRACE_ENTRIES - 2, entry) == true);
+    CPPUNIT_ASSERT(entry.length == (RS9110_Trace::MAX_TRACE_ENTRIES + 9));
+    CPPUNIT_ASSERT(trace->GetEntry(RS9110_Trace::MAX_TRACE_ENTRIES - 1, entry) == false);
+}
+
+
+void RS9110_Trace_Test::ExportChromeTraceTest ()
+{
+    PersistorStringMock out;
+
+
+    rs->Init();
+    rs->ProcessMessage("OK\r\n", 4);
+    rs->ProcessMessage("SLEEP\r\n", 7);
+    rs->KeepSleeping();
+
+    CPPUNIT_ASSERT(trace->ExportChromeTrace(NULL) == false);
+    CPPUNIT_ASSERT(trace->ExportChromeTrace(&out) == true);
+
+    CPPUNIT_ASSERT(out.text.find("{\"traceEvents\":[") == 0);
+    CPPUNIT_ASSERT(out.text.find("\"name\":\"AT+RSI_INIT\",\"cat\":\"command\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0,\"dur\":100") != std::string::npos);
+    CPPUNIT_ASSERT(out.text.find("\"name\":\"SLEEP\",\"cat\":\"unsolicited\",\"ph\":\"i\"") != std::string::npos);
+    CPPUNIT_ASSERT(out.text.find("\"name\":\"ACK\",\"cat\":\"command\",\"ph\":\"i\"") != std::string::npos);
+    CPPUNIT_ASSERT(out.text.find("]") != std::string::npos);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "PersistorWin32Mock.h"
+#include "RS9110_UART.h"
+#include "RS9110_Trace.h"
+
+#include <cppunit\extensions\HelperMacros.h>
+
+
+class RS9110_Trace_Test : public CPPUNIT_NS::TestFixture
+{
+CPPUNIT_TEST_SUITE(RS9110_Trace_Test);
+    CPPUNIT_TEST(RecordTest);
+    CPPUNIT_TEST(WrapAroundTest);
+    CPPUNIT_TEST(ExportChromeTraceTest);
+CPPUNIT_TEST_SUITE_END();
+
+
+public:
+
+    void setUp ();
+    void tearDown ();
+
+    void RecordTest ();
+    void WrapAroundTest ();
+    void ExportChromeTraceTest ();
+
+
+protected:
+
+    PersistorWin32Mock     *mockFile;
+    RS9110_UART            *rs;
+    RS9110_Trace           *trace;
+
+};
@@ -272,6 +272,230 @@ void RS9110_UART_Test::GetResponseTest ()
 }
 
 
+void RS9110_UART_Test::CountersTest ()
+{
+    RS9110_UART::TCounters counters;
+    char data[4] = { 'A', (char) 0xDB, (char) 0x0D, (char) 0x0A };
+
+
+    rs->GetCounters(counters);
+    CPPUNIT_ASSERT(counters.bytesWritten == 0);
+    CPPUNIT_ASSERT(counters.bytesRead == 0);
+
+    rs->Init();
+    rs->Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, data, sizeof(data));
+    rs->ProcessMessage("OK\r\n", 4);
+    rs->ProcessMessage("ERROR\x40\r\n", 8);
+    rs->ProcessMessage("ERROR\x40\r\n", 8);
+    rs->ProcessMessage("ERROR\xC5\r\n", 8);
+    rs->ProcessMessage("UNKNOWN\r\n", 9);
+    rs->ProcessMessage("OK", 2);
+
+    rs->GetCounters(counters);
+    CPPUNIT_ASSERT(counters.bytesWritten == (strlen("AT+RSI_INIT\r\n") + strlen("AT+RSI_SND=1,0,0,0,") + 5 + 2));
+    CPPUNIT_ASSERT(counters.bytesRead == (4 + 8 + 8 + 8 + 9 + 2));
+    CPPUNIT_ASSERT(counters.payloadBytes == 4);
+    CPPUNIT_ASSERT(counters.stuffedBytes == 5);
+    CPPUNIT_ASSERT(counters.frames[RS9110_UART::RESP_TYPE_OK] == 1);
+    CPPUNIT_ASSERT(counters.frames[RS9110_UART::RESP_TYPE_ERROR] == 3);
+    CPPUNIT_ASSERT(counters.rejectedFrames == 2);
+    CPPUNIT_ASSERT(rs->GetErrorCount(RS9110_UART::ERROR_SEND_DATA_TOO_FAST) == 2);
+    CPPUNIT_ASSERT(rs->GetErrorCount(RS9110_UART::ERROR_CMD_TOO_FAST) == 1);
+    CPPUNIT_ASSERT(rs->GetErrorCount(RS9110_UART::ERROR_IP_EXPIRED) == 0);
+
+    rs->ResetCounters();
+    rs->GetCounters(counters);
+    CPPUNIT_ASSERT(counters.bytesWritten == 0);
+    CPPUNIT_ASSERT(counters.frames[RS9110_UART::RESP_TYPE_ERROR] == 0);
+    CPPUNIT_ASSERT(rs->GetErrorCount(RS9110_UART::ERROR_SEND_DATA_TOO_FAST) == 0);
+}
+
+
+void RS9110_UART_Test::StaticPersistorTest ()
+{
+    RS9110_UART_T<PersistorWin32Mock>   rsStatic(mockFile);
+    RS9110_UART::TCounters              counters;
+    bool                                bRtn;
+
+
+    CPPUNIT_ASSERT(rsStatic.GetPersistor() == mockFile);
+
+    bRtn = rsStatic.Band(RS9110_UART::BAND_5_GHZ);
+    CPPUNIT_ASSERT(bRtn == true);
+    CPPUNIT_ASSERT(rsStatic.GetLastCommand() == RS9110_UART::CMD_BAND);
+    CompareStream("AT+RSI_BAND=1\r\n");
+
+    CPPUNIT_ASSERT(rsStatic.Send(2, RS9110_UART::SOCKET_TCP, NULL, 0, "abc", 3) == 3);
+    CompareStream("AT+RSI_SND=2,0,0,0,abc\r\n");
+
+    bRtn = rsStatic.ProcessMessage("OK\r\n", 4);
+    CPPUNIT_ASSERT(bRtn == true);
+    CPPUNIT_ASSERT(rsStatic.GetResponseType() == RS9110_UART::RESP_TYPE_OK);
+
+    rsStatic.GetCounters(counters);
+    CPPUNIT_ASSERT(counters.bytesWritten == (strlen("AT+RSI_BAND=1\r\n") + strlen("AT+RSI_SND=2,0,0,0,abc\r\n")));
+    CPPUNIT_ASSERT(counters.frames[RS9110_UART::RESP_TYPE_OK] == 1);
+}
+
+
+void RS9110_UART_Test::SocketTableTest ()
+{
+    RS9110_UART::TSocketInfo info;
+
+
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 0);
+    CPPUNIT_ASSERT(rs->GetSocketInfo(1, info) == false);
+
+    /* Open: the handle comes in the OK */
+    CPPUNIT_ASSERT(rs->OpenTcpSocket("192.168.1.10", 8000, 1234) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x01\r\n", 5) == true);
+
+    CPPUNIT_ASSERT(rs->IsSocketOpen(1) == true);
+    CPPUNIT_ASSERT(rs->GetSocketInfo(1, info) == true);
+    CPPUNIT_ASSERT(info.id == 1);
+    CPPUNIT_ASSERT(info.type == RS9110_UART::SOCKET_TCP);
+    CPPUNIT_ASSERT(info.localPort == 1234);
+    CPPUNIT_ASSERT(info.remotePort == 8000);
+    CPPUNIT_ASSERT(memcmp(info.remoteAddress, "\xC0\xA8\x01\x0A", 4) == 0);
+
+    CPPUNIT_ASSERT(rs->OpenListeningTcpSocket(5001) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x03\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->GetOpenSockets() == 0x05);
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 2);
+
+    /* Failed open and stray OK leave the table untouched */
+    CPPUNIT_ASSERT(rs->OpenUdpSocket("10.0.0.1", 53, 2000) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\x80\r\n", 8) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x02\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 2);
+
+    /* Remote end of the listening socket */
+    CPPUNIT_ASSERT(rs->GetSocketStatus(3) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x03\x0A\x00\x00\x02\x1F\x90\r\n", 11) == true);
+    CPPUNIT_ASSERT(rs->GetSocketInfo(3, info) == true);
+    CPPUNIT_ASSERT(info.type == RS9110_UART::SOCKET_LTCP);
+    CPPUNIT_ASSERT(info.localPort == 5001);
+    CPPUNIT_ASSERT(info.remotePort == 8080);
+    CPPUNIT_ASSERT(memcmp(info.remoteAddress, "\x0A\x00\x00\x02", 4) == 0);
+
+    /* Close from the host and from the module */
+    CPPUNIT_ASSERT(rs->CloseSocket(1) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\r\n", 4) == true);
+    CPPUNIT_ASSERT(rs->IsSocketOpen(1) == false);
+
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x03\r\n", 15) == true);
+    CPPUNIT_ASSERT(rs->IsSocketOpen(3) == false);
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 0);
+
+    /* Disassociation closes everything */
+    CPPUNIT_ASSERT(rs->OpenListeningUdpSocket(6000) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x07\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->GetSocketInfo(7, info) == true);
+    CPPUNIT_ASSERT(info.type == RS9110_UART::SOCKET_LUDP);
+    CPPUNIT_ASSERT(rs->Disassociate() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\r\n", 4) == true);
+    CPPUNIT_ASSERT(rs->GetOpenSockets() == 0);
+
+    /* Beyond MAX_NUMBER_SOCKETS entries a socket is open, without details */
+    for(unsigned char i = RS9110_UART::MIN_SOCKET_HANDLE; i <= RS9110_UART::MAX_SOCKET_HANDLE; i++)
+    {
+        char ok[] = "OK\x00\r\n";
+
+
+        ok[2] = (char) i;
+
+        CPPUNIT_ASSERT(rs->OpenListeningUdpSocket(6000 + i) == true);
+        CPPUNIT_ASSERT(rs->ProcessMessage(ok, 5) == true);
+        CPPUNIT_ASSERT(rs->IsSocketOpen(i) == true);
+        CPPUNIT_ASSERT(rs->GetSocketInfo(i, info) == (i <= RS9110_UART::MAX_NUMBER_SOCKETS));
+    }
+
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == RS9110_UART::MAX_SOCKET_HANDLE);
+
+    /* A closed entry is reused */
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x01\r\n", 15) == true);
+    CPPUNIT_ASSERT(rs->OpenListeningUdpSocket(7000) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x01\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->GetSocketInfo(1, info) == true);
+    CPPUNIT_ASSERT(info.localPort == 7000);
+
+    rs->ResetSocketTable();
+    CPPUNIT_ASSERT(rs->GetNumOpenSockets() == 0);
+}
+
+
+void RS9110_UART_Test::NetworkParametersCacheTest ()
+{
+    RS9110_UART::TNetworkParams         params;
+    const RS9110_UART::TNetworkParams  *cached;
+    char                                message[sizeof(params) + 4];
+    char                                longMessage[sizeof(RS9110_UART::TNetworkParamsExt) + ((RS9110_UART::MAX_SOCKET_HANDLE - RS9110_UART::MAX_NUMBER_SOCKETS) * sizeof(RS9110_UART::TSocketDetails)) + RS9110_UART::NW_ADDRESS_LEN + 4];
+    int                                 length;
+
+
+    memset(&params, 0, sizeof(params));
+    strcpy(params.ssid, "Redpine");
+    memcpy(params.address, "\xC0\xA8\x01\x0A", 4);
+
+    memcpy(message, "OK", 2);
+    memcpy(&message[2], &params, sizeof(params));
+    memcpy(&message[2 + sizeof(params)], "\r\n", 2);
+
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == false);
+    CPPUNIT_ASSERT(rs->GetCachedNetworkParameters(length) == NULL);
+
+    /* Only asks the module while invalid */
+    CPPUNIT_ASSERT(rs->RefreshNetworkParameters() == RS9110_UART::REFRESH_SENT);
+    CompareStream("AT+RSI_NWPARAMS?\r\n");
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, sizeof(message)) == true);
+
+    cached = (const RS9110_UART::TNetworkParams *) rs->GetCachedNetworkParameters(length);
+    CPPUNIT_ASSERT(cached != NULL);
+    CPPUNIT_ASSERT(length == sizeof(params));
+    CPPUNIT_ASSERT(strcmp(cached->ssid, "Redpine") == 0);
+    CPPUNIT_ASSERT(memcmp(cached->address, "\xC0\xA8\x01\x0A", 4) == 0);
+    CPPUNIT_ASSERT(rs->RefreshNetworkParameters() == RS9110_UART::REFRESH_CACHED);
+
+    /* Commands that do not change them keep the cache */
+    CPPUNIT_ASSERT(rs->GetRSSI() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x30\r\n", 5) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\xC5\r\n", 8) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == true);
+
+    /* Invalidation by command, by error code and by unsolicited close */
+    CPPUNIT_ASSERT(rs->IPConfiguration(RS9110_UART::DHCP_DHCP) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\x00\x23\xA7\x00\x00\x01\x0A\x00\x00\x02\xFF\xFF\xFF\x00\x0A\x00\x00\x01\r\n", 22) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == false);
+
+    CPPUNIT_ASSERT(rs->GetNetworkParameters() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, sizeof(message)) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("ERROR\xF6\r\n", 8) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == false);
+
+    CPPUNIT_ASSERT(rs->GetNetworkParameters() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, sizeof(message)) == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("AT+RSI_CLOSE\x01\r\n", 15) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == false);
+
+    CPPUNIT_ASSERT(rs->GetNetworkParameters() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage(message, sizeof(message)) == true);
+    CPPUNIT_ASSERT(rs->Disassociate() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage("OK\r\n", 4) == true);
+    CPPUNIT_ASSERT(rs->IsNetworkParametersCached() == false);
+
+    /* The longest answer (63 byte PSK, every handle open, DNS server) is kept whole */
+    memset(longMessage, 0x5A, sizeof(longMessage));
+    memcpy(longMessage, "OK", 2);
+    memcpy(&longMessage[sizeof(longMessage) - 2], "\r\n", 2);
+
+    CPPUNIT_ASSERT(rs->GetNetworkParameters() == true);
+    CPPUNIT_ASSERT(rs->ProcessMessage(longMessage, sizeof(longMessage)) == true);
+    CPPUNIT_ASSERT(rs->GetCachedNetworkParameters(length) != NULL);
+    CPPUNIT_ASSERT(length == (int) (sizeof(longMessage) - 4));
+}
+
+
 void RS9110_UART_Test::SendBandTest ()
 {
     bool bRtn;
@@ -886,6 +1110,57 @@ void RS9110_UART_Test::SendTest ()
 }
 
 
+void RS9110_UART_Test::StuffedSizeTest ()
+{
+    static const char   BYTES[]     = { 'A', (char) 0x0D, (char) 0x0A, (char) 0xDB };
+    static char         data[1600];
+    unsigned int        seed        = 1;
+    unsigned int        hdrLen      = strlen("AT+RSI_SND=1,0,0,0,");
+    unsigned int        maxSize     = RS9110_UART::GetMaxSendSize(1, RS9110_UART::SOCKET_TCP);
+    unsigned int        dstSize;
+    unsigned int        iRtn;
+
+
+    dstSize = 10;
+    CPPUNIT_ASSERT(RS9110_UART::GetStuffedSize("\r\nA\xDB\xDB", 5) == 7);
+    CPPUNIT_ASSERT(RS9110_UART::FitByteStuffing(dstSize, "\r\nA\xDB\xDB", 5) == 5);
+    CPPUNIT_ASSERT(dstSize == 7);
+
+    /* A plain byte needs 2 bytes left, a pair is never split */
+    dstSize = 3;
+    CPPUNIT_ASSERT(RS9110_UART::FitByteStuffing(dstSize, "AAAA", 4) == 2);
+    CPPUNIT_ASSERT(dstSize == 2);
+    dstSize = 3;
+    CPPUNIT_ASSERT(RS9110_UART::FitByteStuffing(dstSize, "A\r\nA", 4) == 3);
+    CPPUNIT_ASSERT(dstSize == 3);
+    dstSize = 3;
+    CPPUNIT_ASSERT(RS9110_UART::FitByteStuffing(dstSize, "AA\r\n", 4) == 2);
+    CPPUNIT_ASSERT(dstSize == 2);
+
+    /* Same as what Send() takes, whatever the mix of bytes */
+    for(int n = 0; n < 200; n++)
+    {
+        unsigned int size = 1300 + (n * 7) % 300;
+
+        for(unsigned int i = 0; i < size; i++)
+        {
+            seed    = (seed * 1103515245) + 12345;
+            data[i] = BYTES[(seed >> 16) % (((n % 4) == 0) ? 3 : 4)];
+        }
+
+        dstSize = maxSize;
+        iRtn    = rs->Send(1, RS9110_UART::SOCKET_TCP, NULL, 0, data, size);
+        CPPUNIT_ASSERT(RS9110_UART::FitByteStuffing(dstSize, data, size) == iRtn);
+        CPPUNIT_ASSERT(mockFile->GetBufferSize() == (hdrLen + dstSize + 2));
+
+        if(iRtn == size)
+        {
+            CPPUNIT_ASSERT(RS9110_UART::GetStuffedSize(data, size) == dstSize);
+        }
+    }
+}
+
+
 void RS9110_UART_Test::GetDNSTest ()
 {
     bool bRtn;
@@ -11,6 +11,10 @@ class RS9110_UART_Test : public CPPUNIT_NS::TestFixture
 CPPUNIT_TEST_SUITE(RS9110_UART_Test);
     CPPUNIT_TEST(ProcessMessageTest);
     CPPUNIT_TEST(GetResponseTest);
+    CPPUNIT_TEST(CountersTest);
+    CPPUNIT_TEST(StaticPersistorTest);
+    CPPUNIT_TEST(SocketTableTest);
+    CPPUNIT_TEST(NetworkParametersCacheTest);
 
     CPPUNIT_TEST(SendBandTest);
     CPPUNIT_TEST(SendInitTest);
@@ -42,6 +46,7 @@ CPPUNIT_TEST_SUITE(RS9110_UART_Test);
     CPPUNIT_TEST(GetSocketStatusTest);
     CPPUNIT_TEST(CloseSocketTest);
     CPPUNIT_TEST(SendTest);
+    CPPUNIT_TEST(StuffedSizeTest);
     CPPUNIT_TEST(GetDNSTest);
 
     CPPUNIT_TEST(GetFirmwareVersionTest);
@@ -65,6 +70,10 @@ public:
 
     void ProcessMessageTest ();
     void GetResponseTest ();
+    void CountersTest ();
+    void StaticPersistorTest ();
+    void SocketTableTest ();
+    void NetworkParametersCacheTest ();
 
     void SendBandTest ();
     void SendInitTest ();
@@ -96,6 +105,7 @@ public:
     void GetSocketStatusTest ();
     void CloseSocketTest ();
     void SendTest ();
+    void StuffedSizeTest ();
     void GetDNSTest ();
 
     void GetFirmwareVersionTest ();
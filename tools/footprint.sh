@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+#   Footprint report of the driver per configuration (see include/RS9110_Config.h).
+#
+#   Manual tool: the IAR and MSVS projects do not run it. Run it from a shell
+#   whenever the sizing of a board is reviewed.
+#
+#   Usage:  tools/footprint.sh [extra compiler flags]
+#
+#   CXX and SIZE select the toolchain (i.e. CXX=avr32-g++ SIZE=avr32-size for
+#   the MCU). Reports text/data/bss of the library objects and the RAM used
+#   by one RS9110_UART instance and one RS9110_Trace ring.
+#
+
+CXX=${CXX:-g++}
+SIZE=${SIZE:-size}
+NM=${NM:-nm}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+CONFIG_minimal="-DRS9110_MAX_BUFFER_SIZE=256 -DRS9110_MAX_NUMBER_SOCKETS=2 -DRS9110_MAX_NUM_SCAN_RESULTS=4 \
+ -DRS9110_MAX_DNSGET_RESP=2 -DRS9110_MAX_ERROR_COUNTERS=4 -DRS9110_MAX_TRACE_ENTRIES=16 \
+ -DRS9110_FEATURE_WEP=0 -DRS9110_FEATURE_IBSS=0 -DRS9110_FEATURE_DNS=0"
+CONFIG_default=""
+CONFIG_gateway="-DRS9110_MAX_BUFFER_SIZE=2048 -DRS9110_MAX_ERROR_COUNTERS=32 -DRS9110_MAX_TRACE_ENTRIES=1024"
+
+cat > "$OUT/footprint.cpp" <<'SRC'
+#include "RS9110_UART.h"
+#include "RS9110_Trace.h"
+
+char footprintDriver[sizeof(RS9110_UART)];
+char footprintTrace[sizeof(RS9110_Trace)];
+SRC
+
+printf "%-10s %10s %10s %10s %12s %12s\n" "config" "text" "data" "bss" "driver RAM" "trace RAM"
+
+for config in minimal default gateway; do
+    eval flags=\"\$CONFIG_$config\"
+    mkdir -p "$OUT/$config"
+
+    for src in "$ROOT"/source/*.cpp "$OUT/footprint.cpp"; do
+        $CXX -Os -c $flags "$@" -I"$ROOT/include" "$src" -o "$OUT/$config/$(basename "$src" .cpp).o" || exit 1
+    done
+
+    totals=$($SIZE -t "$OUT/$config"/RS9110_*.o | tail -1)
+    text=$(echo "$totals" | awk '{ print $1 }')
+    data=$(echo "$totals" | awk '{ print $2 }')
+    bss=$(echo "$totals" | awk '{ print $3 }')
+
+    driver=$(printf "%d" "0x$($NM -S "$OUT/$config/footprint.o" | awk '/footprintDriver/ { print $2 }')")
+    trace=$(printf "%d" "0x$($NM -S "$OUT/$config/footprint.o" | awk '/footprintTrace/ { print $2 }')")
+
+    printf "%-10s %10s %10s %10s %12s %12s\n" "$config" "$text" "$data" "$bss" "$driver" "$trace"
+done